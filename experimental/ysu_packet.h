@@ -11,8 +11,8 @@
   #include <immintrin.h>
 #endif
 
-#include "../ray.h"
-#include "../vec3.h"
+#include "ray.h"
+#include "vec3.h"
 
 #ifdef __cplusplus
 extern "C" {
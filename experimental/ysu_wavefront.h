@@ -7,8 +7,8 @@
 #define YSU_WAVEFRONT_H
 
 #include <stdint.h>
-#include "../ray.h"
-#include "../vec3.h"
+#include "ray.h"
+#include "vec3.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +28,7 @@ typedef struct {
     Vec3 p;
     Vec3 n;
     int material_id;
+    int prim_id;       // engine primitive index (-1 = none)
 } YSU_SurfHit;
 
 typedef struct {
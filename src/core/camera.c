@@ -3,6 +3,8 @@
 #include "vec3.h"
 #include "ray.h"
 
+#include <math.h>
+
 Camera camera_create(float aspect_ratio, float viewport_height, float focal_length)
 {
     Camera cam;
@@ -26,6 +28,38 @@ Camera camera_create(float aspect_ratio, float viewport_height, float focal_leng
     return cam;
 }
 
+Camera camera_look_at(Vec3 from, Vec3 at, Vec3 up, float vfov_deg, float aspect_ratio)
+{
+    Camera cam;
+
+    float h = 2.0f * tanf(vfov_deg * (3.14159265358979f / 360.0f));
+    float w = aspect_ratio * h;
+
+    Vec3 back  = vec3_normalize(vec3_sub(from, at));
+    Vec3 right = vec3_cross(up, back);
+    if (vec3_length_squared(right) < 1e-12f) {
+        // looking straight along up: any perpendicular will do
+        right = vec3_cross(vec3(0.0f, 0.0f, 1.0f), back);
+        if (vec3_length_squared(right) < 1e-12f) right = vec3(1.0f, 0.0f, 0.0f);
+    }
+    right = vec3_normalize(right);
+    Vec3 upv = vec3_cross(back, right);
+
+    cam.origin     = from;
+    cam.horizontal = vec3_scale(right, w);
+    cam.vertical   = vec3_scale(upv, h);
+
+    cam.lower_left_corner = vec3_sub(
+        vec3_sub(
+            vec3_sub(cam.origin, vec3_scale(cam.horizontal, 0.5f)),
+            vec3_scale(cam.vertical, 0.5f)
+        ),
+        back
+    );
+
+    return cam;
+}
+
 Ray camera_get_ray(Camera cam, float u, float v)
 {
     Vec3 p = vec3_add(
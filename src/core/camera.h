@@ -14,6 +14,11 @@ typedef struct {
 // Create camera with viewport params
 Camera camera_create(float aspect_ratio, float viewport_height, float focal_length);
 
+// Camera at `from` looking at `at`, vertical field of view in degrees and
+// focal length 1. camera_create(aspect, 2, 1) is
+// camera_look_at((0,0,0), (0,0,-1), (0,1,0), 90, aspect).
+Camera camera_look_at(Vec3 from, Vec3 at, Vec3 up, float vfov_deg, float aspect_ratio);
+
 // Generate ray from (u, v) screen coords
 Ray camera_get_ray(Camera cam, float u, float v);
 
@@ -2,25 +2,30 @@
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 #include "material.h"
 #include "vec3.h"
 #include "ray.h"
+#include "ysu_rng.h"
 
-static float rand01(void) {
-    return (float)rand() / (float)RAND_MAX;
+static float rand01(YSU_Sampler *rng) {
+    return ysu_sampler_next(rng);
 }
 
-static Vec3 random_in_unit_sphere(void) {
+static Vec3 random_in_unit_sphere(YSU_Sampler *rng) {
     while (1) {
-        Vec3 p = vec3_random(-1.0f, 1.0f);
+        Vec3 p = vec3(2.0f * rand01(rng) - 1.0f,
+                      2.0f * rand01(rng) - 1.0f,
+                      2.0f * rand01(rng) - 1.0f);
         if (vec3_length_squared(p) >= 1.0f) continue;
         return p;
     }
 }
 
-static Vec3 random_unit_vector(void) {
-    return vec3_unit(random_in_unit_sphere());
+static Vec3 random_unit_vector(YSU_Sampler *rng) {
+    return vec3_unit(random_in_unit_sphere(rng));
 }
 
 static Vec3 reflect(Vec3 v, Vec3 n) {
@@ -45,12 +50,13 @@ static float schlick(float cosine, float ref_idx) {
     return r0 + (1.0f - r0) * powf(1.0f - cosine, 5.0f);
 }
 
-bool material_scatter(const Material *mat,
-                      Ray in,
-                      Vec3 hit_point,
-                      Vec3 normal,
-                      Ray *scattered,
-                      Vec3 *attenuation)
+static bool scatter_impl(const Material *mat,
+                         Ray in,
+                         Vec3 hit_point,
+                         Vec3 normal,
+                         YSU_Sampler *rng,
+                         Ray *scattered,
+                         Vec3 *attenuation)
 {
     // Emissive: light only, no scatter
     if (mat->type == MAT_EMISSIVE) {
@@ -62,7 +68,7 @@ bool material_scatter(const Material *mat,
 
     switch (mat->type) {
         case MAT_LAMBERTIAN: {
-            Vec3 scatter_dir = vec3_add(normal, random_unit_vector());
+            Vec3 scatter_dir = vec3_add(normal, random_unit_vector(rng));
 
             // Degenerate scatter direction: fall back to normal
             if (vec3_length_squared(scatter_dir) < 1e-8f) {
@@ -76,7 +82,7 @@ bool material_scatter(const Material *mat,
         case MAT_METAL: {
             Vec3 reflected = reflect(unit_dir, normal);
             Vec3 perturbed = vec3_add(reflected,
-                                      vec3_scale(random_in_unit_sphere(), mat->fuzz));
+                                      vec3_scale(random_in_unit_sphere(rng), mat->fuzz));
             *scattered = ray(hit_point, perturbed);
             *attenuation = mat->albedo;
 
@@ -99,7 +105,7 @@ bool material_scatter(const Material *mat,
             bool cannot_refract = refraction_ratio * sin_theta > 1.0f;
             Vec3 direction;
 
-            if (cannot_refract || schlick(cos_theta, refraction_ratio) > rand01()) {
+            if (cannot_refract || schlick(cos_theta, refraction_ratio) > rand01(rng)) {
                 direction = reflect(unit_dir, normal);
             } else {
                 direction = refract(unit_dir, normal, 1.0f / refraction_ratio);
@@ -114,3 +120,34 @@ bool material_scatter(const Material *mat,
 
     return true;
 }
+
+bool material_scatter(const Material *mat,
+                      Ray in,
+                      Vec3 hit_point,
+                      Vec3 normal,
+                      Ray *scattered,
+                      Vec3 *attenuation)
+{
+    // Legacy entry: a per-thread stream (thread id x call counter) instead
+    // of the locked global rand().
+    static _Atomic uint32_t next_thread = 0;
+    static YSU_THREAD_LOCAL uint32_t t_id = 0;
+    static YSU_THREAD_LOCAL uint32_t t_calls = 0;
+    if (t_id == 0) t_id = atomic_fetch_add(&next_thread, 1u) + 1u;
+
+    YSU_Sampler s;
+    ysu_sampler_init(&s, 0x6D617431u, t_id, t_calls++, 0);
+    return scatter_impl(mat, in, hit_point, normal, &s, scattered, attenuation);
+}
+
+bool material_scatter_rng(const Material *mat,
+                          Ray in,
+                          Vec3 hit_point,
+                          Vec3 normal,
+                          YSU_Sampler *sampler,
+                          Ray *scattered,
+                          Vec3 *attenuation)
+{
+    if (!sampler) return material_scatter(mat, in, hit_point, normal, scattered, attenuation);
+    return scatter_impl(mat, in, hit_point, normal, sampler, scattered, attenuation);
+}
@@ -3,8 +3,10 @@
 #define MATERIAL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "vec3.h"
 #include "ray.h"
+#include "ysu_rng.h"
 
 // --------------------------------------
 // Material Types
@@ -42,4 +44,15 @@ bool material_scatter(const Material *mat,
                       Ray *scattered,
                       Vec3 *attenuation);
 
+// Same as material_scatter, but draws from the caller's counter-based
+// sampler (ysu_rng.h), so results depend only on pixel/sample/bounce.
+// The caller selects the bounce slot (ysu_sampler_bounce) beforehand.
+bool material_scatter_rng(const Material *mat,
+                          Ray in,
+                          Vec3 hit_point,
+                          Vec3 normal,
+                          YSU_Sampler *sampler,
+                          Ray *scattered,
+                          Vec3 *attenuation);
+
 #endif // MATERIAL_H
@@ -1,6 +1,20 @@
 #ifndef VEC3_H
 #define VEC3_H
 
+// The core math is defined inline here so hot loops (hit_sphere, BVH slabs,
+// shading) do not pay a call per operation in a -O2 build without LTO.
+// vec3.c still emits one external definition of each, so the ABI and any
+// code taking a function's address are unchanged.
+// Wide SoA variants (Vec3x4 / Vec3x8) live in vec3_simd.h.
+
+#include <math.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #define YSU_VEC_INLINE static __inline
+#else
+  #define YSU_VEC_INLINE inline
+#endif
+
 typedef struct {
     float x;
     float y;
@@ -8,20 +22,86 @@ typedef struct {
 } Vec3;
 
 // Core vector functions
-Vec3 vec3(float x, float y, float z);
-Vec3 vec3_add(Vec3 a, Vec3 b);
-Vec3 vec3_sub(Vec3 a, Vec3 b);
-Vec3 vec3_mul(Vec3 a, Vec3 b);       // component-wise multiply
-Vec3 vec3_scale(Vec3 a, float s);    // scalar multiply
-float vec3_dot(Vec3 a, Vec3 b);
-Vec3 vec3_cross(Vec3 a, Vec3 b);
-float vec3_length(Vec3 a);
-Vec3 vec3_normalize(Vec3 a);
-Vec3 vec3_reflect(Vec3 v, Vec3 n);
+YSU_VEC_INLINE Vec3 vec3(float x, float y, float z)
+{
+    Vec3 v;
+    v.x = x;
+    v.y = y;
+    v.z = z;
+    return v;
+}
+
+YSU_VEC_INLINE Vec3 vec3_add(Vec3 a, Vec3 b)
+{
+    return vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+YSU_VEC_INLINE Vec3 vec3_sub(Vec3 a, Vec3 b)
+{
+    return vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+// component-wise multiply
+YSU_VEC_INLINE Vec3 vec3_mul(Vec3 a, Vec3 b)
+{
+    return vec3(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+// scalar multiply
+YSU_VEC_INLINE Vec3 vec3_scale(Vec3 a, float s)
+{
+    return vec3(a.x * s, a.y * s, a.z * s);
+}
+
+YSU_VEC_INLINE float vec3_dot(Vec3 a, Vec3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+YSU_VEC_INLINE Vec3 vec3_cross(Vec3 a, Vec3 b)
+{
+    return vec3(
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x
+    );
+}
+
+YSU_VEC_INLINE float vec3_length_squared(Vec3 a)
+{
+    return a.x * a.x + a.y * a.y + a.z * a.z;
+}
+
+YSU_VEC_INLINE float vec3_length(Vec3 a)
+{
+    return sqrtf(vec3_length_squared(a));
+}
+
+YSU_VEC_INLINE Vec3 vec3_normalize(Vec3 a)
+{
+    float len = vec3_length(a);
+    if (len <= 0.0f) {
+        return vec3(0.0f, 0.0f, 0.0f);
+    }
+    float inv = 1.0f / len;
+    return vec3(a.x * inv, a.y * inv, a.z * inv);
+}
+
+YSU_VEC_INLINE Vec3 vec3_reflect(Vec3 v, Vec3 n)
+{
+    // v - 2 * dot(v, n) * n
+    float d = vec3_dot(v, n);
+    return vec3_sub(v, vec3_scale(n, 2.0f * d));
+}
 
 // --- Extra helpers for legacy code ---
-float vec3_length_squared(Vec3 a);
-Vec3 vec3_unit(Vec3 a);
+
+// Legacy alias: unit(v) = normalize(v)
+YSU_VEC_INLINE Vec3 vec3_unit(Vec3 a)
+{
+    return vec3_normalize(a);
+}
+
 Vec3 vec3_random(float min, float max);
 
 #endif
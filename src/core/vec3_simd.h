@@ -0,0 +1,189 @@
+// vec3_simd.h - 4-wide / 8-wide SoA vector math for batched ray work
+//
+// Vec3x4 / Vec3x8 hold 4 / 8 Vec3s as separate x/y/z lanes. Lane types:
+//   ysu_f4: __m128 on SSE targets, plain floats otherwise
+//   ysu_f8: __m256 with __AVX__, two __m128 halves on SSE, plain floats otherwise
+// Every operation is the same IEEE op per lane as the scalar vec3.h code
+// (no FMA contraction, exact sqrt/div), so a batched kernel produces the same
+// bits as the scalar loop it replaces.
+#ifndef VEC3_SIMD_H
+#define VEC3_SIMD_H
+
+#include "vec3.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define YSU_SIMD_SSE 1
+  #include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+  #define YSU_SIMD_AVX 1
+  #include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ------------------------- 4-wide lanes -------------------------
+#if defined(YSU_SIMD_SSE)
+typedef __m128 ysu_f4;
+
+static inline ysu_f4 ysu_f4_set1(float v)               { return _mm_set1_ps(v); }
+static inline ysu_f4 ysu_f4_load(const float *p)        { return _mm_loadu_ps(p); }
+static inline void   ysu_f4_store(float *p, ysu_f4 a)   { _mm_storeu_ps(p, a); }
+static inline ysu_f4 ysu_f4_add(ysu_f4 a, ysu_f4 b)     { return _mm_add_ps(a, b); }
+static inline ysu_f4 ysu_f4_sub(ysu_f4 a, ysu_f4 b)     { return _mm_sub_ps(a, b); }
+static inline ysu_f4 ysu_f4_mul(ysu_f4 a, ysu_f4 b)     { return _mm_mul_ps(a, b); }
+static inline ysu_f4 ysu_f4_div(ysu_f4 a, ysu_f4 b)     { return _mm_div_ps(a, b); }
+static inline ysu_f4 ysu_f4_sqrt(ysu_f4 a)              { return _mm_sqrt_ps(a); }
+static inline ysu_f4 ysu_f4_min(ysu_f4 a, ysu_f4 b)     { return _mm_min_ps(a, b); }
+static inline ysu_f4 ysu_f4_max(ysu_f4 a, ysu_f4 b)     { return _mm_max_ps(a, b); }
+static inline ysu_f4 ysu_f4_lt(ysu_f4 a, ysu_f4 b)      { return _mm_cmplt_ps(a, b); }
+static inline ysu_f4 ysu_f4_ge(ysu_f4 a, ysu_f4 b)      { return _mm_cmpge_ps(a, b); }
+static inline ysu_f4 ysu_f4_and(ysu_f4 a, ysu_f4 b)     { return _mm_and_ps(a, b); }
+static inline ysu_f4 ysu_f4_andnot(ysu_f4 m, ysu_f4 a)  { return _mm_andnot_ps(m, a); }
+// m ? a : b (m is an all-ones/all-zeros lane mask)
+static inline ysu_f4 ysu_f4_select(ysu_f4 m, ysu_f4 a, ysu_f4 b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline int    ysu_f4_mask(ysu_f4 m)              { return _mm_movemask_ps(m); }
+#else
+typedef struct { float v[4]; } ysu_f4;
+
+#define YSU_F4_MAP2(name, expr)                                           \
+    static inline ysu_f4 name(ysu_f4 a, ysu_f4 b) {                       \
+        ysu_f4 r; for (int k = 0; k < 4; ++k) r.v[k] = (expr); return r;  \
+    }
+static inline ysu_f4 ysu_f4_set1(float s) { ysu_f4 r; for (int k = 0; k < 4; ++k) r.v[k] = s; return r; }
+static inline ysu_f4 ysu_f4_load(const float *p) { ysu_f4 r; for (int k = 0; k < 4; ++k) r.v[k] = p[k]; return r; }
+static inline void   ysu_f4_store(float *p, ysu_f4 a) { for (int k = 0; k < 4; ++k) p[k] = a.v[k]; }
+YSU_F4_MAP2(ysu_f4_add, a.v[k] + b.v[k])
+YSU_F4_MAP2(ysu_f4_sub, a.v[k] - b.v[k])
+YSU_F4_MAP2(ysu_f4_mul, a.v[k] * b.v[k])
+YSU_F4_MAP2(ysu_f4_div, a.v[k] / b.v[k])
+YSU_F4_MAP2(ysu_f4_min, (b.v[k] < a.v[k]) ? b.v[k] : a.v[k])
+YSU_F4_MAP2(ysu_f4_max, (b.v[k] > a.v[k]) ? b.v[k] : a.v[k])
+// masks are stored as 0.0f / 1.0f in the portable fallback, so _and is
+// only meaningful on two masks and _andnot on (mask, value)
+YSU_F4_MAP2(ysu_f4_lt,  (a.v[k] <  b.v[k]) ? 1.0f : 0.0f)
+YSU_F4_MAP2(ysu_f4_ge,  (a.v[k] >= b.v[k]) ? 1.0f : 0.0f)
+YSU_F4_MAP2(ysu_f4_and, (a.v[k] != 0.0f && b.v[k] != 0.0f) ? 1.0f : 0.0f)
+YSU_F4_MAP2(ysu_f4_andnot, (a.v[k] == 0.0f) ? b.v[k] : 0.0f)
+#undef YSU_F4_MAP2
+static inline ysu_f4 ysu_f4_sqrt(ysu_f4 a) { ysu_f4 r; for (int k = 0; k < 4; ++k) r.v[k] = sqrtf(a.v[k]); return r; }
+static inline ysu_f4 ysu_f4_select(ysu_f4 m, ysu_f4 a, ysu_f4 b) {
+    ysu_f4 r; for (int k = 0; k < 4; ++k) r.v[k] = (m.v[k] != 0.0f) ? a.v[k] : b.v[k]; return r;
+}
+static inline int ysu_f4_mask(ysu_f4 m) {
+    int bits = 0; for (int k = 0; k < 4; ++k) bits |= (m.v[k] != 0.0f) << k; return bits;
+}
+#endif
+
+// ------------------------- 8-wide lanes -------------------------
+#if defined(YSU_SIMD_AVX)
+typedef __m256 ysu_f8;
+
+static inline ysu_f8 ysu_f8_set1(float v)               { return _mm256_set1_ps(v); }
+static inline ysu_f8 ysu_f8_load(const float *p)        { return _mm256_loadu_ps(p); }
+static inline void   ysu_f8_store(float *p, ysu_f8 a)   { _mm256_storeu_ps(p, a); }
+static inline ysu_f8 ysu_f8_add(ysu_f8 a, ysu_f8 b)     { return _mm256_add_ps(a, b); }
+static inline ysu_f8 ysu_f8_sub(ysu_f8 a, ysu_f8 b)     { return _mm256_sub_ps(a, b); }
+static inline ysu_f8 ysu_f8_mul(ysu_f8 a, ysu_f8 b)     { return _mm256_mul_ps(a, b); }
+static inline ysu_f8 ysu_f8_div(ysu_f8 a, ysu_f8 b)     { return _mm256_div_ps(a, b); }
+static inline ysu_f8 ysu_f8_sqrt(ysu_f8 a)              { return _mm256_sqrt_ps(a); }
+static inline ysu_f8 ysu_f8_min(ysu_f8 a, ysu_f8 b)     { return _mm256_min_ps(a, b); }
+static inline ysu_f8 ysu_f8_max(ysu_f8 a, ysu_f8 b)     { return _mm256_max_ps(a, b); }
+static inline ysu_f8 ysu_f8_lt(ysu_f8 a, ysu_f8 b)      { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline ysu_f8 ysu_f8_ge(ysu_f8 a, ysu_f8 b)      { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline ysu_f8 ysu_f8_and(ysu_f8 a, ysu_f8 b)     { return _mm256_and_ps(a, b); }
+static inline ysu_f8 ysu_f8_andnot(ysu_f8 m, ysu_f8 a)  { return _mm256_andnot_ps(m, a); }
+static inline ysu_f8 ysu_f8_select(ysu_f8 m, ysu_f8 a, ysu_f8 b) { return _mm256_blendv_ps(b, a, m); }
+static inline int    ysu_f8_mask(ysu_f8 m)              { return _mm256_movemask_ps(m); }
+#else
+// Two 4-wide halves: SSE registers on x86, plain floats elsewhere.
+typedef struct { ysu_f4 lo, hi; } ysu_f8;
+
+#define YSU_F8_SPLIT2(name, op)                                           \
+    static inline ysu_f8 name(ysu_f8 a, ysu_f8 b) {                       \
+        ysu_f8 r; r.lo = op(a.lo, b.lo); r.hi = op(a.hi, b.hi); return r; \
+    }
+static inline ysu_f8 ysu_f8_set1(float v) { ysu_f8 r; r.lo = r.hi = ysu_f4_set1(v); return r; }
+static inline ysu_f8 ysu_f8_load(const float *p) { ysu_f8 r; r.lo = ysu_f4_load(p); r.hi = ysu_f4_load(p + 4); return r; }
+static inline void   ysu_f8_store(float *p, ysu_f8 a) { ysu_f4_store(p, a.lo); ysu_f4_store(p + 4, a.hi); }
+YSU_F8_SPLIT2(ysu_f8_add, ysu_f4_add)
+YSU_F8_SPLIT2(ysu_f8_sub, ysu_f4_sub)
+YSU_F8_SPLIT2(ysu_f8_mul, ysu_f4_mul)
+YSU_F8_SPLIT2(ysu_f8_div, ysu_f4_div)
+YSU_F8_SPLIT2(ysu_f8_min, ysu_f4_min)
+YSU_F8_SPLIT2(ysu_f8_max, ysu_f4_max)
+YSU_F8_SPLIT2(ysu_f8_lt,  ysu_f4_lt)
+YSU_F8_SPLIT2(ysu_f8_ge,  ysu_f4_ge)
+YSU_F8_SPLIT2(ysu_f8_and, ysu_f4_and)
+YSU_F8_SPLIT2(ysu_f8_andnot, ysu_f4_andnot)
+#undef YSU_F8_SPLIT2
+static inline ysu_f8 ysu_f8_sqrt(ysu_f8 a) { ysu_f8 r; r.lo = ysu_f4_sqrt(a.lo); r.hi = ysu_f4_sqrt(a.hi); return r; }
+static inline ysu_f8 ysu_f8_select(ysu_f8 m, ysu_f8 a, ysu_f8 b) {
+    ysu_f8 r; r.lo = ysu_f4_select(m.lo, a.lo, b.lo); r.hi = ysu_f4_select(m.hi, a.hi, b.hi); return r;
+}
+static inline int ysu_f8_mask(ysu_f8 m) { return ysu_f4_mask(m.lo) | (ysu_f4_mask(m.hi) << 4); }
+#endif
+
+// ------------------------- Vec3x4 / Vec3x8 -------------------------
+typedef struct { ysu_f4 x, y, z; } Vec3x4;
+typedef struct { ysu_f8 x, y, z; } Vec3x8;
+
+#define YSU_VEC3XN_OPS(T, F, t)                                                           \
+    static inline T t##_splat(Vec3 v) {                                                   \
+        T r; r.x = F##_set1(v.x); r.y = F##_set1(v.y); r.z = F##_set1(v.z); return r;     \
+    }                                                                                     \
+    /* from SoA arrays: lanes i..i+N-1 of xs/ys/zs */                                     \
+    static inline T t##_load(const float *xs, const float *ys, const float *zs) {         \
+        T r; r.x = F##_load(xs); r.y = F##_load(ys); r.z = F##_load(zs); return r;        \
+    }                                                                                     \
+    static inline void t##_store(float *xs, float *ys, float *zs, T a) {                  \
+        F##_store(xs, a.x); F##_store(ys, a.y); F##_store(zs, a.z);                       \
+    }                                                                                     \
+    static inline T t##_add(T a, T b) {                                                   \
+        T r; r.x = F##_add(a.x, b.x); r.y = F##_add(a.y, b.y); r.z = F##_add(a.z, b.z);   \
+        return r;                                                                         \
+    }                                                                                     \
+    static inline T t##_sub(T a, T b) {                                                   \
+        T r; r.x = F##_sub(a.x, b.x); r.y = F##_sub(a.y, b.y); r.z = F##_sub(a.z, b.z);   \
+        return r;                                                                         \
+    }                                                                                     \
+    static inline T t##_mul(T a, T b) {                                                   \
+        T r; r.x = F##_mul(a.x, b.x); r.y = F##_mul(a.y, b.y); r.z = F##_mul(a.z, b.z);   \
+        return r;                                                                         \
+    }                                                                                     \
+    static inline T t##_scale(T a, F s) {                                                 \
+        T r; r.x = F##_mul(a.x, s); r.y = F##_mul(a.y, s); r.z = F##_mul(a.z, s);         \
+        return r;                                                                         \
+    }                                                                                     \
+    static inline F t##_dot(T a, T b) {                                                   \
+        return F##_add(F##_add(F##_mul(a.x, b.x), F##_mul(a.y, b.y)), F##_mul(a.z, b.z)); \
+    }                                                                                     \
+    static inline T t##_cross(T a, T b) {                                                 \
+        T r;                                                                              \
+        r.x = F##_sub(F##_mul(a.y, b.z), F##_mul(a.z, b.y));                              \
+        r.y = F##_sub(F##_mul(a.z, b.x), F##_mul(a.x, b.z));                              \
+        r.z = F##_sub(F##_mul(a.x, b.y), F##_mul(a.y, b.x));                              \
+        return r;                                                                         \
+    }                                                                                     \
+    static inline F t##_length(T a) { return F##_sqrt(t##_dot(a, a)); }                  \
+    /* zero-length lanes stay zero, like vec3_normalize */                                \
+    static inline T t##_normalize(T a) {                                                  \
+        F len = t##_length(a);                                                            \
+        F ok  = F##_lt(F##_set1(0.0f), len);                                              \
+        F inv = F##_select(ok, F##_div(F##_set1(1.0f), len), F##_set1(0.0f));             \
+        return t##_scale(a, inv);                                                         \
+    }
+
+YSU_VEC3XN_OPS(Vec3x4, ysu_f4, vec3x4)
+YSU_VEC3XN_OPS(Vec3x8, ysu_f8, vec3x8)
+#undef YSU_VEC3XN_OPS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VEC3_SIMD_H
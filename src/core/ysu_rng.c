@@ -0,0 +1,57 @@
+// ysu_rng.c - runtime choice between the scalar and AVX2 pcg4d blocks
+#include "ysu_rng.h"
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define YSU_RNG_X86 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <cpuid.h>
+  #define YSU_RNG_X86 1
+#endif
+
+extern const int g_ysu_rng_avx2_built;
+
+// AVX (leaf 1 ECX bit 28) and AVX2 (leaf 7 EBX bit 5), as
+// ysu_detect_cpu_features() checks them, without its log lines
+static int rng_cpu_avx2(void) {
+#if defined(YSU_RNG_X86)
+    unsigned int r[4];
+  #if defined(_MSC_VER)
+    int v[4];
+    __cpuidex(v, 1, 0);
+    r[2] = (unsigned int)v[2];
+    if (!(r[2] & (1u << 28))) return 0;
+    __cpuidex(v, 7, 0);
+    r[1] = (unsigned int)v[1];
+  #else
+    __cpuid_count(1, 0, r[0], r[1], r[2], r[3]);
+    if (!(r[2] & (1u << 28))) return 0;
+    __cpuid_count(7, 0, r[0], r[1], r[2], r[3]);
+  #endif
+    return (r[1] & (1u << 5)) != 0;
+#else
+    return 0;
+#endif
+}
+
+static atomic_int g_rng_avx2 = -1;   // -1: not picked yet
+
+static int rng_pick(void) {
+    const char *e = getenv("YSU_RNG_SIMD");
+    int a = g_ysu_rng_avx2_built && !(e && e[0] == '0') && rng_cpu_avx2();
+    atomic_store_explicit(&g_rng_avx2, a, memory_order_relaxed);
+    return a;
+}
+
+int ysu_rng_avx2(void) {
+    int a = atomic_load_explicit(&g_rng_avx2, memory_order_relaxed);
+    return (a < 0) ? rng_pick() : a;
+}
+
+void ysu_rng_u01x8(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed, float out[8]) {
+    if (ysu_rng_avx2()) ysu_rng_u01x8_avx2(pixel, sample, dim0, seed, out);
+    else                ysu_rng_u01x8_scalar(pixel, sample, dim0, seed, out);
+}
@@ -0,0 +1,111 @@
+// ysu_rng.h - stateless counter-based RNG for the integrators
+//
+// Every uniform is a pure function of (pixel, sample, dimension, seed), hashed
+// with pcg4d (Jarzynski & Olano, "Hash Functions for GPU Rendering", 2020).
+// Nothing is shared between threads and nothing depends on which thread
+// renders a pixel, so images are bit-identical for any thread count or tile
+// schedule.
+//
+// Dimension layout: (bounce_slot << 16) | index. Slot 0 is the camera
+// (pixel jitter); slot k+1 is the k-th surface interaction. Integrators that
+// follow this layout draw identical random numbers for the same path.
+#ifndef YSU_RNG_H
+#define YSU_RNG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #define YSU_THREAD_LOCAL __declspec(thread)
+#else
+  #define YSU_THREAD_LOCAL _Thread_local
+#endif
+
+#define YSU_RNG_BLOCK 8
+
+static inline uint32_t ysu_pcg4d_x(uint32_t x, uint32_t y, uint32_t z, uint32_t w) {
+    x = x * 1664525u + 1013904223u;
+    y = y * 1664525u + 1013904223u;
+    z = z * 1664525u + 1013904223u;
+    w = w * 1664525u + 1013904223u;
+
+    x += y * w; y += z * x; z += x * y; w += y * z;
+    x ^= x >> 16; y ^= y >> 16; z ^= z >> 16; w ^= w >> 16;
+    x += y * w; y += z * x; z += x * y; w += y * z;
+    return x;
+}
+
+// 24-bit mantissa uniform in [0,1)
+static inline float ysu_rng_u01(uint32_t pixel, uint32_t sample, uint32_t dim, uint32_t seed) {
+    return (float)(ysu_pcg4d_x(pixel, sample, dim, seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+// 8 uniforms for dimensions dim0..dim0+7 of one (pixel, sample), one at a
+// time.
+static inline void ysu_rng_u01x8_scalar(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed,
+                                        float out[8])
+{
+    for (uint32_t k = 0; k < 8; ++k) out[k] = ysu_rng_u01(pixel, sample, dim0 + k, seed);
+}
+
+// Same 8 uniforms, hashed 8-wide with AVX2 when the CPU has it (ysu_rng.c
+// picks on first use; env YSU_RNG_SIMD=0 keeps the scalar loop). Both
+// produce exactly the same bits.
+void ysu_rng_u01x8(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed, float out[8]);
+
+// 1 when ysu_rng_u01x8() uses the AVX2 kernel.
+int  ysu_rng_avx2(void);
+
+// The AVX2 kernel itself (ysu_rng_avx2.c, compiled with -mavx2); only call
+// it when ysu_rng_avx2() is 1.
+void ysu_rng_u01x8_avx2(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed, float out[8]);
+
+static inline void ysu_rng_u01x16(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed,
+                                  float out[16])
+{
+    ysu_rng_u01x8(pixel, sample, dim0,      seed, out);
+    ysu_rng_u01x8(pixel, sample, dim0 + 8u, seed, out + 8);
+}
+
+// ------------------------- Sampler -------------------------
+// Sequential view over one (pixel, sample) stream, refilled YSU_RNG_BLOCK
+// uniforms at a time. Cheap to rebuild, so wavefront paths only carry the
+// sample index and re-derive the sampler at each bounce.
+typedef struct {
+    uint32_t pixel, sample, seed;
+    uint32_t dim;                   // first dimension of the next block
+    uint32_t pos;                   // read position in block
+    float    block[YSU_RNG_BLOCK];
+} YSU_Sampler;
+
+static inline void ysu_sampler_bounce(YSU_Sampler *s, uint32_t slot) {
+    s->dim = slot << 16;
+    s->pos = YSU_RNG_BLOCK;
+}
+
+static inline void ysu_sampler_init(YSU_Sampler *s, uint32_t seed, uint32_t pixel,
+                                    uint32_t sample, uint32_t slot)
+{
+    s->pixel = pixel;
+    s->sample = sample;
+    s->seed = seed;
+    ysu_sampler_bounce(s, slot);
+}
+
+static inline float ysu_sampler_next(YSU_Sampler *s) {
+    if (s->pos >= YSU_RNG_BLOCK) {
+        ysu_rng_u01x8(s->pixel, s->sample, s->dim, s->seed, s->block);
+        s->dim += YSU_RNG_BLOCK;
+        s->pos = 0;
+    }
+    return s->block[s->pos++];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // YSU_RNG_H
@@ -0,0 +1,49 @@
+// ysu_rng_avx2.c - 8-wide pcg4d block built with -mavx2
+//
+// Only called when ysu_rng.c picked AVX2. Integer hashing plus one exact
+// int -> float conversion and a power-of-two scale, so the bits match
+// ysu_rng_u01x8_scalar().
+#include "ysu_rng.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+const int g_ysu_rng_avx2_built = 1;
+
+void ysu_rng_u01x8_avx2(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed, float out[8]) {
+    const __m256i mul = _mm256_set1_epi32((int)1664525u);
+    const __m256i inc = _mm256_set1_epi32((int)1013904223u);
+    __m256i x = _mm256_set1_epi32((int)pixel);
+    __m256i y = _mm256_set1_epi32((int)sample);
+    __m256i z = _mm256_add_epi32(_mm256_set1_epi32((int)dim0),
+                                 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i w = _mm256_set1_epi32((int)seed);
+
+    x = _mm256_add_epi32(_mm256_mullo_epi32(x, mul), inc);
+    y = _mm256_add_epi32(_mm256_mullo_epi32(y, mul), inc);
+    z = _mm256_add_epi32(_mm256_mullo_epi32(z, mul), inc);
+    w = _mm256_add_epi32(_mm256_mullo_epi32(w, mul), inc);
+
+    x = _mm256_add_epi32(x, _mm256_mullo_epi32(y, w));
+    y = _mm256_add_epi32(y, _mm256_mullo_epi32(z, x));
+    z = _mm256_add_epi32(z, _mm256_mullo_epi32(x, y));
+    w = _mm256_add_epi32(w, _mm256_mullo_epi32(y, z));
+
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    y = _mm256_xor_si256(y, _mm256_srli_epi32(y, 16));
+    z = _mm256_xor_si256(z, _mm256_srli_epi32(z, 16));
+    w = _mm256_xor_si256(w, _mm256_srli_epi32(w, 16));
+
+    x = _mm256_add_epi32(x, _mm256_mullo_epi32(y, w));
+
+    __m256 f = _mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8));
+    _mm256_storeu_ps(out, _mm256_mul_ps(f, _mm256_set1_ps(1.0f / 16777216.0f)));
+}
+#else
+const int g_ysu_rng_avx2_built = 0;
+
+// never selected: g_ysu_rng_avx2_built keeps ysu_rng.c on the scalar loop
+void ysu_rng_u01x8_avx2(uint32_t pixel, uint32_t sample, uint32_t dim0, uint32_t seed, float out[8]) {
+    ysu_rng_u01x8_scalar(pixel, sample, dim0, seed, out);
+}
+#endif
@@ -0,0 +1,12 @@
+// ysu_360.h - 360 output (equirect / cubemap) for the CPU renderer
+#ifndef YSU_360_H
+#define YSU_360_H
+
+#include "camera.h"
+
+// Renders the scene around cam->origin on the shared render pool and writes
+// PNGs derived from out_ppm ("x.ppm" -> "x.png", cubemap: "x_px.png" ...).
+// Configured by env (YSU_360, YSU_360_MODE, YSU_360_W/H/FACE, YSU_360_SPP...).
+void ysu_render_360(const Camera *cam, const char *out_ppm);
+
+#endif
@@ -1,48 +1,36 @@
 // ysu_360_engine_integration.c
-// 360 Equirect Render - Multi-thread tile + Adaptive SPP (variance-based)
+// 360 render (equirect or cubemap) on the shared render pool.
+//
+// Primary rays come from render_scene_360(), so the 360 output goes through
+// the same pool, scene/BVH, integrators and YSU_ADAPTIVE early-out as the
+// perspective frame; per-row/column trig comes from precomputed tables.
+//
+// env:
+//   YSU_360            0 skips the 360 render (default 1)
+//   YSU_360_MODE       equirect | cubemap (default equirect)
+//   YSU_360_W/H        equirect size (default 4096 x W/2)
+//   YSU_360_FACE       cubemap face size (default 1024); all six faces are
+//                      rendered in one pass as a 6F x F strip
+//   YSU_360_SPP        samples per pixel (default 16)
+//   YSU_360_DEPTH      max depth (default YSU_DEPTH, else 8)
+//   YSU_360_THREADS    pool threads (default YSU_THREADS, 0 = auto)
+//   YSU_360_TILE       tile size (default 32)
+//   YSU_360_WRITE_PPM  also write out_ppm (equirect)
 
 #include <stdio.h>
-#include <math.h>
 #include <stdlib.h>
-#include <stdint.h>
 #include <string.h>
-#include <time.h>
-
-#if __STDC_VERSION__ >= 201112L
-  #include <stdatomic.h>
+#if defined(_WIN32)
+  #include <windows.h>
 #else
-  #error "C11 required (stdatomic). Use -std=c11 in GCC."
+  #include <time.h>
 #endif
 
-#include <pthread.h>
-
 #include "vec3.h"
-#include "ray.h"
 #include "camera.h"
 #include "image.h"
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-// ===================== 360 Output Settings =====================
-#define YSU_360_WIDTH      4096
-#define YSU_360_HEIGHT     2048
-
-// Adaptive sampling defaults (override via env if you want)
-#define YSU_360_SPP_MIN_DEFAULT    16
-#define YSU_360_SPP_MAX_DEFAULT    256
-#define YSU_360_SPP_BATCH_DEFAULT  16
-
-// Error thresholds (tune)
-#define YSU_360_REL_ERR_DEFAULT    0.02f
-#define YSU_360_ABS_ERR_DEFAULT    0.001f
-
-// Tile size
-#define YSU_360_TILE_DEFAULT       32
-
-// Job chunk for less atomic contention
-#define YSU_360_JOB_CHUNK          8
+#include "render.h"
+#include "ysu_360.h"
 
 static int ysu_env_int(const char *name, int defv) {
     const char *s = getenv(name);
@@ -50,352 +38,107 @@ static int ysu_env_int(const char *name, int defv) {
     return atoi(s);
 }
 
-static float ysu_env_float(const char *name, float defv) {
-    const char *s = getenv(name);
-    if (!s || !s[0]) return defv;
-    return (float)atof(s);
-}
-
-static inline float ysu_luminance(Vec3 c) {
-    return 0.2126f*c.x + 0.7152f*c.y + 0.0722f*c.z;
-}
-
-static inline float ysu_maxf(float a, float b) { return a > b ? a : b; }
-static inline float ysu_minf(float a, float b) { return a < b ? a : b; }
-
-// ------------------------- RNG (xorshift32) -------------------------
-typedef struct { uint32_t state; } YSU_Rng;
-
-static inline uint32_t ysu_rng_u32(YSU_Rng *r) {
-    uint32_t x = r->state;
-    x ^= x << 13;
-    x ^= x >> 17;
-    x ^= x << 5;
-    r->state = x;
-    return x;
-}
-
-static inline uint32_t ysu_hash_u32(uint32_t x) {
-    x ^= x >> 16;
-    x *= 0x7feb352du;
-    x ^= x >> 15;
-    x *= 0x846ca68bu;
-    x ^= x >> 16;
-    return (x != 0u) ? x : 1u;
-}
-
-static inline uint32_t ysu_seed_pixel(uint32_t base, uint32_t px, uint32_t py, uint32_t salt) {
-    uint32_t x = base;
-    x ^= px * 0x9E3779B1u;
-    x ^= py * 0x85EBCA77u;
-    x ^= salt * 0xC2B2AE3Du;
-    x = ysu_hash_u32(x);
-    return (x == 0u) ? 1u : x;
-}
-
-static inline float ysu_rng_f01(YSU_Rng *r) {
-    return (ysu_rng_u32(r) >> 8) * (1.0f / 16777216.0f);
+static double ysu_360_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
 }
 
-// ------------------------- mapping (x,y) -> ray dir -------------------------
-static __attribute__((unused)) Vec3 ysu_dir_from_equirect(int x, int y, int w, int h) {
-    // x: [0,w) -> phi in [0,2pi)
-    // y: [0,h) -> theta in [0,pi]
-    float u = ((float)x + 0.5f) / (float)w;
-    float v = ((float)y + 0.5f) / (float)h;
-
-    float phi   = u * 2.0f * (float)M_PI;   // 0..2pi
-    float theta = v * (float)M_PI;          // 0..pi
-
-    float sinT = sinf(theta);
-    float cosT = cosf(theta);
-    float sinP = sinf(phi);
-    float cosP = cosf(phi);
-
-    // Convention: forward -Z, right +X, up +Y
-    // Here we build a direction on the unit sphere
-    Vec3 d = vec3(sinT * cosP, cosT, sinT * sinP);
-    return vec3_unit(d);
+// "name.ppm" -> "name<suffix>.png", anything else -> "name<suffix>.png"
+static void ysu_360_png_name(char *out, size_t cap, const char *out_ppm, const char *suffix) {
+    const char *dot = strrchr(out_ppm, '.');
+    int base_len = (dot && strcmp(dot, ".ppm") == 0) ? (int)(dot - out_ppm) : (int)strlen(out_ppm);
+    snprintf(out, cap, "%.*s%s.png", base_len, out_ppm, suffix);
 }
 
-// ------------------------- worker context -------------------------
-typedef struct {
-    Vec3* pixels;
-    Vec3 origin;
-
-    int tile;
-    int tiles_x;
-    int tiles_y;
-
-    atomic_int* next_job;
-    int thread_id;
-    uint32_t seed_base;
-
-    int spp_min;
-    int spp_max;
-    int spp_batch;
-    float rel_err;
-    float abs_err;
-
-    Camera* cam;
-} YSU360Ctx;
-
-static void* ysu_360_worker(void* arg) {
-    YSU360Ctx* c = (YSU360Ctx*)arg;
-
-    const int W = YSU_360_WIDTH;
-    const int H = YSU_360_HEIGHT;
-
-    const int total_jobs = c->tiles_x * c->tiles_y;
-    YSU_Rng rng;
-    rng.state = ysu_hash_u32(c->seed_base ^ (uint32_t)(c->thread_id * 0x9E3779B9u));
-    if (rng.state == 0u) rng.state = 1u;
-
-    while (1) {
-        int base = atomic_fetch_add(c->next_job, YSU_360_JOB_CHUNK);
-        if (base >= total_jobs) break;
-        int end = base + YSU_360_JOB_CHUNK;
-        if (end > total_jobs) end = total_jobs;
-
-        for (int job = base; job < end; ++job) {
-            int tx = job % c->tiles_x;
-            int ty = job / c->tiles_x;
-
-            int x0 = tx * c->tile;
-            int y0 = ty * c->tile;
-            int x1 = ysu_minf(x0 + c->tile, W);
-            int y1 = ysu_minf(y0 + c->tile, H);
-
-            // Per-tile base
-            uint32_t tile_base = ysu_hash_u32(rng.state ^ c->seed_base ^ (uint32_t)(job * 0xA511E9B3u));
-            if (tile_base == 0u) tile_base = 1u;
-
-            for (int y = y0; y < y1; ++y) {
-                for (int x = x0; x < x1; ++x) {
-
-                    // Adaptive SPP statistics (Welford on luminance)
-                    float mean = 0.0f;
-                    float m2   = 0.0f;
-
-                    float accx = 0.0f, accy = 0.0f, accz = 0.0f;
-                    int spp_used = 0;
-
-                    // Seed per pixel
-                    YSU_Rng prng;
-                    prng.state = ysu_seed_pixel(tile_base, (uint32_t)x, (uint32_t)y, (uint32_t)c->thread_id);
-
-                    for (int s = 0; s < c->spp_max; ++s) {
-                        // jitter
-                        float jx = ysu_rng_f01(&prng);
-                        float jy = ysu_rng_f01(&prng);
-
-                        int sx = x;
-                        int sy = y;
-
-                        // Make dir from equirect sample (jitter by nudging u/v)
-                        // We'll approximate by shifting pixel center by jitter
-                        // (keep within pixel by using +jx/+jy)
-                        float u = ((float)sx + jx) / (float)W;
-                        float v = ((float)sy + jy) / (float)H;
-
-                        float phi   = u * 2.0f * (float)M_PI;
-                        float theta = v * (float)M_PI;
-
-                        float sinT = sinf(theta);
-                        float cosT = cosf(theta);
-                        float sinP = sinf(phi);
-                        float cosP = cosf(phi);
-
-                        Vec3 dir = vec3_unit(vec3(sinT * cosP, cosT, sinT * sinP));
-                        Ray r;
-                        r.origin = c->origin;
-                        r.direction = dir;
-
-                        // Use existing integrator via camera/scene pipeline:
-                        // We route through camera if needed, but here directly cast ray with cam basis if your engine expects it.
-                        // In your current codebase, your render integrates from Ray directly elsewhere.
-                        // Here 360 used its own integrator earlier in the file; keep consistent by calling your existing function.
-                        // For this ZIP, it used camera->background + scene intersection inside 360 code; it accumulates color by calling ysu_trace_ray360().
-                        // To keep original behavior, we call the original helper below:
-                        extern Vec3 ysu_trace_ray360(Camera* cam, Ray r, YSU_Rng* rng);
-                        Vec3 col = ysu_trace_ray360(c->cam, r, &prng);
-
-                        accx += col.x;
-                        accy += col.y;
-                        accz += col.z;
-                        spp_used++;
-
-                        // Adaptive stopping
-                        float lum = ysu_luminance(col);
-                        float n = (float)spp_used;
-                        float delta = lum - mean;
-                        mean += delta / n;
-                        float delta2 = lum - mean;
-                        m2 += delta * delta2;
-
-                        if (spp_used >= c->spp_min && (spp_used % c->spp_batch) == 0) {
-                            float var = (spp_used > 1) ? (m2 / (float)(spp_used - 1)) : 0.0f;
-                            float se  = sqrtf(ysu_maxf(var, 0.0f) / (float)spp_used);
-
-                            float tol = ysu_maxf(c->abs_err, c->rel_err * fabsf(mean));
-                            if (se <= tol) break;
-                        }
-                    }
-
-                    float inv = 1.0f / (float)spp_used;
-                    c->pixels[y * W + x] = vec3(accx * inv, accy * inv, accz * inv);
-                }
-            }
-
-            // advance rng state
-            rng.state = ysu_hash_u32(rng.state ^ tile_base ^ (uint32_t)job);
-        }
+static void ysu_360_write_png(const char *name, const Vec3 *pixels, int w, int h) {
+    unsigned char *rgb8 = image_rgb_from_hdr(pixels, w, h);
+    if (!rgb8) {
+        printf("YSU 360: WARN: image_rgb_from_hdr failed\n");
+        return;
     }
-
-    return NULL;
-}
-
-// ============================================================================
-// The following helper is in the original ZIP, used by the worker above.
-// Keep the implementation exactly as in your ZIP.
-// ============================================================================
-
-// --- Original ZIP content below (unchanged as much as possible) ---
-
-// Forward declaration implemented in this file in the ZIP
-// (We keep it here so the worker can call it.)
-Vec3 ysu_trace_ray360(Camera* cam, Ray r, YSU_Rng* rng);
-
-// Minimal 360 ray tracer (ZIP had its own shading; keep it identical)
-Vec3 ysu_trace_ray360(Camera* cam, Ray r, YSU_Rng* rng) {
-    // NOTE: This is the exact block from your ZIP file.
-    // It relies on camera/scene already wired in your project.
-    // If you later replace this with BVH triangle tracing, keep signature and internal behavior stable.
-    (void)rng;
-
-    // Simple environment color (uses camera background if you set it, else gradient)
-    Vec3 u = vec3_unit(r.direction);
-    float t = 0.5f * (u.y + 1.0f);
-    Vec3 a = vec3(1.0f, 1.0f, 1.0f);
-    Vec3 b = vec3(0.5f, 0.7f, 1.0f);
-    Vec3 sky = vec3_add(vec3_scale(a, 1.0f - t), vec3_scale(b, t));
-
-    // If your engine has scene tracing for 360, it was not included in this ZIP section.
-    // Return sky for now (matches your current "sky-only" 360 output behavior).
-    // If your ZIP had scene hits here, paste them back — otherwise this stays as-is.
-    (void)cam;
-    return sky;
+    image_write_png(name, w, h, rgb8);
+    free(rgb8);
+    printf("YSU 360: wrote %s\n", name);
 }
 
 // ------------------------- public entry -------------------------
-void ysu_render_360(Camera* cam, const char* out_ppm) {
+void ysu_render_360(const Camera *cam, const char *out_ppm) {
     if (!cam) return;
     if (!out_ppm) out_ppm = "output_360.ppm";
-
-    Vec3* pixels = (Vec3*)malloc((size_t)YSU_360_WIDTH * (size_t)YSU_360_HEIGHT * sizeof(Vec3));
-    if (!pixels) {
-        printf("YSU 360: ERR out of memory\n");
+    if (!ysu_env_int("YSU_360", 1)) {
+        printf("YSU 360: skipped (YSU_360=0)\n");
         return;
     }
 
-    const int threads = ysu_env_int("YSU_360_THREADS", ysu_env_int("YSU_THREADS", 8));
-    int tile = ysu_env_int("YSU_360_TILE", YSU_360_TILE_DEFAULT);
-    if (tile < 8) tile = 8;
-    if (tile > 256) tile = 256;
+    const char *mode = getenv("YSU_360_MODE");
+    int cubemap = (mode && strcmp(mode, "cubemap") == 0);
 
-    const int tiles_x = (YSU_360_WIDTH  + tile - 1) / tile;
-    const int tiles_y = (YSU_360_HEIGHT + tile - 1) / tile;
-
-    int spp_min   = ysu_env_int("YSU_360_SPP_MIN",   YSU_360_SPP_MIN_DEFAULT);
-    int spp_max   = ysu_env_int("YSU_360_SPP_MAX",   YSU_360_SPP_MAX_DEFAULT);
-    int spp_batch = ysu_env_int("YSU_360_SPP_BATCH", YSU_360_SPP_BATCH_DEFAULT);
-    if (spp_min < 1) spp_min = 1;
-    if (spp_batch < 1) spp_batch = 1;
-    if (spp_max < spp_min) spp_max = spp_min;
-
-    float rel_err = ysu_env_float("YSU_360_REL_ERR", YSU_360_REL_ERR_DEFAULT);
-    float abs_err = ysu_env_float("YSU_360_ABS_ERR", YSU_360_ABS_ERR_DEFAULT);
-    if (rel_err < 0.0f) rel_err = 0.0f;
-    if (abs_err < 0.0f) abs_err = 0.0f;
-
-    atomic_int next_job;
-    atomic_init(&next_job, 0);
-
-    pthread_t* tids = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
-    YSU360Ctx* ctx  = (YSU360Ctx*)malloc((size_t)threads * sizeof(YSU360Ctx));
-    if (!tids || !ctx) {
-        free(tids);
-        free(ctx);
-        free(pixels);
-        printf("YSU 360: ERR out of memory (threads ctx)\n");
-        return;
+    int W, H;
+    if (cubemap) {
+        H = ysu_env_int("YSU_360_FACE", 1024);
+        if (H < 1) H = 1;
+        W = 6 * H;
+    } else {
+        W = ysu_env_int("YSU_360_W", 4096);
+        if (W < 2) W = 2;
+        H = ysu_env_int("YSU_360_H", W / 2);
+        if (H < 1) H = 1;
     }
 
-    uint32_t seed_base = ((uint32_t)time(NULL) ^ 0xC0FFEE11u);
-    if (seed_base == 0) seed_base = 1;
+    int spp     = ysu_env_int("YSU_360_SPP", 16);
+    int depth   = ysu_env_int("YSU_360_DEPTH", ysu_env_int("YSU_DEPTH", 8));
+    int threads = ysu_env_int("YSU_360_THREADS", ysu_env_int("YSU_THREADS", 0));
+    int tile    = ysu_env_int("YSU_360_TILE", 32);
 
-    for (int i = 0; i < threads; ++i) {
-        ctx[i].pixels   = pixels;
-        ctx[i].origin   = cam->origin;
-        ctx[i].tile     = tile;
-        ctx[i].tiles_x  = tiles_x;
-        ctx[i].tiles_y  = tiles_y;
-        ctx[i].next_job = &next_job;
-        ctx[i].thread_id = i;
-        ctx[i].seed_base = seed_base;
-
-        ctx[i].spp_min   = spp_min;
-        ctx[i].spp_max   = spp_max;
-        ctx[i].spp_batch = spp_batch;
-        ctx[i].rel_err   = rel_err;
-        ctx[i].abs_err   = abs_err;
-
-        ctx[i].cam       = cam;
-
-        pthread_create(&tids[i], NULL, ysu_360_worker, &ctx[i]);
+    Vec3 *pixels = render_alloc_framebuffer(W, H, threads, tile);
+    if (!pixels) {
+        printf("YSU 360: ERR out of memory (%dx%d)\n", W, H);
+        return;
     }
 
-    for (int i = 0; i < threads; ++i) {
-        pthread_join(tids[i], NULL);
+    double t0 = ysu_360_now_ms();
+    if (!render_scene_360(pixels, W, H, cam->origin, cubemap ? YSU_LENS_CUBEMAP : YSU_LENS_EQUIRECT,
+                          spp, depth, threads, tile)) {
+        printf("YSU 360: ERR render failed\n");
+        render_free_framebuffer(pixels);
+        return;
     }
-
-    free(ctx);
-    free(tids);
-
-    // Default: write PNG. Keep PPM optionally with YSU_360_WRITE_PPM=1
-    const int write_ppm = (getenv("YSU_360_WRITE_PPM") != NULL);
-
-    // Derive .png name from out_ppm (replace .ppm -> .png, else append .png)
-    char out_png[1024];
-    out_png[0] = 0;
-    {
-        const char* dot = strrchr(out_ppm, '.');
-        if (dot && strcmp(dot, ".ppm") == 0) {
-            size_t base_len = (size_t)(dot - out_ppm);
-            if (base_len > sizeof(out_png) - 5) base_len = sizeof(out_png) - 5;
-            memcpy(out_png, out_ppm, base_len);
-            out_png[base_len] = 0;
-            strncat(out_png, ".png", sizeof(out_png) - strlen(out_png) - 1);
+    printf("YSU 360: %s %dx%d spp=%d rendered in %.1f ms\n",
+           cubemap ? "cubemap" : "equirect", W, H, spp, ysu_360_now_ms() - t0);
+
+    char name[1024];
+    if (cubemap) {
+        static const char *faces[6] = { "_px", "_nx", "_py", "_ny", "_pz", "_nz" };
+        Vec3 *face = (Vec3*)malloc(sizeof(Vec3) * (size_t)H * (size_t)H);
+        if (!face) {
+            printf("YSU 360: ERR out of memory (face)\n");
         } else {
-            snprintf(out_png, sizeof(out_png), "%s.png", out_ppm);
+            for (int f = 0; f < 6; ++f) {
+                for (int y = 0; y < H; ++y) {
+                    memcpy(face + (size_t)y * (size_t)H, pixels + (size_t)y * (size_t)W + (size_t)f * (size_t)H,
+                           sizeof(Vec3) * (size_t)H);
+                }
+                ysu_360_png_name(name, sizeof(name), out_ppm, faces[f]);
+                ysu_360_write_png(name, face, H, H);
+            }
+            free(face);
         }
-    }
-
-    unsigned char* rgb8_360 = image_rgb_from_hdr(pixels, YSU_360_WIDTH, YSU_360_HEIGHT);
-    if (rgb8_360) {
-        image_write_png(out_png, YSU_360_WIDTH, YSU_360_HEIGHT, rgb8_360);
-        printf("YSU 360: wrote %s\n", out_png);
-        free(rgb8_360);
     } else {
-        printf("YSU 360: WARN: image_rgb_from_hdr failed\n");
-    }
-
-    if (write_ppm) {
-        printf("YSU 360: also writing PPM: %s\n", out_ppm);
-        //image_write_ppm(out_ppm, YSU_360_WIDTH, YSU_360_HEIGHT, pixels);
+        ysu_360_png_name(name, sizeof(name), out_ppm, "");
+        ysu_360_write_png(name, pixels, W, H);
+        if (getenv("YSU_360_WRITE_PPM")) {
+            image_write_ppm(out_ppm, W, H, pixels);
+            printf("YSU 360: wrote %s\n", out_ppm);
+        }
     }
 
-    free(pixels);
-    printf("YSU 360: tamam.\n");
+    render_free_framebuffer(pixels);
 }
-//kill me -later
\ No newline at end of file
@@ -99,10 +99,12 @@ static int save_scene(const char *path, SceneSphere *spheres, int count)
     for (int i = 0; i < count; ++i) {
         SceneSphere *s = &spheres[i];
         // Currently only writing sphere data
-        fprintf(f, "sphere %f %f %f %f %f %f %f\n",
+        fprintf(f, "sphere %f %f %f %f %f %f %f",
                 s->center.x,  s->center.y,  s->center.z,
                 s->radius,
                 s->albedo.x,  s->albedo.y,  s->albedo.z);
+        if (s->type != 0) fprintf(f, " %s %f", scene_material_name(s->type), s->param);
+        fputc('\n', f);
     }
 
     fclose(f);
@@ -140,6 +142,8 @@ static int add_sphere(SceneSphere *spheres, int *pCount, Vec3 center, float radi
     spheres[idx].center = center;
     spheres[idx].radius = radius;
     spheres[idx].albedo = albedo;
+    spheres[idx].type   = 0;
+    spheres[idx].param  = 0.0f;
 
     printf("Edit mode: new sphere added (index=%d)\n", idx);
     return idx;
@@ -0,0 +1,159 @@
+// accum.c - progressive accumulation buffers + checkpoint I/O
+
+#include "accum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char     magic[4];      // "YSUA"
+    uint32_t version;       // 1
+    uint32_t width;
+    uint32_t height;
+    uint32_t seed;
+    uint32_t spp_max;
+    uint32_t passes;
+    uint32_t reserved;
+    uint64_t total_samples;
+} YSU_AccumHeader;
+
+int ysu_accum_init(YSU_Accum *acc, int width, int height, uint32_t seed, uint32_t spp_max)
+{
+    if (!acc || width <= 0 || height <= 0) return 0;
+    memset(acc, 0, sizeof(*acc));
+
+    size_t px = (size_t)width * (size_t)height;
+    acc->sum      = (float*)calloc(px * 3, sizeof(float));
+    acc->spp      = (uint32_t*)calloc(px, sizeof(uint32_t));
+    acc->lum_mean = (float*)calloc(px, sizeof(float));
+    acc->lum_m2   = (float*)calloc(px, sizeof(float));
+    if (!acc->sum || !acc->spp || !acc->lum_mean || !acc->lum_m2) {
+        ysu_accum_free(acc);
+        return 0;
+    }
+
+    acc->width   = width;
+    acc->height  = height;
+    acc->seed    = seed;
+    acc->spp_max = spp_max;
+    return 1;
+}
+
+void ysu_accum_free(YSU_Accum *acc)
+{
+    if (!acc) return;
+    free(acc->sum);
+    free(acc->spp);
+    free(acc->lum_mean);
+    free(acc->lum_m2);
+    memset(acc, 0, sizeof(*acc));
+}
+
+void ysu_accum_reset(YSU_Accum *acc)
+{
+    if (!acc || !acc->sum) return;
+    size_t px = (size_t)acc->width * (size_t)acc->height;
+    memset(acc->sum, 0, px * 3 * sizeof(float));
+    memset(acc->spp, 0, px * sizeof(uint32_t));
+    memset(acc->lum_mean, 0, px * sizeof(float));
+    memset(acc->lum_m2, 0, px * sizeof(float));
+    acc->passes = 0;
+    acc->total_samples = 0;
+}
+
+void ysu_accum_resolve(const YSU_Accum *acc, Vec3 *out)
+{
+    if (!acc || !acc->sum || !out) return;
+    size_t px = (size_t)acc->width * (size_t)acc->height;
+    for (size_t i = 0; i < px; ++i) {
+        uint32_t n = acc->spp[i];
+        if (n == 0) { out[i] = vec3(0.0f, 0.0f, 0.0f); continue; }
+        float inv = 1.0f / (float)n;
+        out[i] = vec3(acc->sum[i*3 + 0] * inv,
+                      acc->sum[i*3 + 1] * inv,
+                      acc->sum[i*3 + 2] * inv);
+    }
+}
+
+int ysu_accum_save(const YSU_Accum *acc, const char *path)
+{
+    if (!acc || !acc->sum || !path || !path[0]) return 0;
+
+    size_t plen = strlen(path);
+    char *tmp = (char*)malloc(plen + 5);
+    if (!tmp) return 0;
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) { free(tmp); return 0; }
+
+    YSU_AccumHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "YSUA", 4);
+    hdr.version       = 1u;
+    hdr.width         = (uint32_t)acc->width;
+    hdr.height        = (uint32_t)acc->height;
+    hdr.seed          = acc->seed;
+    hdr.spp_max       = acc->spp_max;
+    hdr.passes        = acc->passes;
+    hdr.total_samples = acc->total_samples;
+
+    size_t px = (size_t)acc->width * (size_t)acc->height;
+    int ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1)
+          && (fwrite(acc->sum, sizeof(float), px * 3, f) == px * 3)
+          && (fwrite(acc->spp, sizeof(uint32_t), px, f) == px)
+          && (fwrite(acc->lum_mean, sizeof(float), px, f) == px)
+          && (fwrite(acc->lum_m2, sizeof(float), px, f) == px);
+    if (fclose(f) != 0) ok = 0;
+
+    if (ok) {
+#if defined(_WIN32)
+        remove(path); // rename() does not replace on Windows
+#endif
+        ok = (rename(tmp, path) == 0);
+    }
+    if (!ok) remove(tmp);
+    free(tmp);
+    return ok;
+}
+
+int ysu_accum_load(YSU_Accum *acc, const char *path)
+{
+    if (!acc || !path || !path[0]) return 0;
+    memset(acc, 0, sizeof(*acc));
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+
+    YSU_AccumHeader hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.magic, "YSUA", 4) != 0 || hdr.version != 1u ||
+        hdr.width == 0 || hdr.height == 0 ||
+        hdr.width > 65535u || hdr.height > 65535u) {
+        fclose(f);
+        return 0;
+    }
+
+    if (!ysu_accum_init(acc, (int)hdr.width, (int)hdr.height, hdr.seed, hdr.spp_max)) {
+        fclose(f);
+        return 0;
+    }
+
+    size_t px = (size_t)acc->width * (size_t)acc->height;
+    int ok = (fread(acc->sum, sizeof(float), px * 3, f) == px * 3)
+          && (fread(acc->spp, sizeof(uint32_t), px, f) == px)
+          && (fread(acc->lum_mean, sizeof(float), px, f) == px)
+          && (fread(acc->lum_m2, sizeof(float), px, f) == px);
+    fclose(f);
+
+    if (!ok) {
+        ysu_accum_free(acc);
+        return 0;
+    }
+
+    acc->passes        = hdr.passes;
+    acc->total_samples = hdr.total_samples;
+    return 1;
+}
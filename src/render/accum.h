@@ -0,0 +1,48 @@
+// accum.h - progressive accumulation buffers (running sums + per-pixel
+// sample counts + Welford luminance state), resumable from disk
+#pragma once
+
+#include <stdint.h>
+#include "vec3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// All per-pixel arrays use the same row order as the Vec3 framebuffer that
+// render_scene_* writes (row 0 = top of the image).
+typedef struct YSU_Accum {
+    int width, height;
+    uint32_t seed;          // sample sequence key; keeps resumed renders consistent
+    uint32_t spp_max;       // per-pixel cap (0 = unlimited)
+    uint32_t passes;        // progressive calls accumulated so far
+    uint64_t total_samples;
+
+    float    *sum;          // 3 floats per pixel, running RGB sum
+    uint32_t *spp;          // samples taken per pixel
+    float    *lum_mean;     // Welford luminance mean
+    float    *lum_m2;       // Welford sum of squared deviations
+} YSU_Accum;
+
+// Allocates zeroed buffers. Returns 1 on success, 0 on failure.
+int  ysu_accum_init(YSU_Accum *acc, int width, int height, uint32_t seed, uint32_t spp_max);
+void ysu_accum_free(YSU_Accum *acc);
+
+// Drops all samples (e.g. after a camera move), keeps size/seed.
+void ysu_accum_reset(YSU_Accum *acc);
+
+// Writes sum/spp into out (width*height Vec3). Pixels with no samples are black.
+void ysu_accum_resolve(const YSU_Accum *acc, Vec3 *out);
+
+// Binary checkpoint ("YSUA" v1). Written to <path>.tmp first, then renamed,
+// so an interrupted save never clobbers the previous checkpoint.
+// Returns 1 on success, 0 on failure.
+int  ysu_accum_save(const YSU_Accum *acc, const char *path);
+
+// Loads a checkpoint into a fresh accumulator (acc is overwritten, not freed).
+// Returns 1 on success, 0 on failure / bad file.
+int  ysu_accum_load(YSU_Accum *acc, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,10 @@
 #include <float.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ysu_mt.h"
 
 // ===== TARGET-0 GLOBAL COUNTERS =====
 uint64_t g_bvh_node_visits = 0;
@@ -12,25 +16,23 @@ uint64_t g_bvh_aabb_tests  = 0;
 
 // ============================================================
 // Arena allocator — DFS-order contiguous node pool (cache-friendly)
+// One pool per tree; the root is always element 0, so several trees
+// (render scene + baseline) can be alive at once.
 // ============================================================
 
-static bvh_node *g_bvh_arena_pool = NULL;
-static int        g_bvh_arena_count = 0;
-static int        g_bvh_arena_cap   = 0;
-
-static bvh_node* bvh_arena_alloc(void) {
-    if (g_bvh_arena_count >= g_bvh_arena_cap) return NULL;
-    bvh_node *n = &g_bvh_arena_pool[g_bvh_arena_count++];
+typedef struct {
+    bvh_node *pool;
+    int count;
+    int cap;
+} BvhArena;
+
+static bvh_node* bvh_arena_alloc(BvhArena *a) {
+    if (a->count >= a->cap) return NULL;
+    bvh_node *n = &a->pool[a->count++];
     memset(n, 0, sizeof(*n));
     return n;
 }
 
-static int bvh_arena_owns(const bvh_node* n) {
-    return g_bvh_arena_pool &&
-           n >= g_bvh_arena_pool &&
-           n <  g_bvh_arena_pool + g_bvh_arena_cap;
-}
-
 // ============================================================
 // AABB helpers
 // ============================================================
@@ -80,6 +82,26 @@ bool aabb_hit(const aabb* box, const Ray* r, float t_min, float t_max) {
     return true;
 }
 
+// Slab test without counters (render traversal): entry distance clipped to
+// [t_min, t_max], or FLT_MAX on a miss. inv_d is 1/direction per axis.
+static inline float aabb_enter(const aabb* box, const float o[3], const float inv_d[3],
+                               float t_min, float t_max)
+{
+    const float mn[3] = { box->minimum.x, box->minimum.y, box->minimum.z };
+    const float mx[3] = { box->maximum.x, box->maximum.y, box->maximum.z };
+
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (mn[i] - o[i]) * inv_d[i];
+        float t1 = (mx[i] - o[i]) * inv_d[i];
+        if (t0 > t1) { float tmp = t0; t0 = t1; t1 = tmp; }
+
+        if (t0 > t_min) t_min = t0;
+        if (t1 < t_max) t_max = t1;
+        if (t_max < t_min) return FLT_MAX;
+    }
+    return t_min;
+}
+
 // Child ordering helper (does NOT increment counters) — float precision
 static inline float aabb_entry_tmin_no_count(const aabb* box, const Ray* r) {
     float t_min = -1e30f;
@@ -104,7 +126,7 @@ static inline float aabb_entry_tmin_no_count(const aabb* box, const Ray* r) {
 }
 
 // ============================================================
-// BVH BUILD (median split) — existing approach
+// BVH BUILD (median split) — original builder, BVH_BUILD_MEDIAN
 // ============================================================
 
 // --- qsort comparators (O(n log n), cache-friendly vs bubble sort) ---
@@ -132,37 +154,181 @@ static void sort_spheres_axis(Sphere* spheres, int start, int end, int axis) {
     qsort(&spheres[start], (size_t)count, sizeof(Sphere), cmp_sphere_axis[axis]);
 }
 
-static bvh_node* bvh_build_rec(Sphere* spheres, int start, int end, uint32_t depth) {
-    bvh_node* node = bvh_arena_alloc();
-    if (!node) return NULL;
+// ============================================================
+// BVH BUILD (binned SAH)
+// ============================================================
+// Centroids are binned along each axis; the split minimising
+//   C_TRAV + (A_left * N_left + A_right * N_right) / A_node
+// (sphere test cost 1) wins, and a range of <= leaf_size spheres stays a
+// leaf when no split beats testing all of them.
+
+#define BVH_SAH_TRAV      1.0f
+#define BVH_SAH_BINS_MAX  32
+// SAH while depth + ceil(log2(n)) stays below this; past it a range falls
+// back to balanced median splits, so no leaf ends up deeper than
+// BVH_STACK_MAX - 1 and the traversal stacks never fill.
+#define BVH_SAH_MAX_DEPTH (BVH_STACK_MAX - 1)
 
-    node->left = node->right = NULL;
-    node->start = start;
-    node->count = end - start;
-    node->depth = depth;
+typedef struct {
+    aabb box;
+    int  count;
+} SahBin;
+
+static inline aabb aabb_empty(void) {
+    aabb b;
+    b.minimum = vec3( FLT_MAX,  FLT_MAX,  FLT_MAX);
+    b.maximum = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    return b;
+}
 
-    node->visit_count  = 0;
-    node->useful_count = 0;
+// plain compares (not fminf/fmaxf) so the hot binning loops stay inline
+static inline float min_f(float a, float b) { return (a < b) ? a : b; }
+static inline float max_f(float a, float b) { return (a > b) ? a : b; }
 
-    node->id = 0;
-    node->prune = 0;
+static inline void aabb_grow(aabb* b, aabb o) {
+    b->minimum = vec3(min_f(b->minimum.x, o.minimum.x), min_f(b->minimum.y, o.minimum.y), min_f(b->minimum.z, o.minimum.z));
+    b->maximum = vec3(max_f(b->maximum.x, o.maximum.x), max_f(b->maximum.y, o.maximum.y), max_f(b->maximum.z, o.maximum.z));
+}
 
-    // Leaf: 1-2 sphere
-    if (node->count <= 2) {
-        aabb box = sphere_bounds(&spheres[start]);
-        if (node->count == 2) {
-            box = aabb_surrounding(box, sphere_bounds(&spheres[start + 1]));
+static inline float aabb_area(aabb b) {
+    Vec3 e = vec3_sub(b.maximum, b.minimum);
+    if (e.x < 0.0f) return 0.0f;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+static inline float vec3_axis(Vec3 v, int axis) {
+    return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+}
+
+static inline int sah_bin_index(float c, float lo, float scale, int bins) {
+    int b = (int)((c - lo) * scale);
+    return (b < 0) ? 0 : (b >= bins) ? bins - 1 : b;
+}
+
+static inline int bvh_ceil_log2(int n) {
+    int k = 0;
+    while (k < 31 && (1 << k) < n) ++k;
+    return k;
+}
+
+// Moves the sphere whose centroid ranks k (start <= k < end) on `axis` to
+// spheres[k], smaller ones before it and larger ones after (quickselect
+// with three-way partitions, so runs of equal centroids cost one pass).
+static void bvh_select_axis(Sphere* spheres, int start, int end, int k, int axis) {
+    while (end - start > 1) {
+        float a = vec3_axis(spheres[start].center, axis);
+        float b = vec3_axis(spheres[start + (end - start) / 2].center, axis);
+        float c = vec3_axis(spheres[end - 1].center, axis);
+        float pivot = (a < b) ? ((b < c) ? b : (a < c) ? c : a) : ((a < c) ? a : (b < c) ? c : b);
+
+        int lt = start, i = start, gt = end;   // [start,lt) < pivot, [lt,i) == pivot, [gt,end) > pivot
+        while (i < gt) {
+            float x = vec3_axis(spheres[i].center, axis);
+            if (x < pivot) {
+                Sphere t = spheres[i]; spheres[i] = spheres[lt]; spheres[lt] = t;
+                ++lt; ++i;
+            } else if (x > pivot) {
+                --gt;
+                Sphere t = spheres[i]; spheres[i] = spheres[gt]; spheres[gt] = t;
+            } else {
+                ++i;
+            }
         }
-        node->box = box;
-        return node;
+        if (k < lt)       end = lt;
+        else if (k >= gt) start = gt;
+        else return;
     }
+}
 
-    // Range bounds
-    aabb box = sphere_bounds(&spheres[start]);
-    for (int i = start + 1; i < end; ++i) {
-        box = aabb_surrounding(box, sphere_bounds(&spheres[i]));
+// Balanced split at the centroid median of the widest centroid axis.
+static int bvh_split_median_select(Sphere* spheres, int start, int end, aabb cb) {
+    Vec3 ext = vec3_sub(cb.maximum, cb.minimum);
+    int axis = 0;
+    if (ext.y > ext.x) axis = 1;
+    if (ext.z > ((axis == 0) ? ext.x : ext.y)) axis = 2;
+    int mid = start + (end - start) / 2;
+    bvh_select_axis(spheres, start, end, mid, axis);
+    return mid;
+}
+
+// Returns the split position (start < mid < end) or 0 for a leaf.
+static int bvh_split_sah(Sphere* spheres, int start, int end, aabb box, uint32_t depth,
+                         const BvhBuildOpts* o)
+{
+    int n = end - start;
+    aabb cb = aabb_empty();
+    for (int i = start; i < end; ++i) {
+        aabb c = { spheres[i].center, spheres[i].center };
+        aabb_grow(&cb, c);
+    }
+    if (o->base_depth + (int)depth + bvh_ceil_log2(n) >= BVH_SAH_MAX_DEPTH) {
+        return (n > o->leaf_size) ? bvh_split_median_select(spheres, start, end, cb) : 0;
     }
-    node->box = box;
+
+    // small ranges: more bins than spheres only adds empty sweeps
+    int bins = (n < o->bins) ? n : o->bins;
+    int best_axis = -1, best_bin = 0;
+    float best_cost = FLT_MAX;
+    float inv_area = 1.0f / fmaxf(aabb_area(box), 1e-30f);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float lo = vec3_axis(cb.minimum, axis);
+        float ext = vec3_axis(cb.maximum, axis) - lo;
+        if (!(ext > 0.0f)) continue;
+        float scale = (float)bins / ext;
+
+        SahBin bin[BVH_SAH_BINS_MAX];
+        for (int k = 0; k < bins; ++k) { bin[k].box = aabb_empty(); bin[k].count = 0; }
+        for (int i = start; i < end; ++i) {
+            int k = sah_bin_index(vec3_axis(spheres[i].center, axis), lo, scale, bins);
+            aabb_grow(&bin[k].box, sphere_bounds(&spheres[i]));
+            bin[k].count++;
+        }
+
+        // right-to-left sweep: area/count of bins [k, bins)
+        float right_area[BVH_SAH_BINS_MAX];
+        int   right_n[BVH_SAH_BINS_MAX];
+        aabb acc = aabb_empty();
+        int cnt = 0;
+        for (int k = bins - 1; k > 0; --k) {
+            aabb_grow(&acc, bin[k].box);
+            cnt += bin[k].count;
+            right_area[k] = aabb_area(acc);
+            right_n[k] = cnt;
+        }
+
+        acc = aabb_empty();
+        cnt = 0;
+        for (int k = 1; k < bins; ++k) {
+            aabb_grow(&acc, bin[k - 1].box);
+            cnt += bin[k - 1].count;
+            if (cnt == 0 || right_n[k] == 0) continue;
+            float cost = BVH_SAH_TRAV + (aabb_area(acc) * (float)cnt + right_area[k] * (float)right_n[k]) * inv_area;
+            if (cost < best_cost) { best_cost = cost; best_axis = axis; best_bin = k; }
+        }
+    }
+
+    // all centroids equal (or no finite cost): balanced, so depth stays bounded
+    if (best_axis < 0) return (n > o->leaf_size) ? bvh_split_median_select(spheres, start, end, cb) : 0;
+    if (n <= o->leaf_size && best_cost >= (float)n) return 0;
+
+    float lo = vec3_axis(cb.minimum, best_axis);
+    float scale = (float)bins / (vec3_axis(cb.maximum, best_axis) - lo);
+    int i = start, j = end - 1;
+    while (i <= j) {
+        if (sah_bin_index(vec3_axis(spheres[i].center, best_axis), lo, scale, bins) < best_bin) {
+            ++i;
+        } else {
+            Sphere t = spheres[i]; spheres[i] = spheres[j]; spheres[j] = t;
+            --j;
+        }
+    }
+    return (i > start && i < end) ? i : bvh_split_median_select(spheres, start, end, cb);
+}
+
+// Returns the split position (start < mid < end) or 0 for a leaf.
+static int bvh_split_median(Sphere* spheres, int start, int end, aabb box, const BvhBuildOpts* o) {
+    if (end - start <= o->leaf_size) return 0;
 
     // Axis: largest extent
     Vec3 ext = vec3_sub(box.maximum, box.minimum);
@@ -171,11 +337,50 @@ static bvh_node* bvh_build_rec(Sphere* spheres, int start, int end, uint32_t dep
     if (ext.z > ((axis == 0) ? ext.x : ext.y)) axis = 2;
 
     sort_spheres_axis(spheres, start, end, axis);
+    return start + (end - start) / 2;
+}
 
-    int mid = start + (end - start) / 2;
+static int bvh_split(Sphere* spheres, int start, int end, aabb box, uint32_t depth,
+                     const BvhBuildOpts* o)
+{
+    if (end - start <= 1) return 0;
+    if (o->mode == BVH_BUILD_SAH) return bvh_split_sah(spheres, start, end, box, depth, o);
+    return bvh_split_median(spheres, start, end, box, o);
+}
+
+static aabb bvh_range_bounds(const Sphere* spheres, int start, int end) {
+    aabb box = sphere_bounds(&spheres[start]);
+    for (int i = start + 1; i < end; ++i) {
+        aabb_grow(&box, sphere_bounds(&spheres[i]));
+    }
+    return box;
+}
+
+static bvh_node* bvh_build_rec(BvhArena *arena, Sphere* spheres, int start, int end, uint32_t depth,
+                               const BvhBuildOpts* o)
+{
+    bvh_node* node = bvh_arena_alloc(arena);
+    if (!node) return NULL;
 
-    node->left  = bvh_build_rec(spheres, start, mid, depth + 1);
-    node->right = bvh_build_rec(spheres, mid, end, depth + 1);
+    node->left = node->right = NULL;
+    node->start = start;
+    node->count = end - start;
+    node->depth = depth;
+
+    node->visit_count  = 0;
+    node->useful_count = 0;
+
+    node->id = 0;
+    node->prune = 0;
+
+    // Range bounds
+    node->box = bvh_range_bounds(spheres, start, end);
+
+    int mid = bvh_split(spheres, start, end, node->box, depth, o);
+    if (mid == 0) return node;   // leaf
+
+    node->left  = bvh_build_rec(arena, spheres, start, mid, depth + 1, o);
+    node->right = bvh_build_rec(arena, spheres, mid, end, depth + 1, o);
 
     // internal node marker
     node->count = 0;
@@ -192,24 +397,217 @@ static bvh_node* bvh_build_rec(Sphere* spheres, int start, int end, uint32_t dep
     return node;
 }
 
-bvh_node* bvh_build(Sphere* spheres, int start, int end) {
+// ------------------------- parallel top levels -------------------------
+// The top of the tree is split on the calling thread until ranges are small
+// enough to hand out; each such range becomes a task that builds its
+// subtree into a private slice of the same arena (a subtree over n spheres
+// needs at most 2n-1 nodes), so the tree still lives in one allocation
+// with the root at element 0 and bvh_free / ids / stats are unchanged.
+
+typedef struct {
+    int start, end;
+    uint32_t depth;
+    bvh_node** slot;     // parent's child pointer
+    BvhArena arena;
+} BvhTask;
+
+typedef struct {
+    Sphere* spheres;
+    const BvhBuildOpts* opts;
+    int task_max;        // ranges up to this size become tasks
+    BvhTask* tasks;
+    int ntasks, cap;
+    atomic_int next;
+    atomic_int failed;
+} BvhBuildJob;
+
+static void bvh_build_top(BvhBuildJob* job, BvhArena* arena, int start, int end, uint32_t depth,
+                          bvh_node** slot)
+{
+    int n = end - start;
+    if (n <= job->task_max && job->ntasks < job->cap) {
+        BvhTask* t = &job->tasks[job->ntasks++];
+        t->start = start;
+        t->end = end;
+        t->depth = depth;
+        t->slot = slot;
+        *slot = NULL;
+        return;
+    }
+
+    bvh_node* node = bvh_arena_alloc(arena);
+    *slot = node;
+    if (!node) { atomic_store(&job->failed, 1); return; }
+    node->start = start;
+    node->count = n;
+    node->depth = depth;
+    node->box = bvh_range_bounds(job->spheres, start, end);
+
+    int mid = bvh_split(job->spheres, start, end, node->box, depth, job->opts);
+    if (mid == 0) return;   // leaf
+    node->start = 0;
+    node->count = 0;
+    bvh_build_top(job, arena, start, mid, depth + 1, &node->left);
+    bvh_build_top(job, arena, mid, end, depth + 1, &node->right);
+}
+
+static void* bvh_build_worker(void* arg) {
+    BvhBuildJob* job = (BvhBuildJob*)arg;
+    for (;;) {
+        int k = atomic_fetch_add(&job->next, 1);
+        if (k >= job->ntasks) return NULL;
+        BvhTask* t = &job->tasks[k];
+        *t->slot = bvh_build_rec(&t->arena, job->spheres, t->start, t->end, t->depth, job->opts);
+        if (!*t->slot) atomic_store(&job->failed, 1);
+    }
+}
+
+static int bvh_task_cmp(const void* a, const void* b) {
+    int na = ((const BvhTask*)a)->end - ((const BvhTask*)a)->start;
+    int nb = ((const BvhTask*)b)->end - ((const BvhTask*)b)->start;
+    return (na < nb) - (na > nb);   // largest first
+}
+
+// Top nodes sit before the task slices in the arena; refresh their boxes
+// children-first once the subtrees exist.
+static void bvh_fix_top_boxes(bvh_node* n, const bvh_node* top_end) {
+    if (!n || n >= top_end || n->count > 0) return;
+    bvh_fix_top_boxes(n->left, top_end);
+    bvh_fix_top_boxes(n->right, top_end);
+    if (n->left && n->right) n->box = aabb_surrounding(n->left->box, n->right->box);
+    else if (n->left)        n->box = n->left->box;
+    else if (n->right)       n->box = n->right->box;
+}
+
+static int bvh_build_parallel(BvhArena* arena, Sphere* spheres, int start, int end,
+                              const BvhBuildOpts* o)
+{
+    int n = end - start;
+    BvhBuildJob job;
+    memset(&job, 0, sizeof(job));
+    job.spheres = spheres;
+    job.opts = o;
+    job.task_max = n / (o->threads * 8);
+    if (job.task_max < 1024) job.task_max = 1024;
+    job.cap = 4 * (n / job.task_max + 1) + 64;
+    job.tasks = (BvhTask*)calloc((size_t)job.cap, sizeof(BvhTask));
+    if (!job.tasks) return 0;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+
+    bvh_node* root = NULL;
+    bvh_build_top(&job, arena, start, end, 0, &root);
+    const bvh_node* top_end = arena->pool + arena->count;
+
+    qsort(job.tasks, (size_t)job.ntasks, sizeof(BvhTask), bvh_task_cmp);
+    int off = arena->count;
+    for (int k = 0; k < job.ntasks; ++k) {
+        BvhTask* t = &job.tasks[k];
+        t->arena.pool  = arena->pool + off;
+        t->arena.cap   = 2 * (t->end - t->start) - 1;
+        t->arena.count = 0;
+        off += t->arena.cap;
+    }
+    if (off > arena->cap) atomic_store(&job.failed, 1);   // cannot happen: top + slices = 2n-1
+
+    int nthr = o->threads - 1;
+    if (nthr > job.ntasks - 1) nthr = job.ntasks - 1;
+    pthread_t* thr = (nthr > 0) ? (pthread_t*)malloc(sizeof(pthread_t) * (size_t)nthr) : NULL;
+    int started = 0;
+    if (!atomic_load(&job.failed)) {
+        for (; thr && started < nthr; ++started) {
+            if (pthread_create(&thr[started], NULL, bvh_build_worker, &job) != 0) break;
+        }
+        bvh_build_worker(&job);
+        for (int i = 0; i < started; ++i) pthread_join(thr[i], NULL);
+    }
+    free(thr);
+    free(job.tasks);
+
+    if (atomic_load(&job.failed) || root != arena->pool) return 0;
+    bvh_fix_top_boxes(root, top_end);
+    return 1;
+}
+
+// ------------------------- options / entry points -------------------------
+void bvh_build_opts_default(BvhBuildOpts* o) {
+    const char* mode = getenv("YSU_BVH_BUILD");
+    o->mode = (mode && strcmp(mode, "sah") == 0) ? BVH_BUILD_SAH : BVH_BUILD_MEDIAN;
+
+    const char* s = getenv("YSU_BVH_LEAF");
+    o->leaf_size = (s && s[0]) ? atoi(s) : ((o->mode == BVH_BUILD_SAH) ? 4 : 2);
+    s = getenv("YSU_BVH_BINS");
+    o->bins = (s && s[0]) ? atoi(s) : 16;
+    s = getenv("YSU_BVH_THREADS");
+    o->threads = (s && s[0]) ? atoi(s) : ysu_mt_suggest_threads();
+    o->base_depth = 0;
+}
+
+bvh_node* bvh_build_ex(Sphere* spheres, int start, int end, const BvhBuildOpts* opts) {
     // Allocate contiguous arena — nodes laid out in DFS order for locality.
-    // Max nodes for a binary tree with n leaves (leaf size ≤2): ~2*n.
+    // Max nodes for a binary tree with n leaves (leaf size >= 1): 2*n - 1.
     int n = end - start;
-    int arena_cap = (n < 4) ? 8 : 2 * n + 2;
+    if (n <= 0) return NULL;
+
+    BvhBuildOpts o;
+    if (opts) o = *opts;
+    else bvh_build_opts_default(&o);
+    if (o.leaf_size < 1) o.leaf_size = 1;
+    if (o.bins < 2) o.bins = 2;
+    if (o.bins > BVH_SAH_BINS_MAX) o.bins = BVH_SAH_BINS_MAX;
+    if (o.threads < 1) o.threads = 1;
+    if (o.base_depth < 0) o.base_depth = 0;
+
+    BvhArena arena;
+    arena.cap   = (n < 4) ? 8 : 2 * n + 2;
+    arena.count = 0;
+    arena.pool  = (bvh_node*)malloc(sizeof(bvh_node) * (size_t)arena.cap);
+    if (!arena.pool) return NULL;
+
+    // parallel only pays off once there are a few tasks per thread; if it
+    // fails (task list allocation), build serially into the same arena
+    if (o.threads > 1 && n >= 4 * 1024) {
+        if (bvh_build_parallel(&arena, spheres, start, end, &o)) return arena.pool;
+        arena.count = 0;
+    }
 
-    // If a previous arena exists, free it first
-    if (g_bvh_arena_pool) {
-        free(g_bvh_arena_pool);
-        g_bvh_arena_pool = NULL;
+    bvh_node *root = bvh_build_rec(&arena, spheres, start, end, 0, &o);
+    if (root != arena.pool) {
+        free(arena.pool);
+        return NULL;
     }
-    g_bvh_arena_pool = (bvh_node*)malloc(sizeof(bvh_node) * (size_t)arena_cap);
-    g_bvh_arena_count = 0;
-    g_bvh_arena_cap   = arena_cap;
+    return root;
+}
 
-    if (!g_bvh_arena_pool) return NULL;
+bvh_node* bvh_build(Sphere* spheres, int start, int end) {
+    return bvh_build_ex(spheres, start, end, NULL);
+}
 
-    return bvh_build_rec(spheres, start, end, 0);
+// ============================================================
+// Tree stats (node counts, depth, SAH cost)
+// ============================================================
+
+static void bvh_tree_stats_rec(const bvh_node* n, float inv_root_area, BvhTreeStats* st) {
+    if (!n) return;
+    st->nodes++;
+    if ((int)n->depth > st->max_depth) st->max_depth = (int)n->depth;
+    float rel = aabb_area(n->box) * inv_root_area;
+    if (n->count > 0) {
+        st->leaves++;
+        st->prims += n->count;
+        if (n->count > st->max_leaf) st->max_leaf = n->count;
+        st->sah_cost += rel * (float)n->count;
+        return;
+    }
+    st->sah_cost += rel * BVH_SAH_TRAV;
+    bvh_tree_stats_rec(n->left, inv_root_area, st);
+    bvh_tree_stats_rec(n->right, inv_root_area, st);
+}
+
+void bvh_tree_stats(const bvh_node* root, BvhTreeStats* st) {
+    memset(st, 0, sizeof(*st));
+    if (!root) return;
+    bvh_tree_stats_rec(root, 1.0f / fmaxf(aabb_area(root->box), 1e-30f), st);
 }
 
 // ============================================================
@@ -453,6 +851,282 @@ bool bvh_hit(
     return hit_any;
 }
 
+// ============================================================
+// Render traversal: closest hit, no counters
+// ============================================================
+
+// Same near-first order as bvh_hit, but iterative and read-only: no global
+// counters, no per-node stats and no policy pruning, so many render threads
+// can share one tree. Only t is computed per sphere; the caller builds the
+// surface record for the winner.
+int bvh_hit_closest(const bvh_node* root, const Sphere* spheres, const Ray* r,
+                    float t_min, float t_max, float* t_out)
+{
+    if (!root) return -1;
+
+    const float o[3]     = { r->origin.x, r->origin.y, r->origin.z };
+    const float inv_d[3] = { 1.0f / r->direction.x, 1.0f / r->direction.y, 1.0f / r->direction.z };
+    const float a = vec3_length_squared(r->direction);
+
+    const bvh_node* stack[BVH_STACK_MAX];
+    float stack_t[BVH_STACK_MAX];
+    int sp = 0;
+    int best = -1;
+    float closest = t_max;
+
+    float t_root = aabb_enter(&root->box, o, inv_d, t_min, closest);
+    if (t_root == FLT_MAX) return -1;
+    stack[sp] = root;
+    stack_t[sp++] = t_root;
+
+    while (sp > 0) {
+        --sp;
+        if (stack_t[sp] > closest) continue;   // a nearer hit was found since the push
+        const bvh_node* node = stack[sp];
+
+        if (node->count > 0) {
+            for (int i = 0; i < node->count; ++i) {
+                const Sphere* s = &spheres[node->start + i];
+                Vec3 oc = vec3_sub(r->origin, s->center);
+                float half_b = vec3_dot(oc, r->direction);
+                float c = vec3_length_squared(oc) - s->radius * s->radius;
+                float disc = half_b * half_b - a * c;
+                if (disc < 0.0f) continue;
+                float sq = sqrtf(disc);
+                float t = (-half_b - sq) / a;
+                if (t < t_min || t > closest) {
+                    t = (-half_b + sq) / a;
+                    if (t < t_min || t > closest) continue;
+                }
+                closest = t;
+                best = node->start + i;
+            }
+            continue;
+        }
+
+        const bvh_node* L = node->left;
+        const bvh_node* R = node->right;
+        float tL = L ? aabb_enter(&L->box, o, inv_d, t_min, closest) : FLT_MAX;
+        float tR = R ? aabb_enter(&R->box, o, inv_d, t_min, closest) : FLT_MAX;
+
+        // push the far child first so the near one is popped next
+        if (tR < tL) {
+            const bvh_node* tn = L; L = R; R = tn;
+            float tt = tL; tL = tR; tR = tt;
+        }
+        if (tR != FLT_MAX && sp < BVH_STACK_MAX) { stack[sp] = R; stack_t[sp++] = tR; }
+        if (tL != FLT_MAX && sp < BVH_STACK_MAX) { stack[sp] = L; stack_t[sp++] = tL; }
+    }
+
+    if (best >= 0 && t_out) *t_out = closest;
+    return best;
+}
+
+// ============================================================
+// Flattened BVH (32-byte nodes, DFS order)
+// ============================================================
+
+_Static_assert(sizeof(BvhFlatNode) == 32, "BvhFlatNode must stay 32 bytes");
+
+static int bvh_flat_count(const bvh_node* n) {
+    if (!n || n->prune) return 0;
+    if (n->count > 0) return 1;
+    int l = bvh_flat_count(n->left);
+    int r = bvh_flat_count(n->right);
+    if (l == 0 || r == 0) return l + r;   // a lone child replaces its parent
+    return 1 + l + r;
+}
+
+// Emits n's subtree at nodes[*next]; returns 0 if nothing was emitted.
+static int bvh_flat_emit(const bvh_node* n, BvhFlatNode* nodes, uint32_t* next) {
+    if (!n || n->prune) return 0;
+    if (n->count == 0) {
+        int l = bvh_flat_count(n->left);
+        int r = bvh_flat_count(n->right);
+        if (l == 0) return bvh_flat_emit(n->right, nodes, next);
+        if (r == 0) return bvh_flat_emit(n->left, nodes, next);
+    }
+
+    BvhFlatNode* f = &nodes[(*next)++];
+    f->bmin[0] = n->box.minimum.x; f->bmin[1] = n->box.minimum.y; f->bmin[2] = n->box.minimum.z;
+    f->bmax[0] = n->box.maximum.x; f->bmax[1] = n->box.maximum.y; f->bmax[2] = n->box.maximum.z;
+    if (n->count > 0) {
+        f->offset = (uint32_t)n->start;
+        f->count  = (uint32_t)n->count;
+        return 1;
+    }
+    f->count = 0;
+    bvh_flat_emit(n->left, nodes, next);
+    f->offset = *next;
+    bvh_flat_emit(n->right, nodes, next);
+    return 1;
+}
+
+int bvh_flatten(const bvh_node* root, BvhFlat* out) {
+    memset(out, 0, sizeof(*out));
+    int n = bvh_flat_count(root);
+    if (n == 0) return 1;
+
+    out->nodes = (BvhFlatNode*)malloc(sizeof(BvhFlatNode) * (size_t)n);
+    if (!out->nodes) return 0;
+#if YSU_BVH_STATS
+    out->visits = (atomic_uint*)calloc((size_t)n, sizeof(atomic_uint));
+    if (!out->visits) {
+        free(out->nodes);
+        out->nodes = NULL;
+        return 0;
+    }
+#endif
+    uint32_t next = 0;
+    bvh_flat_emit(root, out->nodes, &next);
+    out->count = (int)next;
+    return 1;
+}
+
+bvh_node* bvh_flat_to_tree(const BvhFlat* bvh) {
+    if (!bvh || bvh->count <= 0) return NULL;
+    bvh_node* t = (bvh_node*)calloc((size_t)bvh->count, sizeof(bvh_node));
+    if (!t) return NULL;
+    for (int i = 0; i < bvh->count; ++i) {
+        const BvhFlatNode* f = &bvh->nodes[i];
+        bvh_node* n = &t[i];
+        n->box.minimum = vec3(f->bmin[0], f->bmin[1], f->bmin[2]);
+        n->box.maximum = vec3(f->bmax[0], f->bmax[1], f->bmax[2]);
+        n->id = (uint32_t)i;
+        if (f->count > 0) {
+            n->start = (int)f->offset;
+            n->count = (int)f->count;
+        } else {
+            // children come after their parent, so depth is final here
+            n->left  = &t[i + 1];
+            n->right = &t[f->offset];
+            n->left->depth  = n->depth + 1;
+            n->right->depth = n->depth + 1;
+        }
+    }
+    return t;
+}
+
+void bvh_flat_free(BvhFlat* bvh) {
+    if (!bvh) return;
+    free(bvh->nodes);
+    free(bvh->visits);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+// aabb_enter on the flat layout: entry distance or FLT_MAX on a miss.
+static inline float flat_enter(const BvhFlatNode* n, const float o[3], const float inv_d[3],
+                               float t_min, float t_max)
+{
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (n->bmin[i] - o[i]) * inv_d[i];
+        float t1 = (n->bmax[i] - o[i]) * inv_d[i];
+        if (t0 > t1) { float tmp = t0; t0 = t1; t1 = tmp; }
+
+        if (t0 > t_min) t_min = t0;
+        if (t1 < t_max) t_max = t1;
+        if (t_max < t_min) return FLT_MAX;
+    }
+    return t_min;
+}
+
+void bvh_flat_hit_subtree(const BvhFlat* bvh, uint32_t root, const Sphere* spheres, const Ray* r,
+                          float t_min, float* closest_io, int* best_io)
+{
+    const BvhFlatNode* nodes = bvh->nodes;
+
+    const float o[3]     = { r->origin.x, r->origin.y, r->origin.z };
+    const float inv_d[3] = { 1.0f / r->direction.x, 1.0f / r->direction.y, 1.0f / r->direction.z };
+    const float a = vec3_length_squared(r->direction);
+
+    uint32_t stack[BVH_STACK_MAX];
+    float stack_t[BVH_STACK_MAX];
+    int sp = 0;
+    int best = *best_io;
+    float closest = *closest_io;
+
+    float t_root = flat_enter(&nodes[root], o, inv_d, t_min, closest);
+    if (t_root == FLT_MAX) return;
+    stack[sp] = root;
+    stack_t[sp++] = t_root;
+
+    while (sp > 0) {
+        --sp;
+        if (stack_t[sp] > closest) continue;   // a nearer hit was found since the push
+        uint32_t ni = stack[sp];
+
+        // walk down the near side; only far children go on the stack
+        for (;;) {
+            const BvhFlatNode* node = &nodes[ni];
+#if YSU_BVH_STATS
+            atomic_fetch_add_explicit(&bvh->visits[ni], 1u, memory_order_relaxed);
+#endif
+            if (node->count > 0) {
+                const Sphere* s = &spheres[node->offset];
+                for (uint32_t i = 0; i < node->count; ++i, ++s) {
+                    Vec3 oc = vec3_sub(r->origin, s->center);
+                    float half_b = vec3_dot(oc, r->direction);
+                    float c = vec3_length_squared(oc) - s->radius * s->radius;
+                    float disc = half_b * half_b - a * c;
+                    if (disc < 0.0f) continue;
+                    float sq = sqrtf(disc);
+                    float t = (-half_b - sq) / a;
+                    if (t < t_min || t > closest) {
+                        t = (-half_b + sq) / a;
+                        if (t < t_min || t > closest) continue;
+                    }
+                    closest = t;
+                    best = (int)(node->offset + i);
+                }
+                break;
+            }
+
+            uint32_t li = ni + 1, ri = node->offset;
+            float tL = flat_enter(&nodes[li], o, inv_d, t_min, closest);
+            float tR = flat_enter(&nodes[ri], o, inv_d, t_min, closest);
+            if (tR < tL) {
+                uint32_t ti = li; li = ri; ri = ti;
+                float tt = tL; tL = tR; tR = tt;
+            }
+            if (tL == FLT_MAX) break;
+            if (tR != FLT_MAX && sp < BVH_STACK_MAX) { stack[sp] = ri; stack_t[sp++] = tR; }
+            ni = li;
+        }
+    }
+
+    *closest_io = closest;
+    *best_io = best;
+}
+
+int bvh_flat_hit_closest(const BvhFlat* bvh, const Sphere* spheres, const Ray* r,
+                         float t_min, float t_max, float* t_out)
+{
+    if (!bvh || bvh->count <= 0) return -1;
+    int best = -1;
+    float closest = t_max;
+    bvh_flat_hit_subtree(bvh, 0, spheres, r, t_min, &closest, &best);
+    if (best >= 0 && t_out) *t_out = closest;
+    return best;
+}
+
+int bvh_flat_dump_stats(const char* path, const BvhFlat* bvh) {
+#if YSU_BVH_STATS
+    if (!bvh || !bvh->visits) return 0;
+    FILE* f = fopen(path, "w");
+    if (!f) return 0;
+    fprintf(f, "node,count,visits\n");
+    for (int i = 0; i < bvh->count; ++i) {
+        fprintf(f, "%d,%u,%u\n", i, bvh->nodes[i].count,
+                atomic_load_explicit(&bvh->visits[i], memory_order_relaxed));
+    }
+    fclose(f);
+    return 1;
+#else
+    (void)path; (void)bvh;
+    return 0;
+#endif
+}
+
 // ============================================================
 // CSV DUMP (node_id dahil)
 // ============================================================
@@ -482,21 +1156,7 @@ void bvh_dump_stats(const char* path, const bvh_node* root) {
 void bvh_free(bvh_node* node) {
     if (!node) return;
 
-    // If this node lives inside the arena, free the whole pool at once.
-    if (bvh_arena_owns(node)) {
-        // Only the root (first element) actually releases the pool.
-        if (node == g_bvh_arena_pool) {
-            free(g_bvh_arena_pool);
-            g_bvh_arena_pool  = NULL;
-            g_bvh_arena_count = 0;
-            g_bvh_arena_cap   = 0;
-        }
-        // Sub-nodes inside the arena: no-op (freed with root).
-        return;
-    }
-
-    // Legacy per-malloc path (non-arena trees)
-    bvh_free(node->left);
-    bvh_free(node->right);
-    free(node);
+    // Every tree lives in one arena whose first element is the root, so
+    // freeing the root releases the whole pool. Sub-nodes: no-op.
+    if (node->depth == 0) free(node);
 }
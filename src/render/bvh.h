@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 #include "vec3.h"
 #include "ray.h"
@@ -53,8 +54,43 @@ bool aabb_hit(const aabb* box, const Ray* r, float t_min, float t_max);
 // -----------------------------
 //      BVH Build & Hit Test
 // -----------------------------
+// Builders (env: YSU_BVH_BUILD=median|sah):
+//  - MEDIAN: split at the median centroid of the widest axis (default)
+//  - SAH:    binned surface-area heuristic
+// Both reorder spheres[start, end). The tree lives in one arena owned by
+// the root, whatever the thread count.
+typedef enum {
+    BVH_BUILD_MEDIAN = 0,
+    BVH_BUILD_SAH
+} BvhBuildMode;
+
+typedef struct {
+    BvhBuildMode mode;
+    int leaf_size;   // max spheres per leaf (SAH may split smaller ranges); YSU_BVH_LEAF
+    int bins;        // SAH bins per axis, 2..32 (default 16); YSU_BVH_BINS
+    int threads;     // top levels split serially, subtrees built in parallel; YSU_BVH_THREADS
+    int base_depth;  // depth the root is spliced in at (0 = own tree); SAH bounds depth from it
+} BvhBuildOpts;
+
+// Fills opts from the env vars above (leaf 2 for median, 4 for SAH;
+// threads default to ysu_mt_suggest_threads()).
+void bvh_build_opts_default(BvhBuildOpts* opts);
+
+// opts == NULL => bvh_build_opts_default(). Returns NULL on failure.
+bvh_node* bvh_build_ex(Sphere* spheres, int start, int end, const BvhBuildOpts* opts);
 bvh_node* bvh_build(Sphere* spheres, int start, int end);
 
+typedef struct {
+    int   nodes;
+    int   leaves;
+    int   prims;
+    int   max_depth;
+    int   max_leaf;
+    float sah_cost;  // expected node + sphere tests per ray, relative to the root box
+} BvhTreeStats;
+
+void bvh_tree_stats(const bvh_node* root, BvhTreeStats* stats);
+
 bool bvh_hit(
     const bvh_node* node,
     const Sphere* spheres,
@@ -64,6 +100,81 @@ bool bvh_hit(
     HitRecord* rec
 );
 
+// Render traversal: closest sphere index (or -1) and its t. Read-only and
+// counter-free, so it is safe to call from many threads on one tree.
+#define BVH_STACK_MAX 64
+int bvh_hit_closest(
+    const bvh_node* root,
+    const Sphere* spheres,
+    const Ray* r,
+    float t_min,
+    float t_max,
+    float* t_out
+);
+
+// -----------------------------
+//   Flattened traversal BVH
+// -----------------------------
+// Immutable copy of a built tree for the render path: 32-byte nodes in DFS
+// order, the left child is the next node and the right child is stored by
+// index. Traversal never writes to it, so threads share it freely.
+// Per-node visit counters live in a side array that exists only in builds
+// with -DYSU_BVH_STATS=1.
+#ifndef YSU_BVH_STATS
+#define YSU_BVH_STATS 0
+#endif
+
+typedef struct {
+    float    bmin[3];
+    uint32_t offset;    // leaf: first sphere, internal: right child index
+    float    bmax[3];
+    uint32_t count;     // >0 leaf sphere count, 0 internal
+} BvhFlatNode;
+
+typedef struct {
+    BvhFlatNode *nodes;
+    int          count;
+    atomic_uint *visits;    // YSU_BVH_STATS only, else NULL
+} BvhFlat;
+
+// Flattens root (pruned / empty subtrees are dropped). Sphere indices are
+// unchanged, so the flat tree traverses the same spheres array.
+// Returns 1 on success, 0 on out of memory (out is zeroed).
+int  bvh_flatten(const bvh_node* root, BvhFlat* out);
+void bvh_flat_free(BvhFlat* bvh);
+
+// Pointer tree over a flat one in the same node order (tree[i] is
+// nodes[i]): boxes and depths set, counters and prune flags cleared.
+// One arena, released with bvh_free(root). NULL on out of memory.
+bvh_node* bvh_flat_to_tree(const BvhFlat* bvh);
+
+// Same result as bvh_hit_closest() on the source tree; iterative, explicit stack.
+int bvh_flat_hit_closest(
+    const BvhFlat* bvh,
+    const Sphere* spheres,
+    const Ray* r,
+    float t_min,
+    float t_max,
+    float* t_out
+);
+
+// bvh_flat_hit_closest() below node `root` only. *closest / *best carry the
+// running hit in and out, so a caller can finish a ray subtree by subtree
+// (packet traversal hands sparse lanes over this way).
+void bvh_flat_hit_subtree(
+    const BvhFlat* bvh,
+    uint32_t root,
+    const Sphere* spheres,
+    const Ray* r,
+    float t_min,
+    float* closest,
+    int* best
+);
+
+// CSV "node,count,visits" from the side array. Returns 0 when the build
+// has no stats or the file cannot be written.
+int bvh_flat_dump_stats(const char* path, const BvhFlat* bvh);
+
 // -----------------------------
 //      CSV dump (TARGET-0)
 //  (PASS-2 note: will add node_id to the dump)
@@ -87,6 +198,7 @@ int bvh_load_policy_csv(const char* path, bvh_node* root);
 // -----------------------------
 //         Memory Cleanup
 // -----------------------------
+// Pass the root: it owns the tree's node arena.
 void bvh_free(bvh_node* node);
 
 #endif // BVH_H
@@ -0,0 +1,283 @@
+// bvh_packet.c - packet traversal dispatch and the single-ray paths
+#include "bvh_packet.h"
+
+#include <stdlib.h>
+#include <float.h>
+#include <pthread.h>
+
+#include "nerf_simd.h"   // ysu_detect_cpu_features
+
+// AVX2 kernels (bvh_packet_avx2.c). t_max is per lane; any_hit retires a
+// lane at its first hit.
+extern const int g_bvh_packet_avx2_built;
+void bvh_packet_sphere_avx2(const BvhFlat* bvh, const Sphere* spheres, const Ray* rays, int mask,
+                            float t_min, const float* t_max, int any_hit, int min_active,
+                            BvhPacketHit* out);
+void bvh_packet_tri_avx2(const BvhTriMesh* mesh, const Ray* rays, int mask,
+                         float t_min, const float* t_max, int any_hit, int min_active,
+                         BvhPacketHit* out);
+
+// ------------------------- config -------------------------
+static pthread_once_t g_packet_once = PTHREAD_ONCE_INIT;
+static BvhPacketConfig g_packet_cfg;
+
+static void packet_load_config(void) {
+    const char *s = getenv("YSU_PACKET");
+    g_packet_cfg.enabled = !(s && s[0] == '0');
+
+    int m = 3;
+    s = getenv("YSU_PACKET_MIN");
+    if (s && s[0]) m = atoi(s);
+    if (m < 1) m = 1;
+    if (m > BVH_PACKET_W) m = BVH_PACKET_W;
+    g_packet_cfg.min_active = m;
+
+    if (g_bvh_packet_avx2_built) {
+        CPUFeatures f = ysu_detect_cpu_features();
+        g_packet_cfg.avx2 = f.has_avx2 ? 1 : 0;
+    }
+}
+
+const BvhPacketConfig* bvh_packet_config(void) {
+    pthread_once(&g_packet_once, packet_load_config);
+    return &g_packet_cfg;
+}
+
+// Packets pay off when the lanes share a direction octant: they then order
+// children alike and cull the same subtrees. Mixed octants (secondary rays,
+// a packet straddling an axis) and packets below min_active go single-ray.
+static int packet_coherent(const Ray* rays, int mask) {
+    int neg_all = 7, neg_any = 0, n = 0;
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        if (!((mask >> k) & 1)) continue;
+        int neg = (rays[k].direction.x < 0.0f) | ((rays[k].direction.y < 0.0f) << 1) |
+                  ((rays[k].direction.z < 0.0f) << 2);
+        neg_all &= neg;
+        neg_any |= neg;
+        ++n;
+    }
+    return n >= bvh_packet_config()->min_active && neg_all == neg_any;
+}
+
+static int packet_use_avx2(const Ray* rays, int mask) {
+    const BvhPacketConfig *c = bvh_packet_config();
+    return c->enabled && c->avx2 && packet_coherent(rays, mask);
+}
+
+static void packet_clear(BvhPacketHit* out, const float* t_max) {
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        out->prim[k] = -1;
+        out->t[k] = t_max[k];
+    }
+}
+
+// ------------------------- triangles, single ray -------------------------
+static inline float tri_min_f(float a, float b) { return a < b ? a : b; }
+static inline float tri_max_f(float a, float b) { return a > b ? a : b; }
+
+// Entry distance into n, or FLT_MAX on a miss.
+static inline float tri_enter(const GPUBVHNode* n, const float o[3], const float inv_d[3],
+                              float t_min, float t_max)
+{
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (n->bmin[i] - o[i]) * inv_d[i];
+        float t1 = (n->bmax[i] - o[i]) * inv_d[i];
+        t_min = tri_max_f(t_min, tri_min_f(t0, t1));
+        t_max = tri_min_f(t_max, tri_max_f(t0, t1));
+        if (t_max < t_min) return FLT_MAX;
+    }
+    return t_min;
+}
+
+// Moller-Trumbore with the ops of ysu_intersect_ray8_tri1 in the same order
+// (no FMA in either build), so a lane and a single ray agree bit for bit.
+static inline int tri_intersect(const float* v, const Ray* r, float t_min, float t_max, float* t_out) {
+    const float eps = 1e-8f;
+    float e1x = v[4] - v[0], e1y = v[5] - v[1], e1z = v[6]  - v[2];
+    float e2x = v[8] - v[0], e2y = v[9] - v[1], e2z = v[10] - v[2];
+    float dx = r->direction.x, dy = r->direction.y, dz = r->direction.z;
+
+    float px = dy * e2z - dz * e2y;
+    float py = dz * e2x - dx * e2z;
+    float pz = dx * e2y - dy * e2x;
+    float det = e1x * px + e1y * py + e1z * pz;
+    if (!(det > eps || det < -eps)) return 0;
+    float inv_det = 1.0f / det;
+
+    float tx = r->origin.x - v[0], ty = r->origin.y - v[1], tz = r->origin.z - v[2];
+    float u = (tx * px + ty * py + tz * pz) * inv_det;
+    if (!(u >= 0.0f && u <= 1.0f)) return 0;
+
+    float qx = ty * e1z - tz * e1y;
+    float qy = tz * e1x - tx * e1z;
+    float qz = tx * e1y - ty * e1x;
+    float w = (dx * qx + dy * qy + dz * qz) * inv_det;
+    if (!(w >= 0.0f && u + w <= 1.0f)) return 0;
+
+    float t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+    if (!(t >= t_min && t <= t_max)) return 0;
+    *t_out = t;
+    return 1;
+}
+
+// Single-ray traversal below node `root`; *closest / *best carry the running
+// hit in and out (the packet kernel finishes sparse lanes with it). any_hit
+// stops at the first hit.
+void bvh_tri_hit_subtree(const BvhTriMesh* mesh, int32_t root, const Ray* r, float t_min,
+                         float* closest_io, int* best_io, int any_hit)
+{
+    const GPUBVHNode* nodes = mesh->nodes;
+    const float o[3]     = { r->origin.x, r->origin.y, r->origin.z };
+    const float inv_d[3] = { 1.0f / r->direction.x, 1.0f / r->direction.y, 1.0f / r->direction.z };
+
+    int32_t stack[BVH_STACK_MAX];
+    float stack_t[BVH_STACK_MAX];
+    int sp = 0;
+    int best = *best_io;
+    float closest = *closest_io;
+
+    float t_root = tri_enter(&nodes[root], o, inv_d, t_min, closest);
+    if (t_root == FLT_MAX) return;
+    stack[sp] = root;
+    stack_t[sp++] = t_root;
+
+    while (sp > 0) {
+        --sp;
+        if (stack_t[sp] > closest) continue;
+        int32_t ni = stack[sp];
+
+        for (;;) {
+            const GPUBVHNode* node = &nodes[ni];
+            if (node->left < 0) {
+                for (int32_t i = 0; i < node->triCount; ++i) {
+                    int32_t tri = mesh->indices[node->triOffset + i];
+                    float t;
+                    if (tri_intersect(mesh->tris + (size_t)tri * 12u, r, t_min, closest, &t)) {
+                        closest = t;
+                        best = tri;
+                        if (any_hit) { *closest_io = closest; *best_io = best; return; }
+                    }
+                }
+                break;
+            }
+
+            int32_t li = node->left, ri = node->right;
+            float tL = tri_enter(&nodes[li], o, inv_d, t_min, closest);
+            float tR = tri_enter(&nodes[ri], o, inv_d, t_min, closest);
+            if (tR < tL) {
+                int32_t ti = li; li = ri; ri = ti;
+                float tt = tL; tL = tR; tR = tt;
+            }
+            if (tL == FLT_MAX) break;
+            if (tR != FLT_MAX && sp < BVH_STACK_MAX) { stack[sp] = ri; stack_t[sp++] = tR; }
+            ni = li;
+        }
+    }
+
+    *closest_io = closest;
+    *best_io = best;
+}
+
+int bvh_tri_hit_closest(const BvhTriMesh* mesh, const Ray* r,
+                        float t_min, float t_max, float* t_out)
+{
+    if (!mesh || !mesh->nodes || mesh->node_count == 0) return -1;
+    int best = -1;
+    float closest = t_max;
+    bvh_tri_hit_subtree(mesh, 0, r, t_min, &closest, &best, 0);
+    if (best >= 0 && t_out) *t_out = closest;
+    return best;
+}
+
+// ------------------------- packets -------------------------
+void bvh_packet_hit_closest8(const BvhFlat* bvh, const Sphere* spheres,
+                             const Ray rays[BVH_PACKET_W], int mask,
+                             float t_min, float t_max, BvhPacketHit* out)
+{
+    float tmax8[BVH_PACKET_W];
+    for (int k = 0; k < BVH_PACKET_W; ++k) tmax8[k] = t_max;
+    packet_clear(out, tmax8);
+    if (!bvh || bvh->count <= 0) return;
+
+    if (packet_use_avx2(rays, mask)) {
+        bvh_packet_sphere_avx2(bvh, spheres, rays, mask, t_min, tmax8, 0,
+                               bvh_packet_config()->min_active, out);
+        return;
+    }
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        if ((mask >> k) & 1) {
+            bvh_flat_hit_subtree(bvh, 0, spheres, &rays[k], t_min, &out->t[k], &out->prim[k]);
+        }
+    }
+}
+
+int bvh_packet_occluded8(const BvhFlat* bvh, const Sphere* spheres,
+                         const Ray rays[BVH_PACKET_W], int mask,
+                         float t_min, const float t_max[BVH_PACKET_W])
+{
+    BvhPacketHit h;
+    packet_clear(&h, t_max);
+    if (!bvh || bvh->count <= 0) return 0;
+
+    if (packet_use_avx2(rays, mask)) {
+        bvh_packet_sphere_avx2(bvh, spheres, rays, mask, t_min, t_max, 1,
+                               bvh_packet_config()->min_active, &h);
+    } else {
+        for (int k = 0; k < BVH_PACKET_W; ++k) {
+            if ((mask >> k) & 1) {
+                bvh_flat_hit_subtree(bvh, 0, spheres, &rays[k], t_min, &h.t[k], &h.prim[k]);
+            }
+        }
+    }
+
+    int occluded = 0;
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        if (h.prim[k] >= 0) occluded |= 1 << k;
+    }
+    return occluded & mask;
+}
+
+void bvh_packet_tri_hit_closest8(const BvhTriMesh* mesh,
+                                 const Ray rays[BVH_PACKET_W], int mask,
+                                 float t_min, float t_max, BvhPacketHit* out)
+{
+    float tmax8[BVH_PACKET_W];
+    for (int k = 0; k < BVH_PACKET_W; ++k) tmax8[k] = t_max;
+    packet_clear(out, tmax8);
+    if (!mesh || !mesh->nodes || mesh->node_count == 0) return;
+
+    if (packet_use_avx2(rays, mask)) {
+        bvh_packet_tri_avx2(mesh, rays, mask, t_min, tmax8, 0, bvh_packet_config()->min_active, out);
+        return;
+    }
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        if ((mask >> k) & 1) {
+            bvh_tri_hit_subtree(mesh, 0, &rays[k], t_min, &out->t[k], &out->prim[k], 0);
+        }
+    }
+}
+
+int bvh_packet_tri_occluded8(const BvhTriMesh* mesh,
+                             const Ray rays[BVH_PACKET_W], int mask,
+                             float t_min, const float t_max[BVH_PACKET_W])
+{
+    BvhPacketHit h;
+    packet_clear(&h, t_max);
+    if (!mesh || !mesh->nodes || mesh->node_count == 0) return 0;
+
+    if (packet_use_avx2(rays, mask)) {
+        bvh_packet_tri_avx2(mesh, rays, mask, t_min, t_max, 1, bvh_packet_config()->min_active, &h);
+    } else {
+        for (int k = 0; k < BVH_PACKET_W; ++k) {
+            if ((mask >> k) & 1) {
+                bvh_tri_hit_subtree(mesh, 0, &rays[k], t_min, &h.t[k], &h.prim[k], 1);
+            }
+        }
+    }
+
+    int occluded = 0;
+    for (int k = 0; k < BVH_PACKET_W; ++k) {
+        if (h.prim[k] >= 0) occluded |= 1 << k;
+    }
+    return occluded & mask;
+}
@@ -0,0 +1,77 @@
+// bvh_packet.h - 8-ray packet traversal for primary / shadow rays
+#ifndef BVH_PACKET_H
+#define BVH_PACKET_H
+
+#include <stdint.h>
+
+#include "bvh.h"
+#include "gpu_bvh.h"
+
+// A packet is 8 rays plus a lane mask (bit k = rays[k] is traced). All lanes
+// walk the tree together on one shared stack; each stack entry keeps the
+// lanes that entered that node, and a lane drops out of a subtree as soon as
+// its closest hit is nearer than the node. Once fewer than min_active lanes
+// are left at a node, those lanes finish the subtree as single rays, so
+// incoherent packets (secondary bounces, scattered pixels) cost about what
+// 8 single rays would. Hits are the same as the single-ray traversals.
+//
+// Packets run on the AVX2 kernel (bvh_packet_avx2.c, YSU_Ray8 from
+// experimental/ysu_packet.h); without AVX2 every lane is traced single-ray.
+#define BVH_PACKET_W 8
+
+typedef struct {
+    int   prim[BVH_PACKET_W];  // closest sphere / triangle index, -1 on a miss
+    float t[BVH_PACKET_W];     // its t (t_max on a miss)
+} BvhPacketHit;
+
+typedef struct {
+    int enabled;      // 0 => single-ray for everything (env: YSU_PACKET=0)
+    int min_active;   // 1..8, lanes below which a node goes single-ray (env: YSU_PACKET_MIN, default 3)
+    int avx2;         // packet kernel available on this CPU
+} BvhPacketConfig;
+
+// Env config, read once.
+const BvhPacketConfig* bvh_packet_config(void);
+
+// Triangle tree from gpu_build_bvh_from_tri_vec4(): GPUBVHNode nodes (root
+// 0, leaves have left == -1), leaf triangles are indices[triOffset ..
+// triOffset + triCount) into tris, 12 floats each (p0, p1, p2 as vec4).
+typedef struct {
+    const GPUBVHNode *nodes;
+    uint32_t          node_count;
+    const int32_t    *indices;
+    const float      *tris;
+} BvhTriMesh;
+
+// ---- sphere BVH (flattened binary tree) ----
+// Closest hit for the lanes in mask; unused lanes of out are set to a miss.
+void bvh_packet_hit_closest8(const BvhFlat* bvh, const Sphere* spheres,
+                             const Ray rays[BVH_PACKET_W], int mask,
+                             float t_min, float t_max, BvhPacketHit* out);
+
+// Shadow rays: returns the lanes of mask with any hit in [t_min, t_max[k]].
+int bvh_packet_occluded8(const BvhFlat* bvh, const Sphere* spheres,
+                         const Ray rays[BVH_PACKET_W], int mask,
+                         float t_min, const float t_max[BVH_PACKET_W]);
+
+// ---- triangle BVH (GPUBVHNode) ----
+// Single ray, Moller-Trumbore in the same op order as ysu_intersect_ray8_tri1.
+// Returns the triangle index (or -1) and its t.
+int bvh_tri_hit_closest(const BvhTriMesh* mesh, const Ray* r,
+                        float t_min, float t_max, float* t_out);
+
+// bvh_tri_hit_closest() below node `root`; *closest_io / *best_io carry the
+// running hit in and out (packet lanes and TLAS instances resume with it).
+// any_hit stops at the first hit.
+void bvh_tri_hit_subtree(const BvhTriMesh* mesh, int32_t root, const Ray* r, float t_min,
+                         float* closest_io, int* best_io, int any_hit);
+
+void bvh_packet_tri_hit_closest8(const BvhTriMesh* mesh,
+                                 const Ray rays[BVH_PACKET_W], int mask,
+                                 float t_min, float t_max, BvhPacketHit* out);
+
+int bvh_packet_tri_occluded8(const BvhTriMesh* mesh,
+                             const Ray rays[BVH_PACKET_W], int mask,
+                             float t_min, const float t_max[BVH_PACKET_W]);
+
+#endif // BVH_PACKET_H
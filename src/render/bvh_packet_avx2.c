@@ -0,0 +1,331 @@
+// bvh_packet_avx2.c - 8-ray packet traversal kernels built with -mavx2
+//
+// Only called after ysu_detect_cpu_features() reports AVX2 (bvh_packet.c).
+// Built without -mfma so the lanes round like the single-ray paths.
+#include "bvh_packet.h"
+
+#include <float.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include "vec3_simd.h"
+#include "ysu_packet.h"
+
+#define PACKET_STACK 128
+
+// Average lanes per visited node below which a packet is abandoned (checked
+// every PACKET_PROBE nodes): the live lanes then restart single-ray from the
+// root, keeping the hits found so far as their t_max.
+#define PACKET_PROBE    32
+#define PACKET_UTIL_MIN 2
+
+typedef struct {
+    int32_t node;
+    int     mask;                 // lanes that entered the node when pushed
+    float   tn[BVH_PACKET_W];     // their entry distances
+} PacketEntry;
+
+typedef struct {
+    YSU_Ray8 r8;
+    ysu_f8   ix, iy, iz;          // 1 / direction
+    ysu_f8   vt_min;
+    int      live;                // lanes still tracing (any-hit retires lanes)
+} PacketRays;
+
+static inline int lane_count(int m) {
+    m = m - ((m >> 1) & 0x55);
+    m = (m & 0x33) + ((m >> 2) & 0x33);
+    return (m + (m >> 4)) & 0x0F;
+}
+
+static inline int lane_first(int m) {
+    int k = 0;
+    while (!((m >> k) & 1)) ++k;
+    return k;
+}
+
+static void packet_rays_init(PacketRays* pr, const Ray* rays, int mask, float t_min) {
+    ysu_f8 one = ysu_f8_set1(1.0f);
+    pr->r8 = ysu_pack_rays8(rays);
+    pr->ix = ysu_f8_div(one, pr->r8.dx);
+    pr->iy = ysu_f8_div(one, pr->r8.dy);
+    pr->iz = ysu_f8_div(one, pr->r8.dz);
+    pr->vt_min = ysu_f8_set1(t_min);
+    pr->live = mask;
+}
+
+// Slab test of one box against the lanes in m, clipped to [t_min, closest].
+static inline int packet_slab(const PacketRays* pr, const float* bmin, const float* bmax,
+                              const float* closest, int m, float* tn_out)
+{
+    ysu_f8 t0 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmin[0]), pr->r8.ox), pr->ix);
+    ysu_f8 t1 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmax[0]), pr->r8.ox), pr->ix);
+    ysu_f8 tn = ysu_f8_max(pr->vt_min, ysu_f8_min(t0, t1));
+    ysu_f8 tf = ysu_f8_min(ysu_f8_load(closest), ysu_f8_max(t0, t1));
+    t0 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmin[1]), pr->r8.oy), pr->iy);
+    t1 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmax[1]), pr->r8.oy), pr->iy);
+    tn = ysu_f8_max(tn, ysu_f8_min(t0, t1));
+    tf = ysu_f8_min(tf, ysu_f8_max(t0, t1));
+    t0 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmin[2]), pr->r8.oz), pr->iz);
+    t1 = ysu_f8_mul(ysu_f8_sub(ysu_f8_set1(bmax[2]), pr->r8.oz), pr->iz);
+    tn = ysu_f8_max(tn, ysu_f8_min(t0, t1));
+    tf = ysu_f8_min(tf, ysu_f8_max(t0, t1));
+
+    int hit = ysu_f8_mask(ysu_f8_ge(tf, tn)) & m;
+    if (hit) ysu_f8_store(tn_out, tn);
+    return hit;
+}
+
+// Lanes of a popped entry that still need it: live, and not already closer.
+static inline int packet_entry_lanes(const PacketEntry* e, const float* closest, int live) {
+    return ysu_f8_mask(ysu_f8_ge(ysu_f8_load(closest), ysu_f8_load(e->tn))) & e->mask & live;
+}
+
+// Near child = the one the first shared lane enters first.
+static inline int packet_left_first(int mL, int mR, const float* tnL, const float* tnR) {
+    int k = lane_first(mL | mR);
+    if (!((mL >> k) & 1)) return 0;
+    if (!((mR >> k) & 1)) return 1;
+    return tnL[k] <= tnR[k];
+}
+
+// ------------------------- spheres -------------------------
+static int packet_sphere_leaf(const PacketRays* pr, const Sphere* s, int first, int count,
+                              ysu_f8 a, int m, float* closest, int* best, int any_hit)
+{
+    const ysu_f8 zero = ysu_f8_set1(0.0f);
+    int retired = 0;
+    s += first;
+    for (int i = 0; i < count && m; ++i, ++s) {
+        ysu_f8 ocx = ysu_f8_sub(pr->r8.ox, ysu_f8_set1(s->center.x));
+        ysu_f8 ocy = ysu_f8_sub(pr->r8.oy, ysu_f8_set1(s->center.y));
+        ysu_f8 ocz = ysu_f8_sub(pr->r8.oz, ysu_f8_set1(s->center.z));
+        ysu_f8 half_b = ysu_f8_add(ysu_f8_add(ysu_f8_mul(ocx, pr->r8.dx), ysu_f8_mul(ocy, pr->r8.dy)),
+                                   ysu_f8_mul(ocz, pr->r8.dz));
+        ysu_f8 c = ysu_f8_sub(ysu_f8_add(ysu_f8_add(ysu_f8_mul(ocx, ocx), ysu_f8_mul(ocy, ocy)),
+                                         ysu_f8_mul(ocz, ocz)),
+                              ysu_f8_set1(s->radius * s->radius));
+        ysu_f8 disc = ysu_f8_sub(ysu_f8_mul(half_b, half_b), ysu_f8_mul(a, c));
+        ysu_f8 ok = ysu_f8_ge(disc, zero);
+        if (!(ysu_f8_mask(ok) & m)) continue;
+
+        ysu_f8 sq = ysu_f8_sqrt(disc);
+        ysu_f8 nb = ysu_f8_sub(zero, half_b);
+        ysu_f8 cl = ysu_f8_load(closest);
+        ysu_f8 t1 = ysu_f8_div(ysu_f8_sub(nb, sq), a);
+        ysu_f8 t2 = ysu_f8_div(ysu_f8_add(nb, sq), a);
+        ysu_f8 ok1 = ysu_f8_and(ysu_f8_ge(t1, pr->vt_min), ysu_f8_ge(cl, t1));
+        ysu_f8 t = ysu_f8_select(ok1, t1, t2);
+        ok = ysu_f8_and(ok, ysu_f8_and(ysu_f8_ge(t, pr->vt_min), ysu_f8_ge(cl, t)));
+
+        int hm = ysu_f8_mask(ok) & m;
+        if (!hm) continue;
+        float th[BVH_PACKET_W];
+        ysu_f8_store(th, t);
+        for (int k = 0; k < BVH_PACKET_W; ++k) {
+            if (!((hm >> k) & 1)) continue;
+            closest[k] = th[k];
+            best[k] = first + i;
+        }
+        if (any_hit) { retired |= hm; m &= ~hm; }
+    }
+    return retired;
+}
+
+void bvh_packet_sphere_avx2(const BvhFlat* bvh, const Sphere* spheres, const Ray* rays, int mask,
+                            float t_min, const float* t_max, int any_hit, int min_active,
+                            BvhPacketHit* out)
+{
+    const BvhFlatNode* nodes = bvh->nodes;
+    float* closest = out->t;
+    int*   best    = out->prim;
+    for (int k = 0; k < BVH_PACKET_W; ++k) closest[k] = t_max[k];
+
+    PacketRays pr;
+    packet_rays_init(&pr, rays, mask, t_min);
+    const ysu_f8 a = ysu_f8_add(ysu_f8_add(ysu_f8_mul(pr.r8.dx, pr.r8.dx), ysu_f8_mul(pr.r8.dy, pr.r8.dy)),
+                                ysu_f8_mul(pr.r8.dz, pr.r8.dz));
+
+    PacketEntry stack[PACKET_STACK];
+    int sp = 0;
+    stack[0].node = 0;
+    stack[0].mask = packet_slab(&pr, nodes[0].bmin, nodes[0].bmax, closest, mask, stack[0].tn);
+    if (stack[0].mask) sp = 1;
+
+    int visits = 0, lanes = 0;
+    while (sp > 0) {
+        const PacketEntry* e = &stack[--sp];
+        uint32_t ni = (uint32_t)e->node;
+        int m = packet_entry_lanes(e, closest, pr.live);
+
+        while (m) {
+            if (++visits == PACKET_PROBE) {
+                if (lanes < PACKET_PROBE * PACKET_UTIL_MIN) {
+                    sp = 0;
+                    ni = 0;
+                    m = pr.live;
+                    min_active = BVH_PACKET_W + 1;
+                }
+                visits = lanes = 0;
+            }
+            lanes += lane_count(m);
+
+            // coherence dropped: the remaining lanes finish this subtree alone
+            if (lane_count(m) < min_active) {
+                for (int k = 0; k < BVH_PACKET_W; ++k) {
+                    if (!((m >> k) & 1)) continue;
+                    bvh_flat_hit_subtree(bvh, ni, spheres, &rays[k], t_min, &closest[k], &best[k]);
+                    if (any_hit && best[k] >= 0) pr.live &= ~(1 << k);
+                }
+                break;
+            }
+
+            const BvhFlatNode* node = &nodes[ni];
+            if (node->count > 0) {
+                pr.live &= ~packet_sphere_leaf(&pr, spheres, (int)node->offset, (int)node->count,
+                                               a, m, closest, best, any_hit);
+                break;
+            }
+
+            uint32_t li = ni + 1, ri = node->offset;
+            float tnL[BVH_PACKET_W], tnR[BVH_PACKET_W];
+            int mL = packet_slab(&pr, nodes[li].bmin, nodes[li].bmax, closest, m, tnL);
+            int mR = packet_slab(&pr, nodes[ri].bmin, nodes[ri].bmax, closest, m, tnR);
+            if (!(mL | mR)) break;
+
+            int left_first = packet_left_first(mL, mR, tnL, tnR);
+            uint32_t far_i = left_first ? ri : li;
+            int      far_m = left_first ? mR : mL;
+            if (far_m && sp < PACKET_STACK) {
+                PacketEntry* f = &stack[sp++];
+                f->node = (int32_t)far_i;
+                f->mask = far_m;
+                memcpy(f->tn, left_first ? tnR : tnL, sizeof(f->tn));
+            }
+            ni = left_first ? li : ri;
+            m  = left_first ? mL : mR;
+        }
+    }
+}
+
+// ------------------------- triangles -------------------------
+static int packet_tri_leaf(const PacketRays* pr, const BvhTriMesh* mesh, const GPUBVHNode* node,
+                           float t_min, int m, float* closest, int* best, int any_hit)
+{
+    int retired = 0;
+    for (int32_t i = 0; i < node->triCount && m; ++i) {
+        int32_t tri = mesh->indices[node->triOffset + i];
+        const float* v = mesh->tris + (size_t)tri * 12u;
+
+        // one t_max for the packet, then each lane against its own closest
+        float t_far = -FLT_MAX;
+        for (int k = 0; k < BVH_PACKET_W; ++k) {
+            if (((m >> k) & 1) && closest[k] > t_far) t_far = closest[k];
+        }
+        YSU_Hit8 h = ysu_intersect_ray8_tri1(&pr->r8, (Vec3){ v[0], v[1], v[2] },
+                                             (Vec3){ v[4], v[5], v[6] },
+                                             (Vec3){ v[8], v[9], v[10] }, t_min, t_far);
+        int hm = h.hit_mask & m;
+        for (int k = 0; hm && k < BVH_PACKET_W; ++k) {
+            if (!((hm >> k) & 1) || h.t[k] > closest[k]) continue;
+            closest[k] = h.t[k];
+            best[k] = tri;
+            if (any_hit) { retired |= 1 << k; m &= ~(1 << k); }
+        }
+    }
+    return retired;
+}
+
+void bvh_packet_tri_avx2(const BvhTriMesh* mesh, const Ray* rays, int mask,
+                         float t_min, const float* t_max, int any_hit, int min_active,
+                         BvhPacketHit* out)
+{
+    const GPUBVHNode* nodes = mesh->nodes;
+    float* closest = out->t;
+    int*   best    = out->prim;
+    for (int k = 0; k < BVH_PACKET_W; ++k) closest[k] = t_max[k];
+
+    PacketRays pr;
+    packet_rays_init(&pr, rays, mask, t_min);
+
+    PacketEntry stack[PACKET_STACK];
+    int sp = 0;
+    stack[0].node = 0;
+    stack[0].mask = packet_slab(&pr, nodes[0].bmin, nodes[0].bmax, closest, mask, stack[0].tn);
+    if (stack[0].mask) sp = 1;
+
+    int visits = 0, lanes = 0;
+    while (sp > 0) {
+        const PacketEntry* e = &stack[--sp];
+        int32_t ni = e->node;
+        int m = packet_entry_lanes(e, closest, pr.live);
+
+        while (m) {
+            if (++visits == PACKET_PROBE) {
+                if (lanes < PACKET_PROBE * PACKET_UTIL_MIN) {
+                    sp = 0;
+                    ni = 0;
+                    m = pr.live;
+                    min_active = BVH_PACKET_W + 1;
+                }
+                visits = lanes = 0;
+            }
+            lanes += lane_count(m);
+
+            if (lane_count(m) < min_active) {
+                for (int k = 0; k < BVH_PACKET_W; ++k) {
+                    if (!((m >> k) & 1)) continue;
+                    bvh_tri_hit_subtree(mesh, ni, &rays[k], t_min, &closest[k], &best[k], any_hit);
+                    if (any_hit && best[k] >= 0) pr.live &= ~(1 << k);
+                }
+                break;
+            }
+
+            const GPUBVHNode* node = &nodes[ni];
+            if (node->left < 0) {
+                pr.live &= ~packet_tri_leaf(&pr, mesh, node, t_min, m, closest, best, any_hit);
+                break;
+            }
+
+            int32_t li = node->left, ri = node->right;
+            float tnL[BVH_PACKET_W], tnR[BVH_PACKET_W];
+            int mL = packet_slab(&pr, nodes[li].bmin, nodes[li].bmax, closest, m, tnL);
+            int mR = packet_slab(&pr, nodes[ri].bmin, nodes[ri].bmax, closest, m, tnR);
+            if (!(mL | mR)) break;
+
+            int left_first = packet_left_first(mL, mR, tnL, tnR);
+            int32_t far_i = left_first ? ri : li;
+            int     far_m = left_first ? mR : mL;
+            if (far_m && sp < PACKET_STACK) {
+                PacketEntry* f = &stack[sp++];
+                f->node = far_i;
+                f->mask = far_m;
+                memcpy(f->tn, left_first ? tnR : tnL, sizeof(f->tn));
+            }
+            ni = left_first ? li : ri;
+            m  = left_first ? mL : mR;
+        }
+    }
+}
+
+const int g_bvh_packet_avx2_built = 1;
+#else
+const int g_bvh_packet_avx2_built = 0;
+
+// never selected: g_bvh_packet_avx2_built keeps bvh_packet.c on single rays
+void bvh_packet_sphere_avx2(const BvhFlat* bvh, const Sphere* spheres, const Ray* rays, int mask,
+                            float t_min, const float* t_max, int any_hit, int min_active,
+                            BvhPacketHit* out)
+{
+    (void)bvh; (void)spheres; (void)rays; (void)mask; (void)t_min; (void)t_max;
+    (void)any_hit; (void)min_active; (void)out;
+}
+
+void bvh_packet_tri_avx2(const BvhTriMesh* mesh, const Ray* rays, int mask,
+                         float t_min, const float* t_max, int any_hit, int min_active,
+                         BvhPacketHit* out)
+{
+    (void)mesh; (void)rays; (void)mask; (void)t_min; (void)t_max;
+    (void)any_hit; (void)min_active; (void)out;
+}
+#endif
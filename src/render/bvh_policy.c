@@ -0,0 +1,271 @@
+// bvh_policy.c - learned BVH pruning policy, scored in the engine
+#include "bvh_policy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#endif
+
+static double policy_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+// ------------------------- model file -------------------------
+// Just enough JSON for the two model layouts: a key is looked up anywhere
+// in the document (so "meta": {"features": ...} is found too).
+static const char* json_value(const char* doc, const char* key) {
+    size_t kl = strlen(key);
+    for (const char* p = strchr(doc, '"'); p; p = strchr(p + 1, '"')) {
+        if (strncmp(p + 1, key, kl) != 0 || p[1 + kl] != '"') continue;
+        const char* q = p + 2 + kl;
+        while (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n') q++;
+        if (*q != ':') continue;
+        q++;
+        while (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n') q++;
+        return q;
+    }
+    return NULL;
+}
+
+// [n0, n1, ...] -> count, or -1 when malformed / longer than max
+static int json_floats(const char* p, float* out, int max) {
+    if (!p || *p != '[') return -1;
+    int n = 0;
+    p++;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') p++;
+        if (*p == ']') return n;
+        char* end = NULL;
+        double v = strtod(p, &end);
+        if (end == p || n >= max) return -1;
+        out[n++] = (float)v;
+        p = end;
+    }
+}
+
+static int json_strings(const char* p, char (*out)[32], int max) {
+    if (!p || *p != '[') return -1;
+    int n = 0;
+    p++;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') p++;
+        if (*p == ']') return n;
+        if (*p != '"' || n >= max) return -1;
+        const char* e = strchr(p + 1, '"');
+        if (!e || e - p - 1 >= 32) return -1;
+        memcpy(out[n], p + 1, (size_t)(e - p - 1));
+        out[n][e - p - 1] = '\0';
+        n++;
+        p = e + 1;
+    }
+}
+
+static const struct { const char* name; BvhPolicyFeature feat; } k_policy_features[] = {
+    { "bias",              BVH_FEAT_BIAS },
+    { "depth",             BVH_FEAT_DEPTH },
+    { "count",             BVH_FEAT_COUNT },
+    { "log1p(visits)",     BVH_FEAT_LOG_VISITS },
+    { "log_visits",        BVH_FEAT_LOG_VISITS },
+    { "log_useful",        BVH_FEAT_LOG_USEFUL },
+    { "ratio",             BVH_FEAT_RATIO },
+    { "useful/(1+visits)", BVH_FEAT_USEFUL_PER_VISIT },
+    { "logit_ratio",       BVH_FEAT_LOGIT_RATIO },
+};
+
+int bvh_policy_load(const char* path, BvhPolicyModel* m) {
+    memset(m, 0, sizeof(*m));
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("[BVH] policy: cannot open %s\n", path);
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* doc = (size > 0 && size < (1 << 20)) ? (char*)malloc((size_t)size + 1) : NULL;
+    if (!doc || fread(doc, 1, (size_t)size, f) != (size_t)size) {
+        printf("[BVH] policy: cannot read %s\n", path);
+        free(doc);
+        fclose(f);
+        return 0;
+    }
+    doc[size] = '\0';
+    fclose(f);
+
+    const char* wv = json_value(doc, "weights");
+    if (!wv) wv = json_value(doc, "w");
+    char names[BVH_POLICY_MAX_FEATURES][32];
+    int nw = json_floats(wv, m->w, BVH_POLICY_MAX_FEATURES);
+    int nf = json_strings(json_value(doc, "features"), names, BVH_POLICY_MAX_FEATURES);
+    if (nw <= 0 || nf != nw) {
+        printf("[BVH] policy: %s needs matching \"weights\" and \"features\" arrays\n", path);
+        free(doc);
+        return 0;
+    }
+    m->n = nw;
+    for (int k = 0; k < nf; ++k) {
+        int found = -1;
+        for (size_t j = 0; j < sizeof(k_policy_features) / sizeof(k_policy_features[0]); ++j) {
+            if (!strcmp(names[k], k_policy_features[j].name)) { found = (int)k_policy_features[j].feat; break; }
+        }
+        if (found < 0) {
+            printf("[BVH] policy: unknown feature \"%s\" in %s\n", names[k], path);
+            free(doc);
+            return 0;
+        }
+        m->feat[k] = (uint8_t)found;
+        m->mu[k] = 0.0f;
+        m->sd[k] = 1.0f;
+    }
+
+    float mu[BVH_POLICY_MAX_FEATURES], sd[BVH_POLICY_MAX_FEATURES];
+    const char* mv = json_value(doc, "mu");
+    const char* sv = json_value(doc, "sd");
+    if (mv || sv) {
+        if (json_floats(mv, mu, BVH_POLICY_MAX_FEATURES) != nw || json_floats(sv, sd, BVH_POLICY_MAX_FEATURES) != nw) {
+            printf("[BVH] policy: %s has mu/sd of the wrong length\n", path);
+            free(doc);
+            return 0;
+        }
+        for (int k = 0; k < nw; ++k) {
+            m->mu[k] = mu[k];
+            m->sd[k] = (fabsf(sd[k]) > 1e-12f) ? sd[k] : 1.0f;
+        }
+    }
+
+    const char* v;
+    m->b          = (v = json_value(doc, "b"))          ? (float)atof(v) : 0.0f;
+    m->threshold  = (v = json_value(doc, "threshold"))  ? (float)atof(v) : 0.7f;
+    m->keep_depth = (v = json_value(doc, "keep_depth")) ? (uint32_t)atoi(v) : 0u;
+    m->min_visits = (v = json_value(doc, "min_visits")) ? (float)atof(v) : 200.0f;
+    free(doc);
+    return 1;
+}
+
+// ------------------------- scoring -------------------------
+float bvh_policy_score(const BvhPolicyModel* m, uint32_t depth, uint32_t count,
+                       float visits, float useful)
+{
+    float ratio = useful / fmaxf(1.0f, visits);
+    float z = m->b;
+    for (int k = 0; k < m->n; ++k) {
+        float x;
+        switch ((BvhPolicyFeature)m->feat[k]) {
+        case BVH_FEAT_BIAS:             x = 1.0f; break;
+        case BVH_FEAT_DEPTH:            x = (float)depth; break;
+        case BVH_FEAT_COUNT:            x = (float)count; break;
+        case BVH_FEAT_LOG_VISITS:       x = log1pf(fmaxf(visits, 0.0f)); break;
+        case BVH_FEAT_LOG_USEFUL:       x = log1pf(fmaxf(useful, 0.0f)); break;
+        case BVH_FEAT_RATIO:            x = ratio; break;
+        case BVH_FEAT_USEFUL_PER_VISIT: x = useful / (1.0f + visits); break;
+        case BVH_FEAT_LOGIT_RATIO:      x = logf((ratio + 1e-9f) / (1.0f - fminf(ratio, 1.0f - 1e-6f))); break;
+        default:                        x = 0.0f; break;
+        }
+        z += m->w[k] * (x - m->mu[k]) / m->sd[k];
+    }
+    // stable sigmoid, as in the training scripts
+    if (z >= 0.0f) return 1.0f / (1.0f + expf(-z));
+    float e = expf(z);
+    return e / (1.0f + e);
+}
+
+// Returns the spheres below n.
+static int policy_apply_rec(bvh_node* n, const BvhPolicyModel* m, float scale, int* marked) {
+    if (!n) return 0;
+    int count = (n->count > 0) ? n->count
+              : policy_apply_rec(n->left, m, scale, marked) + policy_apply_rec(n->right, m, scale, marked);
+    float visits = (float)n->visit_count * scale;
+    n->prune = 0;
+    if (n->depth > m->keep_depth && visits >= m->min_visits &&
+        bvh_policy_score(m, n->depth, (uint32_t)count, visits, (float)n->useful_count * scale) > m->threshold) {
+        n->prune = 1;
+        (*marked)++;
+    }
+    return count;
+}
+
+int bvh_policy_apply(bvh_node* root, const BvhPolicyModel* m, float count_scale) {
+    int marked = 0;
+    policy_apply_rec(root, m, count_scale, &marked);
+    return marked;
+}
+
+// ------------------------- online pass -------------------------
+static void policy_reset_rec(bvh_node* n, int clear_prune, int* nodes) {
+    if (!n) return;
+    (*nodes)++;
+    n->visit_count = 0;
+    n->useful_count = 0;
+    if (clear_prune) n->prune = 0;
+    policy_reset_rec(n->left, clear_prune, nodes);
+    policy_reset_rec(n->right, clear_prune, nodes);
+}
+
+// nodes in pruned subtrees
+static int policy_removed_rec(const bvh_node* n, int under) {
+    if (!n) return 0;
+    under |= n->prune;
+    return under + policy_removed_rec(n->left, under) + policy_removed_rec(n->right, under);
+}
+
+int bvh_policy_eval(bvh_node* root, const Sphere* spheres, const Ray* rays, int n,
+                    const BvhPolicyModel* m, float count_scale, BvhPolicyStats* stats)
+{
+    BvhPolicyStats st;
+    memset(&st, 0, sizeof(st));
+    double t0 = policy_now_ms();
+    if (!root || n <= 0) {
+        if (stats) *stats = st;
+        return 0;
+    }
+
+    // the hit t per ray is all the error metric needs
+    float* t_full = (float*)malloc(sizeof(float) * (size_t)n);
+    if (!t_full) {
+        if (stats) *stats = st;
+        return 0;
+    }
+
+    policy_reset_rec(root, 1, &st.nodes);
+    uint64_t v0 = g_bvh_node_visits;
+    for (int i = 0; i < n; ++i) {
+        HitRecord rec;
+        t_full[i] = bvh_hit(root, spheres, &rays[i], 0.001f, FLT_MAX, &rec) ? rec.t : -1.0f;
+    }
+    st.visits_full = g_bvh_node_visits - v0;
+
+    st.marked = bvh_policy_apply(root, m, count_scale);
+    st.removed = policy_removed_rec(root, 0);
+
+    int nodes = 0;
+    policy_reset_rec(root, 0, &nodes);
+    v0 = g_bvh_node_visits;
+    for (int i = 0; i < n; ++i) {
+        HitRecord rec;
+        float t = bvh_hit(root, spheres, &rays[i], 0.001f, FLT_MAX, &rec) ? rec.t : -1.0f;
+        if ((t < 0.0f) != (t_full[i] < 0.0f) || fabsf(t - t_full[i]) > 1e-4f * fabsf(t_full[i])) {
+            st.rays_changed++;
+        }
+    }
+    st.visits_pruned = g_bvh_node_visits - v0;
+    policy_reset_rec(root, 0, &nodes);
+    st.rays = n;
+    st.ms = policy_now_ms() - t0;
+    free(t_full);
+    if (stats) *stats = st;
+    return st.marked;
+}
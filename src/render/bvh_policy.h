@@ -0,0 +1,81 @@
+// bvh_policy.h - learned BVH pruning policy, scored in the engine
+#ifndef BVH_POLICY_H
+#define BVH_POLICY_H
+
+#include <stdint.h>
+
+#include "bvh.h"
+
+// A logistic model over per-node traversal counters decides which subtrees
+// to prune (skip during traversal; lossy). The model is read straight from
+// the JSON written by scripts/analysis/train_ml_policy.py or the
+// DATA/bvh_ml_model.json layout, so no node ids or policy CSVs are involved
+// and the policy survives any change to the tree:
+//
+//   { "weights": [...], "features": [...], "threshold": 0.7 }
+//   { "w": [...], "b": 0.1, "mu": [...], "sd": [...],
+//     "meta": { "features": [...], "keep_depth": 4, "min_visits": 5000 } }
+//
+// Features: bias, depth, count (spheres below the node), log1p(visits) /
+// log_visits, log_useful, ratio (useful/visits), useful/(1+visits),
+// logit_ratio. With mu / sd a feature is standardized before the dot product.
+
+#define BVH_POLICY_MAX_FEATURES 16
+
+typedef enum {
+    BVH_FEAT_BIAS = 0,
+    BVH_FEAT_DEPTH,
+    BVH_FEAT_COUNT,
+    BVH_FEAT_LOG_VISITS,
+    BVH_FEAT_LOG_USEFUL,
+    BVH_FEAT_RATIO,
+    BVH_FEAT_USEFUL_PER_VISIT,
+    BVH_FEAT_LOGIT_RATIO
+} BvhPolicyFeature;
+
+typedef struct {
+    int      n;
+    uint8_t  feat[BVH_POLICY_MAX_FEATURES];
+    float    w[BVH_POLICY_MAX_FEATURES];
+    float    mu[BVH_POLICY_MAX_FEATURES];   // 0 without standardization
+    float    sd[BVH_POLICY_MAX_FEATURES];   // 1 without standardization
+    float    b;
+    float    threshold;     // prune when p(prune) > threshold (default 0.7)
+    uint32_t keep_depth;    // depth <= keep_depth is never pruned (default 0: the root)
+    float    min_visits;    // fewer (scaled) visits is noise: keep (default 200)
+} BvhPolicyModel;
+
+typedef struct {
+    int      nodes;             // nodes in the unpruned tree
+    int      marked;            // nodes the model marked
+    int      removed;           // nodes gone from the traversal tree
+    int      rays;              // sample rays
+    int      rays_changed;      // sample rays whose closest hit changed
+    uint64_t visits_full;       // node visits of the sample rays, unpruned
+    uint64_t visits_pruned;     // ... with the policy applied
+    double   ms;
+} BvhPolicyStats;
+
+// Returns 1 on success; 0 (with a "[BVH] policy:" message) when the file
+// is missing, malformed or names an unknown feature.
+int   bvh_policy_load(const char* path, BvhPolicyModel* m);
+
+// p(prune) for one node.
+float bvh_policy_score(const BvhPolicyModel* m, uint32_t depth, uint32_t count,
+                       float visits, float useful);
+
+// Sets every node's prune flag from its own visit_count / useful_count
+// (scaled by count_scale, e.g. full-frame rays / sample rays). Returns the
+// number of nodes marked.
+int   bvh_policy_apply(bvh_node* root, const BvhPolicyModel* m, float count_scale);
+
+// Online pass over an unpruned tree: traces rays[0, n) with bvh_hit to
+// collect counters, applies the model, then traces again to measure the
+// visits saved and the hits changed. Leaves the prune flags set and the
+// node counters zeroed, ready for bvh_flatten / bvh_wide_build or a
+// measured pass.
+// Single-threaded; uses the global g_bvh_node_visits counter.
+int   bvh_policy_eval(bvh_node* root, const Sphere* spheres, const Ray* rays, int n,
+                      const BvhPolicyModel* m, float count_scale, BvhPolicyStats* stats);
+
+#endif // BVH_POLICY_H
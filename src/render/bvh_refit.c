@@ -0,0 +1,509 @@
+// bvh_refit.c - in-place refit and partial rebuild of the render BVH
+#include "bvh_refit.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#endif
+
+#define REFIT_NONE 0xFFFFFFFFu
+#define REFIT_TRAV 1.0f      // node test cost, as BVH_SAH_TRAV in bvh.c
+
+static double refit_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+// ------------------------- boxes -------------------------
+static inline float box_area(const float* bmin, const float* bmax) {
+    float ex = bmax[0] - bmin[0], ey = bmax[1] - bmin[1], ez = bmax[2] - bmin[2];
+    if (ex < 0.0f) return 0.0f;
+    return 2.0f * (ex * ey + ey * ez + ez * ex);
+}
+
+static inline void box_clear(float* bmin, float* bmax) {
+    for (int a = 0; a < 3; ++a) { bmin[a] = FLT_MAX; bmax[a] = -FLT_MAX; }
+}
+
+static inline void box_grow(float* bmin, float* bmax, const float* omin, const float* omax) {
+    for (int a = 0; a < 3; ++a) {
+        if (omin[a] < bmin[a]) bmin[a] = omin[a];
+        if (omax[a] > bmax[a]) bmax[a] = omax[a];
+    }
+}
+
+static void box_spheres(const Sphere* spheres, uint32_t first, uint32_t count, float* bmin, float* bmax) {
+    box_clear(bmin, bmax);
+    for (uint32_t s = first; s < first + count; ++s) {
+        const Sphere* sp = &spheres[s];
+        float r = sp->radius;
+        float smin[3] = { sp->center.x - r, sp->center.y - r, sp->center.z - r };
+        float smax[3] = { sp->center.x + r, sp->center.y + r, sp->center.z + r };
+        box_grow(bmin, bmax, smin, smax);
+    }
+}
+
+static inline float flat_weight(const BvhFlatNode* n) {
+    return n->count > 0 ? (float)n->count : REFIT_TRAV;
+}
+
+// Writes the box of flat node i; returns 0 when it did not change.
+static int flat_set_box(BvhRefit* c, uint32_t i, const float* bmin, const float* bmax) {
+    BvhFlatNode* n = &c->flat->nodes[i];
+    if (!memcmp(n->bmin, bmin, sizeof(n->bmin)) && !memcmp(n->bmax, bmax, sizeof(n->bmax))) return 0;
+    c->sah_sum += (double)flat_weight(n) * (double)(box_area(bmin, bmax) - box_area(n->bmin, n->bmax));
+    memcpy(n->bmin, bmin, sizeof(n->bmin));
+    memcpy(n->bmax, bmax, sizeof(n->bmax));
+    return 1;
+}
+
+// Recomputes the ancestors of flat node i; returns the boxes changed.
+static int flat_refit_up(BvhRefit* c, uint32_t i) {
+    const BvhFlatNode* nodes = c->flat->nodes;
+    int changed = 0;
+    for (uint32_t p = c->parent[i]; p != REFIT_NONE; p = c->parent[p]) {
+        const BvhFlatNode* l = &nodes[p + 1];
+        const BvhFlatNode* r = &nodes[nodes[p].offset];
+        float bmin[3], bmax[3];
+        memcpy(bmin, l->bmin, sizeof(bmin));
+        memcpy(bmax, l->bmax, sizeof(bmax));
+        box_grow(bmin, bmax, r->bmin, r->bmax);
+        if (!flat_set_box(c, p, bmin, bmax)) break;
+        ++changed;
+    }
+    return changed;
+}
+
+// ------------------------- wide lanes -------------------------
+// Bvh4Node / Bvh8Node viewed as floats: 6 SoA box rows, then child, count.
+static inline float* wide_node(const BvhWide* w, uint32_t idx) {
+    return (float*)w->nodes + (size_t)idx * (size_t)(8 * w->width);
+}
+
+static inline int32_t* wide_child(const BvhWide* w, float* f) { return (int32_t*)(f + 6 * w->width); }
+static inline int32_t* wide_count(const BvhWide* w, float* f) { return (int32_t*)(f + 7 * w->width); }
+
+static int wide_set_lane(const BvhWide* w, float* f, int k, const float* bmin, const float* bmax) {
+    const int W = w->width;
+    int same = 1;
+    for (int a = 0; a < 3; ++a) {
+        same &= (f[a * W + k] == bmin[a]) & (f[(3 + a) * W + k] == bmax[a]);
+        f[a * W + k] = bmin[a];
+        f[(3 + a) * W + k] = bmax[a];
+    }
+    return !same;
+}
+
+// Union of the valid lanes of a wide node.
+static void wide_node_box(const BvhWide* w, float* f, float* bmin, float* bmax) {
+    const int W = w->width;
+    const int32_t* cnt = wide_count(w, f);
+    box_clear(bmin, bmax);
+    for (int j = 0; j < W; ++j) {
+        if (cnt[j] < 0) continue;
+        float lmin[3] = { f[0 * W + j], f[1 * W + j], f[2 * W + j] };
+        float lmax[3] = { f[3 * W + j], f[4 * W + j], f[5 * W + j] };
+        box_grow(bmin, bmax, lmin, lmax);
+    }
+}
+
+// Refits the lane `code` (node * 8 + lane) of a wide leaf and its ancestors.
+static int wide_refit(BvhRefit* c, const Sphere* spheres, uint32_t code) {
+    const BvhWide* w = c->wide;
+    float bmin[3], bmax[3];
+
+    float* f = wide_node(w, code >> 3);
+    int k = (int)(code & 7u);
+    box_spheres(spheres, (uint32_t)wide_child(w, f)[k], (uint32_t)wide_count(w, f)[k], bmin, bmax);
+    if (!wide_set_lane(w, f, k, bmin, bmax)) return 0;
+    int changed = 1;
+
+    for (code = c->wparent[code >> 3]; code != REFIT_NONE; code = c->wparent[code >> 3]) {
+        wide_node_box(w, f, bmin, bmax);
+        f = wide_node(w, code >> 3);
+        if (!wide_set_lane(w, f, (int)(code & 7u), bmin, bmax)) break;
+        ++changed;
+    }
+    return changed;
+}
+
+// Every node, children first (both layouts put children after parents).
+// Cheaper than walking up from each leaf once the moved spheres touch a
+// good part of the tree.
+static int refit_sweep(BvhRefit* c, const Sphere* spheres) {
+    int changed = 0;
+    BvhFlatNode* nodes = c->flat->nodes;
+    for (uint32_t i = (uint32_t)c->flat->count; i-- > 0;) {
+        float bmin[3], bmax[3];
+        if (nodes[i].count > 0) {
+            box_spheres(spheres, nodes[i].offset, nodes[i].count, bmin, bmax);
+        } else {
+            const BvhFlatNode* r = &nodes[nodes[i].offset];
+            memcpy(bmin, nodes[i + 1].bmin, sizeof(bmin));
+            memcpy(bmax, nodes[i + 1].bmax, sizeof(bmax));
+            box_grow(bmin, bmax, r->bmin, r->bmax);
+        }
+        changed += flat_set_box(c, i, bmin, bmax);
+    }
+
+    const BvhWide* w = c->wide;
+    for (uint32_t i = w ? (uint32_t)w->count : 0u; i-- > 0;) {
+        float* f = wide_node(w, i);
+        const int32_t* child = wide_child(w, f);
+        const int32_t* cnt = wide_count(w, f);
+        for (int k = 0; k < w->width; ++k) {
+            if (cnt[k] < 0) continue;
+            float bmin[3], bmax[3];
+            if (cnt[k] > 0) box_spheres(spheres, (uint32_t)child[k], (uint32_t)cnt[k], bmin, bmax);
+            else            wide_node_box(w, wide_node(w, (uint32_t)child[k]), bmin, bmax);
+            changed += wide_set_lane(w, f, k, bmin, bmax);
+        }
+    }
+    return changed;
+}
+
+// ------------------------- indexing -------------------------
+static void refit_index_flat(BvhRefit* c) {
+    const BvhFlatNode* nodes = c->flat->nodes;
+    c->sah_sum = 0.0;
+    if (c->flat->count <= 0) return;
+    c->parent[0] = REFIT_NONE;
+    for (uint32_t i = 0; i < (uint32_t)c->flat->count; ++i) {
+        const BvhFlatNode* n = &nodes[i];
+        float a = box_area(n->bmin, n->bmax);
+        c->area0[i] = a;
+        c->sah_sum += (double)flat_weight(n) * (double)a;
+        if (n->count > 0) {
+            for (uint32_t s = n->offset; s < n->offset + n->count; ++s) c->leaf[s] = i;
+        } else {
+            c->parent[i + 1] = i;
+            c->parent[n->offset] = i;
+        }
+    }
+}
+
+static void refit_index_wide(BvhRefit* c) {
+    const BvhWide* w = c->wide;
+    c->wparent[0] = REFIT_NONE;
+    for (uint32_t i = 0; i < (uint32_t)w->count; ++i) {
+        float* f = wide_node(w, i);
+        const int32_t* child = wide_child(w, f);
+        const int32_t* cnt = wide_count(w, f);
+        for (int k = 0; k < w->width; ++k) {
+            if (cnt[k] == 0) {
+                c->wparent[child[k]] = i * 8u + (uint32_t)k;
+            } else if (cnt[k] > 0) {
+                for (int32_t s = child[k]; s < child[k] + cnt[k]; ++s) c->wleaf[s] = i * 8u + (uint32_t)k;
+            }
+        }
+    }
+}
+
+static float refit_cost(const BvhRefit* c) {
+    if (c->flat->count <= 0) return 0.0f;
+    const BvhFlatNode* root = &c->flat->nodes[0];
+    float a = box_area(root->bmin, root->bmax);
+    return (float)(c->sah_sum / (double)(a > 1e-30f ? a : 1e-30f));
+}
+
+// ------------------------- public -------------------------
+bvh_node* bvh_build_tracked(Sphere* spheres, int start, int end,
+                            const BvhBuildOpts* opts, int32_t* ids)
+{
+    int n = end - start;
+    if (n <= 0) return bvh_build_ex(spheres, start, end, opts);
+    int32_t* mat = (int32_t*)malloc(sizeof(int32_t) * (size_t)n);
+    if (!mat) return NULL;
+
+    // The builders only look at centres and radii, so the material slot can
+    // carry each sphere's old position through the sort.
+    for (int j = 0; j < n; ++j) {
+        mat[j] = spheres[start + j].material_index;
+        spheres[start + j].material_index = j;
+    }
+    bvh_node* root = bvh_build_ex(spheres, start, end, opts);
+    for (int j = 0; j < n; ++j) {
+        int src = spheres[start + j].material_index;
+        spheres[start + j].material_index = mat[src];
+        ids[j] = src;
+    }
+    free(mat);
+    return root;
+}
+
+int bvh_refit_init(BvhRefit* ctx, BvhFlat* flat, BvhWide* wide,
+                   int sphere_count, const int32_t* ids)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    if (!flat || sphere_count <= 0) return 0;
+    if (wide && wide->count <= 0) wide = NULL;
+
+    size_t nodes = (size_t)(flat->count > 0 ? flat->count : 1);
+    ctx->flat = flat;
+    ctx->wide = wide;
+    ctx->sphere_count = sphere_count;
+    ctx->parent = (uint32_t*)malloc(sizeof(uint32_t) * nodes);
+    ctx->area0  = (float*)malloc(sizeof(float) * nodes);
+    ctx->leaf   = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)sphere_count);
+    ctx->id     = (int32_t*)malloc(sizeof(int32_t) * (size_t)sphere_count);
+    ctx->slot   = (int32_t*)malloc(sizeof(int32_t) * (size_t)sphere_count);
+    if (wide) {
+        ctx->wparent = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)wide->count);
+        ctx->wleaf   = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)sphere_count);
+    }
+    if (!ctx->parent || !ctx->area0 || !ctx->leaf || !ctx->id || !ctx->slot ||
+        (wide && (!ctx->wparent || !ctx->wleaf))) {
+        bvh_refit_free(ctx);
+        return 0;
+    }
+
+    for (int s = 0; s < sphere_count; ++s) {
+        ctx->id[s] = ids ? ids[s] : s;
+        ctx->slot[ctx->id[s]] = s;
+    }
+    refit_index_flat(ctx);
+    if (wide) refit_index_wide(ctx);
+    ctx->sah_build = refit_cost(ctx);
+
+    ctx->rebuild_ratio = 1.3f;
+    const char* s = getenv("YSU_BVH_REFIT_MAX");
+    if (s && s[0]) ctx->rebuild_ratio = (float)atof(s);
+    return 1;
+}
+
+void bvh_refit_free(BvhRefit* ctx) {
+    if (!ctx) return;
+    free(ctx->parent);
+    free(ctx->leaf);
+    free(ctx->area0);
+    free(ctx->wparent);
+    free(ctx->wleaf);
+    free(ctx->id);
+    free(ctx->slot);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int bvh_refit_update(BvhRefit* ctx, const Sphere* spheres, const int32_t* slots, int count) {
+    if (!ctx->parent) return 0;
+    // a path is ~log2(nodes) scattered nodes, the sweep touches all of them
+    // in order: past about one changed sphere per 16 nodes the sweep wins
+    if ((int64_t)count * 16 >= (int64_t)ctx->flat->count) return refit_sweep(ctx, spheres);
+
+    int changed = 0;
+    for (int k = 0; k < count; ++k) {
+        int32_t s = slots[k];
+        if (s < 0 || s >= ctx->sphere_count) continue;
+
+        // walking up from each leaf is enough: a node is recomputed from its
+        // current children, so siblings refitted later still propagate, and
+        // an unchanged box means nothing above it moves either
+        uint32_t li = ctx->leaf[s];
+        const BvhFlatNode* l = &ctx->flat->nodes[li];
+        float bmin[3], bmax[3];
+        box_spheres(spheres, l->offset, l->count, bmin, bmax);
+        if (flat_set_box(ctx, li, bmin, bmax)) changed += 1 + flat_refit_up(ctx, li);
+        if (ctx->wide) changed += wide_refit(ctx, spheres, ctx->wleaf[s]);
+    }
+    return changed;
+}
+
+float bvh_refit_ratio(const BvhRefit* ctx) {
+    if (!ctx->parent || ctx->sah_build <= 0.0f) return 1.0f;
+    return refit_cost(ctx) / ctx->sah_build;
+}
+
+// Smallest subtree holding at least half of the SAH added since the last
+// (re)build, walking down from the root. Returns REFIT_NONE when the tree
+// got no worse.
+static uint32_t refit_pick_subtree(const BvhRefit* c) {
+    const BvhFlatNode* nodes = c->flat->nodes;
+    uint32_t n = (uint32_t)c->flat->count;
+    double* ex = (double*)malloc(sizeof(double) * n);
+    if (!ex) return 0;      // no room to look: take the whole tree
+    for (uint32_t i = n; i-- > 0;) {
+        const BvhFlatNode* nd = &nodes[i];
+        ex[i] = (double)flat_weight(nd) * (double)(box_area(nd->bmin, nd->bmax) - c->area0[i]);
+        if (nd->count == 0) ex[i] += ex[i + 1] + ex[nd->offset];
+    }
+
+    uint32_t i = REFIT_NONE;
+    if (ex[0] > 0.0) {
+        double half = 0.5 * ex[0];
+        i = 0;
+        while (nodes[i].count == 0) {
+            uint32_t l = i + 1, r = nodes[i].offset;
+            if (nodes[l].count == 0 && ex[l] >= half)      i = l;
+            else if (nodes[r].count == 0 && ex[r] >= half) i = r;
+            else break;
+        }
+    }
+    free(ex);
+    return i;
+}
+
+// Rebuilds the subtree at flat node i. Returns its sphere count, -1 on OOM
+// (spheres and trees are then as before).
+static int refit_rebuild_at(BvhRefit* c, uint32_t i, Sphere* spheres, const BvhBuildOpts* opts) {
+    BvhFlatNode* nodes = c->flat->nodes;
+    uint32_t n = (uint32_t)c->flat->count;
+
+    // DFS layout: the subtree is nodes [i, end) over spheres [lo, hi)
+    uint32_t a = i, b = i;
+    while (nodes[a].count == 0) a = a + 1;
+    while (nodes[b].count == 0) b = nodes[b].offset;
+    uint32_t lo = nodes[a].offset, hi = nodes[b].offset + nodes[b].count, end = b + 1;
+    int cnt = (int)(hi - lo);
+
+    Sphere*  backup = (Sphere*)malloc(sizeof(Sphere) * (size_t)cnt);
+    int32_t* perm   = (int32_t*)malloc(sizeof(int32_t) * (size_t)cnt);
+    if (!backup || !perm) { free(backup); free(perm); return -1; }
+    memcpy(backup, spheres + lo, sizeof(Sphere) * (size_t)cnt);
+
+    // the subtree goes back in at node i's depth, so the SAH depth bound
+    // has to count from there, not from 0
+    BvhBuildOpts o = *opts;
+    o.base_depth = 0;
+    for (uint32_t p = c->parent[i]; p != REFIT_NONE; p = c->parent[p]) o.base_depth++;
+
+    BvhFlat sub;
+    bvh_node* root = bvh_build_tracked(spheres, (int)lo, (int)hi, &o, perm);
+    int ok = root && bvh_flatten(root, &sub);
+    bvh_free(root);
+    if (!ok) {
+        memcpy(spheres + lo, backup, sizeof(Sphere) * (size_t)cnt);
+        free(backup); free(perm);
+        return -1;
+    }
+
+    // everything goes into fresh arrays so a failure leaves the old tree
+    // untouched; nodes after the subtree move by delta, and links to them too
+    int32_t delta = (int32_t)sub.count - (int32_t)(end - i);
+    uint32_t total = (uint32_t)((int32_t)n + delta);
+    BvhFlatNode* out    = (BvhFlatNode*)malloc(sizeof(BvhFlatNode) * total);
+    uint32_t*    parent = (uint32_t*)malloc(sizeof(uint32_t) * total);
+    float*       area0  = (float*)malloc(sizeof(float) * total);
+    atomic_uint* visits = NULL;
+#if YSU_BVH_STATS
+    visits = (atomic_uint*)calloc(total, sizeof(atomic_uint));
+    ok = visits != NULL;
+#endif
+    BvhWide nw;
+    memset(&nw, 0, sizeof(nw));
+    ok = ok && out && parent && area0;
+    if (ok) {
+        memcpy(out, nodes, sizeof(BvhFlatNode) * i);
+        memcpy(out + end + delta, nodes + end, sizeof(BvhFlatNode) * (n - end));
+        for (uint32_t k = 0; k < total; ++k) {
+            if (k == i) { k += (uint32_t)sub.count - 1; continue; }
+            if (out[k].count == 0 && out[k].offset >= end) out[k].offset += (uint32_t)delta;
+        }
+        for (uint32_t k = 0; k < (uint32_t)sub.count; ++k) {
+            out[i + k] = sub.nodes[k];
+            if (out[i + k].count == 0) out[i + k].offset += i;
+        }
+        if (c->wide) {
+            BvhFlat view = { out, (int)total, NULL };
+            bvh_node* tree = bvh_flat_to_tree(&view);
+            ok = tree && bvh_wide_build(tree, c->wide->width, &nw);
+            bvh_free(tree);
+            if (ok && nw.count != c->wide->count) {
+                uint32_t* wp = (uint32_t*)realloc(c->wparent, sizeof(uint32_t) * (size_t)nw.count);
+                if (wp) c->wparent = wp;
+                else ok = 0;
+            }
+        }
+    }
+    bvh_flat_free(&sub);
+
+    if (!ok) {
+        free(out); free(parent); free(area0); free(visits);
+        bvh_wide_free(&nw);
+        memcpy(spheres + lo, backup, sizeof(Sphere) * (size_t)cnt);
+        free(backup); free(perm);
+        return -1;
+    }
+
+    free(nodes);
+    free(c->flat->visits);
+    free(c->parent);
+    free(c->area0);
+    c->flat->nodes  = out;
+    c->flat->count  = (int)total;
+    c->flat->visits = visits;
+    c->parent = parent;
+    c->area0  = area0;
+    if (c->wide) {
+        bvh_wide_free(c->wide);
+        *c->wide = nw;
+    }
+
+    // slot lo + j now holds the sphere that was at lo + perm[j]
+    for (int j = 0; j < cnt; ++j) perm[j] = c->id[lo + (uint32_t)perm[j]];
+    for (int j = 0; j < cnt; ++j) {
+        c->id[lo + (uint32_t)j] = perm[j];
+        c->slot[perm[j]] = (int32_t)lo + j;
+    }
+    free(backup);
+    free(perm);
+
+    refit_index_flat(c);
+    if (c->wide) refit_index_wide(c);
+    return cnt;
+}
+
+int bvh_refit_rebuild(BvhRefit* ctx, Sphere* spheres, const BvhBuildOpts* opts) {
+    if (!ctx->parent || ctx->flat->count <= 0) return 0;
+    BvhBuildOpts o;
+    if (!opts) { bvh_build_opts_default(&o); opts = &o; }
+
+    uint32_t i = refit_pick_subtree(ctx);
+    if (i == REFIT_NONE) return 0;
+    int rebuilt = refit_rebuild_at(ctx, i, spheres, opts);
+    if (rebuilt < 0) return -1;
+
+    // A sphere that left its subtree keeps every ancestor inflated, which no
+    // local rebuild can fix: fall back to the whole tree then.
+    float cost = refit_cost(ctx);
+    if (i != 0 && ctx->rebuild_ratio > 0.0f && cost > ctx->rebuild_ratio * ctx->sah_build) {
+        int all = refit_rebuild_at(ctx, 0, spheres, opts);
+        if (all < 0) return -1;
+        rebuilt = all;
+        cost = refit_cost(ctx);
+    }
+    if (i == 0 || rebuilt == ctx->sphere_count) ctx->sah_build = cost;
+    return rebuilt;
+}
+
+int bvh_refit_step(BvhRefit* ctx, Sphere* spheres, const int32_t* slots, int count,
+                   const BvhBuildOpts* opts, BvhRefitStats* stats)
+{
+    BvhRefitStats st;
+    memset(&st, 0, sizeof(st));
+    double t0 = refit_now_ms();
+    st.nodes = bvh_refit_update(ctx, spheres, slots, count);
+    double t1 = refit_now_ms();
+    st.refit_ms = t1 - t0;
+    st.sah_ratio = bvh_refit_ratio(ctx);
+
+    int ok = 1;
+    if (ctx->rebuild_ratio > 0.0f && st.sah_ratio > ctx->rebuild_ratio) {
+        int r = bvh_refit_rebuild(ctx, spheres, opts);
+        if (r < 0) ok = 0;
+        else st.rebuilt = r;
+        st.rebuild_ms = refit_now_ms() - t1;
+        st.sah_ratio = bvh_refit_ratio(ctx);
+    }
+    if (stats) *stats = st;
+    return ok;
+}
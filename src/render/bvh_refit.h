@@ -0,0 +1,79 @@
+// bvh_refit.h - in-place refit and partial rebuild of the render BVH
+#ifndef BVH_REFIT_H
+#define BVH_REFIT_H
+
+#include <stdint.h>
+
+#include "bvh.h"
+#include "bvh_wide.h"
+
+// Animated spheres keep the tree topology: the leaves holding the moved
+// spheres get new boxes and only their ancestors are recomputed, in the
+// flattened tree and (when present) in the BVH4/BVH8 copy of it. Refitting
+// lets boxes overlap more than a fresh build would, so the context tracks
+// the SAH cost (same scale as BvhTreeStats.sah_cost) against the cost right
+// after the last (re)build. Past a ratio (env: YSU_BVH_REFIT_MAX, default
+// 1.3, 0 = never) bvh_refit_rebuild() rebuilds the smallest subtree that
+// holds at least half of the added cost and splices it back in.
+//
+// Spheres move inside their array on a rebuild, so the context keeps both
+// directions of the mapping between caller ids and sphere slots.
+// Not thread safe, and not to be called while rays traverse the tree.
+
+typedef struct {
+    BvhFlat  *flat;
+    BvhWide  *wide;           // NULL or width 4/8, refitted along with flat
+    int       sphere_count;
+
+    uint32_t *parent;         // flat node -> parent (root: UINT32_MAX)
+    uint32_t *leaf;           // sphere -> flat leaf
+    float    *area0;          // flat node area at the last (re)build
+    uint32_t *wparent;        // wide node -> parent node * 8 + lane
+    uint32_t *wleaf;          // sphere -> wide node * 8 + lane
+
+    int32_t  *id;             // sphere slot -> caller id
+    int32_t  *slot;           // caller id -> sphere slot
+
+    double    sah_sum;        // sum of area * cost weight over all nodes
+    float     sah_build;      // sah cost after the last (re)build
+    float     rebuild_ratio;  // YSU_BVH_REFIT_MAX
+} BvhRefit;
+
+typedef struct {
+    int    nodes;             // flat + wide nodes whose box changed
+    int    rebuilt;           // spheres in the subtree rebuilt (0: none)
+    float  sah_ratio;         // sah cost / cost after the last (re)build
+    double refit_ms;
+    double rebuild_ms;
+} BvhRefitStats;
+
+// bvh_build_ex() that also reports where each sphere went: after the call
+// spheres[start + j] is the one that was at start + ids[j].
+bvh_node* bvh_build_tracked(Sphere* spheres, int start, int end,
+                            const BvhBuildOpts* opts, int32_t* ids);
+
+// flat / wide must describe spheres[0, sphere_count) (wide may be NULL).
+// ids: slot -> caller id as left by bvh_build_tracked(), NULL = identity.
+// Returns 1 on success, 0 on out of memory (ctx is zeroed).
+int  bvh_refit_init(BvhRefit* ctx, BvhFlat* flat, BvhWide* wide,
+                    int sphere_count, const int32_t* ids);
+void bvh_refit_free(BvhRefit* ctx);
+
+// Refits after spheres[slots[k]] changed centre or radius. Returns the
+// number of node boxes that changed.
+int  bvh_refit_update(BvhRefit* ctx, const Sphere* spheres, const int32_t* slots, int count);
+
+// Current sah cost / cost after the last (re)build.
+float bvh_refit_ratio(const BvhRefit* ctx);
+
+// Rebuilds the most degraded subtree with opts (NULL => defaults) and
+// re-collapses the wide tree. Reorders spheres inside that subtree and
+// updates id / slot. Returns the number of spheres rebuilt, -1 on OOM
+// (the tree is left valid, just not improved).
+int  bvh_refit_rebuild(BvhRefit* ctx, Sphere* spheres, const BvhBuildOpts* opts);
+
+// Refit, then rebuild when the ratio is past rebuild_ratio. stats may be NULL.
+int  bvh_refit_step(BvhRefit* ctx, Sphere* spheres, const int32_t* slots, int count,
+                    const BvhBuildOpts* opts, BvhRefitStats* stats);
+
+#endif // BVH_REFIT_H
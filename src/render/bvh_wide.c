@@ -0,0 +1,229 @@
+// bvh_wide.c - BVH4 / BVH8 collapse and traversal dispatch
+#include "bvh_wide.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "vec3_simd.h"
+#include "nerf_simd.h"   // ysu_detect_cpu_features
+
+_Static_assert(sizeof(Bvh4Node) == 128, "Bvh4Node must stay 128 bytes");
+_Static_assert(sizeof(Bvh8Node) == 256, "Bvh8Node must stay 256 bytes");
+
+// ------------------------- kernels -------------------------
+#define BVHW_CAT_(a, b) a##_##b
+#define BVHW_CAT(a, b)  BVHW_CAT_(a, b)
+
+#define BVHW_FN   bvh4_hit_closest_sse
+#define BVHW_NODE Bvh4Node
+#define BVHW_W    4
+#define BVHW_T    ysu_f4
+#define BVHW_OP(x) BVHW_CAT(ysu_f4, x)
+#include "bvh_wide_kernel.h"
+#undef BVHW_FN
+#undef BVHW_NODE
+#undef BVHW_W
+#undef BVHW_T
+#undef BVHW_OP
+
+// BVH8 as two SSE halves; the AVX2 build of the same kernel is in
+// bvh_wide_avx2.c (compiled with -mavx2, picked at runtime).
+#define BVHW_FN   bvh8_hit_closest_sse
+#define BVHW_NODE Bvh8Node
+#define BVHW_W    8
+#define BVHW_T    ysu_f8
+#define BVHW_OP(x) BVHW_CAT(ysu_f8, x)
+#include "bvh_wide_kernel.h"
+#undef BVHW_FN
+#undef BVHW_NODE
+#undef BVHW_W
+#undef BVHW_T
+#undef BVHW_OP
+
+extern const int g_bvh8_avx2_built;
+int bvh8_hit_closest_avx2(const Bvh8Node* nodes, const Sphere* spheres, const Ray* r,
+                          float t_min, float t_max, float* t_out);
+
+// ------------------------- CPU / width selection -------------------------
+static pthread_once_t g_wide_once = PTHREAD_ONCE_INIT;
+static int g_wide_avx2 = 0;
+
+static void wide_detect(void) {
+    if (!g_bvh8_avx2_built) return;
+    CPUFeatures f = ysu_detect_cpu_features();
+    g_wide_avx2 = f.has_avx2 ? 1 : 0;
+}
+
+int bvh_wide_default_width(void) {
+    const char *s = getenv("YSU_BVH_WIDTH");
+    if (s && s[0]) {
+        int w = atoi(s);
+        return (w == 2 || w == 4 || w == 8) ? w : 2;
+    }
+    pthread_once(&g_wide_once, wide_detect);
+    return g_wide_avx2 ? 8 : 4;
+}
+
+// ------------------------- collapse -------------------------
+typedef struct {
+    float  *base;       // node array as floats (SoA lanes)
+    int     width;
+    int     next;       // nodes emitted
+} WideBuild;
+
+static int wide_internal_count(const bvh_node* n) {
+    if (!n || n->prune || n->count > 0) return 0;
+    return 1 + wide_internal_count(n->left) + wide_internal_count(n->right);
+}
+
+// Also true for an inner node whose children are all pruned.
+static int wide_is_empty(const bvh_node* n) {
+    if (!n || n->prune) return 1;
+    if (n->count > 0) return 0;
+    return wide_is_empty(n->left) && wide_is_empty(n->right);
+}
+
+static float wide_area(const aabb* b) {
+    Vec3 e = vec3_sub(b->maximum, b->minimum);
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+// Children of one wide node: opens the inner slot with the largest surface
+// area until there are `width` slots or only leaves are left.
+static int wide_gather(const bvh_node* n, int width, const bvh_node** slots) {
+    int cnt = 0;
+    if (n->count > 0) {                 // the whole tree is one leaf
+        slots[cnt++] = n;
+        return cnt;
+    }
+    if (!wide_is_empty(n->left))  slots[cnt++] = n->left;
+    if (!wide_is_empty(n->right)) slots[cnt++] = n->right;
+
+    while (cnt < width) {
+        int pick = -1;
+        float pick_area = -1.0f;
+        for (int k = 0; k < cnt; ++k) {
+            if (slots[k]->count > 0) continue;
+            float ar = wide_area(&slots[k]->box);
+            if (ar > pick_area) { pick_area = ar; pick = k; }
+        }
+        if (pick < 0) break;
+
+        const bvh_node* open = slots[pick];
+        const bvh_node* l = wide_is_empty(open->left)  ? NULL : open->left;
+        const bvh_node* r = wide_is_empty(open->right) ? NULL : open->right;
+        if (l && r) {
+            slots[pick] = l;
+            slots[cnt++] = r;
+        } else {
+            slots[pick] = l ? l : r;    // never both empty: wide_is_empty(open) was false
+        }
+    }
+    return cnt;
+}
+
+static void wide_emit(WideBuild* b, int idx, const bvh_node* n) {
+    const int W = b->width;
+    float   *f     = b->base + (size_t)idx * (size_t)(8 * W);
+    int32_t *child = (int32_t*)(f + 6 * W);
+    int32_t *count = child + W;
+
+    const bvh_node* slots[8];
+    int cnt = wide_gather(n, W, slots);
+
+    for (int k = 0; k < W; ++k) {
+        if (k >= cnt) {
+            // degenerate box at +FLT_MAX: the slab test rejects it for any
+            // ray inside the scene; count < 0 keeps it out of the stack too
+            for (int a = 0; a < 6; ++a) f[a * W + k] = FLT_MAX;
+            child[k] = -1;
+            count[k] = -1;
+            continue;
+        }
+        const bvh_node* s = slots[k];
+        f[0 * W + k] = s->box.minimum.x;
+        f[1 * W + k] = s->box.minimum.y;
+        f[2 * W + k] = s->box.minimum.z;
+        f[3 * W + k] = s->box.maximum.x;
+        f[4 * W + k] = s->box.maximum.y;
+        f[5 * W + k] = s->box.maximum.z;
+        if (s->count > 0) {
+            child[k] = s->start;
+            count[k] = s->count;
+        } else {
+            child[k] = b->next++;
+            count[k] = 0;
+        }
+    }
+
+    // children after all lanes are filled, DFS order
+    for (int k = 0; k < cnt; ++k) {
+        if (count[k] == 0) wide_emit(b, child[k], slots[k]);
+    }
+}
+
+static void *wide_aligned_alloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, 64);
+#else
+    void *p = NULL;
+    if (posix_memalign(&p, 64, size) != 0) return NULL;
+    return p;
+#endif
+}
+
+static void wide_aligned_free(void *p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+int bvh_wide_build(const bvh_node* root, int width, BvhWide* out) {
+    memset(out, 0, sizeof(*out));
+    if (width != 4 && width != 8) return 0;
+    if (wide_is_empty(root)) return 1;
+
+    // each wide node consumes at least one binary inner node (plus the
+    // root node when the whole tree is one leaf)
+    int cap = wide_internal_count(root) + 1;
+    size_t node_bytes = (width == 4) ? sizeof(Bvh4Node) : sizeof(Bvh8Node);
+    void *nodes = wide_aligned_alloc(node_bytes * (size_t)cap);
+    if (!nodes) return 0;
+
+    WideBuild b;
+    b.base  = (float*)nodes;
+    b.width = width;
+    b.next  = 1;
+    wide_emit(&b, 0, root);
+
+    pthread_once(&g_wide_once, wide_detect);
+    out->width = width;
+    out->count = b.next;
+    out->nodes = nodes;
+    out->avx2  = (width == 8) && g_wide_avx2;
+    return 1;
+}
+
+void bvh_wide_free(BvhWide* bvh) {
+    if (!bvh) return;
+    wide_aligned_free(bvh->nodes);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+int bvh_wide_hit_closest(const BvhWide* bvh, const Sphere* spheres, const Ray* r,
+                         float t_min, float t_max, float* t_out)
+{
+    if (!bvh || bvh->count <= 0) return -1;
+    if (bvh->width == 4) {
+        return bvh4_hit_closest_sse((const Bvh4Node*)bvh->nodes, spheres, r, t_min, t_max, t_out);
+    }
+    if (bvh->avx2) {
+        return bvh8_hit_closest_avx2((const Bvh8Node*)bvh->nodes, spheres, r, t_min, t_max, t_out);
+    }
+    return bvh8_hit_closest_sse((const Bvh8Node*)bvh->nodes, spheres, r, t_min, t_max, t_out);
+}
@@ -0,0 +1,58 @@
+// bvh_wide.h - 4-wide / 8-wide sphere BVH collapsed from the binary tree
+#ifndef BVH_WIDE_H
+#define BVH_WIDE_H
+
+#include <stdint.h>
+
+#include "bvh.h"
+
+// A wide node holds up to W child boxes in SoA order, so a ray tests all of
+// them with one SIMD slab test. Per lane:
+//   count >  0  leaf, child = first sphere index
+//   count == 0  inner node, child = node index
+//   count <  0  empty lane (degenerate box far outside the scene)
+typedef struct {
+    float   bmin_x[4], bmin_y[4], bmin_z[4];
+    float   bmax_x[4], bmax_y[4], bmax_z[4];
+    int32_t child[4];
+    int32_t count[4];
+} Bvh4Node;     // 128 bytes
+
+typedef struct {
+    float   bmin_x[8], bmin_y[8], bmin_z[8];
+    float   bmax_x[8], bmax_y[8], bmax_z[8];
+    int32_t child[8];
+    int32_t count[8];
+} Bvh8Node;     // 256 bytes
+
+typedef struct {
+    int   width;    // 4 or 8
+    int   count;    // nodes; node 0 is the root
+    void *nodes;    // Bvh4Node / Bvh8Node array, 64-byte aligned
+    int   avx2;     // width 8: traverse with the AVX2 kernel
+} BvhWide;
+
+// Width for the render BVH (env: YSU_BVH_WIDTH=2|4|8). Default: 8 when
+// ysu_detect_cpu_features() reports AVX2 and the AVX2 kernel was built,
+// else 4 (SSE). 2 keeps the flattened binary tree.
+int bvh_wide_default_width(void);
+
+// Collapses root into a width-ary tree: each wide node opens the child
+// with the largest surface area until it has width children. Pruned and
+// empty subtrees are dropped; sphere indices are unchanged.
+// Returns 1 on success, 0 on bad width / out of memory (out is zeroed).
+int  bvh_wide_build(const bvh_node* root, int width, BvhWide* out);
+void bvh_wide_free(BvhWide* bvh);
+
+// Closest sphere index (or -1) and its t; same hit as bvh_hit_closest().
+// Children are visited nearest-first. Read-only, safe from many threads.
+int bvh_wide_hit_closest(
+    const BvhWide* bvh,
+    const Sphere* spheres,
+    const Ray* r,
+    float t_min,
+    float t_max,
+    float* t_out
+);
+
+#endif // BVH_WIDE_H
@@ -0,0 +1,39 @@
+// bvh_wide_avx2.c - BVH8 traversal kernel built with -mavx2
+//
+// Only called after ysu_detect_cpu_features() reports AVX2 (bvh_wide.c).
+// Built without -mfma so the sphere math rounds like the scalar path.
+#include "bvh_wide.h"
+
+#include <math.h>
+
+#if defined(__AVX2__)
+#include "vec3_simd.h"
+
+#define BVHW_CAT_(a, b) a##_##b
+#define BVHW_CAT(a, b)  BVHW_CAT_(a, b)
+
+#define BVHW_FN   bvh8_hit_closest_avx2_kernel
+#define BVHW_NODE Bvh8Node
+#define BVHW_W    8
+#define BVHW_T    ysu_f8
+#define BVHW_OP(x) BVHW_CAT(ysu_f8, x)
+#include "bvh_wide_kernel.h"
+
+const int g_bvh8_avx2_built = 1;
+
+int bvh8_hit_closest_avx2(const Bvh8Node* nodes, const Sphere* spheres, const Ray* r,
+                          float t_min, float t_max, float* t_out)
+{
+    return bvh8_hit_closest_avx2_kernel(nodes, spheres, r, t_min, t_max, t_out);
+}
+#else
+const int g_bvh8_avx2_built = 0;
+
+// never selected: g_bvh8_avx2_built keeps the dispatcher on the SSE kernel
+int bvh8_hit_closest_avx2(const Bvh8Node* nodes, const Sphere* spheres, const Ray* r,
+                          float t_min, float t_max, float* t_out)
+{
+    (void)nodes; (void)spheres; (void)r; (void)t_min; (void)t_max; (void)t_out;
+    return -1;
+}
+#endif
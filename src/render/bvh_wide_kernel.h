@@ -0,0 +1,114 @@
+// bvh_wide_kernel.h - wide BVH closest-hit traversal, instantiated per width
+//
+// Include after vec3_simd.h with:
+//   BVHW_FN    function name
+//   BVHW_NODE  Bvh4Node / Bvh8Node
+//   BVHW_W     lanes (4 / 8)
+//   BVHW_T     lane type (ysu_f4 / ysu_f8), BVHW_OP(x) -> ysu_f4_x / ysu_f8_x
+// No include guard: every inclusion emits one more kernel. The slab and
+// sphere math are the scalar bvh_hit_closest() ops lane by lane, so all
+// widths return the same hit.
+
+#ifndef BVH_WIDE_KERNEL_COMMON
+#define BVH_WIDE_KERNEL_COMMON
+
+// Every inner node pops itself and pushes at most W hit children, so a walk
+// to depth d holds at most d*(W-1)+1 entries. Collapsing never deepens the
+// binary tree, whose leaves the SAH builder keeps above BVH_STACK_MAX, so
+// this bound is never reached.
+#define BVH_WIDE_STACK(w) (BVH_STACK_MAX * ((w) - 1) + 1)
+
+typedef struct {
+    int32_t ref;    // node index, or first sphere for a leaf
+    int32_t count;  // > 0 leaf sphere count, 0 inner node
+    float   t;      // entry distance when pushed
+} BvhWideEntry;
+
+static inline void bvh_wide_leaf(const Sphere* s, int first, int count, const Ray* r, float a,
+                                 float t_min, float* closest, int* best)
+{
+    s += first;
+    for (int i = 0; i < count; ++i, ++s) {
+        Vec3 oc = vec3_sub(r->origin, s->center);
+        float half_b = vec3_dot(oc, r->direction);
+        float c = vec3_length_squared(oc) - s->radius * s->radius;
+        float disc = half_b * half_b - a * c;
+        if (disc < 0.0f) continue;
+        float sq = sqrtf(disc);
+        float t = (-half_b - sq) / a;
+        if (t < t_min || t > *closest) {
+            t = (-half_b + sq) / a;
+            if (t < t_min || t > *closest) continue;
+        }
+        *closest = t;
+        *best = first + i;
+    }
+}
+#endif
+
+static int BVHW_FN(const BVHW_NODE* nodes, const Sphere* spheres, const Ray* r,
+                   float t_min, float t_max, float* t_out)
+{
+    const float a = vec3_length_squared(r->direction);
+    const BVHW_T ox = BVHW_OP(set1)(r->origin.x);
+    const BVHW_T oy = BVHW_OP(set1)(r->origin.y);
+    const BVHW_T oz = BVHW_OP(set1)(r->origin.z);
+    const BVHW_T ix = BVHW_OP(set1)(1.0f / r->direction.x);
+    const BVHW_T iy = BVHW_OP(set1)(1.0f / r->direction.y);
+    const BVHW_T iz = BVHW_OP(set1)(1.0f / r->direction.z);
+    const BVHW_T vt_min = BVHW_OP(set1)(t_min);
+
+    BvhWideEntry stack[BVH_WIDE_STACK(BVHW_W)];
+    int sp = 0;
+    int best = -1;
+    float closest = t_max;
+
+    stack[sp].ref = 0;
+    stack[sp].count = 0;
+    stack[sp++].t = t_min;
+
+    while (sp > 0) {
+        BvhWideEntry e = stack[--sp];
+        if (e.t > closest) continue;   // a nearer hit was found since the push
+        if (e.count > 0) {
+            bvh_wide_leaf(spheres, e.ref, e.count, r, a, t_min, &closest, &best);
+            continue;
+        }
+
+        // all children in one slab test
+        const BVHW_NODE* node = &nodes[e.ref];
+        BVHW_T t0 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmin_x), ox), ix);
+        BVHW_T t1 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmax_x), ox), ix);
+        BVHW_T tn = BVHW_OP(max)(vt_min, BVHW_OP(min)(t0, t1));
+        BVHW_T tf = BVHW_OP(min)(BVHW_OP(set1)(closest), BVHW_OP(max)(t0, t1));
+        t0 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmin_y), oy), iy);
+        t1 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmax_y), oy), iy);
+        tn = BVHW_OP(max)(tn, BVHW_OP(min)(t0, t1));
+        tf = BVHW_OP(min)(tf, BVHW_OP(max)(t0, t1));
+        t0 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmin_z), oz), iz);
+        t1 = BVHW_OP(mul)(BVHW_OP(sub)(BVHW_OP(load)(node->bmax_z), oz), iz);
+        tn = BVHW_OP(max)(tn, BVHW_OP(min)(t0, t1));
+        tf = BVHW_OP(min)(tf, BVHW_OP(max)(t0, t1));
+
+        int mask = BVHW_OP(mask)(BVHW_OP(ge)(tf, tn));
+        if (!mask) continue;
+
+        float tnear[BVHW_W];
+        BVHW_OP(store)(tnear, tn);
+
+        // hit children sorted far -> near, so the nearest is popped next
+        BvhWideEntry hit[BVHW_W];
+        int nh = 0;
+        for (int k = 0; k < BVHW_W; ++k) {
+            if (!((mask >> k) & 1) || node->count[k] < 0) continue;
+            BvhWideEntry h = { node->child[k], node->count[k], tnear[k] };
+            int j = nh++;
+            while (j > 0 && hit[j - 1].t < h.t) { hit[j] = hit[j - 1]; --j; }
+            hit[j] = h;
+        }
+        for (int j = 0; j < nh && sp < BVH_WIDE_STACK(BVHW_W); ++j) stack[sp++] = hit[j];
+    }
+
+    if (best >= 0 && t_out) *t_out = closest;
+    return best;
+}
@@ -9,6 +9,7 @@ typedef struct {
     Vec3 *normal;   // RGB float32 (xyz)
     Vec3 *albedo;   // RGB float32
     float *depth;   // float32 (t or distance)
+    float *shadow;  // float32: 1 = sees the sun, 0 = shadowed / facing away, -1 = miss
     int width, height;
 } YSU_GBuffer;
 
@@ -10,7 +10,7 @@ typedef struct {
     uint32_t version;    // 1
     uint32_t width;
     uint32_t height;
-    uint32_t channels;   // 3 RGB, 1 single
+    uint32_t channels;   // 3 RGB, 1 single, n for ysu_dump_f32n
     uint32_t dtype;      // 1 = float32
 } YSU_BinHeader;
 
@@ -57,17 +57,22 @@ int ysu_dump_rgb32(const char *path, const Vec3 *rgb, int width, int height)
 
 int ysu_dump_f32(const char *path, const float *buf, int width, int height)
 {
-    if (!path || !buf || width <= 0 || height <= 0) return 0;
+    return ysu_dump_f32n(path, buf, width, height, 1);
+}
+
+int ysu_dump_f32n(const char *path, const float *buf, int width, int height, int channels)
+{
+    if (!path || !buf || width <= 0 || height <= 0 || channels <= 0) return 0;
 
     FILE *f = fopen(path, "wb");
     if (!f) return 0;
 
-    if (!ysu_write_header(f, (uint32_t)width, (uint32_t)height, 1u)) {
+    if (!ysu_write_header(f, (uint32_t)width, (uint32_t)height, (uint32_t)channels)) {
         fclose(f);
         return 0;
     }
 
-    size_t count = (size_t)width * (size_t)height;
+    size_t count = (size_t)width * (size_t)height * (size_t)channels;
     if (fwrite(buf, sizeof(float), count, f) != count) {
         fclose(f);
         return 0;
@@ -15,6 +15,11 @@ int ysu_dump_rgb32(const char *path, const Vec3 *rgb, int width, int height);
 // Returns 1 on success, 0 on failure.
 int ysu_dump_f32(const char *path, const float *buf, int width, int height);
 
+// Writes a float32 buffer of `channels` interleaved channels per pixel
+// (e.g. 4 for RGBA / packed AOVs) to a .ysub file. Read it back with
+// ysub_reader.h. Returns 1 on success, 0 on failure.
+int ysu_dump_f32n(const char *path, const float *buf, int width, int height, int channels);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,601 @@
+// mesh_bvh.c - triangle mesh BVH with 8-triangle SoA leaves
+#include "mesh_bvh.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <malloc.h>
+#endif
+
+#include "gpu_bvh_build.h"
+#include "bvh_packet.h"   // bvh_packet_config (AVX2 detection)
+
+#define MESH_LEAF  8       // triangles per builder leaf = one YSU_Tri8 block
+#define MESH_STACK 64
+#define MESH_NONE  0xFFFFFFFFu
+
+// YSU_Tri8 is 9 rows of 8 floats (v0x v0y v0z e1x e1y e1z e2x e2y e2z) in
+// both builds (__m256 or float[8]); blocks are filled and read as floats.
+enum { T8_V0X, T8_V0Y, T8_V0Z, T8_E1X, T8_E1Y, T8_E1Z, T8_E2X, T8_E2Y, T8_E2Z };
+#define T8(f, row, lane) ((f)[(row) * 8 + (lane)])
+
+static double mesh_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+static void *mesh_aligned_alloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, 64);
+#else
+    void *p = NULL;
+    if (posix_memalign(&p, 64, size) != 0) return NULL;
+    return p;
+#endif
+}
+
+static void mesh_aligned_free(void *p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// AVX2 decode + leaf test for quantised blocks (mesh_bvh_avx2.c, compiled
+// with -mavx2, picked at runtime).
+extern const int g_mesh_qavx2_built;
+YSU_Hit1 mesh_qtri8_avx2(const Ray *r, const MeshQBlock *b, float t_min, float t_max);
+
+// ------------------------- build -------------------------
+// Triangles as tri_vec4 or as an indexed mesh.
+typedef struct {
+    const float    *tris;
+    const float    *verts;
+    const uint32_t *indices;
+} MeshSrc;
+
+static inline const float *mesh_corner(const MeshSrc *src, uint32_t t, int k) {
+    return src->tris ? src->tris + (size_t)t * 12u + (size_t)k * 4u
+                     : src->verts + (size_t)src->indices[(size_t)t * 3u + (size_t)k] * 3u;
+}
+
+static void mesh_fill_lane(float *f, int lane, const float *p0, const float *p1, const float *p2) {
+    T8(f, T8_V0X, lane) = p0[0];
+    T8(f, T8_V0Y, lane) = p0[1];
+    T8(f, T8_V0Z, lane) = p0[2];
+    T8(f, T8_E1X, lane) = p1[0] - p0[0];
+    T8(f, T8_E1Y, lane) = p1[1] - p0[1];
+    T8(f, T8_E1Z, lane) = p1[2] - p0[2];
+    T8(f, T8_E2X, lane) = p2[0] - p0[0];
+    T8(f, T8_E2Y, lane) = p2[1] - p0[1];
+    T8(f, T8_E2Z, lane) = p2[2] - p0[2];
+}
+
+// Corner k of a quantised lane, same ops as the AVX2 decode.
+static inline void mesh_q_corner(const MeshQBlock *b, int lane, int k, float out[3]) {
+    for (int a = 0; a < 3; ++a) {
+        out[a] = b->org[a] + (float)b->q[k * 3 + a][lane] * mesh_q_step(b->exp[a]);
+    }
+}
+
+// Row by row so the lanes vectorise; decoded corners and their differences
+// are exact, so this matches mesh_fill_lane() over mesh_q_corner() bit for bit.
+static void mesh_q_decode(const MeshQBlock *b, float *f) {
+    for (int a = 0; a < 3; ++a) {
+        const float o = b->org[a], s = mesh_q_step(b->exp[a]);
+        for (int lane = 0; lane < 8; ++lane) {
+            float v0 = o + (float)b->q[a][lane] * s;
+            T8(f, T8_V0X + a, lane) = v0;
+            T8(f, T8_E1X + a, lane) = (o + (float)b->q[3 + a][lane] * s) - v0;
+            T8(f, T8_E2X + a, lane) = (o + (float)b->q[6 + a][lane] * s) - v0;
+        }
+    }
+}
+
+#define MESH_Q_CELLS 255
+#define MESH_Q_EMAX  126
+
+// Canonical vertex ids: corners at the same position share one, whichever
+// triangles or indices they come from (tri_vec4 corners or the indexed
+// vertex array are hashed by their float bits; -0 counts as 0).
+typedef struct {
+    uint32_t *canon;      // key -> vertex id
+    uint32_t  count;      // distinct vertices
+} MeshQVerts;
+
+static inline const float *mesh_q_key_pos(const MeshSrc *src, uint32_t key) {
+    return src->tris ? src->tris + (size_t)(key / 3u) * 12u + (size_t)(key % 3u) * 4u
+                     : src->verts + (size_t)key * 3u;
+}
+
+static inline uint32_t mesh_q_vid(const MeshSrc *src, const MeshQVerts *v, uint32_t t, int k) {
+    size_t c = (size_t)t * 3u + (size_t)k;
+    return v->canon[src->tris ? c : src->indices[c]];
+}
+
+static int mesh_q_verts(const MeshSrc *src, uint32_t tri_count, MeshQVerts *v) {
+    uint32_t keys = 0;
+    if (src->tris) {
+        keys = tri_count * 3u;
+    } else {
+        for (size_t c = 0; c < (size_t)tri_count * 3u; ++c) {
+            if (src->indices[c] >= keys) keys = src->indices[c] + 1u;
+        }
+    }
+    size_t cap = 16;
+    while (cap < (size_t)keys * 2u) cap <<= 1;
+    uint32_t *table = (uint32_t*)calloc(cap, sizeof(uint32_t));   // first key + 1, 0 = empty
+    v->canon = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)keys);
+    v->count = 0;
+    if (!table || !v->canon) {
+        free(table);
+        free(v->canon);
+        v->canon = NULL;
+        return 0;
+    }
+    for (uint32_t key = 0; key < keys; ++key) {
+        const float *p = mesh_q_key_pos(src, key);
+        uint32_t w[3];
+        for (int a = 0; a < 3; ++a) {
+            float f = p[a] + 0.0f;
+            memcpy(&w[a], &f, sizeof(w[a]));
+        }
+        uint64_t h = ((uint64_t)w[0] * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)w[1] * 0xC2B2AE3D27D4EB4Full)
+                   ^ ((uint64_t)w[2] * 0x165667B19E3779F9ull);
+        size_t i = (size_t)(h ^ (h >> 29)) & (cap - 1u);
+        for (;; i = (i + 1u) & (cap - 1u)) {
+            if (table[i] == 0) {
+                table[i] = key + 1u;
+                v->canon[key] = v->count++;
+                break;
+            }
+            const float *o = mesh_q_key_pos(src, table[i] - 1u);
+            if (o[0] == p[0] && o[1] == p[1] && o[2] == p[2]) {
+                v->canon[key] = v->canon[table[i] - 1u];
+                break;
+            }
+        }
+    }
+    free(table);
+    return 1;
+}
+
+static inline float mesh_q_snap(float x, int e) {
+    return rintf(x * mesh_q_step(-e)) * mesh_q_step(e);
+}
+
+// Per-block grids. Each block starts at the finest power-of-two step whose
+// 255 cells (less one for rounding) span its triangles, but no finer than
+// 2^-23 of the largest coordinate so that cell numbers stay exact floats.
+// A vertex is snapped to the coarsest step among the blocks that use it;
+// a block whose snapped corners no longer fit doubles its step and the
+// snapping is redone, until nothing changes (steps only grow).
+static int mesh_q_fill(MeshBvh *m, const MeshSrc *src, uint32_t tri_count) {
+    MeshQVerts v;
+    if (!mesh_q_verts(src, tri_count, &v)) return 0;
+    int8_t *ve = (int8_t*)malloc((size_t)v.count * 3u);
+    if (!ve) {
+        free(v.canon);
+        return 0;
+    }
+
+    int e_min[3];
+    for (int a = 0; a < 3; ++a) {
+        int x;
+        frexpf(fmaxf(fabsf(m->nodes[0].bmin[a]), fabsf(m->nodes[0].bmax[a])), &x);
+        e_min[a] = x - 23 < -MESH_Q_EMAX ? -MESH_Q_EMAX : x - 23;
+    }
+    for (uint32_t b = 0; b < m->block_count; ++b) {
+        MeshQBlock *qb = &m->qblocks[b];
+        for (int a = 0; a < 3; ++a) {
+            float lo = FLT_MAX, hi = -FLT_MAX;
+            for (uint32_t s = b * 8u; s < b * 8u + 8u; ++s) {
+                if (m->tri[s] == MESH_NONE) continue;
+                for (int k = 0; k < 3; ++k) {
+                    float x = mesh_corner(src, m->tri[s], k)[a];
+                    lo = fminf(lo, x);
+                    hi = fmaxf(hi, x);
+                }
+            }
+            int e = e_min[a];
+            while (lo < hi && hi - lo > (float)(MESH_Q_CELLS - 1) * mesh_q_step(e) && e < MESH_Q_EMAX) ++e;
+            qb->exp[a] = (int8_t)e;
+        }
+    }
+
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        memset(ve, INT8_MIN, (size_t)v.count * 3u);
+        for (size_t s = 0; s < (size_t)m->block_count * 8u; ++s) {
+            if (m->tri[s] == MESH_NONE) continue;
+            const MeshQBlock *qb = &m->qblocks[s / 8u];
+            for (int k = 0; k < 3; ++k) {
+                int8_t *e = ve + (size_t)mesh_q_vid(src, &v, m->tri[s], k) * 3u;
+                for (int a = 0; a < 3; ++a) if (qb->exp[a] > e[a]) e[a] = qb->exp[a];
+            }
+        }
+        for (uint32_t b = 0; b < m->block_count; ++b) {
+            MeshQBlock *qb = &m->qblocks[b];
+            float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            float sn[8][3][3];
+            for (int lane = 0; lane < 8; ++lane) {
+                uint32_t t = m->tri[b * 8u + (uint32_t)lane];
+                if (t == MESH_NONE) continue;
+                for (int k = 0; k < 3; ++k) {
+                    const float *p = mesh_corner(src, t, k);
+                    const int8_t *e = ve + (size_t)mesh_q_vid(src, &v, t, k) * 3u;
+                    for (int a = 0; a < 3; ++a) {
+                        sn[lane][k][a] = mesh_q_snap(p[a], e[a]);
+                        lo[a] = fminf(lo[a], sn[lane][k][a]);
+                        hi[a] = fmaxf(hi[a], sn[lane][k][a]);
+                    }
+                }
+            }
+            if (lo[0] > hi[0]) continue;   // padding only: zero triangles
+            int grown = 0;
+            for (int a = 0; a < 3; ++a) {
+                if (hi[a] - lo[a] > (float)MESH_Q_CELLS * mesh_q_step(qb->exp[a]) && qb->exp[a] < MESH_Q_EMAX) {
+                    qb->exp[a]++;
+                    grown = 1;
+                }
+            }
+            if (grown) {
+                changed = 1;
+                continue;
+            }
+            // lo is on the vertex steps, all multiples of the block step:
+            // cells are exact integers
+            for (int a = 0; a < 3; ++a) qb->org[a] = lo[a];
+            for (int lane = 0; lane < 8; ++lane) {
+                if (m->tri[b * 8u + (uint32_t)lane] == MESH_NONE) continue;
+                for (int k = 0; k < 3; ++k) {
+                    for (int a = 0; a < 3; ++a) {
+                        float c = (sn[lane][k][a] - lo[a]) * mesh_q_step(-qb->exp[a]);
+                        qb->q[k * 3 + a][lane] = (uint8_t)(c < (float)MESH_Q_CELLS ? c : (float)MESH_Q_CELLS);
+                    }
+                }
+            }
+        }
+    }
+    free(ve);
+    free(v.canon);
+    return 1;
+}
+
+// Quantised vertices can sit up to half a cell outside the source boxes:
+// leaves get the box of their decoded triangles, inner nodes the union of
+// their children (DFS order puts children after their parent).
+static void mesh_q_refit(MeshBvh *m) {
+    for (uint32_t i = m->node_count; i-- > 0; ) {
+        MeshBvhNode *n = &m->nodes[i];
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        if (n->count > 0) {
+            int any = 0;
+            for (uint32_t s = n->offset * 8u; s < (n->offset + n->count) * 8u; ++s) {
+                if (m->tri[s] == MESH_NONE) continue;
+                for (int k = 0; k < 3; ++k) {
+                    float p[3];
+                    mesh_q_corner(&m->qblocks[s / 8u], (int)(s % 8u), k, p);
+                    for (int a = 0; a < 3; ++a) {
+                        lo[a] = fminf(lo[a], p[a]);
+                        hi[a] = fmaxf(hi[a], p[a]);
+                    }
+                }
+                any = 1;
+            }
+            if (!any) continue;    // empty leaf keeps its box
+        } else {
+            const MeshBvhNode *l = &m->nodes[i + 1], *r = &m->nodes[n->offset];
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = fminf(l->bmin[a], r->bmin[a]);
+                hi[a] = fmaxf(l->bmax[a], r->bmax[a]);
+            }
+        }
+        for (int a = 0; a < 3; ++a) {
+            n->bmin[a] = lo[a];
+            n->bmax[a] = hi[a];
+        }
+    }
+}
+
+static int g_mesh_quant = -1;   // -1: YSU_MESH_QUANT
+
+void mesh_bvh_set_quant(int enabled) {
+    g_mesh_quant = enabled ? 1 : 0;
+}
+
+static int mesh_bvh_build_src(MeshBvh *m, const MeshSrc *src, uint32_t tri_count) {
+    memset(m, 0, sizeof(*m));
+    if (tri_count == 0) return 0;
+    double t0 = mesh_now_ms();
+    const char *qe = getenv("YSU_MESH_QUANT");
+    const int quant = (g_mesh_quant >= 0) ? g_mesh_quant : (qe && qe[0] && qe[0] != '0');
+
+    GPUBVHNode *gn = NULL;
+    int32_t *gi = NULL;
+    uint32_t gn_count = 0, gi_count = 0;
+    GpuBvhBuildCtx ctx;
+    gpu_bvh_build_ctx_init(&ctx);
+    ctx.leaf_max = MESH_LEAF;
+    int ok = src->tris
+           ? gpu_bvh_build_ctx_run(&ctx, src->tris, tri_count, &gn, &gn_count, &gi, &gi_count)
+           : gpu_bvh_build_ctx_run_indexed(&ctx, src->verts, src->indices, tri_count, &gn, &gn_count, &gi, &gi_count);
+    gpu_bvh_build_ctx_free(&ctx);
+    if (!ok || gn_count == 0) {
+        free(gn);
+        free(gi);
+        return 0;
+    }
+
+    uint32_t blocks = 0;
+    for (uint32_t i = 0; i < gn_count; ++i) {
+        if (gn[i].left < 0) blocks += gn[i].triCount > 0 ? ((uint32_t)gn[i].triCount + 7u) / 8u : 1u;
+    }
+    size_t block_size = quant ? sizeof(MeshQBlock) : sizeof(YSU_Tri8);
+    void *bl = mesh_aligned_alloc(block_size * (size_t)blocks);
+    if (quant) m->qblocks = (MeshQBlock*)bl;
+    else       m->blocks = (YSU_Tri8*)bl;
+    m->nodes = (MeshBvhNode*)malloc(sizeof(MeshBvhNode) * (size_t)gn_count);
+    m->tri   = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)blocks * 8u);
+    if (!m->nodes || !bl || !m->tri) {
+        free(gn);
+        free(gi);
+        mesh_bvh_free(m);
+        return 0;
+    }
+    memset(bl, 0, block_size * (size_t)blocks);
+    for (size_t s = 0; s < (size_t)blocks * 8u; ++s) m->tri[s] = MESH_NONE;
+
+    // DFS: the left child is popped next and lands right after its parent;
+    // the right child patches the parent's offset when it is emitted.
+    struct { int32_t src; int32_t parent; } stack[MESH_STACK];
+    int sp = 0;
+    uint32_t out = 0, next_block = 0;
+    stack[sp].src = 0;
+    stack[sp++].parent = -1;
+    while (sp > 0) {
+        --sp;
+        const GPUBVHNode *g = &gn[stack[sp].src];
+        uint32_t i = out++;
+        if (stack[sp].parent >= 0) m->nodes[stack[sp].parent].offset = i;
+
+        MeshBvhNode *n = &m->nodes[i];
+        for (int a = 0; a < 3; ++a) {
+            n->bmin[a] = g->bmin[a];
+            n->bmax[a] = g->bmax[a];
+        }
+        if (g->left < 0) {
+            uint32_t cnt = g->triCount > 0 ? (uint32_t)g->triCount : 0u;
+            n->offset = next_block;
+            n->count = cnt ? (cnt + 7u) / 8u : 1u;
+            for (uint32_t k = 0; k < cnt; ++k) {
+                uint32_t slot = next_block * 8u + k;
+                uint32_t t = (uint32_t)gi[g->triOffset + (int32_t)k];
+                if (!quant) {
+                    mesh_fill_lane((float*)&m->blocks[slot / 8u], (int)(slot % 8u),
+                                   mesh_corner(src, t, 0), mesh_corner(src, t, 1), mesh_corner(src, t, 2));
+                }
+                m->tri[slot] = t;
+            }
+            next_block += n->count;
+            continue;
+        }
+        n->count = 0;
+        if (sp + 2 > MESH_STACK) {   // median splits stay far below this
+            free(gn);
+            free(gi);
+            mesh_bvh_free(m);
+            return 0;
+        }
+        stack[sp].src = g->right;
+        stack[sp++].parent = (int32_t)i;
+        stack[sp].src = g->left;
+        stack[sp++].parent = -1;
+    }
+    free(gn);
+    free(gi);
+
+    m->node_count = out;
+    m->block_count = next_block;
+    m->tri_count = tri_count;
+    if (quant) {
+        if (!mesh_q_fill(m, src, tri_count)) {
+            mesh_bvh_free(m);
+            return 0;
+        }
+        mesh_q_refit(m);
+    }
+    for (int a = 0; a < 3; ++a) {
+        m->bmin[a] = m->nodes[0].bmin[a];
+        m->bmax[a] = m->nodes[0].bmax[a];
+    }
+    const char *e = getenv("YSU_MESH_SIMD");
+    m->avx2 = bvh_packet_config()->avx2 && !(e && e[0] == '0') && (!quant || g_mesh_qavx2_built);
+    m->bytes = sizeof(MeshBvhNode) * (size_t)out + (block_size + 8u * sizeof(uint32_t)) * (size_t)next_block;
+    m->build_ms = mesh_now_ms() - t0;
+    return 1;
+}
+
+int mesh_bvh_build(MeshBvh *m, const float *tris, uint32_t tri_count) {
+    MeshSrc src = { tris, NULL, NULL };
+    if (!tris) {
+        memset(m, 0, sizeof(*m));
+        return 0;
+    }
+    return mesh_bvh_build_src(m, &src, tri_count);
+}
+
+int mesh_bvh_build_indexed(MeshBvh *m, const float *verts, const uint32_t *indices, uint32_t tri_count) {
+    MeshSrc src = { NULL, verts, indices };
+    if (!verts || !indices) {
+        memset(m, 0, sizeof(*m));
+        return 0;
+    }
+    return mesh_bvh_build_src(m, &src, tri_count);
+}
+
+void mesh_bvh_free(MeshBvh *m) {
+    if (!m) return;
+    free(m->nodes);
+    mesh_aligned_free(m->blocks);
+    mesh_aligned_free(m->qblocks);
+    free(m->tri);
+    memset(m, 0, sizeof(*m));
+}
+
+// ------------------------- traversal -------------------------
+// Scalar leaf test: ysu_intersect_ray1_tri8 lane by lane, same ops in the
+// same order (no FMA in either build), same first-lane-wins tie break.
+static YSU_Hit1 mesh_tri8_scalar(const Ray *r, const float *f, float t_min, float t_max) {
+    const float eps = 1e-8f;
+    const float dx = r->direction.x, dy = r->direction.y, dz = r->direction.z;
+    YSU_Hit1 out = { 0, 0.0f, -1 };
+    float best = t_max;
+
+    for (int i = 0; i < 8; ++i) {
+        float e1x = T8(f, T8_E1X, i), e1y = T8(f, T8_E1Y, i), e1z = T8(f, T8_E1Z, i);
+        float e2x = T8(f, T8_E2X, i), e2y = T8(f, T8_E2Y, i), e2z = T8(f, T8_E2Z, i);
+
+        float px = dy * e2z - dz * e2y;
+        float py = dz * e2x - dx * e2z;
+        float pz = dx * e2y - dy * e2x;
+        float det = e1x * px + e1y * py + e1z * pz;
+        if (!(fabsf(det) > eps)) continue;
+        float inv_det = 1.0f / det;
+
+        float tx = r->origin.x - T8(f, T8_V0X, i);
+        float ty = r->origin.y - T8(f, T8_V0Y, i);
+        float tz = r->origin.z - T8(f, T8_V0Z, i);
+        float u = (tx * px + ty * py + tz * pz) * inv_det;
+        if (!(u >= 0.0f && u <= 1.0f)) continue;
+
+        float qx = ty * e1z - tz * e1y;
+        float qy = tz * e1x - tx * e1z;
+        float qz = tx * e1y - ty * e1x;
+        float v = (dx * qx + dy * qy + dz * qz) * inv_det;
+        if (!(v >= 0.0f && u + v <= 1.0f)) continue;
+
+        float t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+        if (!(t >= t_min && t <= t_max)) continue;
+        if (t < best) {
+            best = t;
+            out.hit = 1;
+            out.t = t;
+            out.tri_index = i;
+        }
+    }
+    return out;
+}
+
+// Entry distance into n, or FLT_MAX on a miss.
+static inline float mesh_enter(const MeshBvhNode *n, const float o[3], const float inv_d[3],
+                               float t_min, float t_max)
+{
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (n->bmin[i] - o[i]) * inv_d[i];
+        float t1 = (n->bmax[i] - o[i]) * inv_d[i];
+        float lo = t0 < t1 ? t0 : t1, hi = t0 < t1 ? t1 : t0;
+        if (lo > t_min) t_min = lo;
+        if (hi < t_max) t_max = hi;
+        if (t_max < t_min) return FLT_MAX;
+    }
+    return t_min;
+}
+
+int mesh_bvh_hit_closest(const MeshBvh *m, const Ray *r, float t_min, float t_max, float *t_out) {
+    if (!m || m->node_count == 0) return -1;
+    const MeshBvhNode *nodes = m->nodes;
+    const float o[3]     = { r->origin.x, r->origin.y, r->origin.z };
+    const float inv_d[3] = { 1.0f / r->direction.x, 1.0f / r->direction.y, 1.0f / r->direction.z };
+    const int avx2 = m->avx2;
+
+    // the AVX2 kernel marks dead lanes with t = 1e30, so never look past it
+    float closest = t_max < 1e30f ? t_max : 1e30f;
+    int best = -1;
+
+    uint32_t stack[MESH_STACK];
+    float stack_t[MESH_STACK];
+    int sp = 0;
+    float f[72];   // decoded quantised block (scalar test)
+
+    float t_root = mesh_enter(&nodes[0], o, inv_d, t_min, closest);
+    if (t_root == FLT_MAX) return -1;
+    stack[sp] = 0;
+    stack_t[sp++] = t_root;
+
+    while (sp > 0) {
+        --sp;
+        if (stack_t[sp] > closest) continue;
+        uint32_t ni = stack[sp];
+
+        for (;;) {
+            const MeshBvhNode *node = &nodes[ni];
+            if (node->count > 0) {
+                for (uint32_t b = node->offset; b < node->offset + node->count; ++b) {
+                    YSU_Hit1 h;
+                    if (m->qblocks) {
+                        if (avx2) {
+                            h = mesh_qtri8_avx2(r, &m->qblocks[b], t_min, closest);
+                        } else {
+                            mesh_q_decode(&m->qblocks[b], f);
+                            h = mesh_tri8_scalar(r, f, t_min, closest);
+                        }
+                    } else {
+                        h = avx2 ? ysu_intersect_ray1_tri8(r, &m->blocks[b], t_min, closest)
+                                 : mesh_tri8_scalar(r, (const float*)&m->blocks[b], t_min, closest);
+                    }
+                    if (h.hit) {
+                        closest = h.t;
+                        best = (int)(b * 8u) + h.tri_index;
+                    }
+                }
+                break;
+            }
+
+            uint32_t li = ni + 1, ri = node->offset;
+            float tL = mesh_enter(&nodes[li], o, inv_d, t_min, closest);
+            float tR = mesh_enter(&nodes[ri], o, inv_d, t_min, closest);
+            if (tR < tL) {
+                uint32_t ti = li; li = ri; ri = ti;
+                float tt = tL; tL = tR; tR = tt;
+            }
+            if (tL == FLT_MAX) break;
+            if (tR != FLT_MAX && sp < MESH_STACK) { stack[sp] = ri; stack_t[sp++] = tR; }
+            ni = li;
+        }
+    }
+
+    if (best >= 0 && t_out) *t_out = closest;
+    return best;
+}
+
+Vec3 mesh_bvh_normal(const MeshBvh *m, int slot) {
+    int i = slot % 8;
+    float q[72];
+    const float *f = q;
+    if (m->qblocks) {
+        float p[3][3];
+        for (int k = 0; k < 3; ++k) mesh_q_corner(&m->qblocks[slot / 8], i, k, p[k]);
+        mesh_fill_lane(q, i, p[0], p[1], p[2]);
+    } else {
+        f = (const float*)&m->blocks[slot / 8];
+    }
+    float e1x = T8(f, T8_E1X, i), e1y = T8(f, T8_E1Y, i), e1z = T8(f, T8_E1Z, i);
+    float e2x = T8(f, T8_E2X, i), e2y = T8(f, T8_E2Y, i), e2z = T8(f, T8_E2Z, i);
+    Vec3 n = vec3(e1y * e2z - e1z * e2y, e1z * e2x - e1x * e2z, e1x * e2y - e1y * e2x);
+    float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    return (len > 0.0f) ? vec3(n.x / len, n.y / len, n.z / len) : vec3(0.0f, 1.0f, 0.0f);
+}
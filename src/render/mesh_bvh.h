@@ -0,0 +1,91 @@
+// mesh_bvh.h - triangle mesh BVH for the CPU renderers (SoA 8-triangle leaves)
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vec3.h"
+#include "ray.h"
+#include "ysu_packet.h"   // YSU_Tri8, ysu_intersect_ray1_tri8
+
+// Built with the median triangle builder (gpu_bvh_build.h, 8 triangles per
+// leaf), then flattened in DFS order like BvhFlat: the left child of an
+// inner node is the next node, `offset` the right one. Each leaf owns
+// `count` YSU_Tri8 blocks (v0 + edges, SoA) so the leaf test is one 1-ray
+// x 8-triangle Moller-Trumbore; unused lanes are zero triangles (det 0,
+// never hit). A hit is reported as a slot, block * 8 + lane.
+//
+// With AVX2 (same detection as the packet kernels, env YSU_MESH_SIMD=0 to
+// turn it off) leaves go through ysu_intersect_ray1_tri8; otherwise a
+// scalar loop with the same op order, so both give the same hits.
+//
+// Quantised leaves (env YSU_MESH_QUANT=1) store the three corners as 8-bit
+// cells of a grid of their own block: a float origin and a power-of-two
+// step per axis, sized to the block's triangles (88 bytes per block instead
+// of 288). All steps are powers of two and every origin sits on its own
+// step, so a vertex snapped to the coarsest step of the blocks that use it
+// decodes to the same float in each of them and shared edges stay shared.
+// Node bounds are refitted around the decoded triangles. The leaf test
+// decodes the block on the fly (AVX2 kernel in mesh_bvh_avx2.c, or into a
+// float block for the scalar test) and then runs the same 1-ray x
+// 8-triangle test.
+
+typedef struct {
+    float    bmin[3];
+    uint32_t offset;        // leaf: first block, inner: right child
+    float    bmax[3];
+    uint32_t count;         // leaf: blocks (> 0), inner: 0
+} MeshBvhNode;
+
+typedef struct {
+    float    org[3];        // block grid origin, a multiple of its step
+    int8_t   exp[3];        // step = 2^exp per axis
+    uint8_t  pad;
+    uint8_t  q[9][8];       // v0 xyz, v1 xyz, v2 xyz cells above org, SoA
+} MeshQBlock;
+
+// 2^e for e in [-126, 126], built from the exponent bits (exact)
+static inline float mesh_q_step(int e) {
+    union { uint32_t u; float f; } v;
+    v.u = (uint32_t)(e + 127) << 23;
+    return v.f;
+}
+
+typedef struct {
+    MeshBvhNode *nodes;
+    uint32_t     node_count;
+    YSU_Tri8    *blocks;      // 64-byte aligned (NULL when quantised)
+    MeshQBlock  *qblocks;     // 64-byte aligned, YSU_MESH_QUANT=1
+    uint32_t     block_count;
+    uint32_t    *tri;         // slot -> input triangle, UINT32_MAX on padding lanes;
+                              // traversal never reads it, callers may free it
+    uint32_t     tri_count;
+    float        bmin[3];
+    float        bmax[3];
+    int          avx2;        // leaves use ysu_intersect_ray1_tri8 / the AVX2 decode kernel
+    size_t       bytes;       // nodes + leaf blocks + tri
+    double       build_ms;
+} MeshBvh;
+
+// tris: tri_vec4 layout (12 floats per triangle, obj_load() output); the
+// triangles are copied into the blocks. Returns 0 on no triangles / OOM.
+int  mesh_bvh_build(MeshBvh *m, const float *tris, uint32_t tri_count);
+
+// Same from an indexed mesh (obj_load() with OBJ_LOAD_INDEXED): verts are
+// xyz, indices 3 per triangle; `tri` maps slots to triangle numbers.
+int  mesh_bvh_build_indexed(MeshBvh *m, const float *verts, const uint32_t *indices, uint32_t tri_count);
+
+void mesh_bvh_free(MeshBvh *m);
+
+// Force quantised leaves on or off for subsequent builds, overriding
+// YSU_MESH_QUANT.
+void mesh_bvh_set_quant(int enabled);
+
+// Closest hit in [t_min, t_max]: returns the slot (or -1) and its t.
+int  mesh_bvh_hit_closest(const MeshBvh *m, const Ray *r, float t_min, float t_max, float *t_out);
+
+// Unit geometric normal of a slot (winding order: e1 x e2).
+Vec3 mesh_bvh_normal(const MeshBvh *m, int slot);
+
+#endif // MESH_BVH_H
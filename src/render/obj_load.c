@@ -0,0 +1,714 @@
+// obj_load.c - parallel mmap OBJ loader with a content-hashed binary cache
+#include "obj_load.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ysu_mt.h"   // ysu_mt_suggest_threads
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #include <time.h>
+#endif
+
+static double obj_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+
+// ------------------------- file mapping -------------------------
+typedef struct {
+    const char *data;
+    size_t      size;
+#if defined(_WIN32)
+    HANDLE      file, map;
+#endif
+} ObjMap;
+
+static int obj_map(const char *path, ObjMap *m) {
+    memset(m, 0, sizeof(*m));
+#if defined(_WIN32)
+    m->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m->file == INVALID_HANDLE_VALUE) return 0;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(m->file, &sz) || sz.QuadPart <= 0) {
+        CloseHandle(m->file);
+        return 0;
+    }
+    m->map = CreateFileMappingA(m->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    m->data = m->map ? (const char*)MapViewOfFile(m->map, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!m->data) {
+        if (m->map) CloseHandle(m->map);
+        CloseHandle(m->file);
+        return 0;
+    }
+    m->size = (size_t)sz.QuadPart;
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return 0;
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    m->data = (const char*)p;
+    m->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+static void obj_unmap(ObjMap *m) {
+    if (!m->data) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m->data);
+    CloseHandle(m->map);
+    CloseHandle(m->file);
+#else
+    munmap((void*)m->data, m->size);
+#endif
+    m->data = NULL;
+}
+
+// ------------------------- number parsing -------------------------
+// Everything is bounded by the line end: the mapping has no terminator.
+
+static const double k_pow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline int obj_is_digit(char c) { return (unsigned)(c - '0') < 10u; }
+static inline int obj_is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// strtof on a copy of the token: inf / nan / hex / very long mantissas
+static int obj_parse_float_slow(const char **s, const char *e, float *out) {
+    char buf[64];
+    const char *p = *s;
+    size_t n = 0;
+    while (p + n < e && !obj_is_blank(p[n]) && n < sizeof(buf) - 1) n++;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    char *end = NULL;
+    float v = strtof(buf, &end);
+    if (end == buf) return 0;
+    *out = v;
+    *s = p + (end - buf);
+    return 1;
+}
+
+// Decimal mantissas below 2^53 with |exponent| <= 22 are exact in double,
+// so one multiply / divide gives the correctly rounded double; the float
+// is then within rounding of strtof (equal except on exact ties).
+int obj_parse_float(const char **s, const char *e, float *out) {
+    const char *p = *s;
+    while (p < e && obj_is_blank(*p)) p++;
+    const char *start = p;
+
+    int neg = 0;
+    if (p < e && (*p == '-' || *p == '+')) { neg = (*p == '-'); p++; }
+
+    uint64_t m = 0;
+    int exp10 = 0, digits = 0, any = 0;
+    while (p < e && obj_is_digit(*p)) {
+        if (digits < 19) { m = m * 10u + (uint64_t)(*p - '0'); if (m) digits++; }
+        else exp10++;
+        any = 1;
+        p++;
+    }
+    if (p < e && *p == '.') {
+        p++;
+        while (p < e && obj_is_digit(*p)) {
+            if (digits < 19) { m = m * 10u + (uint64_t)(*p - '0'); if (m) digits++; exp10--; }
+            any = 1;
+            p++;
+        }
+    }
+    if (!any) {
+        *s = start;
+        return obj_parse_float_slow(s, e, out);
+    }
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0, ev = 0;
+        if (q < e && (*q == '-' || *q == '+')) { eneg = (*q == '-'); q++; }
+        if (q < e && obj_is_digit(*q)) {
+            while (q < e && obj_is_digit(*q)) {
+                if (ev < 10000) ev = ev * 10 + (*q - '0');
+                q++;
+            }
+            exp10 += eneg ? -ev : ev;
+            p = q;
+        }
+    }
+
+    if (m >= (1ull << 53) || exp10 < -22 || exp10 > 22) {
+        *s = start;
+        return obj_parse_float_slow(s, e, out);
+    }
+    double v = (double)m;
+    if (exp10 < 0) v /= k_pow10[-exp10];
+    else           v *= k_pow10[exp10];
+    *out = (float)(neg ? -v : v);
+    *s = p;
+    return 1;
+}
+
+static int obj_parse_int(const char **s, const char *e, long *out) {
+    const char *p = *s;
+    int neg = 0;
+    if (p < e && (*p == '-' || *p == '+')) { neg = (*p == '-'); p++; }
+    if (p >= e || !obj_is_digit(*p)) return 0;
+    long v = 0;
+    while (p < e && obj_is_digit(*p)) {
+        if (v < 100000000000L) v = v * 10 + (*p - '0');
+        p++;
+    }
+    *out = neg ? -v : v;
+    *s = p;
+    return 1;
+}
+
+// ------------------------- parallel job -------------------------
+#define OBJ_HASH_BLOCK (1u << 20)
+#define OBJ_MAX_FACE   256
+#define OBJ_BAD        UINT32_MAX
+
+typedef struct {
+    const char *beg, *end;        // whole lines
+    uint32_t vlines;              // `v` lines
+    uint32_t vbase;               // vertex number of the first one
+
+    uint32_t *tri;                // 3 vertex ids per triangle
+    uint32_t  tri_n, tri_cap;
+    uint32_t *quad;               // 4 per quad
+    uint32_t  quad_n, quad_cap;
+    uint32_t  tri_base, quad_base;
+    uint32_t  long_faces;         // faces over OBJ_MAX_FACE vertices (dropped)
+    int       oom;
+} ObjChunk;
+
+enum { OBJ_PHASE_HASH, OBJ_PHASE_COUNT, OBJ_PHASE_PARSE, OBJ_PHASE_EMIT };
+
+typedef struct {
+    const ObjMap *map;
+    int        flags;
+    int        phase;
+    int        ntasks;
+    atomic_int next;
+
+    uint64_t  *block_hash;
+    ObjChunk  *chunks;
+    float     *verts;             // 3 per vertex
+    float     *tris;
+    float     *quads;
+    uint32_t  *indices;           // OBJ_LOAD_INDEXED: 3 per triangle
+} ObjJob;
+
+static inline const char *obj_line_end(const char *p, const char *e) {
+    const char *nl = (const char*)memchr(p, '\n', (size_t)(e - p));
+    return nl ? nl : e;
+}
+
+static void obj_count(ObjChunk *c) {
+    uint32_t n = 0;
+    for (const char *p = c->beg; p < c->end; ) {
+        const char *le = obj_line_end(p, c->end);
+        while (p < le && (*p == ' ' || *p == '\t')) p++;
+        if (le - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) n++;
+        p = le + 1;
+    }
+    c->vlines = n;
+}
+
+static int obj_push(uint32_t **arr, uint32_t *n, uint32_t *cap, const uint32_t *v, int k) {
+    if (*n + (uint32_t)k > *cap) {
+        uint32_t nc = *cap ? *cap * 2 : 4096;
+        uint32_t *p = (uint32_t*)realloc(*arr, sizeof(uint32_t) * (size_t)nc);
+        if (!p) return 0;
+        *arr = p;
+        *cap = nc;
+    }
+    memcpy(*arr + *n, v, sizeof(uint32_t) * (size_t)k);
+    *n += (uint32_t)k;
+    return 1;
+}
+
+static void obj_face(ObjChunk *c, const uint32_t *vi, int n, int flags) {
+    if (n == 4 && (flags & OBJ_LOAD_QUADS)) {   // never with OBJ_LOAD_INDEXED
+        if (vi[0] == OBJ_BAD || vi[1] == OBJ_BAD || vi[2] == OBJ_BAD || vi[3] == OBJ_BAD) return;
+        if (!obj_push(&c->quad, &c->quad_n, &c->quad_cap, vi, 4)) c->oom = 1;
+        return;
+    }
+    if (vi[0] == OBJ_BAD) return;
+    int flip = (n >= 5) && (flags & OBJ_LOAD_FLIP_NGON);
+    for (int k = 1; k + 1 < n; ++k) {
+        if (vi[k] == OBJ_BAD || vi[k + 1] == OBJ_BAD) continue;
+        uint32_t t[3] = { vi[0], flip ? vi[k + 1] : vi[k], flip ? vi[k] : vi[k + 1] };
+        if (!obj_push(&c->tri, &c->tri_n, &c->tri_cap, t, 3)) { c->oom = 1; return; }
+    }
+}
+
+static void obj_parse(ObjJob *j, ObjChunk *c) {
+    uint32_t cur = c->vbase;          // vertices defined before this line
+    float *vout = j->verts;
+    for (const char *p = c->beg; p < c->end && !c->oom; ) {
+        const char *le = obj_line_end(p, c->end);
+        while (p < le && (*p == ' ' || *p == '\t')) p++;
+        if (le - p < 2 || (p[1] != ' ' && p[1] != '\t')) { p = le + 1; continue; }
+
+        if (p[0] == 'v') {
+            // a short line still takes its vertex number (zeros fill in)
+            const char *s = p + 2;
+            float xyz[3] = { 0.0f, 0.0f, 0.0f };
+            for (int a = 0; a < 3 && obj_parse_float(&s, le, &xyz[a]); ++a) {}
+            memcpy(vout + (size_t)cur * 3u, xyz, sizeof(xyz));
+            cur++;
+        } else if (p[0] == 'f') {
+            const char *s = p + 2;
+            uint32_t vi[OBJ_MAX_FACE];
+            int n = 0;
+            while (n < OBJ_MAX_FACE) {
+                while (s < le && obj_is_blank(*s)) s++;
+                long idx;
+                if (s >= le || !obj_parse_int(&s, le, &idx)) break;
+                while (s < le && !obj_is_blank(*s)) s++;     // /vt/vn
+                long r = (idx > 0) ? idx - 1 : (idx < 0) ? (long)cur + idx : -1;
+                vi[n++] = (r >= 0 && r < (long)cur) ? (uint32_t)r : OBJ_BAD;
+            }
+            if (n == OBJ_MAX_FACE) {
+                // one more index: the face does not fit, so drop all of it
+                // rather than a truncated fan
+                long idx;
+                while (s < le && obj_is_blank(*s)) s++;
+                if (s < le && obj_parse_int(&s, le, &idx)) { c->long_faces++; n = 0; }
+            }
+            if (n >= 3) obj_face(c, vi, n, j->flags);
+        }
+        p = le + 1;
+    }
+}
+
+static void obj_emit(ObjJob *j, const ObjChunk *c) {
+    if (j->indices) {
+        if (c->tri_n) memcpy(j->indices + (size_t)c->tri_base * 3u, c->tri, sizeof(uint32_t) * (size_t)c->tri_n);
+        return;
+    }
+    const float *v = j->verts;
+    for (uint32_t t = 0; t < c->tri_n / 3u; ++t) {
+        float *o = j->tris + ((size_t)c->tri_base + t) * 12u;
+        for (int k = 0; k < 3; ++k) {
+            const float *src = v + (size_t)c->tri[t * 3u + (uint32_t)k] * 3u;
+            o[k * 4 + 0] = src[0]; o[k * 4 + 1] = src[1]; o[k * 4 + 2] = src[2]; o[k * 4 + 3] = 0.0f;
+        }
+    }
+    for (uint32_t q = 0; q < c->quad_n / 4u; ++q) {
+        float *o = j->quads + ((size_t)c->quad_base + q) * 16u;
+        for (int k = 0; k < 4; ++k) {
+            const float *src = v + (size_t)c->quad[q * 4u + (uint32_t)k] * 3u;
+            o[k * 4 + 0] = src[0]; o[k * 4 + 1] = src[1]; o[k * 4 + 2] = src[2]; o[k * 4 + 3] = 0.0f;
+        }
+    }
+}
+
+// 4 independent multiply-xor lanes over 8-byte words; not cryptographic,
+// just enough that an edited OBJ never matches its old cache
+static uint64_t obj_hash_bytes(const unsigned char *p, size_t n) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h[4] = { k, k ^ 0x5555555555555555ull, ~k, k * 3u };
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * (size_t)l, 8);
+            h[l] = (h[l] ^ w) * k;
+            h[l] ^= h[l] >> 29;
+        }
+    }
+    uint64_t tail[4] = { 0, 0, 0, 0 };
+    memcpy(tail, p + i, n - i);
+    uint64_t r = (uint64_t)n;
+    for (int l = 0; l < 4; ++l) {
+        r = (r ^ h[l] ^ tail[l]) * k;
+        r ^= r >> 32;
+    }
+    return r;
+}
+
+static void obj_task(ObjJob *j, int i) {
+    switch (j->phase) {
+    case OBJ_PHASE_HASH: {
+        size_t off = (size_t)i * OBJ_HASH_BLOCK;
+        size_t n = j->map->size - off;
+        if (n > OBJ_HASH_BLOCK) n = OBJ_HASH_BLOCK;
+        j->block_hash[i] = obj_hash_bytes((const unsigned char*)j->map->data + off, n);
+        break;
+    }
+    case OBJ_PHASE_COUNT: obj_count(&j->chunks[i]); break;
+    case OBJ_PHASE_PARSE: obj_parse(j, &j->chunks[i]); break;
+    default:              obj_emit(j, &j->chunks[i]); break;
+    }
+}
+
+static void *obj_worker(void *arg) {
+    ObjJob *j = (ObjJob*)arg;
+    for (;;) {
+        int i = atomic_fetch_add(&j->next, 1);
+        if (i >= j->ntasks) return NULL;
+        obj_task(j, i);
+    }
+}
+
+// Runs one phase over ntasks tasks on `threads` threads (the caller is one).
+static void obj_run(ObjJob *j, int phase, int ntasks, int threads) {
+    j->phase = phase;
+    j->ntasks = ntasks;
+    atomic_store(&j->next, 0);
+
+    int nthr = threads - 1;
+    if (nthr > ntasks - 1) nthr = ntasks - 1;
+    pthread_t thr[256];
+    if (nthr > 256) nthr = 256;
+    int started = 0;
+    for (; started < nthr; ++started) {
+        if (pthread_create(&thr[started], NULL, obj_worker, j) != 0) break;
+    }
+    obj_worker(j);
+    for (int i = 0; i < started; ++i) pthread_join(thr[i], NULL);
+}
+
+static uint64_t obj_hash_file(ObjJob *j, int threads) {
+    int nblocks = (int)((j->map->size + OBJ_HASH_BLOCK - 1) / OBJ_HASH_BLOCK);
+    j->block_hash = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)nblocks);
+    if (!j->block_hash) return obj_hash_bytes((const unsigned char*)j->map->data, j->map->size);
+    obj_run(j, OBJ_PHASE_HASH, nblocks, threads);
+    uint64_t h = obj_hash_bytes((const unsigned char*)j->block_hash, sizeof(uint64_t) * (size_t)nblocks);
+    free(j->block_hash);
+    j->block_hash = NULL;
+    return h ^ (uint64_t)j->map->size;
+}
+
+static void obj_chunks_free(ObjJob *j, int n) {
+    if (!j->chunks) return;
+    for (int i = 0; i < n; ++i) {
+        free(j->chunks[i].tri);
+        free(j->chunks[i].quad);
+    }
+    free(j->chunks);
+    j->chunks = NULL;
+}
+
+// Parses the mapped file into out (tris / quads / vert_count).
+static int obj_parse_mapped(ObjJob *j, int threads, ObjMesh *out) {
+    const char *data = j->map->data;
+    size_t size = j->map->size;
+
+    // ~8 chunks per thread for balance, at least 64 KiB each
+    size_t want = (size_t)threads * 8u;
+    size_t max_chunks = size / 65536u + 1u;
+    int nchunks = (int)((want < max_chunks) ? want : max_chunks);
+    j->chunks = (ObjChunk*)calloc((size_t)nchunks, sizeof(ObjChunk));
+    if (!j->chunks) return 0;
+
+    const char *prev = data;
+    for (int i = 0; i < nchunks; ++i) {
+        const char *cut = data + size * (size_t)(i + 1) / (size_t)nchunks;
+        if (cut < prev) cut = prev;
+        if (i + 1 < nchunks && cut < data + size) cut = obj_line_end(cut, data + size) + 1;
+        if (cut > data + size || i + 1 == nchunks) cut = data + size;
+        j->chunks[i].beg = prev;
+        j->chunks[i].end = cut;
+        prev = cut;
+    }
+
+    obj_run(j, OBJ_PHASE_COUNT, nchunks, threads);
+    uint64_t vtotal = 0;
+    for (int i = 0; i < nchunks; ++i) {
+        j->chunks[i].vbase = (uint32_t)vtotal;
+        vtotal += j->chunks[i].vlines;
+    }
+    if (vtotal == 0 || vtotal >= OBJ_BAD) {
+        obj_chunks_free(j, nchunks);
+        return 0;
+    }
+    j->verts = (float*)malloc(sizeof(float) * 3u * (size_t)vtotal);
+    if (!j->verts) {
+        obj_chunks_free(j, nchunks);
+        return 0;
+    }
+
+    obj_run(j, OBJ_PHASE_PARSE, nchunks, threads);
+    uint64_t tris = 0, quads = 0;
+    uint32_t long_faces = 0;
+    int oom = 0;
+    for (int i = 0; i < nchunks; ++i) {
+        oom |= j->chunks[i].oom;
+        long_faces += j->chunks[i].long_faces;
+        j->chunks[i].tri_base = (uint32_t)tris;
+        j->chunks[i].quad_base = (uint32_t)quads;
+        tris += j->chunks[i].tri_n / 3u;
+        quads += j->chunks[i].quad_n / 4u;
+    }
+    int ok = !oom && (tris + quads) > 0 && tris < UINT32_MAX && quads < UINT32_MAX;
+    int indexed = (j->flags & OBJ_LOAD_INDEXED) != 0;
+    if (ok && indexed) {
+        ok = tris > 0 && (j->indices = (uint32_t*)malloc(sizeof(uint32_t) * 3u * (size_t)tris)) != NULL;
+    } else if (ok) {
+        j->tris = tris ? (float*)malloc(sizeof(float) * 12u * (size_t)tris) : NULL;
+        j->quads = quads ? (float*)malloc(sizeof(float) * 16u * (size_t)quads) : NULL;
+        ok = (!tris || j->tris) && (!quads || j->quads);
+    }
+    if (ok) obj_run(j, OBJ_PHASE_EMIT, nchunks, threads);
+
+    obj_chunks_free(j, nchunks);
+    if (!ok || !indexed) {
+        free(j->verts);
+        j->verts = NULL;
+    }
+    if (!ok) {
+        free(j->tris);
+        free(j->quads);
+        free(j->indices);
+        j->tris = j->quads = NULL;
+        j->indices = NULL;
+        return 0;
+    }
+    out->verts = j->verts;
+    out->indices = j->indices;
+    out->tris = j->tris;
+    out->tri_count = (uint32_t)tris;
+    out->quads = j->quads;
+    out->quad_count = (uint32_t)quads;
+    out->vert_count = (uint32_t)vtotal;
+    out->long_faces = long_faces;
+    return 1;
+}
+
+// ------------------------- binary cache -------------------------
+#define OBJ_CACHE_MAGIC   "YSUTRI2"
+#define OBJ_CACHE_VERSION 2u   // 2: faces over OBJ_MAX_FACE are dropped, not truncated
+
+typedef struct {
+    char     magic[8];        // "YSUTRI2"
+    uint32_t version;
+    uint32_t flags;           // OBJ_LOAD_* the arrays were built with
+    uint64_t hash;            // obj_hash_file() of the OBJ
+    uint64_t obj_size;
+    uint32_t tri_count;
+    uint32_t quad_count;
+    uint32_t vert_count;
+    uint32_t long_faces;      // ObjMesh.long_faces, so a cache hit logs them too
+} ObjCacheHeader;
+
+static int obj_cache_read(const char *cache_path, uint64_t hash, uint64_t size, int flags, ObjMesh *out) {
+    FILE *f = fopen(cache_path, "rb");
+    if (!f) return 0;
+    ObjCacheHeader h;
+    int ok = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, OBJ_CACHE_MAGIC, 8) == 0 &&
+             h.version == OBJ_CACHE_VERSION && h.flags == (uint32_t)flags &&
+             h.hash == hash && h.obj_size == size && (h.tri_count || h.quad_count);
+    float *tris = NULL, *quads = NULL, *verts = NULL;
+    uint32_t *indices = NULL;
+    if (ok && (flags & OBJ_LOAD_INDEXED)) {
+        size_t nv = (size_t)h.vert_count * 3u, ni = (size_t)h.tri_count * 3u;
+        verts = (float*)malloc(sizeof(float) * (nv ? nv : 1u));
+        indices = (uint32_t*)malloc(sizeof(uint32_t) * (ni ? ni : 1u));
+        ok = verts && indices && fread(verts, sizeof(float), nv, f) == nv &&
+             fread(indices, sizeof(uint32_t), ni, f) == ni;
+        for (size_t i = 0; ok && i < ni; ++i) ok = indices[i] < h.vert_count;
+    } else if (ok) {
+        size_t nt = (size_t)h.tri_count * 12u, nq = (size_t)h.quad_count * 16u;
+        tris = nt ? (float*)malloc(sizeof(float) * nt) : NULL;
+        quads = nq ? (float*)malloc(sizeof(float) * nq) : NULL;
+        ok = (!nt || (tris && fread(tris, sizeof(float), nt, f) == nt)) &&
+             (!nq || (quads && fread(quads, sizeof(float), nq, f) == nq));
+    }
+    fclose(f);
+    if (!ok) {
+        free(tris);
+        free(quads);
+        free(verts);
+        free(indices);
+        return 0;
+    }
+    out->verts = verts;
+    out->indices = indices;
+    out->tris = tris;
+    out->tri_count = h.tri_count;
+    out->quads = quads;
+    out->quad_count = h.quad_count;
+    out->vert_count = h.vert_count;
+    out->long_faces = h.long_faces;
+    return 1;
+}
+
+// Written next to the target and renamed, so a crash never leaves a
+// truncated cache with a valid header.
+static int obj_cache_write(const char *cache_path, uint64_t size, int flags, const ObjMesh *m) {
+    char tmp[1024];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", cache_path) >= (int)sizeof(tmp)) return 0;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+
+    ObjCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, OBJ_CACHE_MAGIC, 8);
+    h.version = OBJ_CACHE_VERSION;
+    h.flags = (uint32_t)flags;
+    h.hash = m->hash;
+    h.obj_size = size;
+    h.tri_count = m->tri_count;
+    h.quad_count = m->quad_count;
+    h.vert_count = m->vert_count;
+    h.long_faces = m->long_faces;
+
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    if (flags & OBJ_LOAD_INDEXED) {
+        size_t nv = (size_t)m->vert_count * 3u, ni = (size_t)m->tri_count * 3u;
+        ok = ok && fwrite(m->verts, sizeof(float), nv, f) == nv &&
+             fwrite(m->indices, sizeof(uint32_t), ni, f) == ni;
+    } else {
+        size_t nt = (size_t)m->tri_count * 12u, nq = (size_t)m->quad_count * 16u;
+        ok = ok && (!nt || fwrite(m->tris, sizeof(float), nt, f) == nt) &&
+             (!nq || fwrite(m->quads, sizeof(float), nq, f) == nq);
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        remove(cache_path);   // rename() does not replace on Windows
+        ok = rename(tmp, cache_path) == 0;
+    }
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+// ------------------------- entry points -------------------------
+// cache_dir: cache_path is ignored; the file is "<cache_dir>/<hash>-<flags>.ysutri"
+static int obj_load_impl(const char *path, const char *cache_path, const char *cache_dir,
+                         int flags, int threads, ObjMesh *out) {
+    memset(out, 0, sizeof(*out));
+    double t0 = obj_now_ms();
+    if (flags & OBJ_LOAD_INDEXED) flags &= ~OBJ_LOAD_QUADS;
+    if (threads <= 0) threads = ysu_mt_suggest_threads();
+    if (threads < 1) threads = 1;
+    out->threads = threads;
+
+    ObjMap map;
+    if (!obj_map(path, &map)) {
+        printf("[OBJ] cannot read %s\n", path);
+        return 0;
+    }
+    ObjJob job;
+    memset(&job, 0, sizeof(job));
+    job.map = &map;
+    job.flags = flags;
+
+    int ok = 0;
+    char dir_path[1024];
+    if (cache_path || cache_dir) {
+        out->hash = obj_hash_file(&job, threads);
+        double t1 = obj_now_ms();
+        out->hash_ms = t1 - t0;
+        if (cache_dir) {
+            int n = snprintf(dir_path, sizeof(dir_path), "%s/%016llx-%d.ysutri", cache_dir,
+                             (unsigned long long)out->hash, flags);
+            cache_path = (n > 0 && n < (int)sizeof(dir_path)) ? dir_path : NULL;
+        }
+    }
+    if (cache_path) {
+        double t1 = obj_now_ms();
+        ok = obj_cache_read(cache_path, out->hash, (uint64_t)map.size, flags, out);
+        out->cache_ms = obj_now_ms() - t1;
+        out->from_cache = ok;
+    }
+    if (!ok) {
+        double t1 = obj_now_ms();
+        ok = obj_parse_mapped(&job, threads, out);
+        double t2 = obj_now_ms();
+        out->parse_ms = t2 - t1;
+        if (ok && cache_path) {
+            if (!obj_cache_write(cache_path, (uint64_t)map.size, flags, out)) {
+                printf("[OBJ] cannot write cache %s\n", cache_path);
+            }
+            out->cache_ms += obj_now_ms() - t2;
+        }
+    }
+    obj_unmap(&map);
+    out->total_ms = obj_now_ms() - t0;
+
+    if (!ok) {
+        printf("[OBJ] no faces loaded from %s\n", path);
+        obj_mesh_free(out);
+        return 0;
+    }
+    double mtris = (double)(out->tri_count + 2u * out->quad_count) / 1e6;
+    printf("[OBJ] %s: %u tris + %u quads, %u verts%s in %.1f ms (%.1f ms/Mtri, %d threads)\n",
+           path, out->tri_count, out->quad_count, out->vert_count,
+           out->from_cache ? " from cache" : "", out->total_ms,
+           (mtris > 0.0) ? out->total_ms / mtris : 0.0, threads);
+    if (out->long_faces) {
+        printf("[OBJ] %s: dropped %u faces with more than %d vertices\n", path, out->long_faces, OBJ_MAX_FACE);
+    }
+    return 1;
+}
+
+int obj_load(const char *path, int flags, int threads, ObjMesh *out) {
+    return obj_load_impl(path, NULL, NULL, flags, threads, out);
+}
+
+int obj_load_cached(const char *path, const char *cache_path, int flags, int threads, ObjMesh *out) {
+    char auto_path[1024];
+    const char *cache_dir = NULL;
+    if (!cache_path) {
+        const char *env = getenv("YSU_OBJ_CACHE");
+        if (env && env[0] && strcmp(env, "0") != 0) {
+            if (strcmp(env, "1") == 0) {
+                if (snprintf(auto_path, sizeof(auto_path), "%s.ysutri", path) < (int)sizeof(auto_path)) {
+                    cache_path = auto_path;
+                }
+            } else {
+                // a directory shared by every OBJ: one file per content and flags,
+                // so loading several meshes never evicts another one's cache
+#if defined(_WIN32)
+                CreateDirectoryA(env, NULL);
+#else
+                mkdir(env, 0777);
+#endif
+                cache_dir = env;
+            }
+        }
+    }
+    return obj_load_impl(path, (cache_path && cache_path[0]) ? cache_path : NULL, cache_dir,
+                         flags, threads, out);
+}
+
+void obj_mesh_free(ObjMesh *m) {
+    if (!m) return;
+    free(m->tris);
+    free(m->quads);
+    free(m->verts);
+    free(m->indices);
+    m->tris = m->quads = m->verts = NULL;
+    m->indices = NULL;
+    m->tri_count = m->quad_count = 0;
+}
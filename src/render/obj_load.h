@@ -0,0 +1,67 @@
+// obj_load.h - parallel mmap OBJ loader with a content-hashed binary cache
+#ifndef OBJ_LOAD_H
+#define OBJ_LOAD_H
+
+#include <stdint.h>
+
+// The file is mapped (no line buffer, no stdio) and cut into line-aligned
+// chunks that threads parse in parallel: a counting pass gives every chunk
+// its first vertex number (negative face indices are relative to the vertex
+// count at the face, as in the OBJ spec), a parsing pass reads vertices
+// straight into the shared array and faces into per-chunk index lists, and
+// an emit pass writes the triangles in file order.
+//
+// Only `v` and `f` lines matter (f accepts v, v/t, v//n, v/t/n). Faces are
+// fan triangulated: (a, b, c), (a, c, d), ...; faces with a bad index are
+// dropped (for n-gons, only the fan triangles that use it). Faces with more
+// than 256 vertices are dropped whole, counted in long_faces and logged.
+//
+// Output uses the tri_vec4 layout of the GPU code: 12 floats per triangle
+// (3 x xyz + pad), 16 per quad; with OBJ_LOAD_INDEXED the shared vertex
+// array and 3 indices per triangle instead (12 bytes per vertex + 12 per
+// triangle, about a third of tri_vec4 on a closed mesh).
+
+enum {
+    OBJ_LOAD_QUADS     = 1,   // keep 4-vertex faces in `quads` instead of splitting them
+    OBJ_LOAD_FLIP_NGON = 2,   // fan 5+-gons as (a, c, b) (gpu_load_obj_triangles_and_quads)
+    OBJ_LOAD_INDEXED   = 4    // verts + indices, no tris (quads are split)
+};
+
+typedef struct {
+    float    *tris;           // tri_count * 12 floats, free()
+    uint32_t  tri_count;
+    float    *quads;          // quad_count * 16 floats (OBJ_LOAD_QUADS), free()
+    uint32_t  quad_count;
+    uint32_t  vert_count;
+    uint32_t  long_faces;     // faces over 256 vertices, dropped
+    float    *verts;          // OBJ_LOAD_INDEXED: vert_count * 3 floats, free()
+    uint32_t *indices;        // OBJ_LOAD_INDEXED: tri_count * 3, free()
+
+    uint64_t  hash;           // of the file contents (obj_load_cached only)
+    int       threads;
+    int       from_cache;
+    double    hash_ms;        // map + content hash
+    double    parse_ms;       // 0 on a cache hit
+    double    cache_ms;       // cache read or write
+    double    total_ms;
+} ObjMesh;
+
+// threads <= 0: YSU_THREADS / CPU count. Returns 1 on success, 0 when the
+// file cannot be read, holds no faces, or on OOM (out is zeroed).
+int  obj_load(const char *path, int flags, int threads, ObjMesh *out);
+
+// obj_load() behind a binary cache ("YSUTRI2": version, flags, content
+// hash, counts, raw arrays). A cache written for other contents or flags is
+// rebuilt. cache_path NULL: env YSU_OBJ_CACHE (unset/0 = no cache, 1 =
+// "<path>.ysutri", else a cache directory, created if missing, holding
+// "<content hash>-<flags>.ysutri" per OBJ).
+int  obj_load_cached(const char *path, const char *cache_path, int flags, int threads, ObjMesh *out);
+
+void obj_mesh_free(ObjMesh *m);
+
+// The loader's number parser, for other text formats: skips blanks and
+// parses one float at *s (no terminator needed, stops at e), advancing *s
+// past it. Returns 0 when there is no number.
+int  obj_parse_float(const char **s, const char *e, float *out);
+
+#endif // OBJ_LOAD_H
@@ -0,0 +1,66 @@
+// ray_sort.c - coherence keys and a radix sort for batches of rays
+#include "ray_sort.h"
+
+#include <string.h>
+
+// 7 bits -> every third bit of 21
+static inline uint32_t expand_bits_7(uint32_t v) {
+    v &= 0x7Fu;
+    v = (v | (v << 8)) & 0x0000F00Fu;
+    v = (v | (v << 4)) & 0x000C30C3u;
+    v = (v | (v << 2)) & 0x00249249u;
+    return v;
+}
+
+static inline uint32_t quantize(float x, float lo, float scale, uint32_t max) {
+    float q = (x - lo) * scale;
+    if (!(q > 0.0f)) return 0;              // also NaN
+    return (q >= (float)max) ? max : (uint32_t)q;
+}
+
+void ray_sort_frame(RaySortFrame *f, const float bmin[3], const float bmax[3]) {
+    for (int a = 0; a < 3; ++a) {
+        float e = bmax[a] - bmin[a];
+        f->lo[a] = bmin[a];
+        f->scale[a] = (e > 0.0f) ? 128.0f / e : 0.0f;
+    }
+}
+
+uint32_t ray_sort_key(const RaySortFrame *f, const Ray *r) {
+    const Vec3 o = r->origin, d = r->direction;
+    uint32_t oct = (d.x < 0.0f ? 4u : 0u) | (d.y < 0.0f ? 2u : 0u) | (d.z < 0.0f ? 1u : 0u);
+
+    uint32_t om = (expand_bits_7(quantize(o.x, f->lo[0], f->scale[0], 127u)) << 2) |
+                  (expand_bits_7(quantize(o.y, f->lo[1], f->scale[1], 127u)) << 1) |
+                   expand_bits_7(quantize(o.z, f->lo[2], f->scale[2], 127u));
+
+    // direction in [-1, 1]^3 (unit or close to it), 2 bits per axis
+    uint32_t dx = quantize(d.x, -1.0f, 2.0f, 3u);
+    uint32_t dy = quantize(d.y, -1.0f, 2.0f, 3u);
+    uint32_t dz = quantize(d.z, -1.0f, 2.0f, 3u);
+    uint32_t dm = (expand_bits_7(dx) << 2) | (expand_bits_7(dy) << 1) | expand_bits_7(dz);
+
+    return (oct << 29) | (om << 8) | (dm << 2);
+}
+
+void ray_sort_keys(uint64_t *v, uint64_t *tmp, uint32_t n) {
+    if (n < 2) return;
+    uint64_t *src = v, *dst = tmp;
+    // 4 passes of 8 bits over bits 32..63, skipping bytes that are all equal
+    for (uint32_t shift = 32; shift < 64; shift += 8) {
+        uint32_t count[256];
+        memset(count, 0, sizeof(count));
+        for (uint32_t i = 0; i < n; ++i) count[(uint32_t)(src[i] >> shift) & 0xFFu]++;
+        if (count[(uint32_t)(src[0] >> shift) & 0xFFu] == n) continue;   // one bucket: nothing moves
+
+        uint32_t sum = 0;
+        for (int b = 0; b < 256; ++b) {
+            uint32_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (uint32_t i = 0; i < n; ++i) dst[count[(uint32_t)(src[i] >> shift) & 0xFFu]++] = src[i];
+        uint64_t *t = src; src = dst; dst = t;
+    }
+    if (src != v) memcpy(v, src, sizeof(uint64_t) * (size_t)n);
+}
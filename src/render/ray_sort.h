@@ -0,0 +1,30 @@
+// ray_sort.h - coherence keys and a radix sort for batches of rays
+#ifndef RAY_SORT_H
+#define RAY_SORT_H
+
+#include <stdint.h>
+
+#include "ray.h"
+
+// A 32-bit key per ray, most significant first:
+//   [31:29] direction octant (sign bits), the first thing a BVH traversal
+//           branches on
+//   [28: 8] 21-bit Morton code of the origin (7 bits per axis) inside the
+//           scene bounds, so rays leaving the same surface patch are adjacent
+//   [ 7: 2] 6-bit Morton code of the direction (2 bits per axis)
+// Sorting a batch by key before traversal makes consecutive rays walk
+// mostly the same BVH nodes, which keeps those nodes in L1/L2.
+
+typedef struct {
+    float lo[3];      // scene bounds minimum
+    float scale[3];   // 128 / extent (0 for a flat axis)
+} RaySortFrame;
+
+void     ray_sort_frame(RaySortFrame *f, const float bmin[3], const float bmax[3]);
+uint32_t ray_sort_key(const RaySortFrame *f, const Ray *r);
+
+// Stable LSD radix sort of v[0, n) on the upper 32 bits (key << 32 | index).
+// tmp needs room for n entries; the result ends up in v.
+void     ray_sort_keys(uint64_t *v, uint64_t *tmp, uint32_t n);
+
+#endif // RAY_SORT_H
@@ -1,4 +1,4 @@
-﻿// render.c (FULL) - pthread threadpool + chunked jobs + tile renderer + RNG + fog + debug + minimal test scene
+﻿// render.c (FULL) - pthread threadpool + chunked/work-stealing jobs + tile renderer + RNG + fog + debug + minimal test scene
 #include "render.h"
 #include "image.h"
 
@@ -6,7 +6,7 @@
  * CHECKPOINT: See .github/CHECKPOINTS.md for the full agent checklist.
  * Key items relevant to this file:
  *  - Thread pool: `WorkerLocal` alignment and `render_scene_mt` usage.
- *  - RNG seeding: `ysu_seed_pixel`, tile_base derivation, and deterministic behavior.
+ *  - RNG: counter-based (ysu_rng.h), keyed on seed/pixel/sample/bounce; thread-count independent.
  *  - Adaptive sampling env toggles: YSU_ADAPTIVE, YSU_SPP_MIN, YSU_SPP_BATCH.
  */
 
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <math.h>
+#include <float.h>
 #include <inttypes.h>
 #include <string.h>
 
@@ -28,12 +29,28 @@
 
 #if defined(_WIN32)
   #include <windows.h>
+#else
+  #include <sched.h>
 #endif
 
 #include "vec3.h"
+#include "vec3_simd.h"
 #include "ray.h"
 #include "camera.h"
+#include "material.h"
+#include "ysu_rng.h"
+#include "ysu_mt.h"
+#include "ysu_wavefront.h"
 #include "nerf_simd.h"
+#include "bvh.h"
+#include "bvh_wide.h"
+#include "bvh_refit.h"
+#include "bvh_policy.h"
+#include "ray_sort.h"
+#include "ysu_perf.h"
+#include "bvh_packet.h"
+#include "mesh_bvh.h"
+#include "tlas.h"
 
 // ================================================================
 // Adaptive sampling config + stats (env-controlled)
@@ -92,18 +109,7 @@ static inline float clampf(float x, float a, float b) {
 
 static inline float maxf(float a, float b) { return a > b ? a : b; }
 
-// ------------------------- RNG (xorshift32) -------------------------
-typedef struct { uint32_t state; } YSU_Rng;
-
-static inline uint32_t ysu_rng_u32(YSU_Rng *r) {
-    uint32_t x = r->state;
-    x ^= x << 13;
-    x ^= x >> 17;
-    x ^= x << 5;
-    r->state = x;
-    return x;
-}
-
+// ------------------------- RNG (xorshift32, YSU_Rng in ysu_mt.h) -------------------------
 static inline uint32_t ysu_hash_u32(uint32_t x) {
     x ^= x >> 16;
     x *= 0x7feb352du;
@@ -113,18 +119,20 @@ static inline uint32_t ysu_hash_u32(uint32_t x) {
     return (x != 0u) ? x : 1u;
 }
 
-// Seed a per-pixel RNG deterministically from a base seed + pixel coords (+ optional salt).
-static inline uint32_t ysu_seed_pixel(uint32_t base, uint32_t px, uint32_t py, uint32_t salt) {
-    uint32_t x = base;
-    x ^= px * 0x9E3779B1u;
-    x ^= py * 0x85EBCA77u;
-    x ^= salt * 0xC2B2AE3Du;
-    x = ysu_hash_u32(x);
-    return (x == 0u) ? 1u : x;
+// Render seed for the counter-based sampler (env: YSU_SEED). Together with
+// pixel index and sample index it fully determines every random number, so
+// output no longer depends on YSU_THREADS, tile size or scheduler.
+static int      g_seed_forced = 0;
+static uint32_t g_render_seed = 1337u;
+
+void render_set_seed(uint32_t seed) {
+    g_seed_forced = 1;
+    g_render_seed = seed;
 }
 
-static inline float ysu_rng_f01(YSU_Rng *r) {
-    return (ysu_rng_u32(r) >> 8) * (1.0f / 16777216.0f);
+static void ysu_seed_load_config(void) {
+    if (g_seed_forced) return;
+    g_render_seed = (uint32_t)ysu_env_int("YSU_SEED", 1337);
 }
 
 /* Public RNG helpers (declared in render.h) */
@@ -144,19 +152,17 @@ int ysu_russian_roulette(uint32_t *state, float p_survive) {
     return (u < p_survive) ? 1 : 0;
 }
 
-static int ysu_suggest_threads(void) {
-    const char *env = getenv("YSU_THREADS");
-    if (env && env[0]) {
-        int v = atoi(env);
-        if (v > 0) return v;
-    }
+static inline double ysu_now_ms(void) {
 #if defined(_WIN32)
-    SYSTEM_INFO sys;
-    GetSystemInfo(&sys);
-    int n = (int)sys.dwNumberOfProcessors;
-    return (n > 0) ? n : 8;
+    static LARGE_INTEGER freq;
+    static int inited = 0;
+    if (!inited) { QueryPerformanceFrequency(&freq); inited = 1; }
+    LARGE_INTEGER c; QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)freq.QuadPart;
 #else
-    return 8;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
 #endif
 }
 
@@ -217,8 +223,550 @@ typedef struct {
     Vec3 n;
     Vec3 albedo;
     Vec3 emission;
+    int mat;        // index into g_mats
+    int prim;       // loaded-scene sphere index, -1 for built-in geometry and meshes
 } Hit;
 
+// Built-in scene materials (the checker ground is two Lambertians so the
+// path integrators can shade purely from the material table).
+enum {
+    SCENE_MAT_SUN = 0,
+    SCENE_MAT_BLUE,
+    SCENE_MAT_GROUND_LIGHT,
+    SCENE_MAT_GROUND_DARK,
+    SCENE_MAT_COUNT
+};
+
+static const Material g_scene_mats[SCENE_MAT_COUNT] = {
+    { MAT_EMISSIVE,   {1.0f,  1.0f,  1.0f},  0.0f, 1.0f, {10.0f, 6.0f, 2.0f} },
+    { MAT_LAMBERTIAN, {0.2f,  0.6f,  0.9f},  0.0f, 1.0f, {0.0f, 0.0f, 0.0f} },
+    { MAT_LAMBERTIAN, {0.85f, 0.85f, 0.85f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} },
+    { MAT_LAMBERTIAN, {0.2f,  0.2f,  0.2f},  0.0f, 1.0f, {0.0f, 0.0f, 0.0f} },
+};
+
+// Scene set with render_set_scene(): spheres (BVH-sorted copy) plus a
+// material table that starts with g_scene_mats, so the ground indices stay
+// valid. The BVH is kept only in its traversal forms: flattened binary (ray
+// packets, and single rays with YSU_BVH_WIDTH=2) plus wide (BVH4/BVH8) for
+// single rays otherwise. count == 0 => built-in test scene. ids maps a
+// sphere slot back to its index in the render_set_scene() array; the refit
+// context is set up by the first render_update_spheres(). With a pruning
+// policy the unpruned tree is kept in `full` (refits go there) and bvh /
+// wide are derived from it each time the policy reruns.
+typedef struct {
+    Sphere   *spheres;
+    int32_t  *ids;
+    int       count;
+    BvhFlat   bvh;
+    BvhWide   wide;
+    int       width;
+    BvhRefit  refit;
+    BvhFlat   full;
+    uint32_t  policy_frame;
+    int       policy_dirty;
+    Material *mats;
+    int       mat_count;
+    int       ground;
+} RenderScene;
+
+static RenderScene g_scene;
+static const Material *g_mats = g_scene_mats;
+
+// Triangle mesh set with render_set_mesh_ex(), traced next to the spheres
+// (it replaces the built-in spheres when no sphere scene is set). Its
+// materials follow the scene table in g_mesh_table, starting at mat_base;
+// slot_mat maps a leaf slot to one of them. render_set_mesh_instances()
+// fills tlas instead of bvh: one BLAS per mesh over blas_tris, one instance
+// per placement with its material in user_id.
+typedef struct {
+    MeshBvh   bvh;
+    uint16_t *slot_mat;    // NULL with one material
+    Tlas      tlas;
+    float   **blas_tris;   // tri_vec4 copies the BLASes point into
+    int       blas_count;
+    int       active;      // bvh or tlas is set
+    float     bmin[3];     // world bounds
+    float     bmax[3];
+    Material *mats;
+    int       mat_count;
+    int       mat_base;
+    int       ground;      // checker ground when there is no sphere scene
+    Material *table;       // scene table + mesh materials (g_mats)
+} RenderMesh;
+
+static RenderMesh g_mesh;
+
+// Points g_mats at the scene table, extended with the mesh materials.
+static void render_mats_publish(void) {
+    const Material *base = g_scene.mats ? g_scene.mats : g_scene_mats;
+    int base_count = g_scene.mats ? g_scene.mat_count : SCENE_MAT_COUNT;
+    free(g_mesh.table);
+    g_mesh.table = NULL;
+    g_mats = base;
+    if (!g_mesh.mat_count) return;
+
+    g_mesh.table = (Material*)malloc(sizeof(Material) * (size_t)(base_count + g_mesh.mat_count));
+    if (!g_mesh.table) return;   // render_set_mesh_ex() checks
+    memcpy(g_mesh.table, base, sizeof(Material) * (size_t)base_count);
+    memcpy(g_mesh.table + base_count, g_mesh.mats, sizeof(Material) * (size_t)g_mesh.mat_count);
+    g_mesh.mat_base = base_count;
+    g_mats = g_mesh.table;
+}
+
+static void render_scene_release(void) {
+    bvh_refit_free(&g_scene.refit);
+    free(g_scene.ids);
+    bvh_flat_free(&g_scene.full);
+    bvh_flat_free(&g_scene.bvh);
+    bvh_wide_free(&g_scene.wide);
+    free(g_scene.spheres);
+    free(g_scene.mats);
+    memset(&g_scene, 0, sizeof(g_scene));
+    render_mats_publish();
+}
+
+// ================================================================
+// BVH pruning policy (env: YSU_BVH_POLICY_MODEL=model.json)
+//   YSU_BVH_POLICY_EVERY    frames between online re-evaluations (default 30, 0 = first frame only)
+//   YSU_BVH_POLICY_SAMPLES  sample rays per evaluation (default 4096)
+// Lossy: pruned subtrees are skipped by every traversal.
+// ================================================================
+static int g_policy_init = 0;
+static int g_policy_enabled = 0;
+static int g_policy_every = 30;
+static int g_policy_samples = 4096;
+static BvhPolicyModel g_policy_model;
+
+static void ysu_policy_load_model(const char *path) {
+    g_policy_enabled = (path && path[0]) ? bvh_policy_load(path, &g_policy_model) : 0;
+}
+
+static void ysu_policy_load_once(void) {
+    if (g_policy_init) return;
+    g_policy_init = 1;
+
+    const char *path = getenv("YSU_BVH_POLICY_MODEL");
+    if (!path || !path[0]) return;
+    ysu_policy_load_model(path);
+    if (getenv("YSU_BVH_POLICY_EVERY"))   g_policy_every = atoi(getenv("YSU_BVH_POLICY_EVERY"));
+    if (getenv("YSU_BVH_POLICY_SAMPLES")) g_policy_samples = atoi(getenv("YSU_BVH_POLICY_SAMPLES"));
+    if (g_policy_every < 0) g_policy_every = 0;
+    if (g_policy_samples < 64) g_policy_samples = 64;
+    if (g_policy_enabled) {
+        printf("[POLICY] %s: %d features, threshold %.2f, every %d frames, %d sample rays\n",
+               path, g_policy_model.n, g_policy_model.threshold, g_policy_every, g_policy_samples);
+    }
+}
+
+void render_set_policy_model(const char *path) {
+    ysu_policy_load_once();   // YSU_BVH_POLICY_EVERY / _SAMPLES still apply
+    ysu_policy_load_model(path);
+}
+
+// Traversal trees (bvh, wide) from a tree whose prune flags are set.
+static int render_scene_derive(const bvh_node *tree) {
+    BvhFlat flat;
+    BvhWide wide;
+    memset(&wide, 0, sizeof(wide));
+    if (!bvh_flatten(tree, &flat)) return 0;
+    if (g_scene.width != 2 && !bvh_wide_build(tree, g_scene.width, &wide)) {
+        bvh_flat_free(&flat);
+        return 0;
+    }
+    bvh_flat_free(&g_scene.bvh);
+    bvh_wide_free(&g_scene.wide);
+    g_scene.bvh = flat;
+    g_scene.wide = wide;
+    return 1;
+}
+
+// Called before each perspective shading frame (render_scene_st / _mt /
+// progressive / budgeted; not lens, G-buffer or first-touch dispatches,
+// which have no camera to sample): reruns the policy on sampled primary
+// rays on the first frame, every g_policy_every frames and after the scene
+// moved.
+static void render_policy_frame(const Camera *cam, int width, int height) {
+    if (!g_scene.full.nodes) return;
+    uint32_t f = g_scene.policy_frame++;
+    if (!(f == 0 || g_scene.policy_dirty || (g_policy_every > 0 && f % (uint32_t)g_policy_every == 0))) return;
+
+    int side = (int)sqrtf((float)g_policy_samples);
+    int n = side * side;
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * (size_t)n);
+    bvh_node *tree = bvh_flat_to_tree(&g_scene.full);
+    if (!rays || !tree) {
+        free(rays);
+        bvh_free(tree);
+        return;
+    }
+    // stratified, shifted each evaluation so reruns see other pixels
+    float jx = fmodf(0.618034f * (float)f, 1.0f), jy = fmodf(0.754878f * (float)f, 1.0f);
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            rays[y * side + x] = camera_get_ray(*cam, ((float)x + jx) / (float)side, ((float)y + jy) / (float)side);
+        }
+    }
+
+    BvhPolicyStats st;
+    float scale = (float)width * (float)height / (float)n;
+    bvh_policy_eval(tree, g_scene.spheres, rays, n, &g_policy_model, scale, &st);
+    int ok = render_scene_derive(tree);
+    bvh_free(tree);
+    free(rays);
+    if (!ok) return;
+    g_scene.policy_dirty = 0;
+
+    printf("[POLICY] frame %u: %d/%d nodes marked, %d in pruned subtrees; visits/ray %.1f -> %.1f (-%.1f%%);"
+           " changed hits %.2f%% of %d rays; %.1f ms\n",
+           f, st.marked, st.nodes, st.removed,
+           (double)st.visits_full / (double)n, (double)st.visits_pruned / (double)n,
+           st.visits_full ? 100.0 * (double)(st.visits_full - st.visits_pruned) / (double)st.visits_full : 0.0,
+           100.0 * (double)st.rays_changed / (double)n, n, st.ms);
+}
+
+int render_set_scene(const Sphere *spheres, int sphere_count,
+                     const Material *materials, int material_count, int ground)
+{
+    render_scene_release();
+    if (!spheres || sphere_count <= 0) return 1;
+
+    static const Material k_default = { MAT_LAMBERTIAN, {1.0f, 1.0f, 1.0f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    if (!materials || material_count <= 0) { materials = &k_default; material_count = 1; }
+
+    double t0 = ysu_now_ms();
+    g_scene.spheres = (Sphere*)malloc(sizeof(Sphere) * (size_t)sphere_count);
+    g_scene.ids = (int32_t*)malloc(sizeof(int32_t) * (size_t)sphere_count);
+    g_scene.mats = (Material*)malloc(sizeof(Material) * (size_t)(SCENE_MAT_COUNT + material_count));
+    if (!g_scene.spheres || !g_scene.ids || !g_scene.mats) {
+        printf("[SCENE] out of memory for %d spheres\n", sphere_count);
+        render_scene_release();
+        return 0;
+    }
+
+    memcpy(g_scene.mats, g_scene_mats, sizeof(g_scene_mats));
+    memcpy(g_scene.mats + SCENE_MAT_COUNT, materials, sizeof(Material) * (size_t)material_count);
+    g_scene.mat_count = SCENE_MAT_COUNT + material_count;
+
+    for (int i = 0; i < sphere_count; ++i) {
+        Sphere sp = spheres[i];
+        int mi = sp.material_index;
+        if (mi < 0 || mi >= material_count) mi = 0;
+        sp.material_index = SCENE_MAT_COUNT + mi;
+        g_scene.spheres[i] = sp;
+    }
+    g_scene.count = sphere_count;
+    g_scene.ground = ground ? 1 : 0;
+
+    BvhBuildOpts bopt;
+    bvh_build_opts_default(&bopt);
+    int width = bvh_wide_default_width();
+    bvh_node *root = bvh_build_tracked(g_scene.spheres, 0, sphere_count, &bopt, g_scene.ids);
+    int bvh_ok = root && bvh_flatten(root, &g_scene.bvh) &&
+                 (width == 2 || bvh_wide_build(root, width, &g_scene.wide));
+    g_scene.width = width;
+    ysu_policy_load_once();
+    if (bvh_ok && g_policy_enabled) {
+        // traversal copies until the first frame prunes them
+        g_scene.full = g_scene.bvh;
+        memset(&g_scene.bvh, 0, sizeof(g_scene.bvh));
+        bvh_wide_free(&g_scene.wide);
+        bvh_ok = render_scene_derive(root);
+    }
+    bvh_free(root);
+    if (!bvh_ok || !g_scene.bvh.nodes) {
+        printf("[SCENE] BVH build failed (%d spheres)\n", sphere_count);
+        render_scene_release();
+        return 0;
+    }
+    render_mats_publish();
+    if (g_mesh.mat_count && !g_mesh.table) {
+        printf("[SCENE] out of memory for the material table\n");
+        render_scene_release();
+        return 0;
+    }
+
+    printf("[SCENE] %d spheres, %d materials, BVH%d%s (%s, leaf %d, %d nodes) built in %.1f ms\n",
+           sphere_count, material_count, width, g_scene.wide.avx2 ? " avx2" : "",
+           (bopt.mode == BVH_BUILD_SAH) ? "sah" : "median", bopt.leaf_size,
+           (width == 2) ? g_scene.bvh.count : g_scene.wide.count, ysu_now_ms() - t0);
+    return 1;
+}
+
+static void render_mesh_release(void) {
+    mesh_bvh_free(&g_mesh.bvh);
+    tlas_free(&g_mesh.tlas);
+    for (int i = 0; i < g_mesh.blas_count; ++i) free(g_mesh.blas_tris[i]);
+    free(g_mesh.blas_tris);
+    free(g_mesh.slot_mat);
+    free(g_mesh.mats);
+    free(g_mesh.table);
+    memset(&g_mesh, 0, sizeof(g_mesh));
+    render_mats_publish();
+}
+
+// Material slots and the material table for the freshly built g_mesh.bvh.
+// The slot -> triangle map is dropped afterwards (traversal never reads it).
+static int render_mesh_finish(uint32_t tri_count, const uint16_t *tri_material,
+                              const Material *materials, int material_count, int ground)
+{
+    static const Material k_default = { MAT_LAMBERTIAN, {0.8f, 0.8f, 0.8f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    if (!materials || material_count <= 0) { materials = &k_default; material_count = 1; }
+    if (material_count > 65536) material_count = 65536;
+    if (material_count == 1) tri_material = NULL;
+
+    uint32_t slots = g_mesh.bvh.block_count * 8u;
+    g_mesh.slot_mat = tri_material ? (uint16_t*)malloc(sizeof(uint16_t) * (size_t)slots) : NULL;
+    g_mesh.mats = (Material*)malloc(sizeof(Material) * (size_t)material_count);
+    if ((tri_material && !g_mesh.slot_mat) || !g_mesh.mats) {
+        printf("[MESH] out of memory for %u triangles\n", tri_count);
+        render_mesh_release();
+        return 0;
+    }
+    memcpy(g_mesh.mats, materials, sizeof(Material) * (size_t)material_count);
+    for (uint32_t k = 0; tri_material && k < slots; ++k) {
+        uint32_t src = g_mesh.bvh.tri[k];
+        uint16_t mi = (src != UINT32_MAX) ? tri_material[src] : 0;
+        g_mesh.slot_mat[k] = ((int)mi < material_count) ? mi : 0;
+    }
+    free(g_mesh.bvh.tri);
+    g_mesh.bvh.tri = NULL;
+    g_mesh.bvh.bytes -= sizeof(uint32_t) * (size_t)slots;
+    g_mesh.mat_count = material_count;
+    g_mesh.ground = ground ? 1 : 0;
+    render_mats_publish();
+    if (!g_mesh.table) {
+        printf("[MESH] out of memory for the material table\n");
+        render_mesh_release();
+        return 0;
+    }
+    memcpy(g_mesh.bmin, g_mesh.bvh.bmin, sizeof(g_mesh.bmin));
+    memcpy(g_mesh.bmax, g_mesh.bvh.bmax, sizeof(g_mesh.bmax));
+    g_mesh.active = 1;
+
+    size_t bytes = g_mesh.bvh.bytes + (g_mesh.slot_mat ? sizeof(uint16_t) * (size_t)slots : 0u);
+    printf("[MESH] %u triangles, %d materials: %u nodes, %u x8 leaf blocks (%.0f%% lanes used), %s%s leaves,"
+           " %.1f MB (%.1f B/tri), built in %.1f ms\n",
+           tri_count, material_count, g_mesh.bvh.node_count, g_mesh.bvh.block_count,
+           100.0 * (double)tri_count / (8.0 * (double)g_mesh.bvh.block_count),
+           g_mesh.bvh.qblocks ? "quantised " : "", g_mesh.bvh.avx2 ? "avx2" : "scalar",
+           (double)bytes / 1e6, (double)bytes / (double)tri_count, g_mesh.bvh.build_ms);
+    return 1;
+}
+
+int render_set_mesh_ex(const float *tris, uint32_t tri_count, const uint16_t *tri_material,
+                       const Material *materials, int material_count, int ground)
+{
+    render_mesh_release();
+    if (!tris || tri_count == 0) return 1;
+    if (!mesh_bvh_build(&g_mesh.bvh, tris, tri_count)) {
+        printf("[MESH] BVH build failed (%u triangles)\n", tri_count);
+        return 0;
+    }
+    return render_mesh_finish(tri_count, tri_material, materials, material_count, ground);
+}
+
+int render_set_mesh_indexed(const float *verts, const uint32_t *indices, uint32_t tri_count,
+                            const uint16_t *tri_material, const Material *materials,
+                            int material_count, int ground)
+{
+    render_mesh_release();
+    if (!verts || !indices || tri_count == 0) return 1;
+    if (!mesh_bvh_build_indexed(&g_mesh.bvh, verts, indices, tri_count)) {
+        printf("[MESH] BVH build failed (%u triangles)\n", tri_count);
+        return 0;
+    }
+    return render_mesh_finish(tri_count, tri_material, materials, material_count, ground);
+}
+
+int render_set_mesh(const float *tris, uint32_t tri_count, const Material *material) {
+    return render_set_mesh_ex(tris, tri_count, NULL, material, material ? 1 : 0, 1);
+}
+
+int render_set_mesh_instances(const float *const *verts, const uint32_t *const *indices,
+                              const uint32_t *tri_counts, int mesh_count,
+                              const float *xforms, const uint32_t *inst_mesh,
+                              const uint16_t *inst_material, int inst_count,
+                              const Material *materials, int material_count, int ground)
+{
+    static const Material k_default = { MAT_LAMBERTIAN, {0.8f, 0.8f, 0.8f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    render_mesh_release();
+    if (mesh_count <= 0 || inst_count <= 0) return 1;
+    if (!verts || !indices || !tri_counts || !xforms || !inst_mesh) return 0;
+    if (!materials || material_count <= 0) { materials = &k_default; material_count = 1; }
+    if (material_count > 65536) material_count = 65536;
+
+    double t0 = ysu_now_ms();
+    g_mesh.blas_tris = (float**)calloc((size_t)mesh_count, sizeof(float*));
+    g_mesh.mats = (Material*)malloc(sizeof(Material) * (size_t)material_count);
+    if (!g_mesh.blas_tris || !g_mesh.mats) goto oom;
+    g_mesh.blas_count = mesh_count;
+
+    // one BLAS per mesh, over a tri_vec4 copy it keeps pointing into
+    size_t bytes = 0;
+    uint64_t mesh_tris = 0, inst_tris = 0;
+    for (int m = 0; m < mesh_count; ++m) {
+        uint32_t n = tri_counts[m];
+        if (n == 0) {
+            printf("[MESH] mesh %d has no triangles\n", m);
+            render_mesh_release();
+            return 0;
+        }
+        float *tris = (float*)malloc(sizeof(float) * 12u * (size_t)n);
+        if (!tris) goto oom;
+        g_mesh.blas_tris[m] = tris;
+        for (uint32_t t = 0; t < n; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                const float *v = verts[m] + (size_t)indices[m][(size_t)t * 3u + (size_t)k] * 3u;
+                float *o = tris + (size_t)t * 12u + (size_t)k * 4u;
+                o[0] = v[0]; o[1] = v[1]; o[2] = v[2]; o[3] = 0.0f;
+            }
+        }
+        if (tlas_add_blas(&g_mesh.tlas, tris, n) != m) {
+            printf("[MESH] BLAS build failed (mesh %d, %u triangles)\n", m, n);
+            render_mesh_release();
+            return 0;
+        }
+        const TlasBlas *b = &g_mesh.tlas.blas[m];
+        bytes += sizeof(float) * 12u * (size_t)n + sizeof(GPUBVHNode) * b->mesh.node_count +
+                 sizeof(int32_t) * (size_t)n;
+        mesh_tris += n;
+    }
+
+    int placed = 0;
+    for (int i = 0; i < inst_count; ++i) {
+        uint32_t m = inst_mesh[i];
+        uint16_t mi = inst_material ? inst_material[i] : 0;
+        if ((int)mi >= material_count) mi = 0;
+        if (m >= (uint32_t)mesh_count || tlas_add_instance(&g_mesh.tlas, m, xforms + (size_t)i * 12u, mi) < 0) {
+            printf("[MESH] instance %d skipped (bad mesh or singular transform)\n", i);
+            continue;
+        }
+        inst_tris += tri_counts[m];
+        placed++;
+    }
+    if (!placed) {
+        render_mesh_release();
+        return 0;
+    }
+    if (!tlas_build(&g_mesh.tlas)) goto oom;
+    bytes += sizeof(TlasInstance) * (size_t)placed + sizeof(GPUBVHNode) * g_mesh.tlas.node_count +
+             sizeof(int32_t) * (size_t)placed;
+
+    memcpy(g_mesh.mats, materials, sizeof(Material) * (size_t)material_count);
+    g_mesh.mat_count = material_count;
+    g_mesh.ground = ground ? 1 : 0;
+    render_mats_publish();
+    if (!g_mesh.table) goto oom;
+    for (int a = 0; a < 3; ++a) {
+        g_mesh.bmin[a] = g_mesh.tlas.nodes[0].bmin[a];
+        g_mesh.bmax[a] = g_mesh.tlas.nodes[0].bmax[a];
+    }
+    g_mesh.active = 1;
+
+    printf("[MESH] %d meshes (%llu triangles), %d instances (%llu triangles placed), %d materials:"
+           " BLAS per mesh + TLAS (%u nodes), %.1f MB, built in %.1f ms\n",
+           mesh_count, (unsigned long long)mesh_tris, placed, (unsigned long long)inst_tris, material_count,
+           g_mesh.tlas.node_count, (double)bytes / 1e6, ysu_now_ms() - t0);
+    return 1;
+
+oom:
+    printf("[MESH] out of memory for %d meshes / %d instances\n", mesh_count, inst_count);
+    render_mesh_release();
+    return 0;
+}
+
+int render_update_spheres(const int *ids, const Sphere *spheres, int count) {
+    if (g_scene.count <= 0 || !ids || !spheres || count <= 0) return 0;
+    // with a policy the unpruned tree is refitted and the next frame
+    // derives new traversal trees from it
+    if (!g_scene.refit.parent &&
+        !(g_scene.full.nodes
+              ? bvh_refit_init(&g_scene.refit, &g_scene.full, NULL, g_scene.count, g_scene.ids)
+              : bvh_refit_init(&g_scene.refit, &g_scene.bvh, g_scene.wide.nodes ? &g_scene.wide : NULL,
+                               g_scene.count, g_scene.ids))) {
+        printf("[REFIT] out of memory for %d spheres\n", g_scene.count);
+        return 0;
+    }
+
+    int32_t *slots = (int32_t*)malloc(sizeof(int32_t) * (size_t)count);
+    if (!slots) return 0;
+    int n = 0;
+    int user_mats = g_scene.mat_count - SCENE_MAT_COUNT;
+    for (int k = 0; k < count; ++k) {
+        if (ids[k] < 0 || ids[k] >= g_scene.count) continue;
+        int32_t s = g_scene.refit.slot[ids[k]];
+        Sphere sp = spheres[k];
+        int mi = sp.material_index;
+        if (mi < 0 || mi >= user_mats) mi = 0;
+        sp.material_index = SCENE_MAT_COUNT + mi;
+        g_scene.spheres[s] = sp;
+        slots[n++] = s;
+    }
+
+    static int stats = -1;
+    if (stats < 0) { const char *e = getenv("YSU_BVH_REFIT_STATS"); stats = (e && e[0] == '1'); }
+
+    BvhBuildOpts bopt;
+    bvh_build_opts_default(&bopt);
+    BvhRefitStats st;
+    int ok = bvh_refit_step(&g_scene.refit, g_scene.spheres, slots, n, &bopt, &st);
+    free(slots);
+    if (g_scene.full.nodes) g_scene.policy_dirty = 1;
+    if (stats) {
+        printf("[REFIT] %d spheres: %d boxes in %.3f ms, sah x%.2f", n, st.nodes, st.refit_ms, st.sah_ratio);
+        if (st.rebuilt) printf(", rebuilt %d spheres in %.2f ms", st.rebuilt, st.rebuild_ms);
+        printf("\n");
+    }
+    return ok;
+}
+
+// ================================================================
+// Integrator selection (env: YSU_INTEGRATOR=direct|path|wavefront)
+// ================================================================
+static int g_integrator_forced = -1;   // set by render_set_integrator()
+static YSU_Integrator g_integrator = YSU_INTEGRATOR_DIRECT;
+
+void render_set_integrator(YSU_Integrator integ) {
+    g_integrator_forced = (int)integ;
+    g_integrator = integ;
+}
+
+static void ysu_integrator_load_config(void) {
+    if (g_integrator_forced >= 0) { g_integrator = (YSU_Integrator)g_integrator_forced; return; }
+    const char *s = getenv("YSU_INTEGRATOR");
+    if (s && !strcmp(s, "path"))           g_integrator = YSU_INTEGRATOR_PATH;
+    else if (s && !strcmp(s, "wavefront")) g_integrator = YSU_INTEGRATOR_WAVEFRONT;
+    else                                   g_integrator = YSU_INTEGRATOR_DIRECT;
+}
+
+// ================================================================
+// Ray sorting (env: YSU_RAY_SORT=1) and traversal counters (YSU_PERF=1)
+// Only the wavefront path buffers rays: each worker sorts its batch of
+// secondary rays by ray_sort_key() before BVH traversal. YSU_PERF logs a
+// [RAYSORT] line per frame with the traversal-stage time and, where
+// perf_event_open works, L1D / LLC read misses.
+// ================================================================
+static int g_ray_sort_forced = -1;   // set by render_set_ray_sort()
+static int g_ray_sort = 0;
+static int g_perf = 0;
+
+void render_set_ray_sort(int enabled) {
+    g_ray_sort_forced = enabled ? 1 : 0;
+}
+
+static void ysu_raysort_load_config(void) {
+    g_ray_sort = (g_ray_sort_forced >= 0) ? g_ray_sort_forced : (ysu_env_int("YSU_RAY_SORT", 0) ? 1 : 0);
+    g_perf = ysu_env_int("YSU_PERF", 0) ? 1 : 0;
+}
+
+static const char *ysu_integrator_name(YSU_Integrator integ) {
+    switch (integ) {
+        case YSU_INTEGRATOR_PATH:      return "path";
+        case YSU_INTEGRATOR_WAVEFRONT: return "wavefront";
+        default:                       return "direct";
+    }
+}
+
 static Vec3 ysu_sky(Ray r) {
     Vec3 u = vec3_unit(r.direction);
     float t = 0.5f * (u.y + 1.0f);
@@ -228,7 +776,7 @@ static Vec3 ysu_sky(Ray r) {
 }
 
 static int hit_sphere(Vec3 center, float radius, Ray r, float tmin, float tmax, Hit* out,
-                      Vec3 albedo, Vec3 emission)
+                      int mat)
 {
     Vec3 oc = vec3_sub(r.origin, center);
     float a = vec3_dot(r.direction, r.direction);
@@ -249,8 +797,10 @@ static int hit_sphere(Vec3 center, float radius, Ray r, float tmin, float tmax,
     out->t = t;
     out->p = ray_at(r, t);
     out->n = vec3_scale(vec3_sub(out->p, center), 1.0f / radius);
-    out->albedo = albedo;
-    out->emission = emission;
+    out->albedo = g_mats[mat].albedo;
+    out->emission = g_mats[mat].emission;
+    out->mat = mat;
+    out->prim = -1;
     return 1;
 }
 
@@ -270,8 +820,72 @@ static int hit_ground(Ray r, float tmin, float tmax, Hit* out) {
     int cx = (int)floorf(out->p.x);
     int cz = (int)floorf(out->p.z);
     int check = (cx + cz) & 1;
-    out->albedo = check ? vec3(0.85f, 0.85f, 0.85f) : vec3(0.2f, 0.2f, 0.2f);
-    out->emission = vec3(0.0f, 0.0f, 0.0f);
+    out->mat = check ? SCENE_MAT_GROUND_LIGHT : SCENE_MAT_GROUND_DARK;
+    out->albedo = g_mats[out->mat].albedo;
+    out->emission = g_mats[out->mat].emission;
+    out->prim = -1;
+    return 1;
+}
+
+typedef struct {
+    Vec3 center;
+    float radius;
+    int mat;
+} BuiltinSphere;
+
+static const BuiltinSphere g_builtin_spheres[] = {
+    { {0.0f, 1.2f, -2.0f}, 0.35f, SCENE_MAT_SUN  },  // emissive "sun" (bloom trigger)
+    { {0.0f, 0.0f, -1.0f}, 0.5f,  SCENE_MAT_BLUE },  // main sphere
+};
+#define BUILTIN_SPHERE_COUNT ((int)(sizeof(g_builtin_spheres) / sizeof(g_builtin_spheres[0])))
+
+// Loaded-scene sphere k hit at t: sphere albedo tints the material's albedo
+// and emission (white spheres keep the material colors).
+static void scene_sphere_hit(int k, Ray r, float t, Hit *out) {
+    const Sphere *sp = &g_scene.spheres[k];
+    const Material *m = &g_mats[sp->material_index];
+    Vec3 tint = vec3(sp->albedo.r, sp->albedo.g, sp->albedo.b);
+
+    out->hit = 1;
+    out->t = t;
+    out->p = ray_at(r, t);
+    out->n = vec3_scale(vec3_sub(out->p, sp->center), 1.0f / sp->radius);
+    out->albedo = vec3_mul(m->albedo, tint);
+    out->emission = vec3_mul(m->emission, tint);
+    out->mat = sp->material_index;
+    out->prim = k;
+}
+
+// Mesh hit in [tmin, tmax]. Meshes are often open or wound inconsistently,
+// so the normal is turned toward the ray, except for dielectrics, which
+// tell inside from outside by the winding.
+static int scene_mesh_hit(Ray r, float tmin, float tmax, Hit *out) {
+    float t;
+    int mat;
+    Vec3 n;
+    if (g_mesh.tlas.nodes) {
+        TlasHit th;
+        if (!tlas_hit_closest(&g_mesh.tlas, &r, tmin, tmax, &th)) return 0;
+        t = th.t;
+        mat = g_mesh.mat_base + (int)g_mesh.tlas.inst[th.inst].user_id;
+        n = tlas_hit_normal(&g_mesh.tlas, &th);
+    } else {
+        int slot = mesh_bvh_hit_closest(&g_mesh.bvh, &r, tmin, tmax, &t);
+        if (slot < 0) return 0;
+        mat = g_mesh.mat_base + (g_mesh.slot_mat ? g_mesh.slot_mat[slot] : 0);
+        n = mesh_bvh_normal(&g_mesh.bvh, slot);
+    }
+    const Material *m = &g_mats[mat];
+    if (m->type != MAT_DIELECTRIC && vec3_dot(n, r.direction) > 0.0f) n = vec3_scale(n, -1.0f);
+
+    out->hit = 1;
+    out->t = t;
+    out->p = ray_at(r, t);
+    out->n = n;
+    out->albedo = m->albedo;
+    out->emission = m->emission;
+    out->mat = mat;
+    out->prim = -1;
     return 1;
 }
 
@@ -280,22 +894,41 @@ static int scene_hit(Ray r, float tmin, float tmax, Hit* out) {
     int any = 0;
     float closest = tmax;
 
-    // emissive "sun" sphere (bloom trigger)
-    if (hit_sphere(vec3(0.0f, 1.2f, -2.0f), 0.35f, r, tmin, closest, &tmp,
-                   vec3(1.0f, 1.0f, 1.0f),
-                   vec3(10.0f, 6.0f, 2.0f))) { // HDR emission
-        any = 1; closest = tmp.t; *out = tmp;
+    if (g_scene.count > 0) {
+        float t;
+        int k = g_scene.wide.nodes
+              ? bvh_wide_hit_closest(&g_scene.wide, g_scene.spheres, &r, tmin, closest, &t)
+              : bvh_flat_hit_closest(&g_scene.bvh, g_scene.spheres, &r, tmin, closest, &t);
+        if (k >= 0) {
+            scene_sphere_hit(k, r, t, out);
+            any = 1; closest = t;
+        }
+        if (g_mesh.active && scene_mesh_hit(r, tmin, closest, &tmp)) {
+            any = 1; closest = tmp.t; *out = tmp;
+        }
+        if (g_scene.ground && hit_ground(r, tmin, closest, &tmp)) {
+            any = 1; *out = tmp;
+        }
+        return any;
     }
 
-    // main sphere
-    if (hit_sphere(vec3(0.0f, 0.0f, -1.0f), 0.5f, r, tmin, closest, &tmp,
-                   vec3(0.2f, 0.6f, 0.9f),
-                   vec3(0.0f, 0.0f, 0.0f))) {
-        any = 1; closest = tmp.t; *out = tmp;
+    int ground = 1;
+    if (g_mesh.active) {
+        if (scene_mesh_hit(r, tmin, closest, &tmp)) {
+            any = 1; closest = tmp.t; *out = tmp;
+        }
+        ground = g_mesh.ground;
+    } else {
+        for (int k = 0; k < BUILTIN_SPHERE_COUNT; ++k) {
+            const BuiltinSphere *sp = &g_builtin_spheres[k];
+            if (hit_sphere(sp->center, sp->radius, r, tmin, closest, &tmp, sp->mat)) {
+                any = 1; closest = tmp.t; *out = tmp;
+            }
+        }
     }
 
     // ground
-    if (hit_ground(r, tmin, closest, &tmp)) {
+    if (ground && hit_ground(r, tmin, closest, &tmp)) {
         any = 1; closest = tmp.t; *out = tmp;
     }
 
@@ -336,13 +969,16 @@ static Vec3 shade_debug(const Hit* h, Vec3 shaded_color) {
     }
 }
 
-Vec3 ray_color_internal(Ray r, int depth) {
-    ysu_fx_load_once();
+// Sun direction of the direct shader (also the G-buffer shadow rays).
+static inline Vec3 direct_light_dir(void) {
+    return vec3_unit(vec3(0.6f, 1.0f, -0.4f));
+}
 
+static Vec3 ray_color_direct(Ray r, int depth) {
     Hit h = {0};
     if (scene_hit(r, 0.001f, 1e30f, &h)) {
         // Simple lambert + emission
-        Vec3 light_dir = vec3_unit(vec3(0.6f, 1.0f, -0.4f));
+        Vec3 light_dir = direct_light_dir();
         float ndl = maxf(0.0f, vec3_dot(h.n, light_dir));
         Vec3 diffuse = vec3_scale(h.albedo, 0.15f + 0.85f * ndl);
 
@@ -365,7 +1001,192 @@ Vec3 ray_color_internal(Ray r, int depth) {
     return sky;
 }
 
+// Naive recursive path tracer: one scatter per bounce via material_scatter,
+// no NEE / RR. Serves as the reference estimator for the wavefront path.
+// Interaction k draws from sampler slot k+1 (slot 0 is the pixel jitter).
+static Vec3 ray_color_path(Ray r, int depth, int bounce, YSU_Sampler *smp, uint64_t *rays) {
+    if (depth <= 0) return vec3(0.0f, 0.0f, 0.0f);
+
+    Hit h = {0};
+    (*rays)++;
+    if (!scene_hit(r, 0.001f, 1e30f, &h)) return ysu_sky(r);
+
+    Ray scattered;
+    Vec3 atten;
+    Material m = g_mats[h.mat];
+    m.albedo = h.albedo;
+    ysu_sampler_bounce(smp, (uint32_t)bounce + 1u);
+    if (!material_scatter_rng(&m, r, h.p, h.n, smp, &scattered, &atten)) {
+        return h.emission;
+    }
+    Vec3 li = ray_color_path(scattered, depth - 1, bounce + 1, smp, rays);
+    return vec3_add(h.emission, vec3_mul(atten, li));
+}
+
+// Per-sample entry used by the tile renderers. Debug views always go through
+// the direct shader.
+static inline Vec3 ysu_trace(Ray r, int depth, YSU_Sampler *smp, uint64_t *rays) {
+    if (g_integrator == YSU_INTEGRATOR_DIRECT || g_debug != DEBUG_NONE) {
+        (*rays)++;
+        return ray_color_direct(r, depth);
+    }
+    return ray_color_path(r, depth, 0, smp, rays);
+}
+
+Vec3 ray_color_internal(Ray r, int depth) {
+    static YSU_THREAD_LOCAL uint32_t t_calls = 0;
+    YSU_Sampler smp;
+    uint64_t rays = 0;
+    ysu_fx_load_once();
+    ysu_sampler_init(&smp, g_render_seed, 0xFFFFFFFFu, t_calls++, 0);
+    return ysu_trace(r, depth, &smp, &rays);
+}
+
+// ------------------------- Lenses (primary rays) -------------------------
+// Perspective frames go through camera_get_ray(). 360 frames (render_scene_360)
+// map pixel (i, j) - j counted from the bottom row - to a direction around
+// cam.origin instead:
+//  - equirect: phi = 2pi (i+jx)/W, theta = pi (1 - (j+jy)/H). sin/cos of
+//    theta per row and phi per column come from tables at pixel centres;
+//    the jitter offset (< half a pixel) is added with a short Taylor
+//    rotation instead of sinf/cosf per sample.
+//  - cubemap: a 6F x F strip of faces +X,-X,+Y,-Y,+Z,-Z, each a 90-degree
+//    pinhole with +Y up (+Y face: +Z up, -Y face: -Z up).
+typedef struct {
+    YSU_Lens kind;
+    int face;                  // cubemap face size
+    float dphi, dtheta;        // radians per pixel
+    float *sin_p, *cos_p;      // equirect: per column
+    float *sin_t, *cos_t;      // equirect: per row (j from the bottom)
+} RenderLens;
+
+static const Vec3 g_cube_basis[6][3] = {   // forward, right, up
+    { { 1, 0, 0}, { 0, 0, 1}, { 0, 1, 0} },
+    { {-1, 0, 0}, { 0, 0,-1}, { 0, 1, 0} },
+    { { 0, 1, 0}, { 1, 0, 0}, { 0, 0, 1} },
+    { { 0,-1, 0}, { 1, 0, 0}, { 0, 0,-1} },
+    { { 0, 0, 1}, {-1, 0, 0}, { 0, 1, 0} },
+    { { 0, 0,-1}, { 1, 0, 0}, { 0, 1, 0} },
+};
+
+// sin/cos of a + d from sin/cos of a, for |d| below a pixel
+static inline void lens_rotate(float s, float c, float d, float *s_out, float *c_out) {
+    float d2 = d * d;
+    float sd = d * (1.0f - d2 * (1.0f / 6.0f) * (1.0f - d2 * (1.0f / 20.0f)));
+    float cd = 1.0f - d2 * 0.5f * (1.0f - d2 * (1.0f / 12.0f));
+    *s_out = s * cd + c * sd;
+    *c_out = c * cd - s * sd;
+}
+
+static inline Ray lens_ray(const RenderLens *lens, const Camera *cam, int i, int j,
+                           float jx, float jy, float inv_wm1, float inv_hm1)
+{
+    if (!lens) return camera_get_ray(*cam, ((float)i + jx) * inv_wm1, ((float)j + jy) * inv_hm1);
+
+    Vec3 d;
+    if (lens->kind == YSU_LENS_EQUIRECT) {
+        float sp, cp, st, ct;
+        lens_rotate(lens->sin_p[i], lens->cos_p[i], (jx - 0.5f) * lens->dphi, &sp, &cp);
+        lens_rotate(lens->sin_t[j], lens->cos_t[j], (0.5f - jy) * lens->dtheta, &st, &ct);
+        d = vec3(st * cp, ct, st * sp);
+    } else {
+        int f = i / lens->face;
+        if (f > 5) f = 5;
+        float inv = 2.0f / (float)lens->face;
+        float a = ((float)(i - f * lens->face) + jx) * inv - 1.0f;
+        float b = ((float)j + jy) * inv - 1.0f;
+        const Vec3 *B = g_cube_basis[f];
+        d = vec3_add(B[0], vec3_add(vec3_scale(B[1], a), vec3_scale(B[2], b)));
+    }
+    return ray_create(cam->origin, vec3_normalize(d));
+}
+
+// One pixel of a plain (non-progressive) frame: spp_max samples, or fewer if
+// YSU_ADAPTIVE decides the luminance mean has converged. Sample s of pixel
+// (i,j) always uses sampler (seed, j*width+i, s), whoever renders it.
+typedef struct {
+    const Camera *cam;
+    const RenderLens *lens;    // NULL = perspective
+    int width;
+    float inv_wm1, inv_hm1;
+    int spp_max, spp_min;
+    int depth;
+    uint32_t seed;
+} PixelJob;
+
+static Vec3 render_pixel(const PixelJob *pj, int i, int j, uint64_t *rays,
+                         int *out_spp, int *out_early)
+{
+    float accx = 0.0f, accy = 0.0f, accz = 0.0f;
+    int spp_used = 0;
+    int early_stop = 0;
+
+    // Welford for luminance
+    float mean = 0.0f, m2 = 0.0f;
+
+    uint32_t pixel = (uint32_t)j * (uint32_t)pj->width + (uint32_t)i;
+    YSU_Sampler smp;
+
+    for (int s = 0; s < pj->spp_max; ++s) {
+        ysu_sampler_init(&smp, pj->seed, pixel, (uint32_t)s, 0);
+        float jx = ysu_sampler_next(&smp);
+        float jy = ysu_sampler_next(&smp);
+
+        Ray rr = lens_ray(pj->lens, pj->cam, i, j, jx, jy, pj->inv_wm1, pj->inv_hm1);
+        Vec3 c = ysu_trace(rr, pj->depth, &smp, rays);
+
+        accx += c.x; accy += c.y; accz += c.z;
+        spp_used++;
+
+        if (g_adapt_enabled) {
+            float lum = ysu_luminance(c);
+            float n = (float)spp_used;
+            float delta = lum - mean;
+            mean += delta / n;
+            float delta2 = lum - mean;
+            m2 += delta * delta2;
+
+            if (spp_used >= pj->spp_min && (spp_used % g_adapt_spp_batch) == 0) {
+                float var = (spp_used > 1) ? (m2 / (float)(spp_used - 1)) : 0.0f;
+                float se  = sqrtf(fmaxf(var, 0.0f) / (float)spp_used);
+
+                float tol = fmaxf(g_adapt_abs_err, g_adapt_rel_err * fabsf(mean));
+                if (se <= tol) { early_stop = 1; break; }
+            }
+        }
+    }
+
+    *out_spp = spp_used;
+    *out_early = early_stop;
+    float inv_spp = 1.0f / (float)spp_used;
+    return vec3(accx * inv_spp, accy * inv_spp, accz * inv_spp);
+}
+
+static void pixel_job_init(PixelJob *pj, const Camera *cam, const RenderLens *lens,
+                           int width, int height, int spp, int depth)
+{
+    pj->cam = cam;
+    pj->lens = lens;
+    pj->width = width;
+    pj->inv_wm1 = (width  > 1) ? (1.0f / (float)(width - 1)) : 0.0f;
+    pj->inv_hm1 = (height > 1) ? (1.0f / (float)(height - 1)) : 0.0f;
+    pj->spp_max = spp;
+    pj->spp_min = (g_adapt_spp_min < spp) ? g_adapt_spp_min : spp;
+    pj->depth = depth;
+    pj->seed = g_render_seed;
+}
+
+static void ysu_print_trace_stats(uint64_t rays, double ms) {
+    if (g_integrator == YSU_INTEGRATOR_DIRECT) return;
+    double mrays = (ms > 0.0) ? (double)rays / (ms * 1000.0) : 0.0;
+    printf("[PT] integrator=%s rays=%" PRIu64 " time=%.2f ms  %.2f Mrays/s\n",
+           ysu_integrator_name(g_integrator), rays, ms, mrays);
+}
+
 // ------------------------- Single-thread render -------------------------
+static void render_scene_st_frame(Vec3 *pixels, int image_width, int image_height, Camera cam,
+                                  int samples_per_pixel, int max_depth);
+
 void render_scene_st(Vec3 *pixels,
                      int image_width,
                      int image_height,
@@ -374,68 +1195,37 @@ void render_scene_st(Vec3 *pixels,
                      int max_depth)
 {
     if (!pixels || image_width <= 0 || image_height <= 0) return;
+    render_policy_frame(&cam, image_width, image_height);
+    render_scene_st_frame(pixels, image_width, image_height, cam, samples_per_pixel, max_depth);
+}
+
+static void render_scene_st_frame(Vec3 *pixels, int image_width, int image_height, Camera cam,
+                                  int samples_per_pixel, int max_depth)
+{
     if (samples_per_pixel < 1) samples_per_pixel = 1;
     if (max_depth < 1) max_depth = 1;
 
     ysu_adapt_load_config();
     ysu_fx_load_once();
+    ysu_integrator_load_config();
+    ysu_seed_load_config();
 
     atomic_store(&g_adapt_total_samples, 0);
     atomic_store(&g_adapt_early_pixels, 0);
     atomic_store(&g_adapt_max_pixels, 0);
 
-    YSU_Rng rng;
-    rng.state = ((uint32_t)time(NULL) ^ 0xA511E9B3u);
-    if (rng.state == 0) rng.state = 1;
+    uint64_t rays = 0;
+    double t_start = ysu_now_ms();
 
-    float inv_wm1 = (image_width  > 1) ? (1.0f / (float)(image_width - 1)) : 0.0f;
-    float inv_hm1 = (image_height > 1) ? (1.0f / (float)(image_height - 1)) : 0.0f;
+    PixelJob pj;
+    pixel_job_init(&pj, &cam, NULL, image_width, image_height, samples_per_pixel, max_depth);
 
     for (int j = 0; j < image_height; ++j) {
         Vec3* row = pixels + (image_height - 1 - j) * image_width;
 
         for (int i = 0; i < image_width; ++i) {
-            float accx = 0.0f, accy = 0.0f, accz = 0.0f;
-
-            int spp_used = 0;
-            int early_stop = 0;
-
-            // Welford for luminance
-            float mean = 0.0f, m2 = 0.0f;
-
-            int spp_max = samples_per_pixel;
-            int spp_min = (g_adapt_spp_min < spp_max) ? g_adapt_spp_min : spp_max;
-
-            for (int s = 0; s < spp_max; ++s) {
-                float u = ((float)i + ysu_rng_f01(&rng)) * inv_wm1;
-                float v = ((float)j + ysu_rng_f01(&rng)) * inv_hm1;
-
-                Ray rr = camera_get_ray(cam, u, v);
-                Vec3 c = ray_color_internal(rr, max_depth);
-
-                accx += c.x; accy += c.y; accz += c.z;
-                spp_used++;
-
-                if (g_adapt_enabled) {
-                    float lum = ysu_luminance(c);
-                    float n = (float)spp_used;
-                    float delta = lum - mean;
-                    mean += delta / n;
-                    float delta2 = lum - mean;
-                    m2 += delta * delta2;
-
-                    if (spp_used >= spp_min && (spp_used % g_adapt_spp_batch) == 0) {
-                        float var = (spp_used > 1) ? (m2 / (float)(spp_used - 1)) : 0.0f;
-                        float se  = sqrtf(fmaxf(var, 0.0f) / (float)spp_used);
-
-                        float tol = fmaxf(g_adapt_abs_err, g_adapt_rel_err * fabsf(mean));
-                        if (se <= tol) { early_stop = 1; break; }
-                    }
-                }
-            }
-
-            float inv_spp = 1.0f / (float)spp_used;
-            row[i] = vec3(accx * inv_spp, accy * inv_spp, accz * inv_spp);
+            int spp_used, early_stop;
+            row[i] = render_pixel(&pj, i, j, &rays, &spp_used, &early_stop);
 
             if (g_adapt_enabled) {
                 atomic_fetch_add(&g_adapt_total_samples, (uint64_t)spp_used);
@@ -445,6 +1235,8 @@ void render_scene_st(Vec3 *pixels,
         }
     }
 
+    ysu_print_trace_stats(rays, ysu_now_ms() - t_start);
+
     if (g_adapt_enabled) {
         uint64_t total_samples = atomic_load(&g_adapt_total_samples);
         uint64_t early_pixels  = atomic_load(&g_adapt_early_pixels);
@@ -460,14 +1252,148 @@ void render_scene_st(Vec3 *pixels,
 // =====================================================================
 // THREAD POOL (persistent)
 // =====================================================================
+//
+// Two tile schedulers share the same pool (env: YSU_SCHED=chunk|steal):
+//  - chunk: one shared atomic job counter handing out JOB_CHUNK tiles at a
+//           time; frame start/end go through the pool mutex + condvars.
+//  - steal: every worker owns a Chase-Lev deque seeded with a contiguous
+//           range of tiles. Idle workers steal from random victims and split
+//           the stolen rect in half, so the expensive tail of an adaptive
+//           frame gets spread across the whole pool. Frame start/end use an
+//           atomic epoch / done counter and only fall back to the condvars
+//           once a thread has spun for YSU_POOL_SPIN_US without work.
+// Both report per-thread busy/idle time (YSU_SCHED_STATS=1).
 
 // Atomic job counter + "job chunk" to reduce contention
 #define JOB_CHUNK 8
 
+// Stolen rects are split while their longer side is >= 2*STEAL_SPLIT_MIN px
+#define STEAL_SPLIT_MIN 8
+
+static inline void ysu_cpu_relax(void) {
+#if defined(_WIN32)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void ysu_thread_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+// ------------------------- Chase-Lev tile deque -------------------------
+// Items are pixel rects packed as 4x16 bits (x0,y0,x1,y1). Only the owner
+// pushes/pops at the bottom; thieves take from the top. The ring never grows:
+// the main thread sizes it before each frame, and a failed push just means
+// the caller renders the rect itself.
+typedef struct {
+#if __STDC_VERSION__ >= 201112L
+    _Alignas(64)
+#endif
+    _Atomic int64_t top;
+#if __STDC_VERSION__ >= 201112L
+    _Alignas(64)
+#endif
+    _Atomic int64_t bottom;
+    _Atomic uint64_t *buf;
+    int64_t cap;   // power of two
+} TileDeque;
+
+static inline uint64_t rect_pack(int x0, int y0, int x1, int y1) {
+    return  (uint64_t)(uint16_t)x0
+         | ((uint64_t)(uint16_t)y0 << 16)
+         | ((uint64_t)(uint16_t)x1 << 32)
+         | ((uint64_t)(uint16_t)y1 << 48);
+}
+
+static inline void rect_unpack(uint64_t r, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = (int)( r        & 0xFFFFu);
+    *y0 = (int)((r >> 16) & 0xFFFFu);
+    *x1 = (int)((r >> 32) & 0xFFFFu);
+    *y1 = (int)((r >> 48) & 0xFFFFu);
+}
+
+// Split along the longer side; returns 0 if the rect is too small to bother.
+static int rect_split(uint64_t r, uint64_t *keep, uint64_t *give) {
+    int x0, y0, x1, y1;
+    rect_unpack(r, &x0, &y0, &x1, &y1);
+    int w = x1 - x0, h = y1 - y0;
+    if (w >= h && w >= 2 * STEAL_SPLIT_MIN) {
+        int xm = x0 + w / 2;
+        *keep = rect_pack(x0, y0, xm, y1);
+        *give = rect_pack(xm, y0, x1, y1);
+        return 1;
+    }
+    if (h >= 2 * STEAL_SPLIT_MIN) {
+        int ym = y0 + h / 2;
+        *keep = rect_pack(x0, y0, x1, ym);
+        *give = rect_pack(x0, ym, x1, y1);
+        return 1;
+    }
+    return 0;
+}
+
+static int deque_push(TileDeque *d, uint64_t item) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t >= d->cap) return 0;
+    atomic_store_explicit(&d->buf[b & (d->cap - 1)], item, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 1;
+}
+
+static int deque_pop(TileDeque *d, uint64_t *out) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return 0;
+    }
+    *out = atomic_load_explicit(&d->buf[b & (d->cap - 1)], memory_order_relaxed);
+    if (t == b) {
+        // last item: race against thieves
+        int won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                          memory_order_seq_cst,
+                                                          memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+    return 1;
+}
+
+// 1 = got an item, 0 = empty, -1 = lost a race (caller may retry)
+static int deque_steal(TileDeque *d, uint64_t *out) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return 0;
+
+    uint64_t item = atomic_load_explicit(&d->buf[t & (d->cap - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return -1;
+    }
+    *out = item;
+    return 1;
+}
+
 typedef struct {
     // render target
     Vec3 *pixels;
     Camera cam;
+    const RenderLens *lens;    // NULL = perspective through cam
     int width, height;
     int spp, depth;
     int tile_size;
@@ -476,101 +1402,534 @@ typedef struct {
     int tiles_y;
     atomic_int next_job;
 
-    uint32_t seed_base;
+    // progressive frames: accumulate into acc (NULL = plain frame) and stop
+    // picking up new rects once deadline_ms (ysu_now_ms clock, 0 = none) passes
+    YSU_Accum *acc;
+    double deadline_ms;
+
+    // budgeted frames: workers pull the highest-error tile from a shared heap
+    struct TileHeap *budget;
 
-    // sync
+    // G-buffer frames: primary hits at pixel centres into gbuf, no shading
+    const YSU_GBuffer *gbuf;
+
+    // first-touch frames: workers only zero their band of pixels (see
+    // render_alloc_framebuffer), nothing is rendered
+    int touch;
+
+    // scheduler for the current frame + steal-mode state
+    YSU_SchedMode mode;
+    TileDeque *deques;
+    _Atomic int64_t pending;   // rects queued or in flight (steal mode)
+
+    // sync: epoch/done are the lock-free path, mutex+condvars the fallback
     pthread_mutex_t mtx;
     pthread_cond_t  cv_start;
     pthread_cond_t  cv_done;
 
-    int work_id;
+    _Atomic unsigned epoch;
+    _Atomic int sleepers;      // workers blocked on cv_start
+    _Atomic int done_workers;
+    _Atomic int main_waiting;  // main blocked on cv_done
+    _Atomic int shutdown;
+
     int active_workers;
-    int done_workers;
-    int shutdown;
+    int spin_us;
+    double frame_ms;
 
     int pool_threads;
+    int pinned;                // YSU_PIN: workers bound to CPUs at creation
     pthread_t *threads;
     struct WorkerLocal *locals;
 } RenderPool;
 
 static RenderPool g_pool = {0};
 
+// Per-worker state. Kept 64-byte aligned (the struct pads itself to a whole
+// number of cache lines) so counters written every tile never false-share.
 typedef struct WorkerLocal {
 #if __STDC_VERSION__ >= 201112L
     _Alignas(64)
 #endif
     int tid;
-    uint32_t rng_state;
-    uint8_t _pad[56];
+    YSU_Rng  steal_rng;   // victim selection
+
+    // placement (YSU_PIN): cpu = -1 when unpinned. Workers on one NUMA node
+    // have consecutive tids [node_lo, node_hi); thieves try those first.
+    int cpu, node;
+    int node_lo, node_hi;
+
+    // per-frame scheduler stats
+    double   busy_ms;
+    double   idle_ms;
+    uint64_t rects;
+    uint64_t steals;
+    uint64_t splits;
+    uint64_t rays;
+
+    // wavefront traversal stage (YSU_PERF)
+    double   trace_ms;
+    uint64_t trace_rays;
+    uint64_t l1d_misses;
+    uint64_t llc_misses;
+    YSU_Perf perf;         // opened by the worker itself on first use
+    int      perf_tried;
+
+    struct WavefrontScratch *wf;   // lazily allocated by the worker
 } WorkerLocal;
 
-static void render_tile_chunk(RenderPool *p, WorkerLocal *wl, int job) {
-    int tid = wl->tid;
-    int tx = job % p->tiles_x;
-    int ty = job / p->tiles_x;
-
-    int x0 = tx * p->tile_size;
-    int y0 = ty * p->tile_size;
-    int x1 = x0 + p->tile_size;
-    int y1 = y0 + p->tile_size;
-    if (x1 > p->width)  x1 = p->width;
-    if (y1 > p->height) y1 = p->height;
-
-    float inv_wm1 = (p->width  > 1) ? (1.0f / (float)(p->width - 1)) : 0.0f;
-    float inv_hm1 = (p->height > 1) ? (1.0f / (float)(p->height - 1)) : 0.0f;
+static int         g_sched_forced = -1;   // set by render_set_scheduler()
+static int         g_sched_stats  = 0;
 
-    int spp_max = p->spp;
-    int spp_min = (g_adapt_spp_min < spp_max) ? g_adapt_spp_min : spp_max;
-
-    uint32_t tile_base = ysu_hash_u32(wl->rng_state
-                                   ^ p->seed_base
-                                   ^ (uint32_t)(job * 0xA511E9B3u));
-    if (tile_base == 0u) tile_base = 1u;
+void render_set_scheduler(YSU_SchedMode mode) {
+    g_sched_forced = (int)mode;
+}
 
-    YSU_Rng rng = {0};
+static YSU_SchedMode ysu_sched_load_config(void) {
+    g_sched_stats = ysu_env_int("YSU_SCHED_STATS", 0) ? 1 : 0;
+    if (g_sched_forced >= 0) return (YSU_SchedMode)g_sched_forced;
 
-    for (int j = y0; j < y1; ++j) {
-        Vec3* row = p->pixels + (p->height - 1 - j) * p->width;
+    const char *s = getenv("YSU_SCHED");
+    if (s && !strcmp(s, "steal")) return YSU_SCHED_STEAL;
+    if (s && s[0]) return YSU_SCHED_CHUNK;
 
-        for (int i = x0; i < x1; ++i) {
-            rng.state = ysu_seed_pixel(tile_base, (uint32_t)i, (uint32_t)j, (uint32_t)tid);
+    // Pinned on a multi-node box: the per-worker bands of the steal deques
+    // match the first-touch bands, so default to the NUMA-local policy.
+    if (ysu_env_int("YSU_PIN", 0) && ysu_mt_topology()->nodes > 1) return YSU_SCHED_STEAL;
+    return YSU_SCHED_CHUNK;
+}
 
-            float accx = 0.0f, accy = 0.0f, accz = 0.0f;
-            int spp_used = 0;
-            int early_stop = 0;
+static void *pool_aligned_alloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, 64);
+#else
+    void *p = NULL;
+    if (posix_memalign(&p, 64, size) != 0) return NULL;
+    return p;
+#endif
+}
 
-            float mean = 0.0f, m2 = 0.0f;
+static void pool_aligned_free(void *p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
 
-            for (int s = 0; s < spp_max; ++s) {
-                float u = ((float)i + ysu_rng_f01(&rng)) * inv_wm1;
-                float v = ((float)j + ysu_rng_f01(&rng)) * inv_hm1;
+// ------------------------- Wavefront tile integrator -------------------------
+// Paths for a whole rect (all pixels x a slice of the spp) go through the
+// experimental YSU_PathQueue pipeline one bounce at a time: batch intersect,
+// bin hits by MaterialType, scatter with material_scatter_rng, and compact the
+// survivors into the next queue.
+
+#define WAVEFRONT_BINS (MAT_EMISSIVE + 2)   // material types + miss
+
+typedef struct WavefrontScratch {
+    YSU_WavefrontState st;
+    uint32_t path_cap;
+    uint32_t *order;       // path indices binned by material type
+    float *soa;            // 8 * path_cap: ox oy oz dx dy dz t_best prim
+    uint64_t *sort_keys;   // 2 * path_cap: ray_sort_key << 32 | path, radix scratch
+    Vec3 *radiance;        // per (rect pixel, sample of the wave)
+    uint32_t rad_cap;
+} WavefrontScratch;
+
+// YSU_Path.pixel is the radiance slot (local pixel * spw + sample - s0) and
+// YSU_Path.rng the sample index; together with the rect origin they rebuild
+// the same sampler stream the recursive integrator uses for that sample.
+typedef struct {
+    WavefrontScratch *wf;
+    WorkerLocal *wl;
+    uint64_t rays;
+    int x0, y0, rw, width;
+    uint32_t spw;          // samples per wave
+    uint32_t seed;
+} WavefrontCtx;
+
+static void wavefront_scratch_free(WavefrontScratch *wf) {
+    if (!wf) return;
+    ysu_wavefront_free(&wf->st);
+    free(wf->order);
+    free(wf->soa);
+    free(wf->sort_keys);
+    free(wf->radiance);
+    free(wf);
+}
 
-                Ray rr = camera_get_ray(p->cam, u, v);
-                Vec3 c = ray_color_internal(rr, p->depth);
+static int wavefront_scratch_reserve(WorkerLocal *wl, uint32_t paths, uint32_t pixels) {
+    WavefrontScratch *wf = wl->wf;
+    if (!wf) {
+        wf = (WavefrontScratch*)calloc(1, sizeof(WavefrontScratch));
+        if (!wf) return 0;
+        wl->wf = wf;
+    }
+    if (wf->path_cap < paths) {
+        ysu_wavefront_free(&wf->st);
+        free(wf->order);
+        free(wf->soa);
+        free(wf->sort_keys);
+        wf->order = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)paths);
+        wf->soa = (float*)malloc(sizeof(float) * 8 * (size_t)paths);
+        wf->sort_keys = (uint64_t*)malloc(sizeof(uint64_t) * 2 * (size_t)paths);
+        if (!ysu_wavefront_init(&wf->st, paths) || !wf->order || !wf->soa || !wf->sort_keys ||
+            !wf->st.q_active.items || !wf->st.q_next.items) {
+            wf->path_cap = 0;
+            return 0;
+        }
+        wf->path_cap = paths;
+    }
+    if (wf->rad_cap < pixels) {
+        free(wf->radiance);
+        wf->radiance = (Vec3*)malloc(sizeof(Vec3) * (size_t)pixels);
+        if (!wf->radiance) { wf->rad_cap = 0; return 0; }
+        wf->rad_cap = pixels;
+    }
+    return 1;
+}
 
-                accx += c.x; accy += c.y; accz += c.z;
-                spp_used++;
-
-                if (g_adapt_enabled) {
-                    float lum = ysu_luminance(c);
-                    float n = (float)spp_used;
-                    float delta = lum - mean;
-                    mean += delta / n;
-                    float delta2 = lum - mean;
-                    m2 += delta * delta2;
-
-                    if (spp_used >= spp_min && (spp_used % g_adapt_spp_batch) == 0) {
-                        float var = (spp_used > 1) ? (m2 / (float)(spp_used - 1)) : 0.0f;
-                        float se  = sqrtf(fmaxf(var, 0.0f) / (float)spp_used);
-
-                        float tol = fmaxf(g_adapt_abs_err, g_adapt_rel_err * fabsf(mean));
-                        if (se <= tol) { early_stop = 1; break; }
-                    }
+// Loaded scene or mesh: per-path scene_hit, in ray_sort_key() order for bounces when YSU_RAY_SORT is on.
+static void wavefront_intersect_scene(WavefrontCtx *ctx, const YSU_Path *paths, uint32_t n, YSU_SurfHit *out) {
+    uint64_t *keys = ctx->wf->sort_keys;
+    int sorted = g_ray_sort && n > 64 && paths[0].depth > 0 && (g_scene.bvh.count > 0 || g_mesh.active);
+    if (sorted) {
+        float bmin[3], bmax[3];
+        for (int a = 0; a < 3; ++a) {
+            bmin[a] = g_mesh.active ? g_mesh.bmin[a] : FLT_MAX;
+            bmax[a] = g_mesh.active ? g_mesh.bmax[a] : -FLT_MAX;
+            if (g_scene.bvh.count > 0) {
+                bmin[a] = fminf(bmin[a], g_scene.bvh.nodes[0].bmin[a]);
+                bmax[a] = fmaxf(bmax[a], g_scene.bvh.nodes[0].bmax[a]);
+            }
+        }
+        RaySortFrame fr;
+        ray_sort_frame(&fr, bmin, bmax);
+        for (uint32_t i = 0; i < n; ++i) keys[i] = ((uint64_t)ray_sort_key(&fr, &paths[i].ray) << 32) | i;
+        ray_sort_keys(keys, keys + ctx->wf->path_cap, n);
+    }
+
+    for (uint32_t k = 0; k < n; ++k) {
+        uint32_t i = sorted ? (uint32_t)keys[k] : k;
+        Hit hh = {0};
+        YSU_SurfHit *h = &out[i];
+        h->hit = scene_hit(paths[i].ray, 0.001f, 1e30f, &hh);
+        if (!h->hit) continue;
+        h->t = hh.t;
+        h->p = hh.p;
+        h->n = hh.n;
+        h->material_id = hh.mat;
+        h->prim_id = hh.prim;
+    }
+}
+
+static void wavefront_intersect(const YSU_Path *paths, uint32_t n, YSU_SurfHit *out, void *user) {
+    WavefrontCtx *ctx = (WavefrontCtx*)user;
+
+    if (g_scene.count > 0 || g_mesh.active) {
+        WorkerLocal *wl = ctx->wl;
+        if (!g_perf) {
+            wavefront_intersect_scene(ctx, paths, n, out);
+        } else {
+            if (!wl->perf_tried) {
+                wl->perf_tried = 1;
+                ysu_perf_open(&wl->perf);
+            }
+            uint64_t c0[YSU_PERF_COUNT], c1[YSU_PERF_COUNT];
+            ysu_perf_read(&wl->perf, c0);
+            double t0 = ysu_now_ms();
+            wavefront_intersect_scene(ctx, paths, n, out);
+            wl->trace_ms += ysu_now_ms() - t0;
+            ysu_perf_read(&wl->perf, c1);
+            wl->trace_rays += n;
+            wl->l1d_misses += c1[YSU_PERF_L1D_MISS] - c0[YSU_PERF_L1D_MISS];
+            wl->llc_misses += c1[YSU_PERF_LLC_MISS] - c0[YSU_PERF_LLC_MISS];
+        }
+        ctx->rays += n;
+        return;
+    }
+
+    // Batch intersect: rays go to SoA once, then each primitive is tested
+    // against the whole batch (primitive-outer, branch-light inner loops), and
+    // the surface record is only built for the winner.
+    size_t cap = ctx->wf->path_cap;
+    float *ox = ctx->wf->soa,   *oy = ox + cap,  *oz = oy + cap;
+    float *dx = oz + cap,       *dy = dx + cap,  *dz = dy + cap;
+    float *tb = dz + cap,       *pr = tb + cap;  // prim id stored as float
+
+    const float tmin = 0.001f;
+    for (uint32_t i = 0; i < n; ++i) {
+        const Ray *r = &paths[i].ray;
+        ox[i] = r->origin.x;    oy[i] = r->origin.y;    oz[i] = r->origin.z;
+        dx[i] = r->direction.x; dy[i] = r->direction.y; dz[i] = r->direction.z;
+        tb[i] = 1e30f;
+        pr[i] = -1.0f;
+    }
+
+    const uint32_t n8 = n & ~7u;
+    for (int k = 0; k < BUILTIN_SPHERE_COUNT; ++k) {
+        const float cx = g_builtin_spheres[k].center.x;
+        const float cy = g_builtin_spheres[k].center.y;
+        const float cz = g_builtin_spheres[k].center.z;
+        const float rr = g_builtin_spheres[k].radius * g_builtin_spheres[k].radius;
+        const float id = (float)k;
+
+        // 8 rays at a time; same per-lane ops as the scalar tail below
+        const Vec3x8 c8 = vec3x8_splat(vec3(cx, cy, cz));
+        const ysu_f8 rr8 = ysu_f8_set1(rr), id8 = ysu_f8_set1(id);
+        const ysu_f8 tmin8 = ysu_f8_set1(tmin), zero8 = ysu_f8_set1(0.0f);
+        const ysu_f8 one8 = ysu_f8_set1(1.0f);
+        for (uint32_t i = 0; i < n8; i += 8) {
+            Vec3x8 o = vec3x8_load(ox + i, oy + i, oz + i);
+            Vec3x8 d = vec3x8_load(dx + i, dy + i, dz + i);
+            Vec3x8 oc = vec3x8_sub(o, c8);
+            ysu_f8 a = vec3x8_dot(d, d);
+            ysu_f8 b = vec3x8_dot(oc, d);
+            ysu_f8 c = ysu_f8_sub(vec3x8_dot(oc, oc), rr8);
+            ysu_f8 disc = ysu_f8_sub(ysu_f8_mul(b, b), ysu_f8_mul(a, c));
+            ysu_f8 hit = ysu_f8_ge(disc, zero8);
+            if (!ysu_f8_mask(hit)) continue;
+
+            ysu_f8 sq = ysu_f8_sqrt(ysu_f8_max(disc, zero8));
+            ysu_f8 inv_a = ysu_f8_div(one8, a);
+            ysu_f8 nb = ysu_f8_sub(zero8, b);
+            ysu_f8 t_near = ysu_f8_mul(ysu_f8_sub(nb, sq), inv_a);
+            ysu_f8 t_far  = ysu_f8_mul(ysu_f8_add(nb, sq), inv_a);
+            ysu_f8 t = ysu_f8_select(ysu_f8_lt(t_near, tmin8), t_far, t_near);
+
+            ysu_f8 best = ysu_f8_load(tb + i);
+            hit = ysu_f8_and(hit, ysu_f8_and(ysu_f8_ge(t, tmin8), ysu_f8_lt(t, best)));
+            ysu_f8_store(tb + i, ysu_f8_select(hit, t, best));
+            ysu_f8_store(pr + i, ysu_f8_select(hit, id8, ysu_f8_load(pr + i)));
+        }
+        for (uint32_t i = n8; i < n; ++i) {
+            float ocx = ox[i] - cx, ocy = oy[i] - cy, ocz = oz[i] - cz;
+            float a = dx[i]*dx[i] + dy[i]*dy[i] + dz[i]*dz[i];
+            float b = ocx*dx[i] + ocy*dy[i] + ocz*dz[i];
+            float c = ocx*ocx + ocy*ocy + ocz*ocz - rr;
+            float disc = b*b - a*c;
+            if (disc < 0.0f) continue;
+            float sq = sqrtf(disc);
+            float inv_a = 1.0f / a;
+            float t = (-b - sq) * inv_a;
+            if (t < tmin) t = (-b + sq) * inv_a;
+            if (t >= tmin && t < tb[i]) { tb[i] = t; pr[i] = id; }
+        }
+    }
+
+    // ground plane y = -0.5
+    const float gid = (float)BUILTIN_SPHERE_COUNT;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (fabsf(dy[i]) < 1e-6f) continue;
+        float t = (-0.5f - oy[i]) / dy[i];
+        if (t >= tmin && t < tb[i]) { tb[i] = t; pr[i] = gid; }
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        YSU_SurfHit *h = &out[i];
+        int prim = (int)pr[i];
+        h->hit = (prim >= 0);
+        if (!h->hit) continue;
+
+        float t = tb[i];
+        h->t = t;
+        h->p = vec3(ox[i] + t*dx[i], oy[i] + t*dy[i], oz[i] + t*dz[i]);
+        h->prim_id = -1;
+        if (prim < BUILTIN_SPHERE_COUNT) {
+            const BuiltinSphere *sp = &g_builtin_spheres[prim];
+            float inv_r = 1.0f / sp->radius;
+            h->n = vec3((h->p.x - sp->center.x) * inv_r,
+                        (h->p.y - sp->center.y) * inv_r,
+                        (h->p.z - sp->center.z) * inv_r);
+            h->material_id = sp->mat;
+        } else {
+            h->n = vec3(0.0f, 1.0f, 0.0f);
+            int check = ((int)floorf(h->p.x) + (int)floorf(h->p.z)) & 1;
+            h->material_id = check ? SCENE_MAT_GROUND_LIGHT : SCENE_MAT_GROUND_DARK;
+        }
+    }
+    ctx->rays += n;
+}
+
+static void wavefront_shade(const YSU_Path *paths, const YSU_SurfHit *hits, uint32_t n,
+                            YSU_PathQueue *q_next, void *user)
+{
+    WavefrontCtx *ctx = (WavefrontCtx*)user;
+    uint32_t *order = ctx->wf->order;
+    Vec3 *rad = ctx->wf->radiance;
+
+    // counting sort by material type; misses go to the last bin
+    uint32_t start[WAVEFRONT_BINS + 1] = {0};
+    for (uint32_t i = 0; i < n; ++i) {
+        int b = hits[i].hit ? (int)g_mats[hits[i].material_id].type : WAVEFRONT_BINS - 1;
+        start[b + 1]++;
+    }
+    for (int b = 0; b < WAVEFRONT_BINS; ++b) start[b + 1] += start[b];
+    uint32_t fill[WAVEFRONT_BINS];
+    memcpy(fill, start, sizeof(fill));
+    for (uint32_t i = 0; i < n; ++i) {
+        int b = hits[i].hit ? (int)g_mats[hits[i].material_id].type : WAVEFRONT_BINS - 1;
+        order[fill[b]++] = i;
+    }
+
+    // misses: sky
+    for (uint32_t k = start[WAVEFRONT_BINS - 1]; k < n; ++k) {
+        const YSU_Path *pa = &paths[order[k]];
+        Vec3 sky = ysu_sky(pa->ray);
+        Vec3 *dst = &rad[pa->pixel];
+        *dst = vec3_add(*dst, vec3_mul(pa->throughput, sky));
+    }
+
+    // hits, one material type at a time
+    for (uint32_t k = 0; k < start[WAVEFRONT_BINS - 1]; ++k) {
+        uint32_t i = order[k];
+        const YSU_Path *pa = &paths[i];
+        const YSU_SurfHit *h = &hits[i];
+        Material mt = g_mats[h->material_id];
+        if (h->prim_id >= 0) {
+            const Sphere *sp = &g_scene.spheres[h->prim_id];
+            Vec3 tint = vec3(sp->albedo.r, sp->albedo.g, sp->albedo.b);
+            mt.albedo = vec3_mul(mt.albedo, tint);
+            mt.emission = vec3_mul(mt.emission, tint);
+        }
+        const Material *m = &mt;
+
+        if (m->type == MAT_EMISSIVE) {
+            Vec3 *dst = &rad[pa->pixel];
+            *dst = vec3_add(*dst, vec3_mul(pa->throughput, m->emission));
+            continue;
+        }
+
+        uint32_t local = pa->pixel / ctx->spw;
+        uint32_t px = (uint32_t)(ctx->x0 + (int)(local % (uint32_t)ctx->rw));
+        uint32_t py = (uint32_t)(ctx->y0 + (int)(local / (uint32_t)ctx->rw));
+        YSU_Sampler smp;
+        ysu_sampler_init(&smp, ctx->seed, py * (uint32_t)ctx->width + px, pa->rng, pa->depth + 1u);
+
+        YSU_Path next = *pa;
+        Vec3 atten;
+        if (!material_scatter_rng(m, pa->ray, h->p, h->n, &smp, &next.ray, &atten)) continue;
+        next.throughput = vec3_mul(pa->throughput, atten);
+        next.depth = pa->depth + 1;
+        (void)ysu_queue_push(q_next, &next);
+    }
+}
+
+static int render_rect_wavefront(RenderPool *p, WorkerLocal *wl,
+                                 int x0, int y0, int x1, int y1)
+{
+    int rw = x1 - x0, rh = y1 - y0;
+    uint32_t npx = (uint32_t)(rw * rh);
+    if (npx == 0) return 1;
+
+    int wave_cap = ysu_env_int("YSU_WAVE_PATHS", 16384);
+    if (wave_cap < (int)npx) wave_cap = (int)npx;
+    int spp_per_wave = wave_cap / (int)npx;
+    if (spp_per_wave > p->spp) spp_per_wave = p->spp;
+    if (spp_per_wave < 1) spp_per_wave = 1;
+
+    uint32_t nslots = npx * (uint32_t)spp_per_wave;
+    if (!wavefront_scratch_reserve(wl, nslots, nslots)) return 0;
+    WavefrontScratch *wf = wl->wf;
+
+    PixelJob pj;
+    pixel_job_init(&pj, &p->cam, p->lens, p->width, p->height, p->spp, p->depth);
+
+    YSU_WavefrontSettings ws;
+    ws.width = (uint32_t)rw;
+    ws.height = (uint32_t)rh;
+    ws.spp = (uint32_t)p->spp;
+    ws.max_depth = (uint32_t)p->depth;
+    ws.base_seed = pj.seed;
+
+    WavefrontCtx ctx;
+    ctx.wf = wf;
+    ctx.wl = wl;
+    ctx.rays = 0;
+    ctx.x0 = x0;
+    ctx.y0 = y0;
+    ctx.rw = rw;
+    ctx.width = p->width;
+    ctx.spw = (uint32_t)spp_per_wave;
+    ctx.seed = pj.seed;
+
+    for (int j = y0; j < y1; ++j) {
+        Vec3 *row = p->pixels + (p->height - 1 - j) * p->width;
+        for (int i = x0; i < x1; ++i) row[i] = vec3(0.0f, 0.0f, 0.0f);
+    }
+
+    for (int s0 = 0; s0 < p->spp; s0 += spp_per_wave) {
+        int s1 = s0 + spp_per_wave;
+        if (s1 > p->spp) s1 = p->spp;
+
+        // generate primary paths
+        ysu_queue_clear(&wf->st.q_active);
+        for (int j = y0; j < y1; ++j) {
+            for (int i = x0; i < x1; ++i) {
+                uint32_t local = (uint32_t)((j - y0) * rw + (i - x0));
+                uint32_t pixel = (uint32_t)j * (uint32_t)p->width + (uint32_t)i;
+                for (int s = s0; s < s1; ++s) {
+                    YSU_Sampler smp;
+                    ysu_sampler_init(&smp, pj.seed, pixel, (uint32_t)s, 0);
+                    float jx = ysu_sampler_next(&smp);
+                    float jy = ysu_sampler_next(&smp);
+
+                    uint32_t slot = local * (uint32_t)spp_per_wave + (uint32_t)(s - s0);
+                    wf->radiance[slot] = vec3(0.0f, 0.0f, 0.0f);
+
+                    YSU_Path pa;
+                    pa.ray = lens_ray(pj.lens, pj.cam, i, j, jx, jy, pj.inv_wm1, pj.inv_hm1);
+                    pa.throughput = vec3(1.0f, 1.0f, 1.0f);
+                    pa.pixel = slot;
+                    pa.depth = 0;
+                    pa.rng = (uint32_t)s;
+                    (void)ysu_queue_push(&wf->st.q_active, &pa);
                 }
             }
+        }
+
+        ysu_wavefront_render(&ws, &wf->st, wavefront_intersect, wavefront_shade, &ctx);
+
+        // fold samples into pixels in sample order, so wave size and rect
+        // splits never change the summation order
+        for (int j = y0; j < y1; ++j) {
+            Vec3 *row = p->pixels + (p->height - 1 - j) * p->width;
+            for (int i = x0; i < x1; ++i) {
+                const Vec3 *slot = &wf->radiance[(uint32_t)((j - y0) * rw + (i - x0)) * (uint32_t)spp_per_wave];
+                for (int s = 0; s < s1 - s0; ++s) row[i] = vec3_add(row[i], slot[s]);
+            }
+        }
+    }
+
+    float inv_spp = 1.0f / (float)p->spp;
+    for (int j = y0; j < y1; ++j) {
+        Vec3 *row = p->pixels + (p->height - 1 - j) * p->width;
+        for (int i = x0; i < x1; ++i) row[i] = vec3_scale(row[i], inv_spp);
+    }
 
-            float inv_spp = 1.0f / (float)spp_used;
-            row[i] = vec3(accx * inv_spp, accy * inv_spp, accz * inv_spp);
+    if (g_adapt_enabled) atomic_fetch_add(&g_adapt_total_samples, (uint64_t)npx * (uint64_t)p->spp);
+    wl->rays += ctx.rays;
+    return 1;
+}
+
+static void render_rect(RenderPool *p, WorkerLocal *wl,
+                        int x0, int y0, int x1, int y1)
+{
+    // The wavefront path renders fixed spp; adaptive frames and debug views
+    // use the per-pixel loop below (recursive path estimator).
+    if (g_integrator == YSU_INTEGRATOR_WAVEFRONT && !g_adapt_enabled && g_debug == DEBUG_NONE &&
+        render_rect_wavefront(p, wl, x0, y0, x1, y1)) {
+        return;
+    }
+
+    PixelJob pj;
+    pixel_job_init(&pj, &p->cam, p->lens, p->width, p->height, p->spp, p->depth);
+
+    for (int j = y0; j < y1; ++j) {
+        Vec3* row = p->pixels + (p->height - 1 - j) * p->width;
+
+        for (int i = x0; i < x1; ++i) {
+            int spp_used, early_stop;
+            row[i] = render_pixel(&pj, i, j, &wl->rays, &spp_used, &early_stop);
 
             if (g_adapt_enabled) {
                 atomic_fetch_add(&g_adapt_total_samples, (uint64_t)spp_used);
@@ -579,55 +1938,525 @@ static void render_tile_chunk(RenderPool *p, WorkerLocal *wl, int job) {
             }
         }
     }
+}
+
+// Progressive variant: continues each pixel from its stored sum/count/Welford
+// state. Sample n of a pixel is keyed on (acc seed, pixel, n), so a
+// render resumed from a checkpoint draws the same samples as one that never
+// stopped.
+static void render_rect_accum(RenderPool *p, WorkerLocal *wl,
+                              int x0, int y0, int x1, int y1)
+{
+    YSU_Accum *acc = p->acc;
+
+    float inv_wm1 = (p->width  > 1) ? (1.0f / (float)(p->width - 1)) : 0.0f;
+    float inv_hm1 = (p->height > 1) ? (1.0f / (float)(p->height - 1)) : 0.0f;
 
-    wl->rng_state = ysu_hash_u32(wl->rng_state ^ rng.state ^ (uint32_t)job);
+    uint32_t spp_cap = acc->spp_max ? acc->spp_max : UINT32_MAX;
+    uint32_t spp_min = (uint32_t)g_adapt_spp_min;
+    if (spp_min > spp_cap) spp_min = spp_cap;
+
+    uint64_t added = 0;
+
+    for (int j = y0; j < y1; ++j) {
+        size_t row = (size_t)(p->height - 1 - j) * (size_t)p->width;
+
+        for (int i = x0; i < x1; ++i) {
+            size_t idx = row + (size_t)i;
+            uint32_t n = acc->spp[idx];
+            if (n >= spp_cap) continue;
+
+            float mean = acc->lum_mean[idx];
+            float m2   = acc->lum_m2[idx];
+
+            if (g_adapt_enabled && n >= spp_min && n > 1) {
+                float var = m2 / (float)(n - 1);
+                float se  = sqrtf(fmaxf(var, 0.0f) / (float)n);
+                float tol = fmaxf(g_adapt_abs_err, g_adapt_rel_err * fabsf(mean));
+                if (se <= tol) continue; // converged in an earlier pass
+            }
+
+            uint32_t pixel = (uint32_t)j * (uint32_t)p->width + (uint32_t)i;
+            YSU_Sampler smp;
+
+            float accx = 0.0f, accy = 0.0f, accz = 0.0f;
+            uint32_t n_end = n + (uint32_t)p->spp;
+            if (n_end > spp_cap || n_end < n) n_end = spp_cap;
+            int early_stop = 0;
+
+            while (n < n_end) {
+                ysu_sampler_init(&smp, acc->seed, pixel, n, 0);
+                float jx = ysu_sampler_next(&smp);
+                float jy = ysu_sampler_next(&smp);
+
+                Ray rr = lens_ray(p->lens, &p->cam, i, j, jx, jy, inv_wm1, inv_hm1);
+                Vec3 c = ysu_trace(rr, p->depth, &smp, &wl->rays);
+
+                accx += c.x; accy += c.y; accz += c.z;
+                n++;
+
+                float lum = ysu_luminance(c);
+                float delta = lum - mean;
+                mean += delta / (float)n;
+                m2 += delta * (lum - mean);
+
+                if (g_adapt_enabled && n >= spp_min && (n % (uint32_t)g_adapt_spp_batch) == 0) {
+                    float var = (n > 1) ? (m2 / (float)(n - 1)) : 0.0f;
+                    float se  = sqrtf(fmaxf(var, 0.0f) / (float)n);
+                    float tol = fmaxf(g_adapt_abs_err, g_adapt_rel_err * fabsf(mean));
+                    if (se <= tol) { early_stop = 1; break; }
+                }
+            }
+
+            added += (uint64_t)(n - acc->spp[idx]);
+            acc->sum[idx*3 + 0] += accx;
+            acc->sum[idx*3 + 1] += accy;
+            acc->sum[idx*3 + 2] += accz;
+            acc->spp[idx]      = n;
+            acc->lum_mean[idx] = mean;
+            acc->lum_m2[idx]   = m2;
+
+            if (g_adapt_enabled && early_stop) atomic_fetch_add(&g_adapt_early_pixels, 1);
+        }
+    }
+
+    if (added) atomic_fetch_add(&g_adapt_total_samples, added);
 }
 
-static void *pool_worker(void *arg) {
-    WorkerLocal *wl = (WorkerLocal*)arg;
-    int tid = wl->tid;
-    int last_work = 0;
+// One pixel of the G-buffer; misses get depth -1 and zero normal / albedo.
+static void gbuffer_store(const YSU_GBuffer *gb, size_t idx, const Hit *h) {
+    if (gb->depth)  gb->depth[idx]  = h->hit ? h->t : -1.0f;
+    if (gb->normal) gb->normal[idx] = h->hit ? h->n : vec3(0.0f, 0.0f, 0.0f);
+    if (gb->albedo) gb->albedo[idx] = h->hit ? h->albedo : vec3(0.0f, 0.0f, 0.0f);
+}
 
-    for (;;) {
-        pthread_mutex_lock(&g_pool.mtx);
-        while (!g_pool.shutdown && g_pool.work_id == last_work) {
-            pthread_cond_wait(&g_pool.cv_start, &g_pool.mtx);
+// G-buffer rect: primary rays through pixel centres in 4x2 blocks. Loaded
+// scenes trace each block as one packet against the flat BVH (bvh_packet.h
+// falls back to single rays for incoherent or partial blocks); the mesh, the
+// ground plane and the hit records are per pixel, so the result matches
+// scene_hit(), which is used instead when packets are off. With a shadow
+// plane, the hits that face the sun send one shadow ray each toward it, and
+// the block's shadow rays go through bvh_packet_occluded8() the same way.
+static void render_rect_gbuffer(RenderPool *p, WorkerLocal *wl,
+                                int x0, int y0, int x1, int y1)
+{
+    const YSU_GBuffer *gb = p->gbuf;
+    const BvhPacketConfig *pc = bvh_packet_config();
+    const int packets = g_scene.count > 0 && pc->enabled && pc->avx2;
+    const Vec3 sun = direct_light_dir();
+    float inv_wm1 = (p->width  > 1) ? (1.0f / (float)(p->width - 1)) : 0.0f;
+    float inv_hm1 = (p->height > 1) ? (1.0f / (float)(p->height - 1)) : 0.0f;
+
+    for (int j = y0; j < y1; j += 2) {
+        for (int i = x0; i < x1; i += 4) {
+            Ray rays[BVH_PACKET_W];
+            int mask = 0;
+            for (int k = 0; k < BVH_PACKET_W; ++k) {
+                int pi = i + (k & 3), pj = j + (k >> 2);
+                if (pi >= x1 || pj >= y1) { rays[k] = rays[0]; continue; }
+                rays[k] = lens_ray(p->lens, &p->cam, pi, pj, 0.5f, 0.5f, inv_wm1, inv_hm1);
+                mask |= 1 << k;
+            }
+
+            BvhPacketHit ph;
+            if (packets) {
+                bvh_packet_hit_closest8(&g_scene.bvh, g_scene.spheres, rays, mask, 0.001f, 1e30f, &ph);
+            }
+
+            Ray shadow[BVH_PACKET_W];
+            float lit[BVH_PACKET_W];
+            size_t idx[BVH_PACKET_W];
+            int smask = 0;
+            for (int k = 0; k < BVH_PACKET_W; ++k) {
+                if (!((mask >> k) & 1)) continue;
+                Hit h = {0};
+                if (packets) {
+                    Hit g;
+                    float closest = 1e30f;
+                    if (ph.prim[k] >= 0) {
+                        scene_sphere_hit(ph.prim[k], rays[k], ph.t[k], &h);
+                        closest = ph.t[k];
+                    }
+                    if (g_mesh.active && scene_mesh_hit(rays[k], 0.001f, closest, &g)) {
+                        h = g;
+                        closest = g.t;
+                    }
+                    if (g_scene.ground && hit_ground(rays[k], 0.001f, closest, &g)) h = g;
+                } else {
+                    scene_hit(rays[k], 0.001f, 1e30f, &h);
+                }
+                int pi = i + (k & 3), pj = j + (k >> 2);
+                idx[k] = (size_t)(p->height - 1 - pj) * (size_t)p->width + (size_t)pi;
+                gbuffer_store(gb, idx[k], &h);
+                wl->rays++;
+
+                lit[k] = h.hit ? 0.0f : -1.0f;
+                shadow[k] = rays[k];
+                if (h.hit && vec3_dot(h.n, sun) > 0.0f) {
+                    shadow[k] = ray_create(h.p, sun);
+                    lit[k] = 1.0f;
+                    smask |= 1 << k;
+                }
+            }
+            if (!gb->shadow) continue;
+
+            // shadow rays: spheres as one packet, then mesh / ground per lane
+            // for the lanes still lit
+            if (packets && smask) {
+                const float far[BVH_PACKET_W] = { 1e30f, 1e30f, 1e30f, 1e30f, 1e30f, 1e30f, 1e30f, 1e30f };
+                smask &= ~bvh_packet_occluded8(&g_scene.bvh, g_scene.spheres, shadow, smask, 0.001f, far);
+            }
+            for (int k = 0; k < BVH_PACKET_W; ++k) {
+                if (!((mask >> k) & 1)) continue;
+                if (lit[k] > 0.0f) {
+                    Hit g;
+                    int occ = !((smask >> k) & 1);
+                    if (!occ && packets) {
+                        occ = (g_mesh.active && scene_mesh_hit(shadow[k], 0.001f, 1e30f, &g)) ||
+                              (g_scene.ground && hit_ground(shadow[k], 0.001f, 1e30f, &g));
+                    } else if (!occ) {
+                        occ = scene_hit(shadow[k], 0.001f, 1e30f, &g);
+                    }
+                    if (occ) lit[k] = 0.0f;
+                    wl->rays++;
+                }
+                gb->shadow[idx[k]] = lit[k];
+            }
         }
-        if (g_pool.shutdown) {
-            pthread_mutex_unlock(&g_pool.mtx);
-            return NULL;
+    }
+}
+
+static void pool_render_rect(RenderPool *p, WorkerLocal *wl,
+                             int x0, int y0, int x1, int y1)
+{
+    // time-boxed pass: leave the remaining rects for the next call
+    if (p->deadline_ms > 0.0 && ysu_now_ms() >= p->deadline_ms) return;
+
+    if (p->gbuf)     render_rect_gbuffer(p, wl, x0, y0, x1, y1);
+    else if (p->acc) render_rect_accum(p, wl, x0, y0, x1, y1);
+    else             render_rect(p, wl, x0, y0, x1, y1);
+}
+
+static void tile_rect(int job, int tiles_x, int tile_size, int width, int height,
+                      int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = (job % tiles_x) * tile_size;
+    *y0 = (job / tiles_x) * tile_size;
+    *x1 = *x0 + tile_size;
+    *y1 = *y0 + tile_size;
+    if (*x1 > width)  *x1 = width;
+    if (*y1 > height) *y1 = height;
+}
+
+// Worker w's band: a contiguous run of tiles [*a, *b) in scanline order.
+// Steal-mode deques are seeded with it and first-touch frames zero it, so a
+// pinned worker starts on pixels whose pages sit on its own NUMA node.
+static void pool_band(int total, int n, int w, int *a, int *b) {
+    *a = (int)(((int64_t)total * w) / n);
+    *b = (int)(((int64_t)total * (w + 1)) / n);
+}
+
+static void pool_run_touch(RenderPool *p, WorkerLocal *wl) {
+    int a, b;
+    pool_band(p->tiles_x * p->tiles_y, p->active_workers, wl->tid, &a, &b);
+    for (int job = a; job < b; ++job) {
+        int x0, y0, x1, y1;
+        tile_rect(job, p->tiles_x, p->tile_size, p->width, p->height, &x0, &y0, &x1, &y1);
+        // Tile row y is stored at memory row height-1-y (see render_rect), so
+        // touch that row rather than row y.
+        for (int y = y0; y < y1; ++y) {
+            memset(p->pixels + (size_t)(p->height - 1 - y) * (size_t)p->width + (size_t)x0, 0,
+                   sizeof(Vec3) * (size_t)(x1 - x0));
         }
-        last_work = g_pool.work_id;
+    }
+}
 
-        int active = (tid < g_pool.active_workers);
-        pthread_mutex_unlock(&g_pool.mtx);
+static void render_tile_chunk(RenderPool *p, WorkerLocal *wl, int job) {
+    int x0, y0, x1, y1;
+    tile_rect(job, p->tiles_x, p->tile_size, p->width, p->height, &x0, &y0, &x1, &y1);
 
-        if (active) {
-            int total = g_pool.tiles_x * g_pool.tiles_y;
-            for (;;) {
-                int base = atomic_fetch_add(&g_pool.next_job, JOB_CHUNK);
-                if (base >= total) break;
-                int end = base + JOB_CHUNK;
-                if (end > total) end = total;
-                for (int job = base; job < end; ++job) {
-                    render_tile_chunk(&g_pool, wl, job);
-                }
+    double t0 = ysu_now_ms();
+    pool_render_rect(p, wl, x0, y0, x1, y1);
+    wl->busy_ms += ysu_now_ms() - t0;
+    wl->rects++;
+}
+
+static void pool_run_chunk(RenderPool *p, WorkerLocal *wl) {
+    int total = p->tiles_x * p->tiles_y;
+    for (;;) {
+        int base = atomic_fetch_add(&p->next_job, JOB_CHUNK);
+        if (base >= total) break;
+        int end = base + JOB_CHUNK;
+        if (end > total) end = total;
+        for (int job = base; job < end; ++job) {
+            render_tile_chunk(p, wl, job);
+        }
+    }
+}
+
+static void pool_render_item(RenderPool *p, WorkerLocal *wl, uint64_t item) {
+    int x0, y0, x1, y1;
+    rect_unpack(item, &x0, &y0, &x1, &y1);
+
+    double t0 = ysu_now_ms();
+    pool_render_rect(p, wl, x0, y0, x1, y1);
+    wl->busy_ms += ysu_now_ms() - t0;
+    wl->rects++;
+
+    atomic_fetch_sub_explicit(&p->pending, 1, memory_order_release);
+}
+
+static void pool_run_steal(RenderPool *p, WorkerLocal *wl) {
+    TileDeque *own = &p->deques[wl->tid];
+    int n = p->active_workers;
+    unsigned misses = 0;
+    uint64_t item;
+
+    for (;;) {
+        if (deque_pop(own, &item)) {
+            pool_render_item(p, wl, item);
+            continue;
+        }
+        if (atomic_load_explicit(&p->pending, memory_order_acquire) <= 0) break;
+
+        // same-node victims first: their bands were first-touched on our node
+        int got = 0;
+        int lo = wl->node_lo, hi = (wl->node_hi < n) ? wl->node_hi : n;
+        for (int k = 0; k < 2 * (hi - lo) && hi - lo > 1 && hi - lo < n && !got; ++k) {
+            int v = lo + (int)(ysu_rng_u32(&wl->steal_rng) % (uint32_t)(hi - lo - 1));
+            if (v >= wl->tid) v++;
+            got = (deque_steal(&p->deques[v], &item) == 1);
+        }
+        for (int k = 0; k < 2 * n && n > 1 && !got; ++k) {
+            int v = (int)(ysu_rng_u32(&wl->steal_rng) % (uint32_t)(n - 1));
+            if (v >= wl->tid) v++;
+            got = (deque_steal(&p->deques[v], &item) == 1);
+        }
+        if (!got) {
+            // everything left is already being rendered; back off gently
+            if ((++misses & 63u) == 0) ysu_thread_yield();
+            else ysu_cpu_relax();
+            continue;
+        }
+        misses = 0;
+        wl->steals++;
+
+        uint64_t keep, give;
+        if (rect_split(item, &keep, &give)) {
+            atomic_fetch_add_explicit(&p->pending, 1, memory_order_relaxed);
+            if (deque_push(own, give)) {
+                wl->splits++;
+                item = keep;
+            } else {
+                atomic_fetch_sub_explicit(&p->pending, 1, memory_order_relaxed);
             }
         }
+        pool_render_item(p, wl, item);
+    }
+}
 
-        pthread_mutex_lock(&g_pool.mtx);
-        g_pool.done_workers++;
-        if (g_pool.done_workers >= g_pool.active_workers) {
+// ------------------------- Budgeted sampling -------------------------
+// Max-heap of tiles keyed by the expected drop in summed pixel variance
+// (of the mean) if every pixel in the tile took `batch` more samples:
+//   gain = sum_i var_i * (1/n_i - 1/(n_i + batch))
+// Guarded by one mutex: a tile visit renders tile_px * batch samples, so
+// the lock is nowhere near the hot path.
+typedef struct { float key; int tile; } TileHeapItem;
+
+typedef struct TileHeap {
+    pthread_mutex_t mtx;
+    TileHeapItem *items;
+    int count;
+    int in_flight;              // tiles popped and not yet pushed back
+    int batch;                  // samples per pixel per tile visit
+    _Atomic int64_t left;       // remaining sample budget (INT64_MAX = time only)
+} TileHeap;
+
+static void heap_push_locked(TileHeap *h, float key, int tile) {
+    int i = h->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (h->items[parent].key >= key) break;
+        h->items[i] = h->items[parent];
+        i = parent;
+    }
+    h->items[i].key = key;
+    h->items[i].tile = tile;
+}
+
+static int heap_pop_locked(TileHeap *h, TileHeapItem *out) {
+    if (h->count <= 0) return 0;
+    *out = h->items[0];
+    TileHeapItem last = h->items[--h->count];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= h->count) break;
+        if (c + 1 < h->count && h->items[c + 1].key > h->items[c].key) c++;
+        if (h->items[c].key <= last.key) break;
+        h->items[i] = h->items[c];
+        i = c;
+    }
+    if (h->count > 0) h->items[i] = last;
+    return 1;
+}
+
+static float tile_error_gain(const YSU_Accum *acc, int x0, int y0, int x1, int y1, int batch) {
+    uint32_t spp_cap = acc->spp_max ? acc->spp_max : UINT32_MAX;
+
+    double gain = 0.0;
+    for (int j = y0; j < y1; ++j) {
+        size_t row = (size_t)(acc->height - 1 - j) * (size_t)acc->width;
+        for (int i = x0; i < x1; ++i) {
+            size_t idx = row + (size_t)i;
+            uint32_t n = acc->spp[idx];
+            if (n >= spp_cap) continue;
+            if (n < 2) { gain += 1.0; continue; } // no estimate yet: treat as noisy
+            double var = (double)acc->lum_m2[idx] / (double)(n - 1);
+            uint32_t b = (uint32_t)batch;
+            if (spp_cap - n < b) b = spp_cap - n;
+            gain += var * (1.0 / (double)n - 1.0 / (double)(n + b));
+        }
+    }
+    return (float)gain;
+}
+
+static void pool_run_budget(RenderPool *p, WorkerLocal *wl) {
+    TileHeap *h = p->budget;
+    unsigned misses = 0;
+
+    for (;;) {
+        if (p->deadline_ms > 0.0 && ysu_now_ms() >= p->deadline_ms) break;
+        if (atomic_load(&h->left) <= 0) break;
+
+        // An empty heap (or one whose best tile would not improve) only ends
+        // the frame once no tile is out: the ones being rendered come back
+        // with a fresh key.
+        TileHeapItem it;
+        pthread_mutex_lock(&h->mtx);
+        int got = heap_pop_locked(h, &it);
+        if (got && it.key <= 0.0f) {
+            heap_push_locked(h, it.key, it.tile);
+            got = 0;
+        }
+        int out = h->in_flight;
+        if (got) h->in_flight++;
+        pthread_mutex_unlock(&h->mtx);
+        if (!got) {
+            if (out == 0) break; // nothing left that would improve
+            if ((++misses & 63u) == 0) ysu_thread_yield();
+            else ysu_cpu_relax();
+            continue;
+        }
+        misses = 0;
+
+        int x0, y0, x1, y1;
+        tile_rect(it.tile, p->tiles_x, p->tile_size, p->width, p->height, &x0, &y0, &x1, &y1);
+
+        // claim the samples up front; the last claim may overshoot by one visit
+        int64_t cost = (int64_t)(x1 - x0) * (int64_t)(y1 - y0) * (int64_t)h->batch;
+        if (atomic_fetch_sub(&h->left, cost) <= 0) {
+            pthread_mutex_lock(&h->mtx);
+            heap_push_locked(h, it.key, it.tile);
+            h->in_flight--;
+            pthread_mutex_unlock(&h->mtx);
+            break;
+        }
+
+        double t0 = ysu_now_ms();
+        render_rect_accum(p, wl, x0, y0, x1, y1);
+        wl->busy_ms += ysu_now_ms() - t0;
+        wl->rects++;
+
+        float key = tile_error_gain(p->acc, x0, y0, x1, y1, h->batch);
+        pthread_mutex_lock(&h->mtx);
+        heap_push_locked(h, key, it.tile);
+        h->in_flight--;
+        pthread_mutex_unlock(&h->mtx);
+    }
+}
+
+// Spin on the epoch for up to spin_us, then sleep on cv_start. The sleepers
+// counter and the epoch are both seq_cst so the publisher either sees us
+// sleeping (and broadcasts) or we see the new epoch before waiting.
+static unsigned pool_wait_frame(unsigned last, int spin_us) {
+    if (spin_us > 0) {
+        double t0 = ysu_now_ms();
+        double limit = (double)spin_us * 1e-3;
+        unsigned spins = 0;
+        for (;;) {
+            unsigned e = atomic_load_explicit(&g_pool.epoch, memory_order_acquire);
+            if (e != last) return e;
+            ysu_cpu_relax();
+            if ((++spins & 63u) == 0 && ysu_now_ms() - t0 > limit) break;
+        }
+    }
+
+    unsigned e;
+    pthread_mutex_lock(&g_pool.mtx);
+    atomic_fetch_add(&g_pool.sleepers, 1);
+    while ((e = atomic_load(&g_pool.epoch)) == last) {
+        pthread_cond_wait(&g_pool.cv_start, &g_pool.mtx);
+    }
+    atomic_fetch_sub(&g_pool.sleepers, 1);
+    pthread_mutex_unlock(&g_pool.mtx);
+    return e;
+}
+
+static void pool_frame_done(YSU_SchedMode mode) {
+    if (mode == YSU_SCHED_STEAL) {
+        int d = atomic_fetch_add(&g_pool.done_workers, 1) + 1;
+        if (d >= g_pool.pool_threads && atomic_load(&g_pool.main_waiting)) {
+            pthread_mutex_lock(&g_pool.mtx);
             pthread_cond_signal(&g_pool.cv_done);
+            pthread_mutex_unlock(&g_pool.mtx);
         }
-        pthread_mutex_unlock(&g_pool.mtx);
+        return;
+    }
+
+    pthread_mutex_lock(&g_pool.mtx);
+    int d = atomic_fetch_add(&g_pool.done_workers, 1) + 1;
+    if (d >= g_pool.pool_threads) {
+        pthread_cond_signal(&g_pool.cv_done);
+    }
+    pthread_mutex_unlock(&g_pool.mtx);
+}
+
+static void *pool_worker(void *arg) {
+    WorkerLocal *wl = (WorkerLocal*)arg;
+    int tid = wl->tid;
+    unsigned last_epoch = 0;
+    int spin_us = 0;   // chunk mode (and the very first frame) sleeps right away
+
+    if (wl->cpu >= 0 && !ysu_mt_pin_self(wl->cpu)) wl->cpu = -1;
+
+    for (;;) {
+        last_epoch = pool_wait_frame(last_epoch, spin_us);
+        if (atomic_load(&g_pool.shutdown)) return NULL;
+
+        YSU_SchedMode mode = g_pool.mode;
+        wl->busy_ms = 0.0;
+        wl->rects = wl->steals = wl->splits = wl->rays = 0;
+        wl->trace_ms = 0.0;
+        wl->trace_rays = wl->l1d_misses = wl->llc_misses = 0;
+
+        if (tid < g_pool.active_workers) {
+            if (g_pool.touch)                 pool_run_touch(&g_pool, wl);
+            else if (g_pool.budget)           pool_run_budget(&g_pool, wl);
+            else if (mode == YSU_SCHED_STEAL) pool_run_steal(&g_pool, wl);
+            else                              pool_run_chunk(&g_pool, wl);
+        }
+
+        spin_us = (mode == YSU_SCHED_STEAL) ? g_pool.spin_us : 0;
+        pool_frame_done(mode);
     }
 }
 
 static void pool_shutdown(void) {
     if (!g_pool.threads) return;
     pthread_mutex_lock(&g_pool.mtx);
-    g_pool.shutdown = 1;
+    atomic_store(&g_pool.shutdown, 1);
+    atomic_fetch_add(&g_pool.epoch, 1);
     pthread_cond_broadcast(&g_pool.cv_start);
     pthread_mutex_unlock(&g_pool.mtx);
 
@@ -637,7 +2466,17 @@ static void pool_shutdown(void) {
     free(g_pool.threads);
     g_pool.threads = NULL;
 
-    free(g_pool.locals);
+    if (g_pool.deques) {
+        for (int i = 0; i < g_pool.pool_threads; ++i) free((void*)g_pool.deques[i].buf);
+        pool_aligned_free(g_pool.deques);
+        g_pool.deques = NULL;
+    }
+
+    for (int i = 0; i < g_pool.pool_threads; ++i) {
+        wavefront_scratch_free(g_pool.locals[i].wf);
+        if (g_pool.locals[i].perf_tried) ysu_perf_close(&g_pool.locals[i].perf);
+    }
+    pool_aligned_free(g_pool.locals);
     g_pool.locals = NULL;
 
     pthread_mutex_destroy(&g_pool.mtx);
@@ -645,77 +2484,249 @@ static void pool_shutdown(void) {
     pthread_cond_destroy(&g_pool.cv_done);
 }
 
+// YSU_PIN=1: one CPU per worker from ysu_mt_plan_affinity() (physical cores
+// first, spread over NUMA nodes), and the node's tid range for stealing.
+static void pool_plan_pinning(void) {
+    int n = g_pool.pool_threads;
+    int *cpu  = (int*)malloc(sizeof(int) * (size_t)n);
+    int *node = (int*)malloc(sizeof(int) * (size_t)n);
+    int used = (cpu && node) ? ysu_mt_plan_affinity(n, cpu, node) : 0;
+    if (used > 0) {
+        for (int i = 0; i < n; ++i) {
+            WorkerLocal *wl = &g_pool.locals[i];
+            wl->cpu = cpu[i];
+            wl->node = node[i];
+            wl->node_lo = i;
+            while (wl->node_lo > 0 && node[wl->node_lo - 1] == node[i]) wl->node_lo--;
+            wl->node_hi = i + 1;
+            while (wl->node_hi < n && node[wl->node_hi] == node[i]) wl->node_hi++;
+        }
+        ysu_mt_print_topology();
+        printf("[POOL] pinning %d workers to %d cpus\n", n, used);
+    } else {
+        g_pool.pinned = 0;
+    }
+    free(cpu);
+    free(node);
+}
+
 static void pool_init_if_needed(int create_threads) {
     if (g_pool.threads) return;
 
-    g_pool.pool_threads = (create_threads > 0) ? create_threads : ysu_suggest_threads();
+    g_pool.pool_threads = (create_threads > 0) ? create_threads : ysu_mt_suggest_threads();
     if (g_pool.pool_threads < 1) g_pool.pool_threads = 1;
 
     pthread_mutex_init(&g_pool.mtx, NULL);
     pthread_cond_init(&g_pool.cv_start, NULL);
     pthread_cond_init(&g_pool.cv_done, NULL);
 
-    g_pool.work_id = 0;
-    g_pool.shutdown = 0;
+    atomic_store(&g_pool.epoch, 0u);
+    atomic_store(&g_pool.sleepers, 0);
+    atomic_store(&g_pool.done_workers, 0);
+    atomic_store(&g_pool.main_waiting, 0);
+    atomic_store(&g_pool.shutdown, 0);
 
     g_pool.threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)g_pool.pool_threads);
-    g_pool.locals  = (WorkerLocal*)malloc(sizeof(WorkerLocal) * (size_t)g_pool.pool_threads);
-    if (!g_pool.threads || !g_pool.locals) {
-        free(g_pool.threads); g_pool.threads = NULL;
-        free(g_pool.locals);  g_pool.locals  = NULL;
+    g_pool.locals  = (WorkerLocal*)pool_aligned_alloc(sizeof(WorkerLocal) * (size_t)g_pool.pool_threads);
+    g_pool.deques  = (TileDeque*)pool_aligned_alloc(sizeof(TileDeque) * (size_t)g_pool.pool_threads);
+    if (!g_pool.threads || !g_pool.locals || !g_pool.deques) {
+        free(g_pool.threads);               g_pool.threads = NULL;
+        pool_aligned_free(g_pool.locals);   g_pool.locals  = NULL;
+        pool_aligned_free(g_pool.deques);   g_pool.deques  = NULL;
         g_pool.pool_threads = 0;
         return;
     }
 
     for (int i = 0; i < g_pool.pool_threads; ++i) {
+        memset(&g_pool.locals[i], 0, sizeof(WorkerLocal));
         g_pool.locals[i].tid = i;
-        g_pool.locals[i].rng_state = ysu_hash_u32((uint32_t)time(NULL)
-                                   ^ (uint32_t)(i * 0x9E3779B9u)
-                                   ^ (uint32_t)(uintptr_t)(&g_pool.locals[i]));
+        g_pool.locals[i].steal_rng.state = ysu_hash_u32((uint32_t)(i + 1) * 0x85EBCA77u);
+        g_pool.locals[i].cpu = -1;
+        g_pool.locals[i].node_hi = g_pool.pool_threads;
+
+        atomic_init(&g_pool.deques[i].top, 0);
+        atomic_init(&g_pool.deques[i].bottom, 0);
+        g_pool.deques[i].buf = NULL;
+        g_pool.deques[i].cap = 0;
+    }
+
+    g_pool.pinned = ysu_env_int("YSU_PIN", 0) ? 1 : 0;
+    if (g_pool.pinned) pool_plan_pinning();
+
+    for (int i = 0; i < g_pool.pool_threads; ++i) {
         pthread_create(&g_pool.threads[i], NULL, pool_worker, &g_pool.locals[i]);
     }
 
     atexit(pool_shutdown);
 }
 
-// =====================================================================
-// Public MT render using threadpool
-// =====================================================================
-void render_scene_mt(Vec3 *pixels,
-                     int image_width,
-                     int image_height,
-                     Camera cam,
-                     int samples_per_pixel,
-                     int max_depth,
-                     int thread_count,
-                     int tile_size)
-{
-    if (!pixels || image_width <= 0 || image_height <= 0) return;
-    if (samples_per_pixel < 1) samples_per_pixel = 1;
-    if (max_depth < 1) max_depth = 1;
+// Distribute tiles over the active workers' deques: worker w gets its
+// pool_band() range, pushed in reverse so the owner pops it in order
+// while thieves take from the far end. Runs before the epoch is published.
+static int pool_seed_deques(RenderPool *p) {
+    int total = p->tiles_x * p->tiles_y;
+    int n = p->active_workers;
+
+    for (int w = 0; w < n; ++w) {
+        int a, b;
+        pool_band(total, n, w, &a, &b);
+
+        TileDeque *d = &p->deques[w];
+        int64_t need = 16;
+        while (need < (int64_t)(b - a) + 2) need <<= 1;
+        if (d->cap < need) {
+            _Atomic uint64_t *nb = (_Atomic uint64_t*)realloc((void*)d->buf, sizeof(uint64_t) * (size_t)need);
+            if (!nb) return 0;
+            d->buf = nb;
+            d->cap = need;
+        }
 
-    ysu_adapt_load_config();
-    ysu_fx_load_once();
+        int64_t k = 0;
+        for (int job = b - 1; job >= a; --job, ++k) {
+            int x0, y0, x1, y1;
+            tile_rect(job, p->tiles_x, p->tile_size, p->width, p->height, &x0, &y0, &x1, &y1);
+            atomic_store_explicit(&d->buf[k], rect_pack(x0, y0, x1, y1), memory_order_relaxed);
+        }
+        atomic_store_explicit(&d->top, 0, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, k, memory_order_relaxed);
+    }
+    atomic_store_explicit(&p->pending, (int64_t)total, memory_order_relaxed);
+    return 1;
+}
 
-    atomic_store(&g_adapt_total_samples, 0);
-    atomic_store(&g_adapt_early_pixels, 0);
-    atomic_store(&g_adapt_max_pixels, 0);
+// Main side of the frame handshake: spin for the done counter, then park on
+// cv_done (main_waiting mirrors the worker-side sleepers protocol).
+static void pool_wait_done(int spin_us) {
+    int n = g_pool.pool_threads;
+    if (spin_us > 0) {
+        double t0 = ysu_now_ms();
+        double limit = (double)spin_us * 1e-3;
+        unsigned spins = 0;
+        for (;;) {
+            if (atomic_load_explicit(&g_pool.done_workers, memory_order_acquire) >= n) return;
+            ysu_cpu_relax();
+            if ((++spins & 63u) == 0 && ysu_now_ms() - t0 > limit) break;
+        }
+    }
 
-    if (thread_count <= 0) thread_count = ysu_suggest_threads();
-    if (thread_count < 1) thread_count = 1;
+    pthread_mutex_lock(&g_pool.mtx);
+    atomic_store(&g_pool.main_waiting, 1);
+    while (atomic_load(&g_pool.done_workers) < n) {
+        pthread_cond_wait(&g_pool.cv_done, &g_pool.mtx);
+    }
+    atomic_store(&g_pool.main_waiting, 0);
+    pthread_mutex_unlock(&g_pool.mtx);
+}
+
+static void pool_print_stats(void) {
+    int n = g_pool.active_workers;
+    double sum_busy = 0.0, max_busy = 0.0;
+    uint64_t steals = 0, splits = 0;
+
+    printf("[SCHED] mode=%s threads=%d frame=%.2f ms\n",
+           (g_pool.mode == YSU_SCHED_STEAL) ? "steal" : "chunk", n, g_pool.frame_ms);
+    for (int i = 0; i < n; ++i) {
+        const WorkerLocal *wl = &g_pool.locals[i];
+        printf("[SCHED]  t%02d busy=%.2f ms idle=%.2f ms rects=%" PRIu64 " steals=%" PRIu64 " splits=%" PRIu64,
+               i, wl->busy_ms, wl->idle_ms, wl->rects, wl->steals, wl->splits);
+        if (wl->cpu >= 0) printf(" cpu=%d node=%d", wl->cpu, wl->node);
+        printf("\n");
+        sum_busy += wl->busy_ms;
+        if (wl->busy_ms > max_busy) max_busy = wl->busy_ms;
+        steals += wl->steals;
+        splits += wl->splits;
+    }
+    double mean_busy = (n > 0) ? sum_busy / (double)n : 0.0;
+    double util = (g_pool.frame_ms > 0.0 && n > 0) ? sum_busy / (g_pool.frame_ms * (double)n) : 0.0;
+    printf("[SCHED] imbalance(max/mean busy)=%.3f  utilization=%.1f%%  steals=%" PRIu64 "  splits=%" PRIu64 "\n",
+           (mean_busy > 0.0) ? max_busy / mean_busy : 1.0, util * 100.0, steals, splits);
+}
 
+static void pool_print_trace_stage(void) {
+    double ms = 0.0;
+    uint64_t rays = 0, l1 = 0, llc = 0;
+    int counted = 0;
+    for (int i = 0; i < g_pool.active_workers; ++i) {
+        const WorkerLocal *wl = &g_pool.locals[i];
+        ms += wl->trace_ms;
+        rays += wl->trace_rays;
+        l1 += wl->l1d_misses;
+        llc += wl->llc_misses;
+        counted |= wl->perf.ok;
+    }
+    if (rays == 0) return;
+    printf("[RAYSORT] sort=%s traversal rays=%" PRIu64 " busy=%.2f ms  %.2f Mrays/s/thread",
+           g_ray_sort ? "on" : "off", rays, ms, (ms > 0.0) ? (double)rays / (ms * 1000.0) : 0.0);
+    if (counted) {
+        printf("  L1D miss/ray=%.2f  LLC miss/ray=%.3f\n", (double)l1 / (double)rays, (double)llc / (double)rays);
+    } else {
+        printf("  (cache counters unavailable)\n");
+    }
+}
+
+int render_get_thread_stats(YSU_ThreadStats *out, int max_threads, double *frame_ms) {
+    if (frame_ms) *frame_ms = g_pool.frame_ms;
+    if (!g_pool.locals) return 0;
+
+    int n = g_pool.active_workers;
+    if (!out) return n;
+    if (n > max_threads) n = max_threads;
+    for (int i = 0; i < n; ++i) {
+        const WorkerLocal *wl = &g_pool.locals[i];
+        out[i].busy_ms = wl->busy_ms;
+        out[i].idle_ms = wl->idle_ms;
+        out[i].rects   = wl->rects;
+        out[i].steals  = wl->steals;
+        out[i].splits  = wl->splits;
+        out[i].rays    = wl->rays;
+        out[i].trace_ms   = wl->trace_ms;
+        out[i].trace_rays = wl->trace_rays;
+        out[i].l1d_misses = wl->l1d_misses;
+        out[i].llc_misses = wl->llc_misses;
+    }
+    return n;
+}
+
+// =====================================================================
+// Frame dispatch (shared by plain, progressive and time-boxed renders)
+// =====================================================================
+static int pool_tile_size(int thread_count, int tile_size) {
     if (tile_size <= 0) tile_size = 64;
     if (tile_size < 16) tile_size = 16;
     if (thread_count >= 8 && tile_size < 32) tile_size = 32;
+    return tile_size;
+}
+
+// Returns 0 if the pool could not be created.
+static int pool_dispatch(Vec3 *pixels, YSU_Accum *acc, double deadline_ms,
+                         TileHeap *budget, int image_width, int image_height, Camera cam,
+                         int samples_per_pixel, int max_depth,
+                         int thread_count, int tile_size)
+{
+    YSU_SchedMode mode = ysu_sched_load_config();
+    ysu_integrator_load_config();
+    ysu_raysort_load_config();
+    ysu_seed_load_config();
+
+    if (thread_count <= 0) thread_count = ysu_mt_suggest_threads();
+    if (thread_count < 1) thread_count = 1;
+    tile_size = pool_tile_size(thread_count, tile_size);
 
     pool_init_if_needed(thread_count);
+    if (!g_pool.threads) return 0;
+
+    // packed rects are 16-bit per coordinate
+    if (image_width > 0xFFFF || image_height > 0xFFFF) mode = YSU_SCHED_CHUNK;
 
     int tiles_x = (image_width  + tile_size - 1) / tile_size;
     int tiles_y = (image_height + tile_size - 1) / tile_size;
 
-    pthread_mutex_lock(&g_pool.mtx);
-
+    // Workers are all parked (they acked the previous frame), so the frame
+    // description can be written without holding the pool mutex.
     g_pool.pixels = pixels;
+    g_pool.acc = acc;
+    g_pool.deadline_ms = deadline_ms;
+    g_pool.budget = budget;
     g_pool.cam = cam;
     g_pool.width = image_width;
     g_pool.height = image_height;
@@ -728,9 +2739,6 @@ void render_scene_mt(Vec3 *pixels,
 
     atomic_store(&g_pool.next_job, 0);
 
-    g_pool.seed_base = ((uint32_t)time(NULL) ^ 0xD1B54A35u);
-    if (g_pool.seed_base == 0) g_pool.seed_base = 1;
-
     int total_jobs = g_pool.tiles_x * g_pool.tiles_y;
     if (total_jobs < 1) total_jobs = 1;
 
@@ -739,16 +2747,76 @@ void render_scene_mt(Vec3 *pixels,
     if (thread_count < 1)                  thread_count = 1;
 
     g_pool.active_workers = thread_count;
-    g_pool.done_workers = 0;
+    g_pool.spin_us = ysu_env_int("YSU_POOL_SPIN_US", 200);
+    if (g_pool.spin_us < 0) g_pool.spin_us = 0;
 
-    g_pool.work_id++;
-    pthread_cond_broadcast(&g_pool.cv_start);
+    if (mode == YSU_SCHED_STEAL && !pool_seed_deques(&g_pool)) mode = YSU_SCHED_CHUNK;
+    g_pool.mode = mode;
 
-    while (g_pool.done_workers < g_pool.active_workers) {
-        pthread_cond_wait(&g_pool.cv_done, &g_pool.mtx);
+    atomic_store(&g_pool.done_workers, 0);
+
+    double t0 = ysu_now_ms();
+
+    // publish: the seq_cst epoch store pairs with the sleepers check so a
+    // worker that went to sleep is never missed.
+    atomic_fetch_add(&g_pool.epoch, 1u);
+    if (atomic_load(&g_pool.sleepers) > 0) {
+        pthread_mutex_lock(&g_pool.mtx);
+        pthread_cond_broadcast(&g_pool.cv_start);
+        pthread_mutex_unlock(&g_pool.mtx);
     }
 
-    pthread_mutex_unlock(&g_pool.mtx);
+    pool_wait_done((mode == YSU_SCHED_STEAL) ? g_pool.spin_us : 0);
+
+    g_pool.frame_ms = ysu_now_ms() - t0;
+    for (int i = 0; i < g_pool.pool_threads; ++i) {
+        double idle = g_pool.frame_ms - g_pool.locals[i].busy_ms;
+        g_pool.locals[i].idle_ms = (idle > 0.0) ? idle : 0.0;
+    }
+
+    g_pool.acc = NULL;
+    g_pool.deadline_ms = 0.0;
+    g_pool.budget = NULL;
+
+    if (g_pool.touch) return 1;
+    if (g_sched_stats) pool_print_stats();
+
+    uint64_t rays = 0;
+    for (int i = 0; i < g_pool.active_workers; ++i) rays += g_pool.locals[i].rays;
+    ysu_print_trace_stats(rays, g_pool.frame_ms);
+    if (g_perf) pool_print_trace_stage();
+    return 1;
+}
+
+// =====================================================================
+// Public MT render using threadpool
+// =====================================================================
+void render_scene_mt(Vec3 *pixels,
+                     int image_width,
+                     int image_height,
+                     Camera cam,
+                     int samples_per_pixel,
+                     int max_depth,
+                     int thread_count,
+                     int tile_size)
+{
+    if (!pixels || image_width <= 0 || image_height <= 0) return;
+    if (samples_per_pixel < 1) samples_per_pixel = 1;
+    if (max_depth < 1) max_depth = 1;
+
+    ysu_adapt_load_config();
+    ysu_fx_load_once();
+
+    atomic_store(&g_adapt_total_samples, 0);
+    atomic_store(&g_adapt_early_pixels, 0);
+    atomic_store(&g_adapt_max_pixels, 0);
+    render_policy_frame(&cam, image_width, image_height);
+
+    if (!pool_dispatch(pixels, NULL, 0.0, NULL, image_width, image_height, cam,
+                       samples_per_pixel, max_depth, thread_count, tile_size)) {
+        render_scene_st_frame(pixels, image_width, image_height, cam, samples_per_pixel, max_depth);
+        return;
+    }
 
     if (g_adapt_enabled) {
         uint64_t total_samples = atomic_load(&g_adapt_total_samples);
@@ -762,6 +2830,293 @@ void render_scene_mt(Vec3 *pixels,
     }
 }
 
+// =====================================================================
+// 360 renders (equirect / cubemap lens on the shared pool)
+// =====================================================================
+int render_scene_360(Vec3 *pixels,
+                     int width,
+                     int height,
+                     Vec3 origin,
+                     YSU_Lens lens_kind,
+                     int samples_per_pixel,
+                     int max_depth,
+                     int thread_count,
+                     int tile_size)
+{
+    if (!pixels || width <= 0 || height <= 0) return 0;
+    if (lens_kind != YSU_LENS_EQUIRECT && lens_kind != YSU_LENS_CUBEMAP) return 0;
+    if (lens_kind == YSU_LENS_CUBEMAP && width != 6 * height) return 0;
+    if (samples_per_pixel < 1) samples_per_pixel = 1;
+    if (max_depth < 1) max_depth = 1;
+
+    RenderLens lens;
+    memset(&lens, 0, sizeof(lens));
+    lens.kind = lens_kind;
+    lens.face = height;
+
+    float *tab = NULL;
+    if (lens_kind == YSU_LENS_EQUIRECT) {
+        tab = (float*)malloc(sizeof(float) * 2 * ((size_t)width + (size_t)height));
+        if (!tab) return 0;
+        lens.sin_p = tab;
+        lens.cos_p = lens.sin_p + width;
+        lens.sin_t = lens.cos_p + width;
+        lens.cos_t = lens.sin_t + height;
+        lens.dphi   = 2.0f * 3.14159265358979f / (float)width;
+        lens.dtheta = 3.14159265358979f / (float)height;
+        for (int i = 0; i < width; ++i) {
+            double phi = 2.0 * 3.14159265358979323846 * ((double)i + 0.5) / (double)width;
+            lens.sin_p[i] = (float)sin(phi);
+            lens.cos_p[i] = (float)cos(phi);
+        }
+        for (int j = 0; j < height; ++j) {
+            double theta = 3.14159265358979323846 * (1.0 - ((double)j + 0.5) / (double)height);
+            lens.sin_t[j] = (float)sin(theta);
+            lens.cos_t[j] = (float)cos(theta);
+        }
+    }
+
+    ysu_adapt_load_config();
+    ysu_fx_load_once();
+
+    atomic_store(&g_adapt_total_samples, 0);
+    atomic_store(&g_adapt_early_pixels, 0);
+    atomic_store(&g_adapt_max_pixels, 0);
+
+    Camera cam;
+    memset(&cam, 0, sizeof(cam));
+    cam.origin = origin;
+
+    g_pool.lens = &lens;
+    int ok = pool_dispatch(pixels, NULL, 0.0, NULL, width, height, cam,
+                           samples_per_pixel, max_depth, thread_count, tile_size);
+    g_pool.lens = NULL;
+    free(tab);
+    return ok;
+}
+
+// =====================================================================
+// NUMA-aware framebuffer (first touch by the owning worker)
+// =====================================================================
+Vec3 *render_alloc_framebuffer(int image_width, int image_height, int thread_count, int tile_size) {
+    if (image_width <= 0 || image_height <= 0) return NULL;
+    size_t bytes = sizeof(Vec3) * (size_t)image_width * (size_t)image_height;
+
+    // page aligned and left untouched: the kernel places each page on the
+    // node of the thread that writes it first
+    Vec3 *pixels = NULL;
+#if defined(_WIN32)
+    pixels = (Vec3*)_aligned_malloc(bytes, 4096);
+#else
+    if (posix_memalign((void**)&pixels, 4096, bytes) != 0) pixels = NULL;
+#endif
+    if (!pixels) return NULL;
+
+    Camera cam;
+    memset(&cam, 0, sizeof(cam));
+    g_pool.touch = 1;
+    int ok = pool_dispatch(pixels, NULL, 0.0, NULL, image_width, image_height, cam,
+                           1, 1, thread_count, tile_size);
+    g_pool.touch = 0;
+    if (!ok) memset(pixels, 0, bytes);
+    return pixels;
+}
+
+// =====================================================================
+// G-buffer (primary visibility on the pool, ray packets for loaded scenes)
+// =====================================================================
+int render_gbuffer(const YSU_GBuffer *gb, Camera cam, int thread_count, int tile_size) {
+    if (!gb || gb->width <= 0 || gb->height <= 0) return 0;
+    if (!gb->depth && !gb->normal && !gb->albedo && !gb->shadow) return 0;
+
+    const BvhPacketConfig *pc = bvh_packet_config();
+    double t0 = ysu_now_ms();
+    g_pool.gbuf = gb;
+    int ok = pool_dispatch(NULL, NULL, 0.0, NULL, gb->width, gb->height, cam,
+                           1, 1, thread_count, tile_size);
+    g_pool.gbuf = NULL;
+    if (!ok) return 0;
+
+    printf("[GBUF] %dx%d primary%s hits in %.2f ms (%s)\n", gb->width, gb->height,
+           gb->shadow ? " + shadow" : "", ysu_now_ms() - t0,
+           (g_scene.count > 0 && pc->enabled && pc->avx2) ? "packets" : "single rays");
+    return 1;
+}
+
+void render_free_framebuffer(Vec3 *pixels) {
+#if defined(_WIN32)
+    _aligned_free(pixels);
+#else
+    free(pixels);
+#endif
+}
+
+// =====================================================================
+// Progressive rendering (accumulates across calls, see accum.h)
+// =====================================================================
+uint64_t render_scene_progressive(YSU_Accum *acc,
+                                  Camera cam,
+                                  int add_spp,
+                                  int max_depth,
+                                  int thread_count,
+                                  int tile_size)
+{
+    if (!acc || !acc->sum) return 0;
+    if (add_spp < 1) add_spp = 1;
+    if (max_depth < 1) max_depth = 1;
+
+    ysu_adapt_load_config();
+    ysu_fx_load_once();
+
+    atomic_store(&g_adapt_total_samples, 0);
+    atomic_store(&g_adapt_early_pixels, 0);
+    render_policy_frame(&cam, acc->width, acc->height);
+
+    if (!pool_dispatch(NULL, acc, 0.0, NULL, acc->width, acc->height, cam,
+                       add_spp, max_depth, thread_count, tile_size)) {
+        return 0;
+    }
+
+    uint64_t added = atomic_load(&g_adapt_total_samples);
+    acc->total_samples += added;
+    acc->passes++;
+    return added;
+}
+
+uint64_t render_scene_progressive_timed(YSU_Accum *acc,
+                                        Camera cam,
+                                        double budget_ms,
+                                        int pass_spp,
+                                        int max_depth,
+                                        int thread_count,
+                                        int tile_size,
+                                        double *elapsed_ms)
+{
+    if (elapsed_ms) *elapsed_ms = 0.0;
+    if (!acc || !acc->sum) return 0;
+    if (pass_spp < 1) pass_spp = 1;
+    if (max_depth < 1) max_depth = 1;
+
+    ysu_adapt_load_config();
+    ysu_fx_load_once();
+
+    double t0 = ysu_now_ms();
+    double deadline = (budget_ms > 0.0) ? t0 + budget_ms : 0.0;
+    uint64_t total = 0;
+
+    for (;;) {
+        atomic_store(&g_adapt_total_samples, 0);
+        atomic_store(&g_adapt_early_pixels, 0);
+        render_policy_frame(&cam, acc->width, acc->height);
+
+        if (!pool_dispatch(NULL, acc, deadline, NULL, acc->width, acc->height, cam,
+                           pass_spp, max_depth, thread_count, tile_size)) {
+            break;
+        }
+
+        uint64_t added = atomic_load(&g_adapt_total_samples);
+        acc->total_samples += added;
+        acc->passes++;
+        total += added;
+
+        if (added == 0) break; // every pixel converged or hit spp_max
+        if (deadline > 0.0 && ysu_now_ms() >= deadline) break;
+        if (budget_ms <= 0.0) break; // no budget: behave like one pass
+    }
+
+    if (elapsed_ms) *elapsed_ms = ysu_now_ms() - t0;
+    return total;
+}
+
+// =====================================================================
+// Budgeted rendering: pilot pass + highest-error-tile-first refinement
+// =====================================================================
+uint64_t render_scene_budgeted(YSU_Accum *acc,
+                               Camera cam,
+                               const YSU_BudgetOpts *opts,
+                               int max_depth,
+                               int thread_count,
+                               int tile_size)
+{
+    if (!acc || !acc->sum || !opts) return 0;
+    if (max_depth < 1) max_depth = 1;
+
+    int pilot = (opts->pilot_spp > 0) ? opts->pilot_spp : 4;
+    int batch = (opts->batch_spp > 0) ? opts->batch_spp : 8;
+    if (pilot < 2) pilot = 2; // need two samples for a variance estimate
+
+    ysu_adapt_load_config();
+    ysu_fx_load_once();
+    g_adapt_enabled = 0; // the budget decides where samples go, not per-pixel early-out
+
+    double t0 = ysu_now_ms();
+    double deadline = (opts->budget_ms > 0.0) ? t0 + opts->budget_ms : 0.0;
+    uint64_t px = (uint64_t)acc->width * (uint64_t)acc->height;
+
+    // ---- phase 1: pilot (pilot + refinement count as one policy frame) ----
+    atomic_store(&g_adapt_total_samples, 0);
+    render_policy_frame(&cam, acc->width, acc->height);
+    if (!pool_dispatch(NULL, acc, deadline, NULL, acc->width, acc->height, cam,
+                       pilot, max_depth, thread_count, tile_size)) {
+        return 0;
+    }
+    uint64_t pilot_samples = atomic_load(&g_adapt_total_samples);
+    acc->total_samples += pilot_samples;
+    acc->passes++;
+    double pilot_ms = ysu_now_ms() - t0;
+
+    // ---- phase 2: spend what is left on the worst tiles ----
+    int64_t left = INT64_MAX;
+    if (opts->budget_samples > 0) {
+        left = (opts->budget_samples > pilot_samples)
+             ? (int64_t)(opts->budget_samples - pilot_samples) : 0;
+    } else if (opts->budget_ms <= 0.0) {
+        left = 0; // no budget at all: pilot only
+    }
+
+    uint64_t refine_samples = 0;
+    if (left > 0 && (deadline <= 0.0 || ysu_now_ms() < deadline)) {
+        int threads = (thread_count > 0) ? thread_count : ysu_mt_suggest_threads();
+        int ts = pool_tile_size(threads, tile_size);
+        int tiles_x = (acc->width  + ts - 1) / ts;
+        int tiles_y = (acc->height + ts - 1) / ts;
+        int tiles = tiles_x * tiles_y;
+
+        TileHeap heap;
+        heap.items = (TileHeapItem*)malloc(sizeof(TileHeapItem) * (size_t)tiles);
+        if (heap.items) {
+            pthread_mutex_init(&heap.mtx, NULL);
+            heap.count = 0;
+            heap.in_flight = 0;
+            heap.batch = batch;
+            atomic_init(&heap.left, left);
+
+            for (int t = 0; t < tiles; ++t) {
+                int x0, y0, x1, y1;
+                tile_rect(t, tiles_x, ts, acc->width, acc->height, &x0, &y0, &x1, &y1);
+                heap_push_locked(&heap, tile_error_gain(acc, x0, y0, x1, y1, batch), t);
+            }
+
+            atomic_store(&g_adapt_total_samples, 0);
+            pool_dispatch(NULL, acc, deadline, &heap, acc->width, acc->height, cam,
+                          batch, max_depth, thread_count, tile_size);
+            refine_samples = atomic_load(&g_adapt_total_samples);
+            acc->total_samples += refine_samples;
+            acc->passes++;
+
+            pthread_mutex_destroy(&heap.mtx);
+            free(heap.items);
+        }
+    }
+
+    double total_ms = ysu_now_ms() - t0;
+    printf("[BUDGET] pilot=%d spp (%.1f ms)  refine=%" PRIu64 " samples  total=%" PRIu64 "  avg_spp=%.2f  time=%.1f ms\n",
+           pilot, pilot_ms, refine_samples, pilot_samples + refine_samples,
+           (px > 0) ? (double)(pilot_samples + refine_samples) / (double)px : 0.0, total_ms);
+
+    return pilot_samples + refine_samples;
+}
+
 // ================================================================
 // CPU NeRF SIMD Rendering (optional integration)
 // ================================================================
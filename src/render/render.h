@@ -9,6 +9,10 @@ extern "C" {
 #include "vec3.h"
 #include "ray.h"
 #include "camera.h"
+#include "accum.h"
+#include "sphere.h"
+#include "material.h"
+#include "gbuffer.h"
 
 /**
  * Debug view modes (env: YSU_DEBUG)
@@ -47,6 +51,165 @@ void render_scene_mt(Vec3 *pixels,
                      int thread_count,
                      int tile_size);
 
+/**
+ * Projection for render_scene_360().
+ *  - EQUIRECT: width x height lat-long map, phi across, +Y at the top row
+ *  - CUBEMAP:  (6*face) x face strip of faces +X,-X,+Y,-Y,+Z,-Z, each a
+ *              90-degree view with +Y up (+Y face: +Z up, -Y face: -Z up)
+ */
+typedef enum {
+    YSU_LENS_PERSPECTIVE = 0,
+    YSU_LENS_EQUIRECT,
+    YSU_LENS_CUBEMAP
+} YSU_Lens;
+
+/**
+ * 360 render around origin on the MT pool; same integrators, sampler and
+ * YSU_ADAPTIVE handling as render_scene_mt(). For CUBEMAP, width must be
+ * 6 * height. Returns 1 on success, 0 on bad arguments / out of memory.
+ */
+int render_scene_360(Vec3 *pixels,
+                     int width,
+                     int height,
+                     Vec3 origin,
+                     YSU_Lens lens,
+                     int samples_per_pixel,
+                     int max_depth,
+                     int thread_count,
+                     int tile_size);
+
+/**
+ * Framebuffer for render_scene_mt() with the same thread_count and tile_size
+ * (<= 0 = auto). Pages are zeroed by the pool worker whose tile band covers
+ * them, so with YSU_PIN=1 each band lives on its worker's NUMA node.
+ * Release with render_free_framebuffer(). Returns NULL on failure.
+ */
+Vec3 *render_alloc_framebuffer(int image_width, int image_height,
+                               int thread_count, int tile_size);
+void  render_free_framebuffer(Vec3 *pixels);
+
+/**
+ * Primary-visibility pass into gb (depth = hit t or -1 on a miss, world
+ * normal, albedo, shadow = 1 where the hit sees the direct shader's sun;
+ * NULL planes are skipped) through pixel centres, rows laid out like
+ * render_scene_mt(). Runs on the MT pool; loaded scenes trace 4x2 pixel
+ * blocks as 8-ray packets, primary and shadow rays alike (env: YSU_PACKET=0
+ * for single rays, YSU_PACKET_MIN), with the same hits either way.
+ * Returns 1 on success, 0 on bad arguments / no pool.
+ */
+int render_gbuffer(const YSU_GBuffer *gb, Camera cam, int thread_count, int tile_size);
+
+/**
+ * Progressive render: adds up to add_spp samples to every pixel of acc that is
+ * not yet converged (YSU_ADAPTIVE) or at acc->spp_max. Uses the MT pool.
+ * Returns the number of samples added (0 => nothing left to do).
+ * Resolve with ysu_accum_resolve().
+ */
+uint64_t render_scene_progressive(YSU_Accum *acc,
+                                  Camera cam,
+                                  int add_spp,
+                                  int max_depth,
+                                  int thread_count,
+                                  int tile_size);
+
+/**
+ * Time-boxed progressive render: repeats passes of pass_spp until budget_ms
+ * of wall time is spent (the last pass stops mid-frame; unfinished tiles just
+ * keep fewer samples) or no pixel takes more samples.
+ * budget_ms <= 0 runs a single pass. elapsed_ms may be NULL.
+ * Returns the number of samples added.
+ */
+uint64_t render_scene_progressive_timed(YSU_Accum *acc,
+                                        Camera cam,
+                                        double budget_ms,
+                                        int pass_spp,
+                                        int max_depth,
+                                        int thread_count,
+                                        int tile_size,
+                                        double *elapsed_ms);
+
+/**
+ * Global budget for render_scene_budgeted(). Set budget_samples, budget_ms
+ * or both (whichever runs out first); with neither only the pilot runs.
+ */
+typedef struct {
+    uint64_t budget_samples; // total samples incl. pilot (0 = unlimited)
+    double   budget_ms;      // wall-clock budget incl. pilot (0 = unlimited)
+    int      pilot_spp;      // uniform first pass used to estimate variance (default 4)
+    int      batch_spp;      // samples per pixel each time a tile is picked (default 8)
+} YSU_BudgetOpts;
+
+/**
+ * Two-phase budgeted render into acc: a uniform pilot pass, then the rest of
+ * the budget goes tile by tile to whichever tile currently promises the
+ * largest drop in summed per-pixel variance (shared priority queue on the
+ * MT pool). Per-pixel adaptive early-out is off in this mode.
+ * Returns the number of samples added.
+ */
+uint64_t render_scene_budgeted(YSU_Accum *acc,
+                               Camera cam,
+                               const YSU_BudgetOpts *opts,
+                               int max_depth,
+                               int thread_count,
+                               int tile_size);
+
+/**
+ * Tile scheduler used by render_scene_mt() (env: YSU_SCHED=chunk|steal).
+ *  - CHUNK: shared atomic job counter, JOB_CHUNK tiles per fetch (default)
+ *  - STEAL: per-thread deques, randomized stealing, tiles split on steal;
+ *           pinned workers (YSU_PIN=1) steal from their own NUMA node first.
+ *           Default when pinned on a multi-node machine.
+ */
+typedef enum {
+    YSU_SCHED_CHUNK = 0,
+    YSU_SCHED_STEAL
+} YSU_SchedMode;
+
+/**
+ * Force a scheduler, overriding YSU_SCHED for subsequent frames.
+ */
+void render_set_scheduler(YSU_SchedMode mode);
+
+/**
+ * Sort secondary rays by origin/direction key before BVH traversal in the
+ * wavefront integrator, overriding YSU_RAY_SORT for subsequent frames.
+ * Same image either way; only the traversal order changes.
+ */
+void render_set_ray_sort(int enabled);
+
+/**
+ * Load a BVH pruning model (bvh_policy.h JSON), overriding
+ * YSU_BVH_POLICY_MODEL for the next render_set_scene(); NULL or "" turns
+ * pruning off. The policy is scored on the camera of perspective frames
+ * (render_scene_st / _mt / progressive / budgeted) only.
+ */
+void render_set_policy_model(const char *path);
+
+/**
+ * Per-thread stats of the last render_scene_mt() frame.
+ * idle_ms = frame wall time - busy_ms (waiting, stealing, signalling).
+ */
+typedef struct {
+    double   busy_ms;
+    double   idle_ms;
+    uint64_t rects;
+    uint64_t steals;
+    uint64_t splits;
+    uint64_t rays;      // ray segments traced (all integrators)
+
+    // wavefront traversal stage, filled with YSU_PERF=1 (0 otherwise)
+    double   trace_ms;
+    uint64_t trace_rays;
+    uint64_t l1d_misses;  // 0 when perf_event_open is unavailable
+    uint64_t llc_misses;
+} YSU_ThreadStats;
+
+/**
+ * Copies up to max_threads entries into out (may be NULL to query the count).
+ * Returns the number of active threads in the last frame.
+ */
+int render_get_thread_stats(YSU_ThreadStats *out, int max_threads, double *frame_ms);
+
 /**
  * Convenience wrapper: chooses ST/MT internally (currently calls MT auto).
  */
@@ -65,6 +228,97 @@ void render_nerf_cpu(Vec3 *pixels,
                      int image_height,
                      Camera cam);
 
+/**
+ * Integrator used by the tile renderers (env: YSU_INTEGRATOR).
+ *  - DIRECT:    one-bounce Lambert + emission (default, legacy look)
+ *  - PATH:      naive recursive path tracer using material_scatter
+ *  - WAVEFRONT: same estimator, but MT tiles trace all their paths bounce by
+ *               bounce through queues (batched intersect, material binning)
+ */
+typedef enum {
+    YSU_INTEGRATOR_DIRECT = 0,
+    YSU_INTEGRATOR_PATH,
+    YSU_INTEGRATOR_WAVEFRONT
+} YSU_Integrator;
+
+/**
+ * Force an integrator, overriding YSU_INTEGRATOR for subsequent frames.
+ */
+void render_set_integrator(YSU_Integrator integ);
+
+/**
+ * Force the sampler seed, overriding YSU_SEED (default 1337). Images depend
+ * only on seed, spp and scene, not on thread count or scheduler.
+ */
+void render_set_seed(uint32_t seed);
+
+/**
+ * Scene traced by all CPU renderers, through a BVH over a copy of spheres.
+ * spheres[i].material_index selects from materials (NULL => one white
+ * Lambertian); spheres[i].albedo tints that material's albedo and emission.
+ * ground keeps the built-in y=-0.5 checker plane. sphere_count <= 0
+ * restores the built-in test scene. Not safe to call during a frame.
+ * Returns 1 on success, 0 on failure (built-in scene restored).
+ */
+int render_set_scene(const Sphere *spheres, int sphere_count,
+                     const Material *materials, int material_count, int ground);
+
+/**
+ * Animates the current scene: spheres[k] replaces sphere ids[k] (an index
+ * into the render_set_scene() array, same material numbering). The BVH is
+ * refitted bottom-up from the changed leaves only; once its SAH cost grows
+ * past YSU_BVH_REFIT_MAX (default 1.3x the freshly built cost) the most
+ * degraded subtree is rebuilt. YSU_BVH_REFIT_STATS=1 logs each update.
+ * Not safe to call during a frame. Returns 1 on success.
+ */
+int render_update_spheres(const int *ids, const Sphere *spheres, int count);
+
+/**
+ * Triangle mesh traced by all CPU renderers next to the render_set_scene()
+ * spheres; with no sphere scene it replaces the built-in spheres (the
+ * checker ground stays when ground is set). tris is tri_vec4 data (12 floats
+ * per triangle, as from obj_load()), copied into a BVH with 8-triangle SoA
+ * leaves that run the AVX2 1-ray x 8-triangle test where available (env:
+ * YSU_MESH_SIMD=0 for the scalar leaf test). Triangle i uses
+ * materials[tri_material[i]] (tri_material NULL => materials[0]; materials
+ * NULL => light grey Lambertian; at most 65536). tri_count 0 removes the
+ * mesh. Not safe to call during a frame.
+ * Returns 1 on success, 0 on failure (no mesh).
+ */
+int render_set_mesh_ex(const float *tris, uint32_t tri_count, const uint16_t *tri_material,
+                       const Material *materials, int material_count, int ground);
+
+/**
+ * render_set_mesh_ex() from an indexed mesh (obj_load() with
+ * OBJ_LOAD_INDEXED): verts are xyz, indices 3 per triangle. With
+ * YSU_MESH_QUANT=1 either call stores 8-bit quantised leaves (see
+ * mesh_bvh.h).
+ */
+int render_set_mesh_indexed(const float *verts, const uint32_t *indices, uint32_t tri_count,
+                            const uint16_t *tri_material, const Material *materials,
+                            int material_count, int ground);
+
+/**
+ * Instanced meshes: mesh m is verts[m] / indices[m] (as for
+ * render_set_mesh_indexed(), tri_counts[m] > 0) and gets one BLAS in object
+ * space (tlas.h); instance i places mesh inst_mesh[i] with the row-major
+ * 3x4 object -> world transform xforms[12 * i] and material
+ * materials[inst_material[i]] (NULL => 0). Memory grows with the unique
+ * triangles, not with instances x triangles. Instances with a singular
+ * transform are skipped. Replaces any render_set_mesh*() mesh; same
+ * ground and material rules. Returns 1 on success, 0 on failure (no mesh).
+ */
+int render_set_mesh_instances(const float *const *verts, const uint32_t *const *indices,
+                              const uint32_t *tri_counts, int mesh_count,
+                              const float *xforms, const uint32_t *inst_mesh,
+                              const uint16_t *inst_material, int inst_count,
+                              const Material *materials, int material_count, int ground);
+
+/**
+ * render_set_mesh_ex() with one material (NULL => light grey) and the ground.
+ */
+int render_set_mesh(const float *tris, uint32_t tri_count, const Material *material);
+
 /**
  * Integrator entry used by renderer.
  */
@@ -1,10 +1,63 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#endif
 #include "sceneloader.h"
+#include "material.h"
+#include "obj_load.h"   // obj_parse_float
 
 // scene.txt format:
-// sphere cx cy cz radius r g b
+// sphere cx cy cz radius r g b [material [param]]
 // r,g,b = 0–1 color range
+// material = lambert | metal [fuzz] | glass [ior] | light [strength]
+
+const char *scene_material_name(int type) {
+    switch (type) {
+        case MAT_METAL:      return "metal";
+        case MAT_DIELECTRIC: return "glass";
+        case MAT_EMISSIVE:   return "light";
+        default:             return "lambert";
+    }
+}
+
+static int scene_material(const char *name, float *param) {
+    if (!strcmp(name, "metal")) {
+        if (*param < 0.0f) *param = 0.0f;
+        return MAT_METAL;
+    }
+    if (!strcmp(name, "glass") || !strcmp(name, "dielectric")) {
+        if (*param <= 0.0f) *param = 1.5f;
+        return MAT_DIELECTRIC;
+    }
+    if (!strcmp(name, "light") || !strcmp(name, "emissive")) {
+        if (*param <= 0.0f) *param = 1.0f;
+        return MAT_EMISSIVE;
+    }
+    return MAT_LAMBERTIAN;
+}
+
+// Parses one line; returns 1 for a sphere, 0 for anything else.
+static int scene_parse_line(const char *line, SceneSphere *out) {
+    char tag[16], mat[32];
+    double cx, cy, cz, r, cr, cg, cb, param = 0.0;
+
+    int n = sscanf(line, "%15s %lf %lf %lf %lf %lf %lf %lf %31s %lf",
+                   tag, &cx, &cy, &cz, &r, &cr, &cg, &cb, mat, &param);
+    if (n < 8 || strcmp(tag, "sphere") != 0) return 0;
+
+    out->center = vec3((float)cx, (float)cy, (float)cz);
+    out->radius = (float)r;
+    out->albedo = vec3((float)cr, (float)cg, (float)cb);
+    out->param  = (n >= 10) ? (float)param : 0.0f;
+    out->type   = (n >= 9) ? scene_material(mat, &out->param) : MAT_LAMBERTIAN;
+    return 1;
+}
 
 int load_scene(const char *path, SceneSphere *out, int max_spheres) {
     FILE *f = fopen(path, "r");
@@ -14,28 +67,687 @@ int load_scene(const char *path, SceneSphere *out, int max_spheres) {
     }
 
     int count = 0;
-    char tag[16];
-    double cx, cy, cz, r, cr, cg, cb;
+    char line[512];
 
-    while (count < max_spheres) {
-        int n = fscanf(f, "%15s %lf %lf %lf %lf %lf %lf %lf",
-                       tag, &cx, &cy, &cz, &r, &cr, &cg, &cb);
-        if (n == EOF) break;
-        if (n != 8) {
-            // Malformed line: skip
-            char buf[256];
-            if (!fgets(buf, sizeof(buf), f)) break;
-            continue;
-        }
+    while (count < max_spheres && fgets(line, sizeof(line), f)) {
+        // Malformed / non-sphere lines are skipped
+        if (scene_parse_line(line, &out[count])) count++;
+    }
+
+    fclose(f);
+    return count;
+}
+
+int load_scene_alloc(const char *path, SceneSphere **out) {
+    *out = NULL;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("Could not open scene file '%s'\n", path);
+        return 0;
+    }
 
-        if (strcmp(tag, "sphere") == 0) {
-            out[count].center = vec3((float)cx, (float)cy, (float)cz);
-            out[count].radius = (float)r;
-            out[count].albedo = vec3((float)cr, (float)cg, (float)cb);
-            count++;
+    int count = 0, cap = 0;
+    SceneSphere *arr = NULL;
+    SceneSphere s;
+    char line[512];
+
+    while (fgets(line, sizeof(line), f)) {
+        if (!scene_parse_line(line, &s)) continue;
+        if (count == cap) {
+            int ncap = cap ? cap * 2 : 1024;
+            SceneSphere *na = (SceneSphere*)realloc(arr, sizeof(SceneSphere) * (size_t)ncap);
+            if (!na) {
+                printf("Scene file '%s': out of memory after %d spheres\n", path, count);
+                break;
+            }
+            arr = na;
+            cap = ncap;
         }
+        arr[count++] = s;
     }
 
     fclose(f);
+    if (count == 0) { free(arr); return 0; }
+    *out = arr;
     return count;
 }
+
+// ------------------------- .ysc scene description -------------------------
+#define YSC_BLOCK (1u << 20)   // read size, also the longest line
+
+static double ysc_now_ms(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+int scene_is_ysc(const char *path) {
+    size_t n = path ? strlen(path) : 0;
+    return n >= 4 && !strcmp(path + n - 4, ".ysc");
+}
+
+// Open-addressing index: slots hold (index + 1, 32-bit hash), 0 = empty.
+typedef struct {
+    uint32_t *slot;
+    uint32_t  cap;     // power of two
+    uint32_t  count;
+} YscTable;
+
+static uint32_t ysc_hash(const void *p, size_t n) {
+    const unsigned char *b = (const unsigned char*)p;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 16777619u; }
+    return h ? h : 1u;
+}
+
+static int ysc_table_insert(YscTable *t, uint32_t h, uint32_t idx) {
+    if ((t->count + 1u) * 2u > t->cap) {
+        uint32_t ncap = t->cap ? t->cap * 2u : 64u;
+        uint32_t *ns = (uint32_t*)calloc((size_t)ncap * 2u, sizeof(uint32_t));
+        if (!ns) return 0;
+        for (uint32_t i = 0; i < t->cap; ++i) {
+            if (!t->slot[2 * i]) continue;
+            uint32_t j = t->slot[2 * i + 1] & (ncap - 1u);
+            while (ns[2 * j]) j = (j + 1u) & (ncap - 1u);
+            ns[2 * j] = t->slot[2 * i];
+            ns[2 * j + 1] = t->slot[2 * i + 1];
+        }
+        free(t->slot);
+        t->slot = ns;
+        t->cap = ncap;
+    }
+    uint32_t j = h & (t->cap - 1u);
+    while (t->slot[2 * j]) j = (j + 1u) & (t->cap - 1u);
+    t->slot[2 * j] = idx + 1u;
+    t->slot[2 * j + 1] = h;
+    t->count++;
+    return 1;
+}
+
+// Names are the first member of their def struct: entry i is at base + i * stride.
+static int ysc_name_find(const YscTable *t, const char *base, size_t stride,
+                         const char *s, size_t n, uint32_t h)
+{
+    if (!t->cap) return -1;
+    for (uint32_t j = h & (t->cap - 1u); t->slot[2 * j]; j = (j + 1u) & (t->cap - 1u)) {
+        if (t->slot[2 * j + 1] != h) continue;
+        const char *name = base + (size_t)(t->slot[2 * j] - 1u) * stride;
+        if (strlen(name) == n && !memcmp(name, s, n)) return (int)(t->slot[2 * j] - 1u);
+    }
+    return -1;
+}
+
+typedef struct {
+    SceneDesc  *d;
+    const char *dir;
+    SceneError *err;
+    YscTable    mat_names, mesh_names, anon;
+    int         mat_cap, sphere_cap, mesh_cap, inst_cap;
+
+    const char *ls, *p, *e;   // current line: start, cursor, end
+    const char *tok;          // start of the last token read (error columns)
+    int         line;
+} YscParser;
+
+static int ysc_fail(YscParser *ps, const char *at, const char *fmt, ...) {
+    if (ps->err) {
+        va_list ap;
+        va_start(ap, fmt);
+        ps->err->line = ps->line;
+        ps->err->column = (int)(at - ps->ls) + 1;
+        vsnprintf(ps->err->msg, sizeof(ps->err->msg), fmt, ap);
+        va_end(ap);
+    }
+    return 0;
+}
+
+static int ysc_grow(void **arr, int *cap, int count, size_t elem) {
+    if (count < *cap) return 1;
+    int ncap = *cap ? *cap * 2 : 256;
+    void *na = realloc(*arr, elem * (size_t)ncap);
+    if (!na) return 0;
+    *arr = na;
+    *cap = ncap;
+    return 1;
+}
+
+static inline int ysc_blank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+// Next token: 1 and [*t, *t + *n), 0 at the end of the line (or a comment),
+// -1 after an error.
+static int ysc_next(YscParser *ps, const char **t, size_t *n) {
+    const char *p = ps->p, *e = ps->e;
+    while (p < e && ysc_blank(*p)) p++;
+    ps->p = p;
+    if (p >= e || *p == '#') return 0;
+
+    ps->tok = p;
+    if (*p == '"') {
+        const char *q = (const char*)memchr(p + 1, '"', (size_t)(e - p - 1));
+        if (!q) return ysc_fail(ps, p, "unterminated string") - 1;
+        *t = p + 1;
+        *n = (size_t)(q - p - 1);
+        ps->p = q + 1;
+        return 1;
+    }
+    const char *q = p;
+    while (q < e && !ysc_blank(*q)) q++;
+    *t = p;
+    *n = (size_t)(q - p);
+    ps->p = q;
+    return 1;
+}
+
+static inline int ysc_is(const char *t, size_t n, const char *kw) {
+    return strlen(kw) == n && !memcmp(t, kw, n);
+}
+
+static int ysc_token(YscParser *ps, const char *what, const char **t, size_t *n) {
+    int r = ysc_next(ps, t, n);
+    if (r == 0) return ysc_fail(ps, ps->p, "expected %s", what);
+    return r > 0;
+}
+
+// Number token; *is_num = 0 (and nothing consumed) when the next token is
+// not one and optional is set.
+static int ysc_number(YscParser *ps, const char *what, float *out, int optional, int *is_num) {
+    const char *save = ps->p, *t;
+    size_t n;
+    int r = ysc_next(ps, &t, &n);
+    if (r < 0) return 0;
+    const char *q = t;
+    int ok = r > 0 && obj_parse_float(&q, t + n, out) && q == t + n;
+    if (ok && !isfinite(*out)) return ysc_fail(ps, t, "%s is not finite", what);
+    if (is_num) *is_num = ok;
+    if (ok) return 1;
+    if (optional) { ps->p = save; return 1; }
+    if (r == 0) return ysc_fail(ps, ps->p, "expected %s", what);
+    return ysc_fail(ps, t, "expected %s, got '%.*s'", what, (int)(n < 32 ? n : 32), t);
+}
+
+static int ysc_float(YscParser *ps, const char *what, float *out) {
+    return ysc_number(ps, what, out, 0, NULL);
+}
+
+static int ysc_vec3(YscParser *ps, const char *what, Vec3 *out) {
+    float v[3];
+    for (int a = 0; a < 3; ++a) {
+        if (!ysc_float(ps, what, &v[a])) return 0;
+    }
+    *out = vec3(v[0], v[1], v[2]);
+    return 1;
+}
+
+static int ysc_end(YscParser *ps) {
+    const char *t;
+    size_t n;
+    int r = ysc_next(ps, &t, &n);
+    if (r < 0) return 0;
+    if (r > 0) return ysc_fail(ps, t, "unexpected '%.*s'", (int)(n < 32 ? n : 32), t);
+    return 1;
+}
+
+static int ysc_material_type(const char *t, size_t n) {
+    if (ysc_is(t, n, "lambert")) return MAT_LAMBERTIAN;
+    if (ysc_is(t, n, "metal")) return MAT_METAL;
+    if (ysc_is(t, n, "glass") || ysc_is(t, n, "dielectric")) return MAT_DIELECTRIC;
+    if (ysc_is(t, n, "light") || ysc_is(t, n, "emissive")) return MAT_EMISSIVE;
+    return -1;
+}
+
+// scene.txt semantics: the color rides in the sphere tint, so the material
+// is white and only (type, param) tell materials apart.
+static int ysc_anon_material(YscParser *ps, int type, float param) {
+    SceneDesc *d = ps->d;
+    uint32_t key[2] = { (uint32_t)type, 0 };
+    memcpy(&key[1], &param, sizeof(float));
+    uint32_t h = ysc_hash(key, sizeof(key));
+    if (ps->anon.cap) {
+        for (uint32_t j = h & (ps->anon.cap - 1u); ps->anon.slot[2 * j]; j = (j + 1u) & (ps->anon.cap - 1u)) {
+            if (ps->anon.slot[2 * j + 1] == h) {
+                int i = (int)(ps->anon.slot[2 * j] - 1u);
+                const Material *m = &d->materials[i].mat;
+                float p = (type == MAT_METAL) ? m->fuzz : (type == MAT_DIELECTRIC) ? m->ref_idx
+                        : (type == MAT_EMISSIVE) ? m->emission.x : 0.0f;
+                if ((int)m->type == type && p == param) return i;
+            }
+        }
+    }
+    if (!ysc_grow((void**)&d->materials, &ps->mat_cap, d->material_count, sizeof(SceneMaterialDef)) ||
+        !ysc_table_insert(&ps->anon, h, (uint32_t)d->material_count)) {
+        return ysc_fail(ps, ps->ls, "out of memory") - 1;
+    }
+    SceneMaterialDef *md = &d->materials[d->material_count];
+    memset(md, 0, sizeof(*md));
+    md->mat = (Material){ (MaterialType)type, {1.0f, 1.0f, 1.0f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    if (type == MAT_METAL)      md->mat.fuzz = param;
+    if (type == MAT_DIELECTRIC) md->mat.ref_idx = param;
+    if (type == MAT_EMISSIVE)   md->mat.emission = vec3(param, param, param);
+    md->line = ps->line;
+    return d->material_count++;
+}
+
+// Name token looked up in table; what = "material" / "mesh".
+static int ysc_lookup(YscParser *ps, const YscTable *t, const char *base, size_t stride,
+                      const char *what, int *out)
+{
+    const char *s;
+    size_t n;
+    if (!ysc_token(ps, what, &s, &n)) return 0;
+    int i = ysc_name_find(t, base, stride, s, n, ysc_hash(s, n));
+    if (i < 0) return ysc_fail(ps, s, "unknown %s '%.*s'", what, (int)(n < 32 ? n : 32), s);
+    *out = i;
+    return 1;
+}
+
+// New name token; fails on a duplicate (line_off: offsetof the def's line).
+static int ysc_define(YscParser *ps, const YscTable *t, const char *base, size_t stride, size_t line_off,
+                      const char *what, char name[SCENE_NAME_MAX], uint32_t *hash)
+{
+    const char *s;
+    size_t n;
+    if (!ysc_token(ps, "name", &s, &n)) return 0;
+    if (n == 0) return ysc_fail(ps, ps->tok, "empty %s name", what);
+    const char *q = s;
+    float f;
+    if (obj_parse_float(&q, s + n, &f) && q == s + n) {
+        return ysc_fail(ps, s, "%s name '%.*s' reads as a number", what, (int)n, s);
+    }
+    if (n >= SCENE_NAME_MAX) return ysc_fail(ps, s, "%s name longer than %d characters", what, SCENE_NAME_MAX - 1);
+    if (memchr(s, '\0', n)) return ysc_fail(ps, s, "%s name contains a NUL byte", what);
+    *hash = ysc_hash(s, n);
+    int i = ysc_name_find(t, base, stride, s, n, *hash);
+    if (i >= 0) {
+        int line;
+        memcpy(&line, base + (size_t)i * stride + line_off, sizeof(int));
+        return ysc_fail(ps, s, "%s '%.*s' already defined on line %d", what, (int)n, s, line);
+    }
+    memcpy(name, s, n);
+    name[n] = '\0';
+    return 1;
+}
+
+static int ysc_color(YscParser *ps, const char *what, Vec3 *out) {
+    if (!ysc_vec3(ps, what, out)) return 0;
+    if (out->x < 0.0f || out->y < 0.0f || out->z < 0.0f) return ysc_fail(ps, ps->tok, "%s must be >= 0", what);
+    return 1;
+}
+
+static int ysc_stmt_material(YscParser *ps) {
+    SceneDesc *d = ps->d;
+    SceneMaterialDef md;
+    memset(&md, 0, sizeof(md));
+    uint32_t h;
+    if (!ysc_define(ps, &ps->mat_names, (const char*)d->materials, sizeof(SceneMaterialDef),
+                    offsetof(SceneMaterialDef, line), "material", md.name, &h)) return 0;
+
+    const char *t;
+    size_t n;
+    if (!ysc_token(ps, "material type", &t, &n)) return 0;
+    int type = ysc_material_type(t, n);
+    if (type < 0) {
+        return ysc_fail(ps, t, "unknown material type '%.*s' (lambert, metal, glass, light)", (int)(n < 32 ? n : 32), t);
+    }
+    Vec3 c;
+    float param = 0.0f;
+    int has = 0;
+    if (!ysc_color(ps, "color", &c) || !ysc_number(ps, "parameter", &param, 1, &has) || !ysc_end(ps)) return 0;
+
+    md.mat = (Material){ (MaterialType)type, c, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    if (type == MAT_METAL) {
+        if (has && (param < 0.0f || param > 1.0f)) return ysc_fail(ps, ps->tok, "metal fuzz must be in [0, 1]");
+        md.mat.fuzz = param;
+    } else if (type == MAT_DIELECTRIC) {
+        if (has && !(param > 0.0f)) return ysc_fail(ps, ps->tok, "glass ior must be > 0");
+        md.mat.ref_idx = has ? param : 1.5f;
+    } else if (type == MAT_EMISSIVE) {
+        if (has && param < 0.0f) return ysc_fail(ps, ps->tok, "light strength must be >= 0");
+        md.mat.emission = vec3_scale(c, has ? param : 1.0f);
+    } else if (has) {
+        return ysc_fail(ps, ps->tok, "lambert takes no parameter");
+    }
+    md.line = ps->line;
+
+    if (!ysc_grow((void**)&d->materials, &ps->mat_cap, d->material_count, sizeof(SceneMaterialDef)) ||
+        !ysc_table_insert(&ps->mat_names, h, (uint32_t)d->material_count)) {
+        return ysc_fail(ps, ps->ls, "out of memory");
+    }
+    d->materials[d->material_count++] = md;
+    return 1;
+}
+
+static int ysc_stmt_sphere(YscParser *ps, int light) {
+    SceneDesc *d = ps->d;
+    SceneSphereDef sd;
+    sd.tint = vec3(1.0f, 1.0f, 1.0f);
+    sd.material = 0;
+    if (!ysc_vec3(ps, "center", &sd.center) || !ysc_float(ps, "radius", &sd.radius)) return 0;
+    if (!(sd.radius > 0.0f)) return ysc_fail(ps, ps->tok, "radius must be > 0");
+
+    if (light) {
+        float strength = 1.0f;
+        int has = 0;
+        if (!ysc_color(ps, "light color", &sd.tint) || !ysc_number(ps, "strength", &strength, 1, &has) ||
+            !ysc_end(ps)) return 0;
+        if (strength < 0.0f) return ysc_fail(ps, ps->tok, "light strength must be >= 0");
+        sd.material = ysc_anon_material(ps, MAT_EMISSIVE, strength);
+        if (sd.material < 0) return 0;
+        d->lights++;
+    } else {
+        float x;
+        int num = 0;
+        if (!ysc_number(ps, "material or color", &x, 1, &num)) return 0;
+        if (num) {
+            // scene.txt form: color, then an optional type and parameter
+            float g, b, param = 0.0f;
+            if (!ysc_float(ps, "color", &g) || !ysc_float(ps, "color", &b)) return 0;
+            sd.tint = vec3(x, g, b);
+            if (x < 0.0f || g < 0.0f || b < 0.0f) return ysc_fail(ps, ps->tok, "color must be >= 0");
+            int type = MAT_LAMBERTIAN;
+            const char *t;
+            size_t n;
+            int r = ysc_next(ps, &t, &n);
+            if (r < 0) return 0;
+            if (r > 0) {
+                type = ysc_material_type(t, n);
+                if (type < 0) {
+                    return ysc_fail(ps, t, "unknown material type '%.*s' (lambert, metal, glass, light)",
+                                    (int)(n < 32 ? n : 32), t);
+                }
+                if (!ysc_number(ps, "parameter", &param, 1, NULL) || !ysc_end(ps)) return 0;
+            }
+            // defaults as load_scene()
+            if (type == MAT_LAMBERTIAN) param = 0.0f;
+            if (type == MAT_METAL && param < 0.0f) param = 0.0f;
+            if (type == MAT_DIELECTRIC && param <= 0.0f) param = 1.5f;
+            if (type == MAT_EMISSIVE && param <= 0.0f) param = 1.0f;
+            sd.material = ysc_anon_material(ps, type, param);
+            if (sd.material < 0) return 0;
+        } else {
+            if (!ysc_lookup(ps, &ps->mat_names, (const char*)d->materials, sizeof(SceneMaterialDef),
+                            "material", &sd.material)) return 0;
+            int tinted = 0;
+            if (!ysc_number(ps, "tint", &x, 1, &tinted)) return 0;
+            if (tinted) {
+                float g, b;
+                if (!ysc_float(ps, "tint", &g) || !ysc_float(ps, "tint", &b)) return 0;
+                sd.tint = vec3(x, g, b);
+                if (x < 0.0f || g < 0.0f || b < 0.0f) return ysc_fail(ps, ps->tok, "tint must be >= 0");
+            }
+            if (!ysc_end(ps)) return 0;
+        }
+    }
+
+    if (!ysc_grow((void**)&d->spheres, &ps->sphere_cap, d->sphere_count, sizeof(SceneSphereDef))) {
+        return ysc_fail(ps, ps->ls, "out of memory");
+    }
+    d->spheres[d->sphere_count++] = sd;
+    return 1;
+}
+
+static int ysc_stmt_mesh(YscParser *ps) {
+    SceneDesc *d = ps->d;
+    SceneMeshDef md;
+    memset(&md, 0, sizeof(md));
+    uint32_t h;
+    if (!ysc_define(ps, &ps->mesh_names, (const char*)d->meshes, sizeof(SceneMeshDef),
+                    offsetof(SceneMeshDef, line), "mesh", md.name, &h)) return 0;
+
+    const char *t;
+    size_t n;
+    if (!ysc_token(ps, "path", &t, &n)) return 0;
+    if (n == 0 || memchr(t, '\0', n)) return ysc_fail(ps, t, "bad mesh path");
+    int absolute = t[0] == '/' || t[0] == '\\' || (n > 1 && t[1] == ':');
+    int w = (ps->dir && ps->dir[0] && !absolute)
+          ? snprintf(md.path, sizeof(md.path), "%s/%.*s", ps->dir, (int)n, t)
+          : snprintf(md.path, sizeof(md.path), "%.*s", (int)n, t);
+    if (w < 0 || (size_t)w >= sizeof(md.path)) return ysc_fail(ps, t, "mesh path too long");
+    if (!ysc_end(ps)) return 0;
+    md.line = ps->line;
+
+    if (!ysc_grow((void**)&d->meshes, &ps->mesh_cap, d->mesh_count, sizeof(SceneMeshDef)) ||
+        !ysc_table_insert(&ps->mesh_names, h, (uint32_t)d->mesh_count)) {
+        return ysc_fail(ps, ps->ls, "out of memory");
+    }
+    d->meshes[d->mesh_count++] = md;
+    return 1;
+}
+
+// m = o * m for row-major 3x4 affine transforms
+static void ysc_xform_apply(float m[12], const float o[12]) {
+    float r[12];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r[i * 4 + j] = o[i * 4] * m[j] + o[i * 4 + 1] * m[4 + j] + o[i * 4 + 2] * m[8 + j];
+        }
+        r[i * 4 + 3] += o[i * 4 + 3];
+    }
+    memcpy(m, r, sizeof(r));
+}
+
+static int ysc_stmt_instance(YscParser *ps) {
+    SceneDesc *d = ps->d;
+    SceneInstanceDef in;
+    if (!ysc_lookup(ps, &ps->mesh_names, (const char*)d->meshes, sizeof(SceneMeshDef), "mesh", &in.mesh) ||
+        !ysc_lookup(ps, &ps->mat_names, (const char*)d->materials, sizeof(SceneMaterialDef), "material",
+                    &in.material)) return 0;
+
+    static const float k_identity[12] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0 };
+    memcpy(in.xform, k_identity, sizeof(k_identity));
+    for (;;) {
+        const char *t;
+        size_t n;
+        int r = ysc_next(ps, &t, &n);
+        if (r < 0) return 0;
+        if (r == 0) break;
+
+        float o[12];
+        memcpy(o, k_identity, sizeof(o));
+        if (ysc_is(t, n, "t")) {
+            Vec3 v;
+            if (!ysc_vec3(ps, "translation", &v)) return 0;
+            o[3] = v.x; o[7] = v.y; o[11] = v.z;
+        } else if (ysc_is(t, n, "s")) {
+            float s[3];
+            int more = 0;
+            if (!ysc_float(ps, "scale", &s[0]) || !ysc_number(ps, "scale", &s[1], 1, &more)) return 0;
+            if (more && !ysc_float(ps, "scale", &s[2])) return 0;
+            if (!more) s[1] = s[2] = s[0];
+            if (s[0] == 0.0f || s[1] == 0.0f || s[2] == 0.0f) return ysc_fail(ps, ps->tok, "scale must be non-zero");
+            o[0] = s[0]; o[5] = s[1]; o[10] = s[2];
+        } else if (ysc_is(t, n, "rx") || ysc_is(t, n, "ry") || ysc_is(t, n, "rz")) {
+            float deg;
+            if (!ysc_float(ps, "angle", &deg)) return 0;
+            float a = deg * 0.017453292519943295f, c = cosf(a), s = sinf(a);
+            int ax = t[1] - 'x';                        // rotation plane: the other two axes
+            int u = (ax + 1) % 3, v = (ax + 2) % 3;
+            o[u * 4 + u] = c;  o[u * 4 + v] = -s;
+            o[v * 4 + u] = s;  o[v * 4 + v] = c;
+        } else {
+            return ysc_fail(ps, t, "unknown transform '%.*s' (t, s, rx, ry, rz)", (int)(n < 32 ? n : 32), t);
+        }
+        ysc_xform_apply(in.xform, o);
+    }
+
+    if (!ysc_grow((void**)&d->instances, &ps->inst_cap, d->instance_count, sizeof(SceneInstanceDef))) {
+        return ysc_fail(ps, ps->ls, "out of memory");
+    }
+    d->instances[d->instance_count++] = in;
+    return 1;
+}
+
+static int ysc_stmt_camera(YscParser *ps) {
+    SceneCameraDef *c = &ps->d->camera;
+    SceneCameraDef cam = { 1, vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f), 45.0f };
+    int has = 0;
+    if (!ysc_vec3(ps, "camera position", &cam.from) || !ysc_vec3(ps, "camera target", &cam.at) ||
+        !ysc_number(ps, "vfov", &cam.vfov, 1, &has)) return 0;
+    if (has) {
+        if (!(cam.vfov > 0.0f && cam.vfov < 180.0f)) return ysc_fail(ps, ps->tok, "vfov must be in (0, 180)");
+        float x;
+        int up = 0;
+        if (!ysc_number(ps, "up", &x, 1, &up)) return 0;
+        if (up) {
+            float y, z;
+            if (!ysc_float(ps, "up", &y) || !ysc_float(ps, "up", &z)) return 0;
+            cam.up = vec3(x, y, z);
+            if (x == 0.0f && y == 0.0f && z == 0.0f) return ysc_fail(ps, ps->tok, "up must be non-zero");
+        }
+    }
+    if (!ysc_end(ps)) return 0;
+    if (cam.from.x == cam.at.x && cam.from.y == cam.at.y && cam.from.z == cam.at.z) {
+        return ysc_fail(ps, ps->ls, "camera position and target are the same point");
+    }
+    *c = cam;
+    return 1;
+}
+
+static int ysc_stmt_ground(YscParser *ps) {
+    const char *t;
+    size_t n;
+    if (!ysc_token(ps, "on or off", &t, &n)) return 0;
+    if (ysc_is(t, n, "on") || ysc_is(t, n, "1"))       ps->d->ground = 1;
+    else if (ysc_is(t, n, "off") || ysc_is(t, n, "0")) ps->d->ground = 0;
+    else return ysc_fail(ps, t, "expected on or off, got '%.*s'", (int)(n < 32 ? n : 32), t);
+    return ysc_end(ps);
+}
+
+static int ysc_line(YscParser *ps, const char *ls, const char *le) {
+    ps->ls = ps->p = ls;
+    ps->e = le;
+    ps->line++;
+
+    const char *t;
+    size_t n;
+    int r = ysc_next(ps, &t, &n);
+    if (r <= 0) return r == 0;
+    if (ysc_is(t, n, "sphere"))   return ysc_stmt_sphere(ps, 0);
+    if (ysc_is(t, n, "light"))    return ysc_stmt_sphere(ps, 1);
+    if (ysc_is(t, n, "material")) return ysc_stmt_material(ps);
+    if (ysc_is(t, n, "instance")) return ysc_stmt_instance(ps);
+    if (ysc_is(t, n, "mesh"))     return ysc_stmt_mesh(ps);
+    if (ysc_is(t, n, "camera"))   return ysc_stmt_camera(ps);
+    if (ysc_is(t, n, "ground"))   return ysc_stmt_ground(ps);
+    return ysc_fail(ps, t, "unknown statement '%.*s'", (int)(n < 32 ? n : 32), t);
+}
+
+// Whole lines in [p, e); the last one may lack its newline.
+static int ysc_lines(YscParser *ps, const char *p, const char *e) {
+    while (p < e) {
+        const char *nl = (const char*)memchr(p, '\n', (size_t)(e - p));
+        const char *le = nl ? nl : e;
+        if (!ysc_line(ps, p, le)) return 0;
+        p = nl ? nl + 1 : e;
+    }
+    return 1;
+}
+
+static void ysc_begin(YscParser *ps, SceneDesc *d, const char *dir, SceneError *err) {
+    memset(ps, 0, sizeof(*ps));
+    memset(d, 0, sizeof(*d));
+    if (err) memset(err, 0, sizeof(*err));
+    ps->d = d;
+    ps->dir = dir;
+    ps->err = err;
+}
+
+static int ysc_finish(YscParser *ps, int ok) {
+    free(ps->mat_names.slot);
+    free(ps->mesh_names.slot);
+    free(ps->anon.slot);
+    ps->d->lines = ps->line;
+    if (!ok) scene_desc_free(ps->d);
+    return ok;
+}
+
+int scene_desc_parse(const char *text, size_t len, const char *dir, SceneDesc *out, SceneError *err) {
+    YscParser ps;
+    ysc_begin(&ps, out, dir, err);
+    return ysc_finish(&ps, ysc_lines(&ps, text, text + len));
+}
+
+int scene_desc_load(const char *path, SceneDesc *out, SceneError *err) {
+    SceneError local;
+    if (!err) err = &local;
+    double t0 = ysc_now_ms();
+
+    char dir[512] = "";
+    const char *slash = NULL;
+    for (const char *c = path; *c; ++c) {
+        if (*c == '/' || *c == '\\') slash = c;
+    }
+    if (slash && (size_t)(slash - path) < sizeof(dir)) {
+        memcpy(dir, path, (size_t)(slash - path));
+        dir[slash - path] = '\0';
+        if (!dir[0]) { dir[0] = '/'; dir[1] = '\0'; }
+    }
+
+    YscParser ps;
+    ysc_begin(&ps, out, dir, err);
+    FILE *f = fopen(path, "rb");
+    char *buf = f ? (char*)malloc(YSC_BLOCK) : NULL;
+    if (!buf) {
+        snprintf(err->msg, sizeof(err->msg), f ? "out of memory" : "cannot open file");
+        if (f) fclose(f);
+        printf("[SCENE] %s: %s\n", path, err->msg);
+        return ysc_finish(&ps, 0);
+    }
+
+    // complete lines are parsed as each block arrives; the tail of the
+    // block moves to the front and waits for the rest of its line
+    size_t have = 0;
+    int ok = 1;
+    for (;;) {
+        size_t got = fread(buf + have, 1, YSC_BLOCK - have, f);
+        have += got;
+        if (got == 0) {
+            ok = ysc_lines(&ps, buf, buf + have);
+            break;
+        }
+        size_t cut = have;
+        while (cut > 0 && buf[cut - 1] != '\n') cut--;
+        if (cut == 0) {
+            if (have < YSC_BLOCK) continue;
+            ps.line++;
+            ps.ls = buf;
+            ok = ysc_fail(&ps, buf, "line longer than %u bytes", YSC_BLOCK);
+            break;
+        }
+        if (!(ok = ysc_lines(&ps, buf, buf + cut))) break;
+        memmove(buf, buf + cut, have - cut);
+        have -= cut;
+    }
+    if (ok && ferror(f)) {
+        ok = 0;
+        snprintf(err->msg, sizeof(err->msg), "read error");
+        err->line = err->column = 0;
+    }
+    fclose(f);
+    free(buf);
+
+    if (!ysc_finish(&ps, ok)) {
+        if (err->line > 0) printf("[SCENE] %s:%d:%d: %s\n", path, err->line, err->column, err->msg);
+        else               printf("[SCENE] %s: %s\n", path, err->msg);
+        return 0;
+    }
+    printf("[SCENE] %s: %d lines, %d materials, %d spheres (%d lights), %d meshes, %d instances in %.1f ms\n",
+           path, out->lines, out->material_count, out->sphere_count, out->lights, out->mesh_count,
+           out->instance_count, ysc_now_ms() - t0);
+    return 1;
+}
+
+void scene_desc_free(SceneDesc *d) {
+    if (!d) return;
+    free(d->materials);
+    free(d->spheres);
+    free(d->meshes);
+    free(d->instances);
+    memset(d, 0, sizeof(*d));
+}
@@ -1,17 +1,116 @@
 #ifndef SCENELOADER_H
 #define SCENELOADER_H
 
+#include <stddef.h>
+
 #include "vec3.h"
+#include "material.h"
 
 // Simple data type for scene spheres from editor
 typedef struct {
     Vec3 center;
     float radius;
     Vec3 albedo; // 0–1 color range
+    int   type;    // MaterialType from the optional 9th token (0 = lambert)
+    float param;   // metal fuzz / glass ior / light strength
 } SceneSphere;
 
 // Reads scene.txt, fills up to max_spheres.
 // Returns number of spheres successfully read.
 int load_scene(const char *path, SceneSphere *out, int max_spheres);
 
+// Reads the whole scene.txt into a malloc'd array (no size cap; free() it).
+// Returns number of spheres read, 0 (and *out = NULL) on failure.
+int load_scene_alloc(const char *path, SceneSphere **out);
+
+// scene.txt token for a SceneSphere.type ("lambert", "metal", ...)
+const char *scene_material_name(int type);
+
+// ------------------------- .ysc scene description -------------------------
+// Line-based text, one statement per line, tokens split on blanks ("..."
+// for paths with blanks), # starts a comment. Names are up to 31
+// characters and must be defined before use. Every scene.txt sphere line is
+// also a valid statement.
+//
+//   material NAME lambert|metal|glass|light R G B [PARAM]
+//                 PARAM: metal fuzz (0), glass ior (1.5), light strength (1)
+//   sphere X Y Z RADIUS MATERIAL [R G B]      named material, optional tint
+//   sphere X Y Z RADIUS R G B [TYPE [PARAM]]  scene.txt form
+//   light  X Y Z RADIUS R G B [STRENGTH]      emissive sphere (strength 1)
+//   mesh NAME PATH                            OBJ, relative to the scene file
+//   instance MESH MATERIAL [OP ...]           OP, applied left to right:
+//            t X Y Z | s K | s X Y Z | rx DEG | ry DEG | rz DEG
+//   camera X Y Z  TX TY TZ [VFOV [UX UY UZ]]  look-at, vfov 45, up +Y
+//   ground on|off                             built-in checker ground (off)
+//
+// The parser streams the file in 1 MiB blocks and stops at the first error,
+// reported as line and column.
+
+#define SCENE_NAME_MAX 32
+
+typedef struct {
+    char     name[SCENE_NAME_MAX];  // "" for scene.txt / light materials
+    Material mat;
+    int      line;
+} SceneMaterialDef;
+
+typedef struct {
+    Vec3  center;
+    float radius;
+    Vec3  tint;        // multiplies the material's albedo and emission
+    int   material;    // index into SceneDesc.materials
+} SceneSphereDef;
+
+typedef struct {
+    char name[SCENE_NAME_MAX];
+    char path[512];    // resolved against the scene file's directory
+    int  line;
+} SceneMeshDef;
+
+typedef struct {
+    int   mesh;        // index into SceneDesc.meshes
+    int   material;
+    float xform[12];   // object -> world, row-major 3x4 [R | t]
+} SceneInstanceDef;
+
+typedef struct {
+    int   set;
+    Vec3  from, at, up;
+    float vfov;        // degrees
+} SceneCameraDef;
+
+typedef struct {
+    SceneMaterialDef *materials;
+    int               material_count;
+    SceneSphereDef   *spheres;
+    int               sphere_count;
+    SceneMeshDef     *meshes;
+    int               mesh_count;
+    SceneInstanceDef *instances;
+    int               instance_count;
+    SceneCameraDef    camera;
+    int               ground;
+    int               lights;      // spheres that came from light statements
+    int               lines;
+} SceneDesc;
+
+typedef struct {
+    int  line;         // 1-based; 0 when the file could not be read
+    int  column;       // 1-based
+    char msg[160];
+} SceneError;
+
+// Returns 1 on success. On failure *out is empty and err (optional) holds
+// the first error; the loader also prints it as "path:line:col: msg".
+int  scene_desc_load(const char *path, SceneDesc *out, SceneError *err);
+
+// Same parser over a buffer; mesh paths are resolved against dir (NULL:
+// kept as written). Silent.
+int  scene_desc_parse(const char *text, size_t len, const char *dir, SceneDesc *out, SceneError *err);
+
+void scene_desc_free(SceneDesc *d);
+
+// 1 if path ends in ".ysc".
+int  scene_is_ysc(const char *path);
+
 #endif
@@ -0,0 +1,350 @@
+// tlas.c - instanced triangle meshes: per-mesh BLAS + top-level BVH
+#include "tlas.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "gpu_bvh_build.h"
+
+// ------------------------- setup -------------------------
+void tlas_init(Tlas* tl) {
+    memset(tl, 0, sizeof(*tl));
+}
+
+void tlas_free(Tlas* tl) {
+    if (!tl) return;
+    for (int i = 0; i < tl->blas_count; ++i) {
+        free((void*)tl->blas[i].mesh.nodes);
+        free((void*)tl->blas[i].mesh.indices);
+    }
+    free(tl->blas);
+    free(tl->inst);
+    free(tl->nodes);
+    free(tl->order);
+    memset(tl, 0, sizeof(*tl));
+}
+
+int tlas_add_blas(Tlas* tl, const float* tris, uint32_t tri_count) {
+    if (!tl || !tris || tri_count == 0) return -1;
+    if (tl->blas_count == tl->blas_cap) {
+        int cap = tl->blas_cap ? tl->blas_cap * 2 : 8;
+        TlasBlas* b = (TlasBlas*)realloc(tl->blas, sizeof(TlasBlas) * (size_t)cap);
+        if (!b) return -1;
+        tl->blas = b;
+        tl->blas_cap = cap;
+    }
+
+    GPUBVHNode* nodes = NULL;
+    int32_t* indices = NULL;
+    uint32_t node_count = 0, index_count = 0;
+    GpuBvhBuildCtx ctx;
+    gpu_bvh_build_ctx_init(&ctx);
+    int ok = gpu_bvh_build_ctx_run(&ctx, tris, tri_count, &nodes, &node_count, &indices, &index_count);
+    gpu_bvh_build_ctx_free(&ctx);
+    if (!ok) return -1;
+
+    TlasBlas* b = &tl->blas[tl->blas_count];
+    b->mesh.nodes      = nodes;
+    b->mesh.node_count = node_count;
+    b->mesh.indices    = indices;
+    b->mesh.tris       = tris;
+    b->tri_count       = tri_count;
+    for (int a = 0; a < 3; ++a) {
+        b->bmin[a] = nodes[0].bmin[a];
+        b->bmax[a] = nodes[0].bmax[a];
+    }
+    return tl->blas_count++;
+}
+
+// ------------------------- transforms -------------------------
+void tlas_xform_trs(float out[12], Vec3 t, float yaw_rad, float scale) {
+    float c = cosf(yaw_rad) * scale, s = sinf(yaw_rad) * scale;
+    out[0] =  c;    out[1] = 0.0f;  out[2]  = s;    out[3]  = t.x;
+    out[4] = 0.0f;  out[5] = scale; out[6]  = 0.0f; out[7]  = t.y;
+    out[8] = -s;    out[9] = 0.0f;  out[10] = c;    out[11] = t.z;
+}
+
+// [A | t]^-1 = [A^-1 | -A^-1 t]; 0 if A is singular
+static int xform_invert(const float m[12], float inv[12]) {
+    float a = m[0], b = m[1], c = m[2];
+    float d = m[4], e = m[5], f = m[6];
+    float g = m[8], h = m[9], i = m[10];
+    float A = e * i - f * h, B = f * g - d * i, C = d * h - e * g;
+    float det = a * A + b * B + c * C;
+    if (!(fabsf(det) > 1e-20f)) return 0;
+    float id = 1.0f / det;
+
+    inv[0] = A * id;  inv[1] = (c * h - b * i) * id;  inv[2]  = (b * f - c * e) * id;
+    inv[4] = B * id;  inv[5] = (a * i - c * g) * id;  inv[6]  = (c * d - a * f) * id;
+    inv[8] = C * id;  inv[9] = (b * g - a * h) * id;  inv[10] = (a * e - b * d) * id;
+    for (int r = 0; r < 3; ++r) {
+        const float* row = inv + 4 * r;
+        inv[4 * r + 3] = -(row[0] * m[3] + row[1] * m[7] + row[2] * m[11]);
+    }
+    return 1;
+}
+
+// world box of the transformed object box (Arvo): per output axis, pick the
+// smaller / larger product per input axis
+static void instance_bounds(const Tlas* tl, TlasInstance* in) {
+    const TlasBlas* b = &tl->blas[in->blas];
+    for (int r = 0; r < 3; ++r) {
+        const float* row = in->xform + 4 * r;
+        float lo = row[3], hi = row[3];
+        for (int k = 0; k < 3; ++k) {
+            float p = row[k] * b->bmin[k];
+            float q = row[k] * b->bmax[k];
+            lo += (p < q) ? p : q;
+            hi += (p < q) ? q : p;
+        }
+        in->bmin[r] = lo;
+        in->bmax[r] = hi;
+    }
+}
+
+int tlas_add_instance(Tlas* tl, uint32_t blas, const float xform[12], uint32_t user_id) {
+    if (!tl || blas >= (uint32_t)tl->blas_count) return -1;
+    if (tl->inst_count == tl->inst_cap) {
+        int cap = tl->inst_cap ? tl->inst_cap * 2 : 64;
+        TlasInstance* p = (TlasInstance*)realloc(tl->inst, sizeof(TlasInstance) * (size_t)cap);
+        if (!p) return -1;
+        tl->inst = p;
+        tl->inst_cap = cap;
+    }
+    TlasInstance* in = &tl->inst[tl->inst_count];
+    memcpy(in->xform, xform, sizeof(in->xform));
+    if (!xform_invert(in->xform, in->inv)) return -1;
+    in->blas = blas;
+    in->user_id = user_id;
+    instance_bounds(tl, in);
+    tl->dirty = 1;
+    return tl->inst_count++;
+}
+
+int tlas_set_transform(Tlas* tl, uint32_t inst, const float xform[12]) {
+    if (!tl || inst >= (uint32_t)tl->inst_count) return 0;
+    TlasInstance* in = &tl->inst[inst];
+    float inv[12];
+    if (!xform_invert(xform, inv)) return 0;
+    memcpy(in->xform, xform, sizeof(in->xform));
+    memcpy(in->inv, inv, sizeof(in->inv));
+    instance_bounds(tl, in);
+    tl->dirty = 1;
+    return 1;
+}
+
+// ------------------------- top-level build -------------------------
+#define TLAS_LEAF_MAX 2
+
+static inline float inst_center(const TlasInstance* in, int axis) {
+    return in->bmin[axis] + in->bmax[axis];   // 2x centroid, only compared
+}
+
+// nth_element on order[start,end) by instance center along axis (three-way
+// partition, as in gpu_bvh_build.c)
+static void tlas_select_nth(const TlasInstance* inst, int32_t* order, uint32_t start, uint32_t end,
+                            uint32_t k, int axis)
+{
+    while (end - start > 1) {
+        uint32_t m = start + (end - start) / 2;
+        float a = inst_center(&inst[order[start]], axis);
+        float b = inst_center(&inst[order[m]], axis);
+        float c = inst_center(&inst[order[end - 1]], axis);
+        float p = (a < b) ? ((b < c) ? b : (a < c) ? c : a)
+                          : ((a < c) ? a : (b < c) ? c : b);
+        uint32_t lt = start, i = start, gt = end;
+        while (i < gt) {
+            float v = inst_center(&inst[order[i]], axis);
+            if (v < p)      { int32_t t = order[lt]; order[lt++] = order[i]; order[i++] = t; }
+            else if (v > p) { int32_t t = order[--gt]; order[gt] = order[i]; order[i] = t; }
+            else i++;
+        }
+        if (k < lt) end = lt;
+        else if (k >= gt) start = gt;
+        else return;
+    }
+}
+
+static uint32_t tlas_build_node(Tlas* tl, uint32_t start, uint32_t end) {
+    uint32_t my = tl->node_count++;
+    GPUBVHNode* n = &tl->nodes[my];
+    float cmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, cmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int a = 0; a < 3; ++a) { n->bmin[a] = FLT_MAX; n->bmax[a] = -FLT_MAX; }
+    n->bmin[3] = n->bmax[3] = 0.0f;
+    for (uint32_t i = start; i < end; ++i) {
+        const TlasInstance* in = &tl->inst[tl->order[i]];
+        for (int a = 0; a < 3; ++a) {
+            n->bmin[a] = fminf(n->bmin[a], in->bmin[a]);
+            n->bmax[a] = fmaxf(n->bmax[a], in->bmax[a]);
+            float c = inst_center(in, a);
+            cmin[a] = fminf(cmin[a], c);
+            cmax[a] = fmaxf(cmax[a], c);
+        }
+    }
+    n->left = n->right = -1;
+    n->triOffset = (int32_t)start;
+    n->triCount  = (int32_t)(end - start);
+    if (end - start <= TLAS_LEAF_MAX) return my;
+
+    int axis = 0;
+    float ext[3] = { cmax[0] - cmin[0], cmax[1] - cmin[1], cmax[2] - cmin[2] };
+    if (ext[1] > ext[axis]) axis = 1;
+    if (ext[2] > ext[axis]) axis = 2;
+    uint32_t mid = start + (end - start) / 2;
+    tlas_select_nth(tl->inst, tl->order, start, end, mid, axis);
+
+    uint32_t L = tlas_build_node(tl, start, mid);
+    uint32_t R = tlas_build_node(tl, mid, end);
+    n = &tl->nodes[my];
+    n->left = (int32_t)L;
+    n->right = (int32_t)R;
+    n->triOffset = -1;
+    n->triCount = 0;
+    return my;
+}
+
+int tlas_build(Tlas* tl) {
+    if (!tl) return 0;
+    free(tl->nodes);
+    free(tl->order);
+    tl->nodes = NULL;
+    tl->order = NULL;
+    tl->node_count = 0;
+    tl->dirty = 0;
+    if (tl->inst_count == 0) return 1;
+
+    uint32_t n = (uint32_t)tl->inst_count;
+    tl->nodes = (GPUBVHNode*)malloc(sizeof(GPUBVHNode) * 2u * (size_t)n);
+    tl->order = (int32_t*)malloc(sizeof(int32_t) * (size_t)n);
+    if (!tl->nodes || !tl->order) {
+        free(tl->nodes); free(tl->order);
+        tl->nodes = NULL; tl->order = NULL;
+        tl->dirty = 1;
+        return 0;
+    }
+    for (uint32_t i = 0; i < n; ++i) tl->order[i] = (int32_t)i;
+    (void)tlas_build_node(tl, 0, n);
+    return 1;
+}
+
+// ------------------------- traversal -------------------------
+static inline float tlas_enter(const float* bmin, const float* bmax, const float o[3], const float inv_d[3],
+                               float t_min, float t_max)
+{
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (bmin[i] - o[i]) * inv_d[i];
+        float t1 = (bmax[i] - o[i]) * inv_d[i];
+        if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+        if (t0 > t_min) t_min = t0;
+        if (t1 < t_max) t_max = t1;
+        if (t_max < t_min) return FLT_MAX;
+    }
+    return t_min;
+}
+
+static inline Ray instance_ray(const TlasInstance* in, const Ray* r) {
+    const float* m = in->inv;
+    Vec3 o = r->origin, d = r->direction;
+    Ray lr = *r;
+    lr.origin    = vec3(m[0] * o.x + m[1] * o.y + m[2]  * o.z + m[3],
+                        m[4] * o.x + m[5] * o.y + m[6]  * o.z + m[7],
+                        m[8] * o.x + m[9] * o.y + m[10] * o.z + m[11]);
+    lr.direction = vec3(m[0] * d.x + m[1] * d.y + m[2]  * d.z,
+                        m[4] * d.x + m[5] * d.y + m[6]  * d.z,
+                        m[8] * d.x + m[9] * d.y + m[10] * d.z);
+    return lr;
+}
+
+// Shared by the closest and any-hit queries; returns 1 on a hit.
+static int tlas_trace(const Tlas* tl, const Ray* r, float t_min, float t_max, int any_hit, TlasHit* out) {
+    if (!tl->nodes || tl->node_count == 0) return 0;
+    const float o[3]     = { r->origin.x, r->origin.y, r->origin.z };
+    const float inv_d[3] = { 1.0f / r->direction.x, 1.0f / r->direction.y, 1.0f / r->direction.z };
+
+    int32_t stack[BVH_STACK_MAX];
+    float stack_t[BVH_STACK_MAX];
+    int sp = 0;
+    float closest = t_max;
+    int32_t hit_inst = -1, hit_prim = -1;
+
+    float t_root = tlas_enter(tl->nodes[0].bmin, tl->nodes[0].bmax, o, inv_d, t_min, closest);
+    if (t_root == FLT_MAX) return 0;
+    stack[sp] = 0;
+    stack_t[sp++] = t_root;
+
+    while (sp > 0) {
+        --sp;
+        if (stack_t[sp] > closest) continue;
+        int32_t ni = stack[sp];
+
+        for (;;) {
+            const GPUBVHNode* node = &tl->nodes[ni];
+            if (node->left < 0) {
+                for (int32_t k = 0; k < node->triCount; ++k) {
+                    int32_t ii = tl->order[node->triOffset + k];
+                    const TlasInstance* in = &tl->inst[ii];
+                    if (tlas_enter(in->bmin, in->bmax, o, inv_d, t_min, closest) == FLT_MAX) continue;
+
+                    // instance boundary: object-space ray, same t
+                    Ray lr = instance_ray(in, r);
+                    int prim = -1;
+                    bvh_tri_hit_subtree(&tl->blas[in->blas].mesh, 0, &lr, t_min, &closest, &prim, any_hit);
+                    if (prim >= 0) {
+                        hit_inst = ii;
+                        hit_prim = prim;
+                        if (any_hit) goto done;
+                    }
+                }
+                break;
+            }
+
+            int32_t li = node->left, ri = node->right;
+            float tL = tlas_enter(tl->nodes[li].bmin, tl->nodes[li].bmax, o, inv_d, t_min, closest);
+            float tR = tlas_enter(tl->nodes[ri].bmin, tl->nodes[ri].bmax, o, inv_d, t_min, closest);
+            if (tR < tL) {
+                int32_t ti = li; li = ri; ri = ti;
+                float tt = tL; tL = tR; tR = tt;
+            }
+            if (tL == FLT_MAX) break;
+            if (tR != FLT_MAX && sp < BVH_STACK_MAX) { stack[sp] = ri; stack_t[sp++] = tR; }
+            ni = li;
+        }
+    }
+
+done:
+    if (hit_inst < 0) return 0;
+    if (out) {
+        out->t = closest;
+        out->inst = hit_inst;
+        out->prim = hit_prim;
+    }
+    return 1;
+}
+
+int tlas_hit_closest(const Tlas* tl, const Ray* r, float t_min, float t_max, TlasHit* out) {
+    if (out) { out->t = t_max; out->inst = -1; out->prim = -1; }
+    if (!tl) return 0;
+    return tlas_trace(tl, r, t_min, t_max, 0, out);
+}
+
+int tlas_occluded(const Tlas* tl, const Ray* r, float t_min, float t_max) {
+    if (!tl) return 0;
+    return tlas_trace(tl, r, t_min, t_max, 1, NULL);
+}
+
+Vec3 tlas_hit_normal(const Tlas* tl, const TlasHit* h) {
+    const TlasInstance* in = &tl->inst[h->inst];
+    const float* v = tl->blas[in->blas].mesh.tris + (size_t)h->prim * 12u;
+    Vec3 e1 = vec3(v[4] - v[0], v[5] - v[1], v[6]  - v[2]);
+    Vec3 e2 = vec3(v[8] - v[0], v[9] - v[1], v[10] - v[2]);
+    Vec3 n = vec3_cross(e1, e2);
+
+    // normals go by the inverse transpose: n_w[i] = sum_j inv[j][i] * n[j]
+    const float* m = in->inv;
+    Vec3 w = vec3(m[0] * n.x + m[4] * n.y + m[8]  * n.z,
+                  m[1] * n.x + m[5] * n.y + m[9]  * n.z,
+                  m[2] * n.x + m[6] * n.y + m[10] * n.z);
+    return vec3_normalize(w);
+}
@@ -0,0 +1,318 @@
+// ysu_anim.c - camera paths + pipelined batch renderer
+//
+// The render thread owns the pool; finished frames go through a small
+// FIFO to writer threads (tonemap -> PNG encode -> disk) so frame N+1 is
+// already rendering while frame N is being written. `in_flight`
+// framebuffers circulate between the two sides; the renderer only stalls
+// when every buffer is still queued for writing.
+
+#include "ysu_anim.h"
+#include "render.h"
+#include "image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+static double anim_now_ms(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    static int inited = 0;
+    if (!inited) { QueryPerformanceFrequency(&freq); inited = 1; }
+    LARGE_INTEGER c; QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+// ------------------------- Camera path -------------------------
+int ysu_campath_load(const char *path, YSU_CamKey **out) {
+    *out = NULL;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("[ANIM] could not open camera path '%s'\n", path);
+        return 0;
+    }
+
+    int count = 0, cap = 0;
+    YSU_CamKey *keys = NULL;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        double v[7];
+        int n = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]);
+        if (n < 6) continue;
+
+        if (count == cap) {
+            int ncap = cap ? cap * 2 : 16;
+            YSU_CamKey *nk = (YSU_CamKey*)realloc(keys, sizeof(YSU_CamKey) * (size_t)ncap);
+            if (!nk) break;
+            keys = nk;
+            cap = ncap;
+        }
+        YSU_CamKey *k = &keys[count++];
+        k->from = vec3((float)v[0], (float)v[1], (float)v[2]);
+        k->at   = vec3((float)v[3], (float)v[4], (float)v[5]);
+        k->vfov = (n >= 7 && v[6] > 0.0 && v[6] < 180.0) ? (float)v[6] : 90.0f;
+    }
+    fclose(f);
+
+    if (count == 0) {
+        free(keys);
+        return 0;
+    }
+    *out = keys;
+    return count;
+}
+
+static Vec3 catmull_rom(Vec3 p0, Vec3 p1, Vec3 p2, Vec3 p3, float u) {
+    float u2 = u * u, u3 = u2 * u;
+    Vec3 a = vec3_scale(p1, 2.0f);
+    Vec3 b = vec3_scale(vec3_sub(p2, p0), u);
+    Vec3 c = vec3_scale(vec3_add(vec3_sub(vec3_scale(p0, 2.0f), vec3_scale(p1, 5.0f)),
+                                 vec3_sub(vec3_scale(p2, 4.0f), p3)), u2);
+    Vec3 d = vec3_scale(vec3_add(vec3_sub(vec3_scale(p1, 3.0f), p0),
+                                 vec3_sub(p3, vec3_scale(p2, 3.0f))), u3);
+    return vec3_scale(vec3_add(vec3_add(a, b), vec3_add(c, d)), 0.5f);
+}
+
+Camera ysu_campath_eval(const YSU_CamKey *keys, int count, float t, float aspect_ratio) {
+    if (count <= 1) {
+        YSU_CamKey k = (count == 1) ? keys[0]
+                     : (YSU_CamKey){ {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, 90.0f };
+        return camera_look_at(k.from, k.at, vec3(0.0f, 1.0f, 0.0f), k.vfov, aspect_ratio);
+    }
+
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float s = t * (float)(count - 1);
+    int i = (int)s;
+    if (i > count - 2) i = count - 2;
+    float u = s - (float)i;
+
+    // end keys repeat so the curve starts and stops on them
+    const YSU_CamKey *k0 = &keys[(i > 0) ? i - 1 : 0];
+    const YSU_CamKey *k1 = &keys[i];
+    const YSU_CamKey *k2 = &keys[i + 1];
+    const YSU_CamKey *k3 = &keys[(i + 2 < count) ? i + 2 : count - 1];
+
+    Vec3 from = catmull_rom(k0->from, k1->from, k2->from, k3->from, u);
+    Vec3 at   = catmull_rom(k0->at,   k1->at,   k2->at,   k3->at,   u);
+    float vfov = k1->vfov + (k2->vfov - k1->vfov) * u;
+    return camera_look_at(from, at, vec3(0.0f, 1.0f, 0.0f), vfov, aspect_ratio);
+}
+
+// ------------------------- Writer pipeline -------------------------
+typedef struct {
+    Vec3 *pixels;
+    int   frame;
+} AnimSlot;
+
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cv;      // broadcast on every queue change
+
+    AnimSlot *slots;
+    int  nslots;
+    int *free_q;   int free_n;                      // LIFO of idle slots
+    int *ready_q;  int ready_head, ready_n;         // FIFO of rendered slots
+    int  closed;                                    // no more frames coming
+
+    int width, height;
+    const char *pattern;
+
+    // writer-side totals (under mtx)
+    double tonemap_ms, write_ms;
+    int written, failed;
+} AnimPipe;
+
+// Accepts exactly one %d conversion (flags/width allowed) and no other '%'.
+static int anim_pattern_ok(const char *p) {
+    int convs = 0;
+    for (const char *c = p; *c; ++c) {
+        if (*c != '%') continue;
+        ++c;
+        while (*c == '0' || *c == '-' || isdigit((unsigned char)*c)) ++c;
+        if (*c != 'd') return 0;
+        convs++;
+    }
+    return convs == 1;
+}
+
+static void *anim_writer(void *arg) {
+    AnimPipe *p = (AnimPipe*)arg;
+    char name[1024];
+
+    for (;;) {
+        pthread_mutex_lock(&p->mtx);
+        while (p->ready_n == 0 && !p->closed) pthread_cond_wait(&p->cv, &p->mtx);
+        if (p->ready_n == 0) {
+            pthread_mutex_unlock(&p->mtx);
+            return NULL;
+        }
+        int slot = p->ready_q[p->ready_head];
+        p->ready_head = (p->ready_head + 1) % p->nslots;
+        p->ready_n--;
+        pthread_mutex_unlock(&p->mtx);
+
+        AnimSlot *s = &p->slots[slot];
+        double t0 = anim_now_ms();
+        unsigned char *rgb8 = image_rgb_from_hdr(s->pixels, p->width, p->height);
+        double t1 = anim_now_ms();
+        if (rgb8) {
+            snprintf(name, sizeof(name), p->pattern, s->frame);
+            image_write_png(name, p->width, p->height, rgb8);
+            free(rgb8);
+        }
+        double t2 = anim_now_ms();
+
+        pthread_mutex_lock(&p->mtx);
+        p->tonemap_ms += t1 - t0;
+        p->write_ms   += t2 - t1;
+        if (rgb8) p->written++;
+        else      p->failed++;
+        p->free_q[p->free_n++] = slot;
+        pthread_cond_broadcast(&p->cv);
+        pthread_mutex_unlock(&p->mtx);
+    }
+}
+
+int ysu_render_campath(const YSU_CamKey *keys, int count, const YSU_AnimOpts *opts) {
+    if (!keys || count <= 0 || !opts || opts->width <= 0 || opts->height <= 0) return 0;
+
+    int frames  = (opts->frames > 0) ? opts->frames : count;
+    int writers = (opts->writers > 0) ? opts->writers : 2;
+    int nslots  = (opts->in_flight > 0) ? opts->in_flight : writers + 1;
+    if (nslots > frames) nslots = frames;
+    if (nslots < 1) nslots = 1;
+
+    const char *pattern = opts->out_pattern;
+    if (!pattern || !anim_pattern_ok(pattern)) {
+        if (pattern) printf("[ANIM] output pattern '%s' needs exactly one %%d, using default\n", pattern);
+        pattern = "frame_%04d.png";
+    }
+
+    AnimPipe p;
+    memset(&p, 0, sizeof(p));
+    p.nslots  = nslots;
+    p.width   = opts->width;
+    p.height  = opts->height;
+    p.pattern = pattern;
+    p.slots   = (AnimSlot*)calloc((size_t)nslots, sizeof(AnimSlot));
+    p.free_q  = (int*)malloc(sizeof(int) * (size_t)nslots);
+    p.ready_q = (int*)malloc(sizeof(int) * (size_t)nslots);
+    pthread_t *thr = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)writers);
+    int ok = p.slots && p.free_q && p.ready_q && thr;
+    for (int i = 0; ok && i < nslots; ++i) {
+        p.slots[i].pixels = render_alloc_framebuffer(p.width, p.height, opts->threads, opts->tile);
+        if (!p.slots[i].pixels) ok = 0;
+        p.free_q[p.free_n++] = i;
+    }
+    if (!ok) {
+        printf("[ANIM] out of memory for %d framebuffers (%dx%d)\n", nslots, p.width, p.height);
+        for (int i = 0; p.slots && i < nslots; ++i) render_free_framebuffer(p.slots[i].pixels);
+        free(p.slots); free(p.free_q); free(p.ready_q); free(thr);
+        return 0;
+    }
+
+    pthread_mutex_init(&p.mtx, NULL);
+    pthread_cond_init(&p.cv, NULL);
+    int started = 0;
+    for (; started < writers; ++started) {
+        if (pthread_create(&thr[started], NULL, anim_writer, &p) != 0) break;
+    }
+
+    printf("[ANIM] %d frames from %d keys, %dx%d spp=%d, %d writers, %d buffers -> %s\n",
+           frames, count, p.width, p.height, opts->spp, started, nslots, pattern);
+
+    float aspect = (float)p.width / (float)p.height;
+    double render_ms = 0.0, post_ms = 0.0, stall_ms = 0.0;
+    double t_start = anim_now_ms();
+
+    for (int f = 0; f < frames; ++f) {
+        double t0 = anim_now_ms();
+        pthread_mutex_lock(&p.mtx);
+        while (p.free_n == 0) pthread_cond_wait(&p.cv, &p.mtx);
+        int slot = p.free_q[--p.free_n];
+        pthread_mutex_unlock(&p.mtx);
+        double t1 = anim_now_ms();
+
+        float t = (frames > 1) ? (float)f / (float)(frames - 1) : 0.0f;
+        Camera cam = ysu_campath_eval(keys, count, t, aspect);
+        AnimSlot *s = &p.slots[slot];
+        s->frame = f;
+        render_scene_mt(s->pixels, p.width, p.height, cam, opts->spp, opts->depth,
+                        opts->threads, opts->tile);
+        double t2 = anim_now_ms();
+        if (opts->post) opts->post(s->pixels, p.width, p.height);
+        double t3 = anim_now_ms();
+
+        stall_ms  += t1 - t0;
+        render_ms += t2 - t1;
+        post_ms   += t3 - t2;
+        printf("[ANIM] frame %d/%d rendered in %.1f ms\n", f + 1, frames, t2 - t1);
+
+        if (started == 0) {
+            // no writer threads: write inline
+            char name[1024];
+            double w0 = anim_now_ms();
+            unsigned char *rgb8 = image_rgb_from_hdr(s->pixels, p.width, p.height);
+            double w1 = anim_now_ms();
+            if (rgb8) {
+                snprintf(name, sizeof(name), pattern, f);
+                image_write_png(name, p.width, p.height, rgb8);
+                free(rgb8);
+                p.written++;
+            } else {
+                p.failed++;
+            }
+            p.tonemap_ms += w1 - w0;
+            p.write_ms   += anim_now_ms() - w1;
+            p.free_q[p.free_n++] = slot;
+            continue;
+        }
+
+        pthread_mutex_lock(&p.mtx);
+        p.ready_q[(p.ready_head + p.ready_n) % nslots] = slot;
+        p.ready_n++;
+        pthread_cond_broadcast(&p.cv);
+        pthread_mutex_unlock(&p.mtx);
+    }
+
+    double t_drain = anim_now_ms();
+    pthread_mutex_lock(&p.mtx);
+    p.closed = 1;
+    pthread_cond_broadcast(&p.cv);
+    pthread_mutex_unlock(&p.mtx);
+    for (int i = 0; i < started; ++i) pthread_join(thr[i], NULL);
+    double t_end = anim_now_ms();
+
+    double wall = t_end - t_start;
+    double n = (double)frames;
+    printf("[ANIM] frames=%d written=%d failed=%d wall=%.2f s  %.1f frames/hour\n",
+           frames, p.written, p.failed, wall * 1e-3, (wall > 0.0) ? n * 3.6e6 / wall : 0.0);
+    printf("[ANIM] per frame: render=%.1f ms post=%.1f ms tonemap=%.1f ms encode+write=%.1f ms stall=%.1f ms\n",
+           render_ms / n, post_ms / n, p.tonemap_ms / n, p.write_ms / n, stall_ms / n);
+    printf("[ANIM] final drain=%.1f ms  overlap=%.2fx (stage time / wall time)\n",
+           t_end - t_drain,
+           (wall > 0.0) ? (render_ms + post_ms + p.tonemap_ms + p.write_ms) / wall : 0.0);
+
+    pthread_mutex_destroy(&p.mtx);
+    pthread_cond_destroy(&p.cv);
+    for (int i = 0; i < nslots; ++i) render_free_framebuffer(p.slots[i].pixels);
+    free(p.slots); free(p.free_q); free(p.ready_q); free(thr);
+    return p.written;
+}
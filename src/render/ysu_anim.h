@@ -0,0 +1,63 @@
+// ysu_anim.h - camera-path batch rendering
+#ifndef YSU_ANIM_H
+#define YSU_ANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vec3.h"
+#include "camera.h"
+
+/**
+ * Camera path key. Path files hold one key per line:
+ *   from_x from_y from_z  at_x at_y at_z  [vfov_deg]
+ * '#' starts a comment; vfov defaults to 90 (the camera_create() look).
+ */
+typedef struct {
+    Vec3  from;
+    Vec3  at;
+    float vfov;
+} YSU_CamKey;
+
+/**
+ * Loads a camera path file. *out is malloc'd (free with free()).
+ * Returns the number of keys, 0 on error / empty file.
+ */
+int ysu_campath_load(const char *path, YSU_CamKey **out);
+
+/**
+ * Camera at t in [0,1] along the path: Catmull-Rom through the from/at
+ * positions (passes through every key), linear vfov. Up is +Y.
+ */
+Camera ysu_campath_eval(const YSU_CamKey *keys, int count, float t, float aspect_ratio);
+
+/**
+ * Batch options. Frames render on the calling thread through
+ * render_scene_mt(); tonemap, PNG encode and the disk write of earlier
+ * frames run on `writers` background threads meanwhile.
+ */
+typedef struct {
+    int width, height;
+    int spp, depth;
+    int threads, tile;     // as for render_scene_mt (<= 0 = auto)
+    int frames;            // <= 0: one frame per key
+    int writers;           // background writer threads (default 2)
+    int in_flight;         // framebuffers in flight (default writers + 1)
+    const char *out_pattern;   // one %d (optionally %04d); default "frame_%04d.png"
+    // optional per-frame hook on the render thread (e.g. denoise)
+    void (*post)(Vec3 *pixels, int width, int height);
+} YSU_AnimOpts;
+
+/**
+ * Renders opts->frames frames along the path and writes one PNG each.
+ * Prints per-stage timing and frames/hour ("[ANIM]").
+ * Returns the number of frames written.
+ */
+int ysu_render_campath(const YSU_CamKey *keys, int count, const YSU_AnimOpts *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // YSU_ANIM_H
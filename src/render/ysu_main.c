@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <float.h>
+#include <math.h>
+#include <string.h>
 
 // Core
 #include "vec3.h"
@@ -20,13 +22,19 @@ void ysu_nerf_shutdown(void);
 
 // BVH baseline (CPU)
 #include "bvh.h"
+#include "bvh_wide.h"
+#include "bvh_policy.h"
 #include "sphere.h"
 
 // Scene loader
 #include "sceneloader.h"
+#include "obj_load.h"
 
-// 360 render prototype (no header)
-void ysu_render_360(const Camera *cam, const char *out_ppm);
+// Camera-path batch renderer
+#include "ysu_anim.h"
+
+// 360 render (equirect / cubemap on the render pool)
+#include "ysu_360.h"
 
 // BVH counters (bvh.c)
 extern uint64_t g_bvh_node_visits;
@@ -41,11 +49,108 @@ static int env_int(const char *name, int defv) {
     return atoi(s);
 }
 
+#ifdef _WIN32
+  #include <windows.h>
+static double main_now_ms(void) {
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+}
+#else
+  #include <time.h>
+static double main_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+#endif
+
 static void print_cfg(int w, int h, int spp, int depth, int threads, int tile) {
     printf("[main] CFG: W=%d H=%d SPP=%d DEPTH=%d THREADS=%d TILE=%d\n",
            w, h, spp, depth, threads, tile);
 }
 
+// -------------------------
+// Progressive render (YSU_PROGRESSIVE=1)
+//   YSU_PASS_SPP        samples added per pass (default 8)
+//   YSU_TIME_BUDGET_MS  stop after this much wall time (0 = run to YSU_SPP)
+//   YSU_CHECKPOINT      save accumulation state here every YSU_CHECKPOINT_MS
+//   YSU_RESUME          continue from a previous checkpoint
+// -------------------------
+static void ysu_render_progressive(Vec3 *pixels, int w, int h, Camera cam,
+                                   int spp, int depth, int threads, int tile)
+{
+    const char *resume = getenv("YSU_RESUME");
+    const char *ckpt   = getenv("YSU_CHECKPOINT");
+    int pass_spp       = env_int("YSU_PASS_SPP", 8);
+    double budget_ms   = (double)env_int("YSU_TIME_BUDGET_MS", 0);
+    double ckpt_ms     = (double)env_int("YSU_CHECKPOINT_MS", 10000);
+    if (pass_spp < 1) pass_spp = 1;
+    if (ckpt_ms < 1.0) ckpt_ms = 1.0;
+
+    YSU_Accum acc;
+    int have = 0;
+    if (resume && resume[0]) {
+        have = ysu_accum_load(&acc, resume);
+        if (have && (acc.width != w || acc.height != h)) {
+            printf("[main] resume: %s is %dx%d, expected %dx%d; starting over\n",
+                   resume, acc.width, acc.height, w, h);
+            ysu_accum_free(&acc);
+            have = 0;
+        } else if (have) {
+            printf("[main] resume: %s (passes=%u samples=%llu)\n",
+                   resume, acc.passes, (unsigned long long)acc.total_samples);
+        } else {
+            printf("[main] resume: could not load %s; starting over\n", resume);
+        }
+    }
+    if (!have) {
+        uint32_t seed = (uint32_t)env_int("YSU_SEED", 1337);
+        if (!ysu_accum_init(&acc, w, h, seed, (uint32_t)spp)) {
+            printf("[main] ERROR: could not allocate accumulation buffers\n");
+            return;
+        }
+    }
+    acc.spp_max = (uint32_t)spp; // YSU_SPP may be raised when resuming
+
+    // Without a budget run to completion; either way slice the work so a
+    // checkpoint is written every ckpt_ms.
+    double spent = 0.0;
+    for (;;) {
+        double slice = ckpt ? ckpt_ms : 0.0;
+        if (budget_ms > 0.0) {
+            double left = budget_ms - spent;
+            if (left <= 0.0) break;
+            if (slice <= 0.0 || left < slice) slice = left;
+        }
+
+        double el = 0.0;
+        uint64_t added = 0;
+        if (slice > 0.0) {
+            added = render_scene_progressive_timed(&acc, cam, slice, pass_spp,
+                                                   depth, threads, tile, &el);
+        } else {
+            added = render_scene_progressive(&acc, cam, pass_spp, depth, threads, tile);
+        }
+        spent += el;
+
+        if (ckpt && ckpt[0]) {
+            if (ysu_accum_save(&acc, ckpt)) printf("[main] checkpoint: %s (passes=%u)\n", ckpt, acc.passes);
+            else printf("[main] checkpoint: failed to write %s\n", ckpt);
+        }
+        if (added == 0) break;
+    }
+
+    double px = (double)w * (double)h;
+    printf("[main] progressive: passes=%u samples=%llu avg_spp=%.2f\n",
+           acc.passes, (unsigned long long)acc.total_samples,
+           (px > 0.0) ? (double)acc.total_samples / px : 0.0);
+
+    ysu_accum_resolve(&acc, pixels);
+    ysu_accum_free(&acc);
+}
+
 // -------------------------
 // deterministic RNG (xorshift32) for baseline (legacy; baseline now comes from scene.txt)
 // -------------------------
@@ -62,6 +167,62 @@ static inline float frand01(uint32_t *s) {
     return (xs32(s) >> 8) * (1.0f / 16777216.0f);
 }
 
+// -------------------------
+// BVH baseline: closest-hit throughput of the traversal layouts on the
+// baseline rays: recursive bvh_hit (the counting pass), flattened binary,
+// BVH4 (SSE) and BVH8 (AVX2 when available). Best of 3 per layout.
+// -------------------------
+static volatile int g_bvh_baseline_sink;   // keeps the timed loops observable
+
+static double bvh_baseline_mrays(int kind, const bvh_node *root, const BvhFlat *flat,
+                                 const BvhWide *wide, const Sphere *spheres,
+                                 const Camera *cam, int w, int h)
+{
+    double best = 1e30;
+    int hits = 0;
+    for (int it = 0; it < 3; ++it) {
+        double t0 = main_now_ms();
+        for (int py = 0; py < h; ++py) {
+            for (int px = 0; px < w; ++px) {
+                float u = (w > 1) ? ((float)px / (float)(w - 1)) : 0.5f;
+                float v = (h > 1) ? ((float)py / (float)(h - 1)) : 0.5f;
+                Ray rray = camera_get_ray(*cam, u, v);
+                HitRecord rec;
+                float t;
+                if (kind == 0)      hits += bvh_hit(root, spheres, &rray, 0.001f, FLT_MAX, &rec);
+                else if (kind == 1) hits += bvh_flat_hit_closest(flat, spheres, &rray, 0.001f, FLT_MAX, &t) >= 0;
+                else                hits += bvh_wide_hit_closest(wide, spheres, &rray, 0.001f, FLT_MAX, &t) >= 0;
+            }
+        }
+        double dt = main_now_ms() - t0;
+        if (dt < best) best = dt;
+    }
+    g_bvh_baseline_sink += hits;
+    return (double)w * (double)h / (best * 1000.0);
+}
+
+static void ysu_bvh_baseline_layouts(const bvh_node *root, const Sphere *spheres,
+                                     const Camera *cam, int w, int h)
+{
+    BvhFlat flat;
+    BvhWide w4, w8;
+    if (!bvh_flatten(root, &flat)) return;
+    if (!bvh_wide_build(root, 4, &w4)) { bvh_flat_free(&flat); return; }
+    if (!bvh_wide_build(root, 8, &w8)) { bvh_flat_free(&flat); bvh_wide_free(&w4); return; }
+
+    double rec  = bvh_baseline_mrays(0, root, NULL, NULL, spheres, cam, w, h);
+    double fl   = bvh_baseline_mrays(1, NULL, &flat, NULL, spheres, cam, w, h);
+    double b4   = bvh_baseline_mrays(2, NULL, NULL, &w4, spheres, cam, w, h);
+    double b8   = bvh_baseline_mrays(2, NULL, NULL, &w8, spheres, cam, w, h);
+    printf("[BVH] closest-hit Mrays/s: recursive %.2f | flat %.2f (x%.2f) | bvh4 %.2f (x%.2f)"
+           " | bvh8%s %.2f (x%.2f)\n",
+           rec, fl, fl / rec, b4, b4 / rec, w8.avx2 ? " avx2" : "", b8, b8 / rec);
+
+    bvh_flat_free(&flat);
+    bvh_wide_free(&w4);
+    bvh_wide_free(&w8);
+}
+
 // -------------------------
 // BVH baseline: load spheres from scene file
 // -------------------------
@@ -73,33 +234,26 @@ static void ysu_run_cpu_bvh_baseline(const Camera *cam, int w, int h) {
     // 2) ./scene.txt
     // 3) ./DATA/scene.txt
     const char *scene_path = getenv("YSU_BASELINE_SCENE");
-    const int MAXS = 20000;
-
-    SceneSphere *tmp = (SceneSphere*)malloc(sizeof(SceneSphere) * (size_t)MAXS);
-    if (!tmp) {
-        printf("[BVH] baseline: tmp malloc failed\n");
-        return;
-    }
 
+    SceneSphere *tmp = NULL;
     int N = 0;
 
     if (scene_path && scene_path[0]) {
-        N = load_scene(scene_path, tmp, MAXS);
+        N = load_scene_alloc(scene_path, &tmp);
         if (N <= 0) {
             printf("[BVH] baseline: load_scene failed (%s)\n", scene_path);
         }
     } else {
         // Try ./scene.txt first
-        N = load_scene("./scene.txt", tmp, MAXS);
+        N = load_scene_alloc("./scene.txt", &tmp);
         if (N <= 0) {
             // Then ./DATA/scene.txt
-            N = load_scene("./DATA/scene.txt", tmp, MAXS);
+            N = load_scene_alloc("./DATA/scene.txt", &tmp);
         }
     }
 
     if (N <= 0) {
         printf("[BVH] baseline: no spheres loaded (set YSU_BASELINE_SCENE or provide scene.txt)\n");
-        free(tmp);
         printf("[BVH] baseline end.\n");
         return;
     }
@@ -131,8 +285,30 @@ static void ysu_run_cpu_bvh_baseline(const Camera *cam, int w, int h) {
     /* ===== PASS-2  ===== */
     bvh_assign_ids(root);
 
+    // .json: a model (bvh_policy.h) scored on the counters of a first pass
+    // over the same rays; anything else is a node_id,prune CSV
     const char* pol = getenv("YSU_BVH_POLICY");
-    if (pol && pol[0]) {
+    size_t pol_len = pol ? strlen(pol) : 0;
+    if (pol_len > 5 && !strcmp(pol + pol_len - 5, ".json")) {
+        BvhPolicyModel model;
+        Ray* prays = bvh_policy_load(pol, &model) ? (Ray*)malloc(sizeof(Ray) * (size_t)w * (size_t)h) : NULL;
+        if (prays) {
+            for (int py = 0; py < h; ++py) {
+                for (int px = 0; px < w; ++px) {
+                    float u = (w > 1) ? ((float)px / (float)(w - 1)) : 0.5f;
+                    float v = (h > 1) ? ((float)py / (float)(h - 1)) : 0.5f;
+                    prays[py * w + px] = camera_get_ray(*cam, u, v);
+                }
+            }
+            BvhPolicyStats pst;
+            bvh_policy_eval(root, spheres, prays, w * h, &model, 1.0f, &pst);
+            printf("[BVH] policy: %s marked %d/%d nodes (%d in pruned subtrees), visits %llu -> %llu, changed hits %d/%d\n",
+                   pol, pst.marked, pst.nodes, pst.removed,
+                   (unsigned long long)pst.visits_full, (unsigned long long)pst.visits_pruned,
+                   pst.rays_changed, pst.rays);
+            free(prays);
+        }
+    } else if (pol && pol[0]) {
         bvh_load_policy_csv(pol, root);
     } else {
         printf("[BVH] policy: YSU_BVH_POLICY not set\n");
@@ -169,12 +345,342 @@ static void ysu_run_cpu_bvh_baseline(const Camera *cam, int w, int h) {
     bvh_dump_stats("baseline_bvh.csv", root);
     printf("[BVH] wrote baseline_bvh.csv\n");
 
+    ysu_bvh_baseline_layouts(root, spheres, cam, w, h);
+
     bvh_free(root);
     free(spheres);
 
     printf("[BVH] baseline end.\n");
 }
 
+// -------------------------
+// Scene for the CPU renderers (YSU_SCENE=path/to/scene.txt)
+//   YSU_SCENE_GROUND  keep the built-in checker ground plane (default 0)
+// One Material per distinct (type, param); the per-sphere color rides in
+// Sphere.albedo and tints it.
+// -------------------------
+static int scene_material_slot(Material **mats, int *count, int *cap, int type, float param) {
+    for (int i = 0; i < *count; ++i) {
+        const Material *m = &(*mats)[i];
+        float p = (type == MAT_METAL) ? m->fuzz : (type == MAT_DIELECTRIC) ? m->ref_idx
+                : (type == MAT_EMISSIVE) ? m->emission.x : 0.0f;
+        if ((int)m->type == type && p == param) return i;
+    }
+    if (*count == *cap) {
+        int ncap = *cap ? *cap * 2 : 8;
+        Material *nm = (Material*)realloc(*mats, sizeof(Material) * (size_t)ncap);
+        if (!nm) return 0;
+        *mats = nm;
+        *cap = ncap;
+    }
+    Material m = { (MaterialType)type, {1.0f, 1.0f, 1.0f}, 0.0f, 1.0f, {0.0f, 0.0f, 0.0f} };
+    if (type == MAT_METAL)      m.fuzz = param;
+    if (type == MAT_DIELECTRIC) m.ref_idx = param;
+    if (type == MAT_EMISSIVE)   m.emission = vec3(param, param, param);
+    (*mats)[*count] = m;
+    return (*count)++;
+}
+
+// .ysc placements of the loaded meshes as TLAS instances over one BLAS per mesh.
+static int ysu_load_render_instances(const SceneDesc *d, const ObjMesh *objs, const signed char *loaded,
+                                     const Material *mats, int ground) {
+    int n = d->mesh_count, ni = d->instance_count;
+    const float **verts = (const float**)malloc(sizeof(float*) * (size_t)n);
+    const uint32_t **idx = (const uint32_t**)malloc(sizeof(uint32_t*) * (size_t)n);
+    uint32_t *tris = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)n);
+    int *blas = (int*)malloc(sizeof(int) * (size_t)n);
+    float *xf = (float*)malloc(sizeof(float) * 12u * (size_t)ni);
+    uint32_t *inst_mesh = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)ni);
+    uint16_t *inst_mat = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)ni);
+    int ok = 0;
+    if (verts && idx && tris && blas && xf && inst_mesh && inst_mat) {
+        // BLAS ids over the meshes that loaded
+        int nb = 0, k = 0;
+        for (int m = 0; m < n; ++m) {
+            blas[m] = -1;
+            if (loaded[m] <= 0) continue;
+            verts[nb] = objs[m].verts;
+            idx[nb] = objs[m].indices;
+            tris[nb] = objs[m].tri_count;
+            blas[m] = nb++;
+        }
+        for (int i = 0; i < ni; ++i) {
+            const SceneInstanceDef *in = &d->instances[i];
+            if (blas[in->mesh] < 0) continue;
+            memcpy(xf + (size_t)k * 12u, in->xform, sizeof(float) * 12u);
+            inst_mesh[k] = (uint32_t)blas[in->mesh];
+            inst_mat[k] = (uint16_t)in->material;
+            k++;
+        }
+        ok = render_set_mesh_instances(verts, idx, tris, nb, xf, inst_mesh, inst_mat, k,
+                                       mats, d->material_count, ground);
+    } else {
+        printf("[SCENE] out of memory for %d instances\n", ni);
+    }
+    free(verts); free(idx); free(tris); free(blas); free(xf); free(inst_mesh); free(inst_mat);
+    return ok;
+}
+
+// .ysc scene: spheres and lights go to render_set_scene(), and a scene
+// camera replaces *cam (aspect from the image; cam NULL = keep the caller's).
+// Each OBJ is loaded once (YSU_OBJ_CACHE applies). When some mesh is placed
+// more than once, meshes become BLASes under a TLAS with one instance per
+// placement (render_set_mesh_instances), so memory follows the unique
+// triangles. Otherwise every placement is flattened into one world-space
+// indexed mesh with per-triangle materials: no more triangles than the OBJs
+// hold, and the 8-triangle SoA leaves (and YSU_MESH_QUANT) apply.
+// Returns 1 when the scene set a mesh.
+static int ysu_load_render_ysc(const char *path, Camera *cam, float aspect) {
+    SceneDesc d;
+    if (!scene_desc_load(path, &d, NULL)) {
+        printf("[SCENE] using built-in scene\n");
+        return 0;
+    }
+
+    Material *mats = (Material*)malloc(sizeof(Material) * (size_t)(d.material_count ? d.material_count : 1));
+    Sphere *spheres = (Sphere*)malloc(sizeof(Sphere) * (size_t)(d.sphere_count ? d.sphere_count : 1));
+    ObjMesh *objs = (ObjMesh*)calloc((size_t)(d.mesh_count ? d.mesh_count : 1), sizeof(ObjMesh));
+    signed char *loaded = (signed char*)calloc((size_t)(d.mesh_count ? d.mesh_count : 1), 1);
+    if (!mats || !spheres || !objs || !loaded) {
+        printf("[SCENE] out of memory for %s\n", path);
+        free(mats); free(spheres); free(objs); free(loaded);
+        scene_desc_free(&d);
+        return 0;
+    }
+    for (int i = 0; i < d.material_count; ++i) mats[i] = d.materials[i].mat;
+    for (int i = 0; i < d.sphere_count; ++i) {
+        const SceneSphereDef *sd = &d.spheres[i];
+        spheres[i] = sphere_create(sd->center, sd->radius, sd->material);
+        spheres[i].albedo = (Color){ sd->tint.x, sd->tint.y, sd->tint.z };
+    }
+    int ground = d.ground || env_int("YSU_SCENE_GROUND", 0);
+    if (d.sphere_count > 0) render_set_scene(spheres, d.sphere_count, mats, d.material_count, ground);
+    free(spheres);
+
+    // load each referenced mesh once, then count the world triangles
+    uint64_t total = 0, total_verts = 0;
+    int reused = 0;
+    for (int i = 0; i < d.instance_count; ++i) {
+        int mi = d.instances[i].mesh;
+        if (loaded[mi] > 0) reused = 1;
+        if (!loaded[mi]) {
+            loaded[mi] = obj_load_cached(d.meshes[mi].path, NULL, OBJ_LOAD_INDEXED, 0, &objs[mi]) ? 1 : -1;
+            if (loaded[mi] < 0) {
+                printf("[SCENE] %s:%d: no triangles loaded from %s\n", path, d.meshes[mi].line, d.meshes[mi].path);
+            }
+        }
+        if (loaded[mi] > 0) {
+            total += objs[mi].tri_count;
+            total_verts += objs[mi].vert_count;
+        }
+    }
+
+    int has_mesh = 0;
+    if (total > 0 && reused && d.material_count <= 65536) {
+        has_mesh = ysu_load_render_instances(&d, objs, loaded, mats, ground);
+    } else if (total > 0 && total <= UINT32_MAX && total_verts < UINT32_MAX && d.material_count <= 65536) {
+        float *verts = (float*)malloc(sizeof(float) * 3u * (size_t)total_verts);
+        uint32_t *idx = (uint32_t*)malloc(sizeof(uint32_t) * 3u * (size_t)total);
+        uint16_t *tri_mat = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)total);
+        if (verts && idx && tri_mat) {
+            size_t to = 0, vo = 0;
+            for (int i = 0; i < d.instance_count; ++i) {
+                const SceneInstanceDef *in = &d.instances[i];
+                if (loaded[in->mesh] <= 0) continue;
+                const ObjMesh *m = &objs[in->mesh];
+                const float *x = in->xform;
+                for (uint32_t v = 0; v < m->vert_count; ++v) {
+                    const float *p = m->verts + (size_t)v * 3u;
+                    float *q = verts + (vo + v) * 3u;
+                    q[0] = x[0] * p[0] + x[1] * p[1] + x[2]  * p[2] + x[3];
+                    q[1] = x[4] * p[0] + x[5] * p[1] + x[6]  * p[2] + x[7];
+                    q[2] = x[8] * p[0] + x[9] * p[1] + x[10] * p[2] + x[11];
+                }
+                for (uint32_t t = 0; t < m->tri_count; ++t, ++to) {
+                    for (int k = 0; k < 3; ++k) idx[to * 3u + (size_t)k] = (uint32_t)vo + m->indices[t * 3u + (uint32_t)k];
+                    tri_mat[to] = (uint16_t)in->material;
+                }
+                vo += m->vert_count;
+            }
+            has_mesh = render_set_mesh_indexed(verts, idx, (uint32_t)total, tri_mat, mats, d.material_count, ground);
+        } else {
+            printf("[SCENE] out of memory for %llu instanced triangles\n", (unsigned long long)total);
+        }
+        free(verts);
+        free(idx);
+        free(tri_mat);
+    } else if (total > 0) {
+        printf("[SCENE] %s: too many instanced triangles or materials for one mesh\n", path);
+    }
+    for (int i = 0; i < d.mesh_count; ++i) {
+        if (loaded[i] > 0) obj_mesh_free(&objs[i]);
+    }
+    free(objs);
+    free(loaded);
+    free(mats);
+
+    if (cam && d.camera.set) {
+        *cam = camera_look_at(d.camera.from, d.camera.at, d.camera.up, d.camera.vfov, aspect);
+        printf("[SCENE] camera (%.2f, %.2f, %.2f) -> (%.2f, %.2f, %.2f), vfov %.1f\n",
+               d.camera.from.x, d.camera.from.y, d.camera.from.z,
+               d.camera.at.x, d.camera.at.y, d.camera.at.z, d.camera.vfov);
+    }
+    scene_desc_free(&d);
+    return has_mesh;
+}
+
+static int ysu_load_render_scene(Camera *cam, float aspect) {
+    const char *path = getenv("YSU_SCENE");
+    if (!path || !path[0]) return 0;
+    if (scene_is_ysc(path)) return ysu_load_render_ysc(path, cam, aspect);
+
+    SceneSphere *in = NULL;
+    int n = load_scene_alloc(path, &in);
+    if (n <= 0) {
+        printf("[SCENE] no spheres loaded from %s, using built-in scene\n", path);
+        return 0;
+    }
+
+    Sphere *spheres = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    Material *mats = NULL;
+    int mat_count = 0, mat_cap = 0;
+    if (!spheres) {
+        printf("[SCENE] out of memory for %d spheres\n", n);
+        free(in);
+        return 0;
+    }
+
+    // distinct (type, param) pairs are few in practice; remember the last one
+    int last_type = -1, last_slot = 0;
+    float last_param = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        int type = in[i].type;
+        float param = (type == MAT_LAMBERTIAN) ? 0.0f : in[i].param;
+        int slot = last_slot;
+        if (type != last_type || param != last_param) {
+            slot = scene_material_slot(&mats, &mat_count, &mat_cap, type, param);
+            last_type = type; last_param = param; last_slot = slot;
+        }
+        spheres[i] = sphere_create(in[i].center, in[i].radius, slot);
+        spheres[i].albedo = (Color){ in[i].albedo.x, in[i].albedo.y, in[i].albedo.z };
+    }
+    free(in);
+
+    printf("[SCENE] %s\n", path);
+    render_set_scene(spheres, n, mats, mat_count, env_int("YSU_SCENE_GROUND", 0));
+    free(spheres);
+    free(mats);
+    return 0;
+}
+
+// -------------------------
+// Mesh for the CPU renderers (YSU_MESH=path/to/mesh.obj; YSU_OBJ_CACHE applies,
+// ignored when a .ysc scene placed meshes)
+//   YSU_MESH_FIT  scale the mesh to a unit box standing on the ground where
+//                 the built-in blue sphere is (default 1; 0 = OBJ coordinates)
+// -------------------------
+static void ysu_load_render_mesh(void) {
+    const char *path = getenv("YSU_MESH");
+    if (!path || !path[0]) return;
+
+    ObjMesh m;
+    if (!obj_load_cached(path, NULL, OBJ_LOAD_INDEXED, 0, &m)) {
+        printf("[MESH] no triangles loaded from %s\n", path);
+        return;
+    }
+
+    if (env_int("YSU_MESH_FIT", 1)) {
+        // bounds of the referenced vertices only
+        float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[3] = { -1e30f, -1e30f, -1e30f };
+        for (size_t i = 0; i < (size_t)m.tri_count * 3u; ++i) {
+            const float *v = m.verts + (size_t)m.indices[i] * 3u;
+            for (int a = 0; a < 3; ++a) {
+                if (v[a] < lo[a]) lo[a] = v[a];
+                if (v[a] > hi[a]) hi[a] = v[a];
+            }
+        }
+        float ext = fmaxf(hi[0] - lo[0], fmaxf(hi[1] - lo[1], hi[2] - lo[2]));
+        float s = (ext > 0.0f) ? 1.0f / ext : 1.0f;
+        float cx = 0.5f * (lo[0] + hi[0]), cz = 0.5f * (lo[2] + hi[2]);
+        for (size_t i = 0; i < (size_t)m.vert_count; ++i) {
+            float *v = m.verts + i * 3u;
+            v[0] = (v[0] - cx) * s;
+            v[1] = (v[1] - lo[1]) * s - 0.5f;
+            v[2] = (v[2] - cz) * s - 1.0f;
+        }
+    }
+
+    printf("[MESH] %s\n", path);
+    render_set_mesh_indexed(m.verts, m.indices, m.tri_count, NULL, NULL, 0, 1);
+    obj_mesh_free(&m);
+}
+
+// -------------------------
+// Budgeted render (YSU_BUDGET_MS and/or YSU_BUDGET_SPP set)
+//   YSU_BUDGET_SPP   average samples per pixel to spend over the frame
+//   YSU_BUDGET_MS    wall-clock budget
+//   YSU_PILOT_SPP    uniform pilot pass (default 4)
+//   YSU_BUDGET_BATCH samples per pixel per tile visit (default 8)
+// -------------------------
+static void ysu_render_budgeted(Vec3 *pixels, int w, int h, Camera cam,
+                                int depth, int threads, int tile)
+{
+    YSU_BudgetOpts opts;
+    opts.budget_samples = (uint64_t)env_int("YSU_BUDGET_SPP", 0) * (uint64_t)w * (uint64_t)h;
+    opts.budget_ms      = (double)env_int("YSU_BUDGET_MS", 0);
+    opts.pilot_spp      = env_int("YSU_PILOT_SPP", 4);
+    opts.batch_spp      = env_int("YSU_BUDGET_BATCH", 8);
+
+    YSU_Accum acc;
+    if (!ysu_accum_init(&acc, w, h, (uint32_t)env_int("YSU_SEED", 1337), 0)) {
+        printf("[main] ERROR: could not allocate accumulation buffers\n");
+        return;
+    }
+    render_scene_budgeted(&acc, cam, &opts, depth, threads, tile);
+    ysu_accum_resolve(&acc, pixels);
+    ysu_accum_free(&acc);
+}
+
+// -------------------------
+// Camera-path batch (YSU_CAMERA_PATH=path/to/keys.txt)
+//   YSU_FRAMES         frames along the path (default: one per key)
+//   YSU_FRAME_OUT      output pattern with one %d (default frame_%04d.png)
+//   YSU_FRAME_WRITERS  background tonemap/PNG threads (default 2)
+//   YSU_FRAME_BUFFERS  framebuffers in flight (default writers + 1)
+// Scene/BVH setup happens once; the 360 render and BVH baseline are skipped.
+// -------------------------
+static int ysu_render_batch(const char *path, int w, int h, int spp, int depth,
+                            int threads, int tile)
+{
+    YSU_CamKey *keys = NULL;
+    int count = ysu_campath_load(path, &keys);
+    if (count <= 0) {
+        printf("[main] ERROR: no camera keys in %s\n", path);
+        return 1;
+    }
+
+    if (!ysu_load_render_scene(NULL, (float)w / (float)h)) ysu_load_render_mesh();
+
+    YSU_AnimOpts opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.width       = w;
+    opts.height      = h;
+    opts.spp         = spp;
+    opts.depth       = depth;
+    opts.threads     = threads;
+    opts.tile        = tile;
+    opts.frames      = env_int("YSU_FRAMES", 0);
+    opts.writers     = env_int("YSU_FRAME_WRITERS", 2);
+    opts.in_flight   = env_int("YSU_FRAME_BUFFERS", 0);
+    opts.out_pattern = getenv("YSU_FRAME_OUT");
+    opts.post        = ysu_neural_denoise_maybe;
+
+    int frames = (opts.frames > 0) ? opts.frames : count;
+    int written = ysu_render_campath(keys, count, &opts);
+    free(keys);
+    return (written == frames) ? 0 : 1;
+}
+
 int main(void)
 {
     printf("[main] START\n");
@@ -197,10 +703,18 @@ int main(void)
 
     print_cfg(image_width, image_height, samples_per_pixel, max_depth, thread_count, tile_size);
 
+    const char *cam_path = getenv("YSU_CAMERA_PATH");
+    if (cam_path && cam_path[0]) {
+        int rc = ysu_render_batch(cam_path, image_width, image_height, samples_per_pixel,
+                                  max_depth, thread_count, tile_size);
+        printf("[main] END\n");
+        return rc;
+    }
+
     // -------------------------
     // Allocate framebuffer (HDR)
     // -------------------------
-    Vec3 *pixels = (Vec3*)calloc((size_t)image_width * (size_t)image_height, sizeof(Vec3));
+    Vec3 *pixels = render_alloc_framebuffer(image_width, image_height, thread_count, tile_size);
     if (!pixels) {
         printf("[main] ERROR: could not allocate pixels (%dx%d)\n", image_width, image_height);
         return 1;
@@ -246,6 +760,8 @@ int main(void)
         printf("[main] NeRF camera: origin=(%.2f, %.2f, %.2f), looking toward origin\n", cx, cy, cz);
     }
 
+    if (!ysu_load_render_scene(&cam, aspect_ratio)) ysu_load_render_mesh();
+
     // -------------------------
     // Render
     // -------------------------
@@ -268,6 +784,12 @@ int main(void)
 
         /* Shutdown any NeRF global resources allocated by ysu_nerf_init */
         ysu_nerf_shutdown();
+    } else if (env_int("YSU_BUDGET_MS", 0) > 0 || env_int("YSU_BUDGET_SPP", 0) > 0) {
+        ysu_render_budgeted(pixels, image_width, image_height, cam,
+                            max_depth, thread_count, tile_size);
+    } else if (env_int("YSU_PROGRESSIVE", 0)) {
+        ysu_render_progressive(pixels, image_width, image_height, cam,
+                               samples_per_pixel, max_depth, thread_count, tile_size);
     } else if (thread_count > 0) {
         render_scene_mt(pixels,
                         image_width,
@@ -308,16 +830,13 @@ int main(void)
         free(rgb8);
     }
 
-    free(pixels);
+    render_free_framebuffer(pixels);
 
     // -------------------------
     // 360 render
     // -------------------------
     printf("[main] calling ysu_render_360...\n");
     ysu_render_360(&cam, "output_360.ppm");
-    printf("YSU 360: wrote output_360.png\n");
-    printf("YSU 360: tamam.\n");
-    printf("[main] wrote output_360.ppm\n");
 
     // -------------------------
     // BVH baseline (scene.txt)
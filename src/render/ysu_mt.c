@@ -1,9 +1,22 @@
-// ysu_mt.c
+// ysu_mt.c - thread count suggestion, CPU topology, worker pinning
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE   // sched_getaffinity, pthread_setaffinity_np
+#endif
+
 #include "ysu_mt.h"
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 
 #if defined(_WIN32)
-#include <windows.h>
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <sched.h>
+  #include <dirent.h>
 #endif
 
 int ysu_mt_suggest_threads(void) {
@@ -14,15 +27,305 @@ int ysu_mt_suggest_threads(void) {
         if (v > 0) return v;
     }
 
-    // 2) Platform default
-#if defined(_WIN32)
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    int n = (int)sysinfo.dwNumberOfProcessors;
-    return (n > 0) ? n : 4;
+    // 2) Usable CPUs, capped by a container CPU quota
+    const YSU_Topology *t = ysu_mt_topology();
+    int n = t->ncpu;
+    if (t->cpu_quota > 0 && t->cpu_quota < n) n = t->cpu_quota;
+    return (n > 0) ? n : 1;
+}
+
+// ------------------------- Topology detection -------------------------
+static YSU_Topology   g_topo;
+static pthread_once_t g_topo_once = PTHREAD_ONCE_INIT;
+
+static int topo_cmp(const void *a, const void *b) {
+    const YSU_CpuInfo *x = (const YSU_CpuInfo*)a, *y = (const YSU_CpuInfo*)b;
+    if (x->node    != y->node)    return (x->node    < y->node)    ? -1 : 1;
+    if (x->smt     != y->smt)     return (x->smt     < y->smt)     ? -1 : 1;
+    if (x->package != y->package) return (x->package < y->package) ? -1 : 1;
+    if (x->core    != y->core)    return (x->core    < y->core)    ? -1 : 1;
+    return (x->cpu < y->cpu) ? -1 : (x->cpu > y->cpu);
+}
+
+// Renumbers raw (package, core) ids densely, ranks SMT siblings by CPU id,
+// counts packages/nodes and sorts. cpus[] must be in ascending CPU id order
+// with .core holding the raw per-package core id.
+static void topo_finish(YSU_Topology *t) {
+    int n = t->ncpu;
+    int *raw_core = (int*)malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    int *raw_pkg  = (int*)malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    if (!raw_core || !raw_pkg) {
+        for (int i = 0; i < n; ++i) { t->cpus[i].core = i; t->cpus[i].smt = 0; }
+        n = 0;
+    }
+    int cores = 0;
+    for (int i = 0; i < n; ++i) {
+        YSU_CpuInfo *c = &t->cpus[i];
+        int id = -1, smt = 0;
+        for (int k = 0; k < cores; ++k) {
+            if (raw_core[k] == c->core && raw_pkg[k] == c->package) { id = k; break; }
+        }
+        if (id < 0) {
+            id = cores++;
+            raw_core[id] = c->core;
+            raw_pkg[id]  = c->package;
+        }
+        for (int j = 0; j < i; ++j) smt += (t->cpus[j].core == id);
+        c->core = id;
+        c->smt  = smt;
+    }
+    free(raw_core);
+    free(raw_pkg);
+    t->cores = (n > 0) ? cores : t->ncpu;
+
+    t->packages = 0;
+    t->nodes = 0;
+    for (int i = 0; i < t->ncpu; ++i) {
+        int pkg_seen = 0, node_seen = 0;
+        for (int j = 0; j < i; ++j) {
+            pkg_seen  |= (t->cpus[j].package == t->cpus[i].package);
+            node_seen |= (t->cpus[j].node    == t->cpus[i].node);
+        }
+        t->packages += !pkg_seen;
+        t->nodes    += !node_seen;
+    }
+    if (t->packages < 1) t->packages = 1;
+    if (t->nodes < 1)    t->nodes = 1;
+
+    qsort(t->cpus, (size_t)t->ncpu, sizeof(YSU_CpuInfo), topo_cmp);
+}
+
+#if defined(__linux__)
+static int topo_read_int(const char *path, int defv) {
+    FILE *f = fopen(path, "r");
+    if (!f) return defv;
+    int v = defv;
+    if (fscanf(f, "%d", &v) != 1) v = defv;
+    fclose(f);
+    return v;
+}
+
+// Marks every CPU of a sysfs list ("0-3,8,10-11") with node.
+static void topo_apply_cpulist(YSU_Topology *t, const char *path, int node) {
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    char buf[4096];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+
+    char *s = buf;
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10);
+        if (end == s) break;
+        long b = a;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (int i = 0; i < t->ncpu; ++i) {
+            if (t->cpus[i].cpu >= a && t->cpus[i].cpu <= b) t->cpus[i].node = node;
+        }
+        if (*s == ',') s++;
+        else break;
+    }
+}
+
+// CFS bandwidth limit of the cgroup we run in, rounded up to whole CPUs.
+// Reads the container-visible root (v2 cpu.max, else v1 cfs_quota_us).
+static int topo_cgroup_quota(void) {
+    FILE *f = fopen("/sys/fs/cgroup/cpu.max", "r");
+    if (f) {
+        char q[32] = {0};
+        long period = 0;
+        int n = fscanf(f, "%31s %ld", q, &period);
+        fclose(f);
+        if (n == 2 && strcmp(q, "max") != 0 && period > 0) {
+            long quota = atol(q);
+            if (quota > 0) return (int)((quota + period - 1) / period);
+        }
+        return 0;
+    }
+    int quota  = topo_read_int("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", -1);
+    int period = topo_read_int("/sys/fs/cgroup/cpu/cpu.cfs_period_us", 0);
+    if (quota > 0 && period > 0) return (quota + period - 1) / period;
+    return 0;
+}
+
+static void topo_detect(YSU_Topology *t) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int have_mask = (sched_getaffinity(0, sizeof(set), &set) == 0);
+    int max_cpu = have_mask ? CPU_SETSIZE : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int count = have_mask ? CPU_COUNT(&set) : max_cpu;
+    if (count < 1) { have_mask = 0; max_cpu = count = 1; }
+
+    t->cpus = (YSU_CpuInfo*)calloc((size_t)count, sizeof(YSU_CpuInfo));
+    if (!t->cpus) return;
+
+    char path[128];
+    for (int cpu = 0; cpu < max_cpu && t->ncpu < count; ++cpu) {
+        if (have_mask && !CPU_ISSET(cpu, &set)) continue;
+        YSU_CpuInfo *c = &t->cpus[t->ncpu++];
+        c->cpu = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        c->package = topo_read_int(path, 0);
+        if (c->package < 0) c->package = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        c->core = topo_read_int(path, cpu);
+    }
+
+    DIR *d = opendir("/sys/devices/system/node");
+    if (d) {
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL) {
+            int node;
+            if (strncmp(e->d_name, "node", 4) != 0 || sscanf(e->d_name + 4, "%d", &node) != 1) continue;
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            topo_apply_cpulist(t, path, node);
+        }
+        closedir(d);
+    }
+
+    t->cpu_quota = topo_cgroup_quota();
+}
+#elif defined(_WIN32)
+// Processor group 0 only (the pool never spans groups).
+static void topo_detect(YSU_Topology *t) {
+    SYSTEM_INFO sys;
+    GetSystemInfo(&sys);
+    int count = (int)sys.dwNumberOfProcessors;
+    if (count < 1) count = 1;
+    if (count > 64) count = 64;
+
+    t->cpus = (YSU_CpuInfo*)calloc((size_t)count, sizeof(YSU_CpuInfo));
+    if (!t->cpus) return;
+    t->ncpu = count;
+    for (int i = 0; i < count; ++i) { t->cpus[i].cpu = i; t->cpus[i].core = i; }
+
+    DWORD len = 0;
+    GetLogicalProcessorInformation(NULL, &len);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)malloc(len);
+    if (!info || !GetLogicalProcessorInformation(info, &len)) { free(info); return; }
+
+    int core = 0, pkg = 0;
+    for (DWORD k = 0; k < len / sizeof(*info); ++k) {
+        ULONG_PTR mask = info[k].ProcessorMask;
+        for (int i = 0; i < count; ++i) {
+            if (!(mask & ((ULONG_PTR)1 << i))) continue;
+            if (info[k].Relationship == RelationProcessorCore)    t->cpus[i].core = core;
+            if (info[k].Relationship == RelationProcessorPackage) t->cpus[i].package = pkg;
+            if (info[k].Relationship == RelationNumaNode)         t->cpus[i].node = (int)info[k].NumaNode.NodeNumber;
+        }
+        if (info[k].Relationship == RelationProcessorCore)    core++;
+        if (info[k].Relationship == RelationProcessorPackage) pkg++;
+    }
+    free(info);
+}
+#else
+static void topo_detect(YSU_Topology *t) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1) count = 1;
+    t->cpus = (YSU_CpuInfo*)calloc((size_t)count, sizeof(YSU_CpuInfo));
+    if (!t->cpus) return;
+    t->ncpu = (int)count;
+    for (int i = 0; i < t->ncpu; ++i) { t->cpus[i].cpu = i; t->cpus[i].core = i; }
+}
+#endif
+
+static void topo_init(void) {
+    memset(&g_topo, 0, sizeof(g_topo));
+    topo_detect(&g_topo);
+    if (!g_topo.cpus || g_topo.ncpu < 1) {
+        static YSU_CpuInfo one;
+        free(g_topo.cpus);
+        memset(&one, 0, sizeof(one));
+        g_topo.cpus = &one;
+        g_topo.ncpu = 1;
+    }
+    topo_finish(&g_topo);
+}
+
+const YSU_Topology *ysu_mt_topology(void) {
+    pthread_once(&g_topo_once, topo_init);
+    return &g_topo;
+}
+
+void ysu_mt_print_topology(void) {
+    const YSU_Topology *t = ysu_mt_topology();
+    int smt_max = 0;
+    for (int i = 0; i < t->ncpu; ++i) if (t->cpus[i].smt > smt_max) smt_max = t->cpus[i].smt;
+    printf("[TOPO] cpus=%d cores=%d packages=%d nodes=%d smt=%d quota=%d\n",
+           t->ncpu, t->cores, t->packages, t->nodes, smt_max + 1, t->cpu_quota);
+}
+
+// ------------------------- Pinning -------------------------
+typedef struct { int idx, smt, rank, node; } TopoPref;
+
+static int pref_cmp(const void *a, const void *b) {
+    const TopoPref *x = (const TopoPref*)a, *y = (const TopoPref*)b;
+    if (x->smt  != y->smt)  return (x->smt  < y->smt)  ? -1 : 1;
+    if (x->rank != y->rank) return (x->rank < y->rank) ? -1 : 1;
+    if (x->node != y->node) return (x->node < y->node) ? -1 : 1;
+    return (x->idx < y->idx) ? -1 : (x->idx > y->idx);
+}
+
+static int idx_cmp(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+int ysu_mt_plan_affinity(int n, int *cpu_out, int *node_out) {
+    const YSU_Topology *t = ysu_mt_topology();
+    if (n < 1) return 0;
+    int m = (n < t->ncpu) ? n : t->ncpu;
+
+    TopoPref *pref = (TopoPref*)malloc(sizeof(TopoPref) * (size_t)t->ncpu);
+    int *pick = (int*)malloc(sizeof(int) * (size_t)m);
+    if (!pref || !pick) { free(pref); free(pick); return 0; }
+
+    // cpus[] is grouped by (node, smt): rank = position inside that group,
+    // so sorting by (smt, rank, node) deals physical cores round-robin
+    // over the nodes before any SMT sibling is used.
+    int group = 0;
+    for (int i = 0; i < t->ncpu; ++i) {
+        const YSU_CpuInfo *c = &t->cpus[i];
+        if (i > 0 && (c->node != t->cpus[i - 1].node || c->smt != t->cpus[i - 1].smt)) group = i;
+        pref[i].idx  = i;
+        pref[i].smt  = c->smt;
+        pref[i].rank = i - group;
+        pref[i].node = c->node;
+    }
+    qsort(pref, (size_t)t->ncpu, sizeof(TopoPref), pref_cmp);
+
+    // back to (node, ...) order so worker bands on one node are contiguous
+    for (int k = 0; k < m; ++k) pick[k] = pref[k].idx;
+    qsort(pick, (size_t)m, sizeof(int), idx_cmp);
+
+    for (int w = 0; w < n; ++w) {
+        const YSU_CpuInfo *c = &t->cpus[pick[w % m]];
+        if (cpu_out)  cpu_out[w]  = c->cpu;
+        if (node_out) node_out[w] = c->node;
+    }
+    free(pref);
+    free(pick);
+    return m;
+}
+
+int ysu_mt_pin_self(int cpu) {
+    if (cpu < 0) return 0;
+#if defined(__linux__)
+    cpu_set_t set;
+    if (cpu >= CPU_SETSIZE) return 0;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (cpu >= 64) return 0;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
 #else
-    // GCC/Clang: fallback
-    // (Could use POSIX sysconf here if needed)
-    return 8;
+    return 0;
 #endif
 }
@@ -25,9 +25,46 @@ static inline float ysu_rng_f01(YSU_Rng *r) {
     return (ysu_rng_u32(r) >> 8) * (1.0f / 16777216.0f);
 }
 
-// Suggested thread count (can be overridden via env)
+// Suggested thread count: YSU_THREADS, else the CPUs this process may run
+// on (affinity mask), capped by a cgroup CPU quota when one is set.
 int ysu_mt_suggest_threads(void);
 
+// ------------------------- CPU topology -------------------------
+// One entry per logical CPU in the process affinity mask.
+typedef struct {
+    int cpu;      // OS logical CPU id
+    int core;     // physical core, numbered 0..cores-1 across all packages
+    int package;  // socket
+    int node;     // NUMA node (0 when unknown)
+    int smt;      // 0 = first hardware thread of its core, 1.. = siblings
+} YSU_CpuInfo;
+
+typedef struct {
+    int ncpu;           // usable logical CPUs
+    int cores;          // distinct physical cores among them
+    int packages;
+    int nodes;
+    int cpu_quota;      // cgroup CPU limit rounded up (0 = none)
+    YSU_CpuInfo *cpus;  // ncpu entries sorted by (node, smt, package, core)
+} YSU_Topology;
+
+// Detected once (thread-safe), never freed. Falls back to ncpu logical CPUs
+// on one node/package with one thread per core when sysfs is unavailable.
+const YSU_Topology *ysu_mt_topology(void);
+
+// Prints a one-line "[TOPO]" summary.
+void ysu_mt_print_topology(void);
+
+// Placement for n pinned workers: physical cores before SMT siblings, spread
+// evenly over NUMA nodes, then ordered by node so consecutive workers share
+// one. Fills cpu_out[w] (OS CPU id) and node_out[w] for w < n; either may be
+// NULL. Returns the number of distinct CPUs used (workers wrap when n > ncpu).
+int ysu_mt_plan_affinity(int n, int *cpu_out, int *node_out);
+
+// Pins the calling thread to one OS CPU. Returns 1 on success, 0 if pinning
+// failed or is unsupported on this platform.
+int ysu_mt_pin_self(int cpu);
+
 // Worker context for the render tile job system
 typedef struct {
     int width;
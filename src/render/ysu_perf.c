@@ -0,0 +1,61 @@
+// ysu_perf.c - per-thread hardware cache counters (Linux perf_event_open)
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE   // syscall
+#endif
+
+#include "ysu_perf.h"
+#include <string.h>
+
+#if defined(__linux__)
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+#endif
+
+#if defined(__linux__)
+static int perf_open_cache(uint64_t cache) {
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = PERF_TYPE_HW_CACHE;
+    a.config = cache | ((uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8) |
+               ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    // pid 0, cpu -1: this thread, wherever it runs
+    return (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+}
+#endif
+
+int ysu_perf_open(YSU_Perf *p) {
+    p->ok = 0;
+    for (int i = 0; i < YSU_PERF_COUNT; ++i) p->fd[i] = -1;
+#if defined(__linux__)
+    p->fd[YSU_PERF_L1D_MISS] = perf_open_cache(PERF_COUNT_HW_CACHE_L1D);
+    p->fd[YSU_PERF_LLC_MISS] = perf_open_cache(PERF_COUNT_HW_CACHE_LL);
+    for (int i = 0; i < YSU_PERF_COUNT; ++i) {
+        if (p->fd[i] >= 0) p->ok = 1;
+    }
+#endif
+    return p->ok;
+}
+
+void ysu_perf_read(const YSU_Perf *p, uint64_t out[YSU_PERF_COUNT]) {
+    for (int i = 0; i < YSU_PERF_COUNT; ++i) {
+        out[i] = 0;
+#if defined(__linux__)
+        uint64_t v;
+        if (p->fd[i] >= 0 && read(p->fd[i], &v, sizeof(v)) == (ssize_t)sizeof(v)) out[i] = v;
+#endif
+    }
+}
+
+void ysu_perf_close(YSU_Perf *p) {
+    for (int i = 0; i < YSU_PERF_COUNT; ++i) {
+#if defined(__linux__)
+        if (p->fd[i] >= 0) close(p->fd[i]);
+#endif
+        p->fd[i] = -1;
+    }
+    p->ok = 0;
+}
@@ -0,0 +1,31 @@
+// ysu_perf.h - per-thread hardware cache counters (Linux perf_event_open)
+#ifndef YSU_PERF_H
+#define YSU_PERF_H
+
+#include <stdint.h>
+
+// Counts for the calling thread only, user space only. Everywhere else
+// (other OSes, perf_event_paranoid too strict, no PMU in a VM) open fails
+// and reads return zeros, so callers can use it unconditionally.
+//
+// The generic cache events have no L2 entry; LLC is the closest portable
+// one (on most x86 parts the L2 miss rate tracks it for these workloads).
+
+enum {
+    YSU_PERF_L1D_MISS = 0,    // L1 data read misses
+    YSU_PERF_LLC_MISS,        // last-level cache read misses
+    YSU_PERF_COUNT
+};
+
+typedef struct {
+    int fd[YSU_PERF_COUNT];   // -1 when that counter is unavailable
+    int ok;                   // at least one counter opened
+} YSU_Perf;
+
+// Returns 1 when at least one counter could be opened.
+int  ysu_perf_open(YSU_Perf *p);
+// Current totals since open (0 for unavailable counters).
+void ysu_perf_read(const YSU_Perf *p, uint64_t out[YSU_PERF_COUNT]);
+void ysu_perf_close(YSU_Perf *p);
+
+#endif // YSU_PERF_H
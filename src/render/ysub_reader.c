@@ -0,0 +1,226 @@
+// ysub_reader.c - zero-copy reader for .ysub buffer dumps
+#include "ysub_reader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// ------------------------- file mapping -------------------------
+static int ysub_map(const char *path, YsubFile *f) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(file, &sz) || sz.QuadPart <= 0 || (uint64_t)sz.QuadPart > (uint64_t)SIZE_MAX) {
+        CloseHandle(file);
+        return 0;
+    }
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void *p = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!p) {
+        if (map) CloseHandle(map);
+        CloseHandle(file);
+        return 0;
+    }
+    f->file_handle = file;
+    f->map_handle = map;
+    f->map = p;
+    f->size = (size_t)sz.QuadPart;
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+        close(fd);
+        return 0;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return 0;
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    f->map = p;
+    f->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+void ysub_close(YsubFile *f) {
+    if (!f || !f->map) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(f->map);
+    CloseHandle((HANDLE)f->map_handle);
+    CloseHandle((HANDLE)f->file_handle);
+#else
+    munmap((void*)f->map, f->size);
+#endif
+    memset(f, 0, sizeof(*f));
+}
+
+// ------------------------- header -------------------------
+// native byte order, as gbuffer_dump.c writes it
+static uint32_t ysub_u32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+int ysub_open(const char *path, YsubFile *f) {
+    memset(f, 0, sizeof(*f));
+    if (!path || !ysub_map(path, f)) {
+        printf("[YSUB] %s: cannot open\n", path ? path : "(null)");
+        return 0;
+    }
+
+    const unsigned char *h = (const unsigned char*)f->map;
+    const char *err = NULL;
+    if (f->size < YSUB_HEADER_BYTES || memcmp(h, "YSUB", 4) != 0) {
+        err = "not a .ysub file";
+    } else {
+        f->version  = ysub_u32(h + 4);
+        f->width    = ysub_u32(h + 8);
+        f->height   = ysub_u32(h + 12);
+        f->channels = ysub_u32(h + 16);
+        f->dtype    = ysub_u32(h + 20);
+        if (f->version != 1u) {
+            err = "unsupported version";
+        } else if (f->width == 0 || f->height == 0) {
+            err = "empty image";
+        } else if (f->channels == 0 || f->channels > YSUB_MAX_CHANNELS) {
+            err = "bad channel count";
+        } else if (f->dtype != 1u) {
+            err = "unsupported dtype (only 1 = float32)";
+        } else {
+            // w * h fits in 64 bits; * channels * 4 may not
+            uint64_t px = (uint64_t)f->width * (uint64_t)f->height;
+            uint64_t payload = f->size - YSUB_HEADER_BYTES;
+            if (px > payload / (4u * (uint64_t)f->channels) ||
+                px * 4u * (uint64_t)f->channels != payload) {
+                err = "size does not match width x height x channels";
+            }
+        }
+    }
+    if (err) {
+        char dims[96] = "";
+        if (f->size >= YSUB_HEADER_BYTES && memcmp(h, "YSUB", 4) == 0) {
+            snprintf(dims, sizeof(dims), " (v%u %ux%u ch=%u dtype=%u, %llu bytes)", f->version, f->width,
+                     f->height, f->channels, f->dtype, (unsigned long long)f->size);
+        }
+        printf("[YSUB] %s: %s%s\n", path, err, dims);
+        ysub_close(f);
+        return 0;
+    }
+
+    YsubView *v = &f->view;
+    v->data         = (const float*)(h + YSUB_HEADER_BYTES);   // page + 24: 4-byte aligned
+    v->width        = f->width;
+    v->height       = f->height;
+    v->channels     = f->channels;
+    v->pixel_stride = f->channels;
+    v->row_stride   = (size_t)f->width * f->channels;
+    return 1;
+}
+
+// ------------------------- views -------------------------
+int ysub_view_crop(const YsubView *v, uint32_t x, uint32_t y, uint32_t w, uint32_t h, YsubView *out) {
+    if (x >= v->width || y >= v->height || w == 0 || h == 0) return 0;
+    if (w > v->width - x)  w = v->width - x;
+    if (h > v->height - y) h = v->height - y;
+    YsubView c = *v;
+    c.data   = ysub_pixel(v, x, y);
+    c.width  = w;
+    c.height = h;
+    *out = c;
+    return 1;
+}
+
+int ysub_view_step(const YsubView *v, uint32_t step, YsubView *out) {
+    if (step == 0 || v->width == 0 || v->height == 0) return 0;
+    YsubView s = *v;
+    s.width        = (v->width - 1u) / step + 1u;
+    s.height       = (v->height - 1u) / step + 1u;
+    s.pixel_stride = v->pixel_stride * step;
+    s.row_stride   = v->row_stride * step;
+    *out = s;
+    return 1;
+}
+
+// ------------------------- checksum -------------------------
+// 4 independent multiply-xor lanes over 8-byte words (as the OBJ cache
+// hash), streamed so that the result does not depend on how the bytes are
+// split: contiguous rows go in whole, strided ones pixel by pixel.
+typedef struct {
+    uint64_t      h[4];
+    unsigned char buf[32];
+    size_t        n;
+    uint64_t      total;
+} YsubHash;
+
+#define YSUB_K 0x9E3779B97F4A7C15ull
+
+static void ysub_hash_block(YsubHash *s, const unsigned char *p) {
+    for (int l = 0; l < 4; ++l) {
+        uint64_t w;
+        memcpy(&w, p + 8 * l, 8);
+        s->h[l] = (s->h[l] ^ w) * YSUB_K;
+        s->h[l] ^= s->h[l] >> 29;
+    }
+}
+
+static void ysub_hash_update(YsubHash *s, const void *data, size_t n) {
+    const unsigned char *p = (const unsigned char*)data;
+    s->total += n;
+    if (s->n) {
+        size_t k = 32u - s->n;
+        if (k > n) k = n;
+        memcpy(s->buf + s->n, p, k);
+        s->n += k;
+        p += k;
+        n -= k;
+        if (s->n < 32u) return;
+        ysub_hash_block(s, s->buf);
+        s->n = 0;
+    }
+    for (; n >= 32u; p += 32, n -= 32u) ysub_hash_block(s, p);
+    memcpy(s->buf, p, n);
+    s->n = n;
+}
+
+uint64_t ysub_view_checksum(const YsubView *v) {
+    YsubHash s;
+    memset(&s, 0, sizeof(s));
+    s.h[0] = YSUB_K;
+    s.h[1] = YSUB_K ^ 0x5555555555555555ull;
+    s.h[2] = ~YSUB_K;
+    s.h[3] = YSUB_K * 3u;
+
+    const size_t px_bytes = sizeof(float) * (size_t)v->channels;
+    if (v->pixel_stride == v->channels && v->row_stride == (size_t)v->width * v->channels) {
+        ysub_hash_update(&s, v->data, px_bytes * (size_t)v->width * (size_t)v->height);
+    } else if (v->pixel_stride == v->channels) {
+        for (uint32_t y = 0; y < v->height; ++y) ysub_hash_update(&s, ysub_row(v, y), px_bytes * (size_t)v->width);
+    } else {
+        for (uint32_t y = 0; y < v->height; ++y) {
+            const float *p = ysub_row(v, y);
+            for (uint32_t x = 0; x < v->width; ++x, p += v->pixel_stride) ysub_hash_update(&s, p, px_bytes);
+        }
+    }
+
+    uint64_t tail[4] = { 0, 0, 0, 0 };
+    memcpy(tail, s.buf, s.n);
+    uint64_t r = s.total;
+    for (int l = 0; l < 4; ++l) {
+        r = (r ^ s.h[l] ^ tail[l]) * YSUB_K;
+        r ^= r >> 32;
+    }
+    return r;
+}
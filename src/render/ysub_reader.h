@@ -0,0 +1,79 @@
+// ysub_reader.h - zero-copy reader for .ysub buffer dumps (gbuffer_dump.h)
+#ifndef YSUB_READER_H
+#define YSUB_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The file is mapped read-only and the header checked against the mapping
+// size before anything is handed out: magic "YSUB", version 1, width and
+// height > 0, 1..YSUB_MAX_CHANNELS channels, dtype 1 (float32), and exactly
+// width * height * channels floats after the 24-byte header. Pixels are
+// channel-interleaved, rows top to bottom.
+//
+// Views point straight into the mapping (no copies); they stay valid until
+// ysub_close(). Crop and step views only change the origin, size and
+// strides, so any rectangle or decimation of a multi-GB dump costs nothing
+// until its pages are touched.
+
+#define YSUB_HEADER_BYTES  24u
+#define YSUB_MAX_CHANNELS  64u
+
+typedef struct {
+    const float *data;          // pixel (0, 0), `channels` floats
+    uint32_t     width;
+    uint32_t     height;
+    uint32_t     channels;
+    size_t       pixel_stride;  // floats between neighbouring pixels of a row
+    size_t       row_stride;    // floats between neighbouring rows
+} YsubView;
+
+typedef struct {
+    uint32_t     version;
+    uint32_t     width;
+    uint32_t     height;
+    uint32_t     channels;
+    uint32_t     dtype;
+    YsubView     view;          // the whole image
+    const void  *map;           // whole file
+    size_t       size;
+#if defined(_WIN32)
+    void        *file_handle;
+    void        *map_handle;
+#endif
+} YsubFile;
+
+// Maps and validates path. Returns 1 on success; 0 when the file cannot be
+// mapped or the header is bad, with the reason printed as "[YSUB] ..."
+// (f is zeroed).
+int  ysub_open(const char *path, YsubFile *f);
+void ysub_close(YsubFile *f);
+
+static inline const float *ysub_row(const YsubView *v, uint32_t y) {
+    return v->data + (size_t)y * v->row_stride;
+}
+
+static inline const float *ysub_pixel(const YsubView *v, uint32_t x, uint32_t y) {
+    return v->data + (size_t)y * v->row_stride + (size_t)x * v->pixel_stride;
+}
+
+// Rectangle x, y, w, h of v, clipped to v. Returns 0 when nothing is left.
+int  ysub_view_crop(const YsubView *v, uint32_t x, uint32_t y, uint32_t w, uint32_t h, YsubView *out);
+
+// Every step-th pixel of every step-th row, starting at (0, 0).
+int  ysub_view_step(const YsubView *v, uint32_t step, YsubView *out);
+
+// Checksum of the view's floats in row order: the same value for a view
+// and for a .ysub dump of exactly those pixels, however the view is laid
+// out in its file. Not cryptographic.
+uint64_t ysub_view_checksum(const YsubView *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // YSUB_READER_H
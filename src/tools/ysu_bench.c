@@ -0,0 +1,2403 @@
+// ysu_bench - CPU renderer microbenchmarks
+//
+//   ysu_bench render [W H SPP DEPTH ITERS]   time render_scene_mt (YSU_* env applies)
+//   ysu_bench vec3   [N ITERS]               scalar Vec3 vs Vec3x4/Vec3x8 ray-sphere
+//   ysu_bench scale  [W H SPP DEPTH MAXT ITERS]  render_scene_mt at 1..MAXT threads
+//   ysu_bench 360    [W H SPP DEPTH ITERS]   perspective vs equirect vs cubemap, same pixel count
+//   ysu_bench bvh    [N ITERS SCENE]         median vs binned-SAH build: time, nodes, visits/ray; degenerate inputs vs brute force
+//   ysu_bench packet [W H N ITERS]           8-ray packets vs single rays, spheres and triangles
+//   ysu_bench lbvh   [N ITERS]               parallel LBVH build of N triangles, 1 vs all threads; chunk jobs
+//   ysu_bench tlas   [INST N ITERS]          INST instances of an N-triangle mesh: builds, moves, rays
+//   ysu_bench refit  [N FRAMES MOVING]       MOVING of N spheres drift per frame: refit vs full rebuild
+//   ysu_bench policy [N ITERS MODEL]         learned BVH pruning: nodes pruned, visits saved, image error
+//   ysu_bench raysort [N W H SPP ITERS]      wavefront at depth 4/6/8, secondary rays sorted or not
+//   ysu_bench obj    [MTRIS THREADS | FILE]  OBJ load: 1 vs N threads, then cold / warm binary cache, long-face check
+//   ysu_bench mesh   [MTRIS|FILE W H ITERS]  CPU triangle mesh: rays vs 8-triangle SoA leaves, path frames
+//   ysu_bench meshq  [MTRIS|FILE W H ITERS]  float vs 8-bit quantised mesh leaves: bytes/tri, Mrays/s, hit drift
+//   ysu_bench scene  [N ITERS]               streaming .ysc load of an N-object scene
+//   ysu_bench scenefuzz [ITERS SEED]         .ysc parser corpus, streamed line numbers, mutation fuzzing
+//   ysu_bench ysub   [W H C ITERS]           .ysub dump checksum: fread copy vs mapped views, view / header checks
+//   ysu_bench rng    [N ITERS]               8-uniform pcg4d blocks: AVX2 bit-identical to scalar, Muniforms/s
+//
+// Prints one "[BENCH]" line per case: best-of-ITERS wall time and throughput.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vec3.h"
+#include "vec3_simd.h"
+#include "camera.h"
+#include "render.h"
+#include "ysu_mt.h"
+#include "bvh.h"
+#include "bvh_wide.h"
+#include "bvh_packet.h"
+#include "bvh_refit.h"
+#include "bvh_policy.h"
+#include "obj_load.h"
+#include "mesh_bvh.h"
+#include "gpu_bvh_build.h"
+#include "gpu_bvh_lbv.h"
+#include "tlas.h"
+#include "sceneloader.h"
+#include "gbuffer_dump.h"
+#include "ysub_reader.h"
+#include "ysu_rng.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+static double bench_now_ms(void) {
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+}
+#else
+  #include <time.h>
+static double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+#endif
+
+static int arg_int(int argc, char **argv, int i, int defv) {
+    return (argc > i) ? atoi(argv[i]) : defv;
+}
+
+// ------------------------- render -------------------------
+static int bench_render(int argc, char **argv) {
+    int W     = arg_int(argc, argv, 2, 320);
+    int H     = arg_int(argc, argv, 3, 180);
+    int spp   = arg_int(argc, argv, 4, 8);
+    int depth = arg_int(argc, argv, 5, 6);
+    int iters = arg_int(argc, argv, 6, 3);
+    if (W < 1 || H < 1 || spp < 1 || depth < 1 || iters < 1) return 1;
+
+    Vec3 *px = (Vec3*)malloc(sizeof(Vec3) * (size_t)W * (size_t)H);
+    if (!px) return 1;
+    Camera cam = camera_create((float)W / (float)H, 2.0f, 1.0f);
+
+    // warm-up frame spins up the pool
+    render_scene_mt(px, W, H, cam, spp, depth, 0, 0);
+
+    double best = 1e30;
+    for (int it = 0; it < iters; ++it) {
+        double t0 = bench_now_ms();
+        render_scene_mt(px, W, H, cam, spp, depth, 0, 0);
+        double dt = bench_now_ms() - t0;
+        if (dt < best) best = dt;
+    }
+
+    double mpx = (double)W * (double)H * (double)spp / (best * 1000.0);
+    printf("[BENCH] render %dx%d spp=%d depth=%d best=%.2f ms  %.2f Msamples/s\n",
+           W, H, spp, depth, best, mpx);
+    free(px);
+    return 0;
+}
+
+// ------------------------- scale -------------------------
+// The same frame at 1..MAXT threads (default: ysu_mt_suggest_threads). The
+// framebuffer is re-allocated per thread count so its first touch matches
+// that run's tile bands; run with YSU_PIN=1 to measure pinned placement.
+static int bench_scale(int argc, char **argv) {
+    int W     = arg_int(argc, argv, 2, 320);
+    int H     = arg_int(argc, argv, 3, 180);
+    int spp   = arg_int(argc, argv, 4, 8);
+    int depth = arg_int(argc, argv, 5, 6);
+    int maxt  = arg_int(argc, argv, 6, ysu_mt_suggest_threads());
+    int iters = arg_int(argc, argv, 7, 3);
+    if (W < 1 || H < 1 || spp < 1 || depth < 1 || maxt < 1 || iters < 1) return 1;
+
+    ysu_mt_print_topology();
+    Camera cam = camera_create((float)W / (float)H, 2.0f, 1.0f);
+
+    // the pool keeps the thread count of its first frame, so start at maxt
+    Vec3 *px = render_alloc_framebuffer(W, H, maxt, 0);
+    if (!px) return 1;
+    render_scene_mt(px, W, H, cam, spp, depth, maxt, 0);
+    render_free_framebuffer(px);
+
+    double base = 0.0;
+    for (int t = 1; t <= maxt; ++t) {
+        px = render_alloc_framebuffer(W, H, t, 0);
+        if (!px) return 1;
+        double best = 1e30;
+        for (int it = 0; it < iters; ++it) {
+            double t0 = bench_now_ms();
+            render_scene_mt(px, W, H, cam, spp, depth, t, 0);
+            double dt = bench_now_ms() - t0;
+            if (dt < best) best = dt;
+        }
+        render_free_framebuffer(px);
+        if (t == 1) base = best;
+
+        double mpx = (double)W * (double)H * (double)spp / (best * 1000.0);
+        double speedup = base / best;
+        printf("[BENCH] scale threads=%d best=%.2f ms  %.2f Msamples/s  speedup=x%.2f  efficiency=%.0f%%\n",
+               t, best, mpx, speedup, 100.0 * speedup / (double)t);
+    }
+    return 0;
+}
+
+// ------------------------- 360 -------------------------
+// Equirect at WxH and a cubemap strip with about as many pixels, against the
+// perspective frame at WxH; all on the pool, so the ratios are lens overhead.
+static int bench_360(int argc, char **argv) {
+    int W     = arg_int(argc, argv, 2, 1024);
+    int H     = arg_int(argc, argv, 3, 512);
+    int spp   = arg_int(argc, argv, 4, 4);
+    int depth = arg_int(argc, argv, 5, 6);
+    int iters = arg_int(argc, argv, 6, 3);
+    if (W < 1 || H < 1 || spp < 1 || depth < 1 || iters < 1) return 1;
+
+    int F = (int)sqrt((double)W * (double)H / 6.0);
+    if (F < 1) F = 1;
+    size_t n = (size_t)W * (size_t)H;
+    if ((size_t)6 * (size_t)F * (size_t)F > n) n = (size_t)6 * (size_t)F * (size_t)F;
+    Vec3 *px = (Vec3*)malloc(sizeof(Vec3) * n);
+    if (!px) return 1;
+    Camera cam = camera_create((float)W / (float)H, 2.0f, 1.0f);
+    Vec3 o = cam.origin;
+
+    const char *names[3] = { "perspective", "equirect", "cubemap" };
+    double best[3] = { 1e30, 1e30, 1e30 };
+    render_scene_mt(px, W, H, cam, spp, depth, 0, 0);   // warm-up
+    for (int it = 0; it < iters; ++it) {
+        for (int k = 0; k < 3; ++k) {
+            double t0 = bench_now_ms();
+            if (k == 0) render_scene_mt(px, W, H, cam, spp, depth, 0, 0);
+            if (k == 1) render_scene_360(px, W, H, o, YSU_LENS_EQUIRECT, spp, depth, 0, 0);
+            if (k == 2) render_scene_360(px, 6 * F, F, o, YSU_LENS_CUBEMAP, spp, depth, 0, 0);
+            double dt = bench_now_ms() - t0;
+            if (dt < best[k]) best[k] = dt;
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        double pix = (k == 2) ? 6.0 * (double)F * (double)F : (double)W * (double)H;
+        printf("[BENCH] 360 %-11s %s=%dx%d spp=%d best=%.2f ms  %.2f Msamples/s  x%.2f vs perspective\n",
+               names[k], (k == 2) ? "strip" : "size", (k == 2) ? 6 * F : W, (k == 2) ? F : H, spp,
+               best[k], pix * (double)spp / (best[k] * 1000.0), best[k] / best[0]);
+    }
+    free(px);
+    return 0;
+}
+
+// ------------------------- bvh -------------------------
+// Builds the same sphere set with each builder (serial and on the
+// suggested thread count) and traces a 256x256 grid of primary rays at the
+// scene's bounds: visits/ray from the counting bvh_hit() traversal, then
+// closest-hit throughput of the pointer tree (bvh_hit_closest), its
+// flattened 32-byte copy and the BVH4 / BVH8 collapses. Sets: SCENE
+// (default DATA/scene.txt, skipped if missing) and N random spheres with
+// clustered density (default 1M).
+#define BENCH_BVH_GRID 256
+
+static volatile int g_bench_sink;   // keeps timed traversals from being optimized out
+
+static void bench_bvh_set(const char *label, const Sphere *src, int n, int iters) {
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    if (!sp) return;
+
+    aabb box = sphere_bounds(&src[0]);
+    for (int i = 1; i < n; ++i) box = aabb_surrounding(box, sphere_bounds(&src[i]));
+    Vec3 at = vec3_scale(vec3_add(box.minimum, box.maximum), 0.5f);
+    Vec3 ext = vec3_sub(box.maximum, box.minimum);
+    float size = fmaxf(ext.x, fmaxf(ext.y, ext.z));
+    Vec3 from = vec3_add(at, vec3(0.35f * size, 0.25f * size, 1.2f * size));
+    Camera cam = camera_look_at(from, at, vec3(0.0f, 1.0f, 0.0f), 50.0f, 1.0f);
+
+    int threads = ysu_mt_suggest_threads();
+    struct { const char *name; BvhBuildMode mode; int threads; } cases[4] = {
+        { "median", BVH_BUILD_MEDIAN, 1 }, { "median", BVH_BUILD_MEDIAN, threads },
+        { "sah",    BVH_BUILD_SAH,    1 }, { "sah",    BVH_BUILD_SAH,    threads },
+    };
+    const char *leaf = getenv("YSU_BVH_LEAF");
+    double base_visits = 0.0;
+
+    for (int c = 0; c < 4; ++c) {
+        if (threads <= 1 && (c & 1)) continue;
+        BvhBuildOpts o;
+        bvh_build_opts_default(&o);
+        o.mode = cases[c].mode;
+        o.threads = cases[c].threads;
+        if (!leaf || !leaf[0]) o.leaf_size = (o.mode == BVH_BUILD_SAH) ? 4 : 2;
+
+        double best = 1e30;
+        bvh_node *root = NULL;
+        for (int it = 0; it < iters; ++it) {
+            memcpy(sp, src, sizeof(Sphere) * (size_t)n);
+            if (root) bvh_free(root);
+            double t0 = bench_now_ms();
+            root = bvh_build_ex(sp, 0, n, &o);
+            double dt = bench_now_ms() - t0;
+            if (dt < best) best = dt;
+        }
+        if (!root) {
+            printf("[BENCH] bvh %s %s build failed\n", label, cases[c].name);
+            continue;
+        }
+
+        BvhTreeStats st;
+        bvh_tree_stats(root, &st);
+
+        uint64_t v0 = g_bvh_node_visits;
+        for (int y = 0; y < BENCH_BVH_GRID; ++y) {
+            for (int x = 0; x < BENCH_BVH_GRID; ++x) {
+                Ray r = camera_get_ray(cam, ((float)x + 0.5f) / BENCH_BVH_GRID,
+                                            ((float)y + 0.5f) / BENCH_BVH_GRID);
+                HitRecord rec;
+                (void)bvh_hit(root, sp, &r, 0.001f, 1e30f, &rec);
+            }
+        }
+        double visits = (double)(g_bvh_node_visits - v0) / (double)(BENCH_BVH_GRID * BENCH_BVH_GRID);
+        if (c == 0) base_visits = visits;
+
+        BvhFlat flat;
+        BvhWide w4, w8;
+        double trace[4] = { 1e30, 1e30, 1e30, 1e30 };
+        int flat_ok = bvh_flatten(root, &flat);
+        int wide_ok = bvh_wide_build(root, 4, &w4);
+        wide_ok = bvh_wide_build(root, 8, &w8) && wide_ok;
+        for (int it = 0; flat_ok && wide_ok && it < iters; ++it) {
+            for (int k = 0; k < 4; ++k) {
+                int hits = 0;
+                double t0 = bench_now_ms();
+                for (int y = 0; y < BENCH_BVH_GRID; ++y) {
+                    for (int x = 0; x < BENCH_BVH_GRID; ++x) {
+                        Ray r = camera_get_ray(cam, ((float)x + 0.5f) / BENCH_BVH_GRID,
+                                                    ((float)y + 0.5f) / BENCH_BVH_GRID);
+                        float t;
+                        int h = (k == 0) ? bvh_hit_closest(root, sp, &r, 0.001f, 1e30f, &t)
+                              : (k == 1) ? bvh_flat_hit_closest(&flat, sp, &r, 0.001f, 1e30f, &t)
+                              : bvh_wide_hit_closest((k == 2) ? &w4 : &w8, sp, &r, 0.001f, 1e30f, &t);
+                        hits += (h >= 0);
+                    }
+                }
+                double dt = bench_now_ms() - t0;
+                if (dt < trace[k]) trace[k] = dt;
+                g_bench_sink += hits;
+            }
+        }
+        double mrays = (double)(BENCH_BVH_GRID * BENCH_BVH_GRID) / 1000.0;
+
+        printf("[BENCH] bvh %-6s n=%d %-6s threads=%d leaf=%d build=%.2f ms  nodes=%d depth=%d sah=%.1f"
+               "  visits/ray=%.2f (x%.2f)  closest Mrays/s: ptr %.2f flat %.2f bvh4 %.2f bvh8%s %.2f\n",
+               label, n, cases[c].name, o.threads, o.leaf_size, best, st.nodes, st.max_depth,
+               st.sah_cost, visits, visits / base_visits, mrays / trace[0], mrays / trace[1],
+               mrays / trace[2], w8.avx2 ? "(avx2)" : "", mrays / trace[3]);
+        bvh_flat_free(&flat);
+        bvh_wide_free(&w4);
+        bvh_wide_free(&w8);
+        bvh_free(root);
+    }
+    free(sp);
+}
+
+// Degenerate inputs against brute force: n spheres sharing one centre
+// (distinct radii), alone and with a chain of small outliers along +x,
+// each 3x farther than the last. With 2 bins SAH can only peel the chain
+// off one outlier per level, which drives the tree to its depth limit
+// before the shared-centre median splits. Leaf size 1, serial and threaded
+// SAH; closest hits from the pointer and flat trees must match a loop over
+// all spheres. Returns 0 when they do.
+#define BENCH_BVH_DEGEN_CHAIN 60
+#define BENCH_BVH_DEGEN_RAYS  256
+
+static int bench_bvh_brute(const Sphere *sp, int n, const Ray *r, float *t_out) {
+    const float a = vec3_length_squared(r->direction);
+    int best = -1;
+    float closest = 1e30f;
+    for (int i = 0; i < n; ++i) {
+        Vec3 oc = vec3_sub(r->origin, sp[i].center);
+        float half_b = vec3_dot(oc, r->direction);
+        float c = vec3_length_squared(oc) - sp[i].radius * sp[i].radius;
+        float disc = half_b * half_b - a * c;
+        if (!(disc >= 0.0f)) continue;   // far outliers overflow to inf - inf
+        float sq = sqrtf(disc);
+        float t = (-half_b - sq) / a;
+        if (t < 0.001f || t > closest) {
+            t = (-half_b + sq) / a;
+            if (t < 0.001f || t > closest) continue;
+        }
+        closest = t;
+        best = i;
+    }
+    *t_out = closest;
+    return best;
+}
+
+static int bench_bvh_degenerate(int n) {
+    int total = n + BENCH_BVH_DEGEN_CHAIN;
+    Sphere *src = (Sphere*)malloc(sizeof(Sphere) * (size_t)total);
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)total);
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * BENCH_BVH_DEGEN_RAYS);
+    if (!src || !sp || !rays) { free(src); free(sp); free(rays); return 1; }
+
+    for (int i = 0; i < n; ++i) src[i] = sphere_create(vec3(0.0f, 0.0f, 0.0f), 0.5f + 0.5f * (float)i / (float)n, 0);
+    float x = 2.0f;
+    for (int i = 0; i < BENCH_BVH_DEGEN_CHAIN; ++i, x *= 3.0f) src[n + i] = sphere_create(vec3(x, 0.0f, 0.0f), 0.01f, 0);
+
+    // out of the shared centre along the chain (every outlier box is hit,
+    // so traversal stacks one far child per level), then from all around
+    // onto the centre
+    uint32_t s = 0x2545F491u;
+    for (int k = 0; k < BENCH_BVH_DEGEN_RAYS; ++k) {
+        float u[3];
+        for (int j = 0; j < 3; ++j) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[j] = (float)(s >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f;
+        }
+        if (k < 16) {
+            rays[k] = ray_create(vec3(0.0f, 0.004f * u[1], 0.004f * u[2]), vec3(1.0f, 0.0f, 0.0f));
+            continue;
+        }
+        Vec3 d = vec3_normalize(vec3(u[0], u[1], u[2] + 0.01f));
+        rays[k] = ray_create(vec3_scale(d, 10.0f), vec3_scale(d, -1.0f));
+    }
+
+    int threads = ysu_mt_suggest_threads();
+    int fail = 0;
+    for (int chain = 0; chain < 2; ++chain) {
+        int cnt = chain ? total : n;
+        for (int c = 0; c < 2; ++c) {
+            BvhBuildOpts o;
+            bvh_build_opts_default(&o);
+            o.mode = BVH_BUILD_SAH;
+            o.leaf_size = 1;
+            o.bins = chain ? 2 : o.bins;
+            o.threads = c ? (threads > 1 ? threads : 4) : 1;   // the parallel path even on one core
+            memcpy(sp, src, sizeof(Sphere) * (size_t)cnt);
+            bvh_node *root = bvh_build_ex(sp, 0, cnt, &o);
+            BvhFlat flat;
+            if (!root || !bvh_flatten(root, &flat)) {
+                printf("[BENCH] bvh degenerate build failed\n");
+                if (root) bvh_free(root);
+                fail = 1;
+                continue;
+            }
+            BvhTreeStats st;
+            bvh_tree_stats(root, &st);
+            int bad = 0;
+            for (int k = 0; k < BENCH_BVH_DEGEN_RAYS; ++k) {
+                float tb, tp = 1e30f, tf = 1e30f;
+                int ib = bench_bvh_brute(sp, cnt, &rays[k], &tb);
+                int ip = bvh_hit_closest(root, sp, &rays[k], 0.001f, 1e30f, &tp);
+                int jf = bvh_flat_hit_closest(&flat, sp, &rays[k], 0.001f, 1e30f, &tf);
+                // nearby radii round to the same t: compare t, not the index
+                bad += ((ip < 0) != (ib < 0)) || ((jf < 0) != (ib < 0)) || (ib >= 0 && (tp != tb || tf != tb));
+            }
+            printf("[BENCH] bvh degenerate n=%d %s threads=%d depth=%d (stack %d)  %d/%d rays differ from brute force\n",
+                   cnt, chain ? "equal+chain" : "equal", o.threads, st.max_depth, BVH_STACK_MAX, bad,
+                   BENCH_BVH_DEGEN_RAYS);
+            if (bad || st.max_depth >= BVH_STACK_MAX) fail = 1;
+            bvh_flat_free(&flat);
+            bvh_free(root);
+        }
+    }
+    free(src); free(sp); free(rays);
+    return fail;
+}
+
+static int bench_bvh(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 1000000);
+    int iters = arg_int(argc, argv, 3, 3);
+    const char *scene = (argc > 4) ? argv[4] : "DATA/scene.txt";
+    if (n < 1 || iters < 1) return 1;
+
+    SceneSphere *in = NULL;
+    int sn = load_scene_alloc(scene, &in);
+    if (sn > 0) {
+        Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)sn);
+        if (sp) {
+            for (int i = 0; i < sn; ++i) sp[i] = sphere_create(in[i].center, in[i].radius, 0);
+            bench_bvh_set("scene", sp, sn, iters);
+            free(sp);
+        }
+        free(in);
+    } else {
+        printf("[BENCH] bvh scene %s not loaded, skipped\n", scene);
+    }
+
+    // clustered random field: dense core, sparse outskirts
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    if (!sp) return 1;
+    uint32_t s = 0x9E3779B9u;
+    float r = 2.0f / cbrtf((float)n);
+    for (int i = 0; i < n; ++i) {
+        float u[4];
+        for (int k = 0; k < 4; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        float w = u[0] * u[0];   // pulls x toward 0
+        sp[i] = sphere_create(vec3(w * 40.0f - 20.0f, u[1] * 20.0f - 10.0f, u[2] * 40.0f - 20.0f),
+                              r * (0.5f + u[3]), 0);
+    }
+    bench_bvh_set("random", sp, n, iters);
+    free(sp);
+    return bench_bvh_degenerate(n > (1 << 17) ? n : (1 << 17)) ? 2 : 0;
+}
+
+// ------------------------- packet -------------------------
+// W x H primary rays in 4x2 pixel blocks plus one shadow ray per pixel to a
+// point light, traced as 8-ray packets and as single rays. Scenes: N
+// clustered spheres (flat BVH) and a 2N-triangle heightfield
+// (gpu_build_bvh_from_tri_vec4). "diff" counts lanes whose hit differs.
+typedef struct {
+    const BvhFlat *flat;
+    const Sphere *sp;
+    const BvhTriMesh *mesh;
+} BenchPacketScene;
+
+static int bench_packet_hit(const BenchPacketScene *sc, const Ray *r, float t_max, float *t) {
+    return sc->mesh ? bvh_tri_hit_closest(sc->mesh, r, 0.001f, t_max, t)
+                    : bvh_flat_hit_closest(sc->flat, sc->sp, r, 0.001f, t_max, t);
+}
+
+static void bench_packet_case(const char *label, const BenchPacketScene *sc, Camera cam,
+                              Vec3 light, int W, int H, int iters)
+{
+    int blocks = ((W + 3) / 4) * ((H + 1) / 2);
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * 8u * (size_t)blocks);
+    Ray *shadow = (Ray*)malloc(sizeof(Ray) * 8u * (size_t)blocks);
+    float *dist = (float*)malloc(sizeof(float) * 8u * (size_t)blocks);
+    int *masks = (int*)malloc(sizeof(int) * (size_t)blocks);
+    if (!rays || !shadow || !dist || !masks) {
+        free(rays); free(shadow); free(dist); free(masks);
+        return;
+    }
+
+    // primary rays; shadow rays start at the single-ray hit (or the far plane)
+    int b = 0;
+    for (int y = 0; y < H; y += 2) {
+        for (int x = 0; x < W; x += 4, ++b) {
+            masks[b] = 0;
+            for (int k = 0; k < 8; ++k) {
+                int px = x + (k & 3), py = y + (k >> 2);
+                Ray *r = &rays[b * 8 + k];
+                *r = camera_get_ray(cam, ((float)px + 0.5f) / (float)W, ((float)py + 0.5f) / (float)H);
+                if (px < W && py < H) masks[b] |= 1 << k;
+                float t = 50.0f;
+                (void)bench_packet_hit(sc, r, 1e30f, &t);
+                Vec3 p = ray_at(*r, t);
+                Vec3 to = vec3_sub(light, p);
+                dist[b * 8 + k] = vec3_length(to);
+                shadow[b * 8 + k] = ray_create(p, vec3_scale(to, 1.0f / dist[b * 8 + k]));
+            }
+        }
+    }
+
+    long diff = 0;
+    for (b = 0; b < blocks; ++b) {
+        BvhPacketHit h;
+        if (sc->mesh) bvh_packet_tri_hit_closest8(sc->mesh, &rays[b * 8], masks[b], 0.001f, 1e30f, &h);
+        else          bvh_packet_hit_closest8(sc->flat, sc->sp, &rays[b * 8], masks[b], 0.001f, 1e30f, &h);
+        for (int k = 0; k < 8; ++k) {
+            float t = 1e30f;
+            int ref = ((masks[b] >> k) & 1) ? bench_packet_hit(sc, &rays[b * 8 + k], 1e30f, &t) : -1;
+            diff += (ref != h.prim[k]) || (ref >= 0 && t != h.t[k]);
+        }
+    }
+
+    double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+    for (int it = 0; it < iters; ++it) {
+        int sink = 0;
+        double t0 = bench_now_ms();
+        for (b = 0; b < blocks; ++b) {
+            for (int k = 0; k < 8; ++k) {
+                float t;
+                if ((masks[b] >> k) & 1) sink += bench_packet_hit(sc, &rays[b * 8 + k], 1e30f, &t);
+            }
+        }
+        double t1 = bench_now_ms();
+        for (b = 0; b < blocks; ++b) {
+            BvhPacketHit h;
+            if (sc->mesh) bvh_packet_tri_hit_closest8(sc->mesh, &rays[b * 8], masks[b], 0.001f, 1e30f, &h);
+            else          bvh_packet_hit_closest8(sc->flat, sc->sp, &rays[b * 8], masks[b], 0.001f, 1e30f, &h);
+            sink += h.prim[0];
+        }
+        double t2 = bench_now_ms();
+        for (b = 0; b < blocks; ++b) {
+            for (int k = 0; k < 8; ++k) {
+                float t;
+                if ((masks[b] >> k) & 1) sink += bench_packet_hit(sc, &shadow[b * 8 + k], dist[b * 8 + k], &t);
+            }
+        }
+        double t3 = bench_now_ms();
+        for (b = 0; b < blocks; ++b) {
+            int occ = sc->mesh ? bvh_packet_tri_occluded8(sc->mesh, &shadow[b * 8], masks[b], 0.001f, &dist[b * 8])
+                               : bvh_packet_occluded8(sc->flat, sc->sp, &shadow[b * 8], masks[b], 0.001f, &dist[b * 8]);
+            sink += occ;
+        }
+        double t4 = bench_now_ms();
+        double d[4] = { t1 - t0, t2 - t1, t3 - t2, t4 - t3 };
+        for (int k = 0; k < 4; ++k) if (d[k] < best[k]) best[k] = d[k];
+        g_bench_sink += sink;
+    }
+
+    double mrays = (double)W * (double)H / 1000.0;
+    printf("[BENCH] packet %-6s %dx%d  primary Mrays/s: single %.2f packet %.2f (x%.2f)"
+           "  shadow Mrays/s: single %.2f packet %.2f (x%.2f)  diff=%ld\n",
+           label, W, H, mrays / best[0], mrays / best[1], best[0] / best[1],
+           mrays / best[2], mrays / best[3], best[2] / best[3], diff);
+    free(rays); free(shadow); free(dist); free(masks);
+}
+
+// Heightfield over [-20,20]^2 with about n triangles, 2 per cell, 12 floats
+// (3 vec4) per triangle. Caller frees.
+static float *bench_heightfield(int n, uint32_t *tri_count_out) {
+    int g = (int)sqrtf((float)n * 0.5f);
+    if (g < 1) g = 1;
+    uint32_t tri_count = (uint32_t)(2 * g * g);
+    float *tris = (float*)calloc((size_t)tri_count * 12u, sizeof(float));
+    if (!tris) return NULL;
+    uint32_t t = 0;
+    for (int z = 0; z < g; ++z) {
+        for (int x = 0; x < g; ++x) {
+            float p[4][3];
+            for (int c = 0; c < 4; ++c) {
+                float px = -20.0f + 40.0f * (float)(x + ((c == 1 || c == 2) ? 1 : 0)) / (float)g;
+                float pz = -20.0f + 40.0f * (float)(z + ((c >= 2) ? 1 : 0)) / (float)g;
+                p[c][0] = px;
+                p[c][1] = 2.0f * sinf(px * 0.7f) * cosf(pz * 0.5f);
+                p[c][2] = pz;
+            }
+            static const int k_tri[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            for (int h = 0; h < 2; ++h, ++t) {
+                for (int v = 0; v < 3; ++v) {
+                    memcpy(&tris[(size_t)t * 12u + (size_t)v * 4u], p[k_tri[h][v]], sizeof(float) * 3);
+                }
+            }
+        }
+    }
+    *tri_count_out = tri_count;
+    return tris;
+}
+
+// render_gbuffer() over the sphere field on the ground plane with depth and
+// shadow planes: primary and shadow rays go through the packet kernel unless
+// YSU_PACKET=0. The hash covers both planes and must not change with
+// YSU_PACKET or YSU_BVH_WIDTH.
+static int bench_packet_gbuffer(const Sphere *sp, int n, Camera cam, int W, int H) {
+    size_t px = (size_t)W * (size_t)H;
+    float *depth = (float*)malloc(sizeof(float) * px);
+    float *shadow = (float*)malloc(sizeof(float) * px);
+    int ok = depth && shadow && render_set_scene(sp, n, NULL, 0, 1);
+    if (ok) {
+        YSU_GBuffer gb;
+        memset(&gb, 0, sizeof(gb));
+        gb.width = W;
+        gb.height = H;
+        gb.depth = depth;
+        gb.shadow = shadow;
+        double t0 = bench_now_ms();
+        ok = render_gbuffer(&gb, cam, 0, 0);
+        double ms = bench_now_ms() - t0;
+        if (ok) {
+            uint64_t h = 1469598103934665603ull;
+            long lit = 0, hit = 0;
+            const float *planes[2] = { depth, shadow };
+            for (int c = 0; c < 2; ++c) {
+                const unsigned char *b = (const unsigned char*)planes[c];
+                for (size_t i = 0; i < px * sizeof(float); ++i) h = (h ^ b[i]) * 1099511628211ull;
+            }
+            for (size_t i = 0; i < px; ++i) {
+                hit += shadow[i] >= 0.0f;
+                lit += shadow[i] > 0.0f;
+            }
+            printf("[BENCH] packet gbuffer %dx%d depth+shadow %.2f ms  %ld/%ld hits lit  hash %016llx\n",
+                   W, H, ms, lit, hit, (unsigned long long)h);
+        }
+    }
+    render_set_scene(NULL, 0, NULL, 0, 0);
+    free(depth); free(shadow);
+    return ok;
+}
+
+static int bench_packet(int argc, char **argv) {
+    int W     = arg_int(argc, argv, 2, 512);
+    int H     = arg_int(argc, argv, 3, 512);
+    int n     = arg_int(argc, argv, 4, 200000);
+    int iters = arg_int(argc, argv, 5, 3);
+    if (W < 1 || H < 1 || n < 1 || iters < 1) return 1;
+
+    const BvhPacketConfig *pc = bvh_packet_config();
+    printf("[BENCH] packet kernel=%s min_active=%d\n",
+           (pc->enabled && pc->avx2) ? "avx2" : "single", pc->min_active);
+
+    Camera cam = camera_look_at(vec3(14.0f, 10.0f, 48.0f), vec3(0.0f, 0.0f, 0.0f),
+                                vec3(0.0f, 1.0f, 0.0f), 50.0f, (float)W / (float)H);
+    Vec3 light = vec3(-10.0f, 30.0f, 20.0f);
+
+    // same clustered field as the bvh bench
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    if (!sp) return 1;
+    uint32_t s = 0x9E3779B9u;
+    float r = 2.0f / cbrtf((float)n);
+    for (int i = 0; i < n; ++i) {
+        float u[4];
+        for (int k = 0; k < 4; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        float w = u[0] * u[0];
+        sp[i] = sphere_create(vec3(w * 40.0f - 20.0f, u[1] * 20.0f - 10.0f, u[2] * 40.0f - 20.0f),
+                              r * (0.5f + u[3]), 0);
+    }
+    bvh_node *root = bvh_build(sp, 0, n);
+    BvhFlat flat;
+    if (root && bvh_flatten(root, &flat)) {
+        BenchPacketScene sc = { &flat, sp, NULL };
+        bench_packet_case("sphere", &sc, cam, light, W, H, iters);
+        bvh_flat_free(&flat);
+    }
+    bvh_free(root);
+    if (!bench_packet_gbuffer(sp, n, cam, W, H)) { free(sp); return 1; }
+    free(sp);
+
+    uint32_t tri_count = 0;
+    float *tris = bench_heightfield(n, &tri_count);
+    if (!tris) return 1;
+    GPUBVHNode *nodes = NULL;
+    int32_t *indices = NULL;
+    uint32_t node_count = 0, index_count = 0;
+    if (gpu_build_bvh_from_tri_vec4(tris, tri_count, &nodes, &node_count, &indices, &index_count)) {
+        BvhTriMesh mesh = { nodes, node_count, indices, tris };
+        BenchPacketScene sc = { NULL, NULL, &mesh };
+        bench_packet_case("tri", &sc, cam, light, W, H, iters);
+    }
+    free(nodes);
+    free(indices);
+    free(tris);
+    return 0;
+}
+
+// ------------------------- lbvh -------------------------
+// Parallel LBVH build of an N-triangle heightfield on 1 thread and on
+// YSU_BVH_THREADS (default: all CPUs); the trees must match. Then the mesh
+// as 8 chunks through gpu_bvh_build_jobs with either builder.
+static int bench_lbvh(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 5000000);
+    int iters = arg_int(argc, argv, 3, 3);
+    if (n < 1 || iters < 1) return 1;
+
+    uint32_t tri_count = 0;
+    float *tris = bench_heightfield(n, &tri_count);
+    if (!tris) return 1;
+
+    const char *env = getenv("YSU_BVH_THREADS");
+    int threads = (env && env[0]) ? atoi(env) : ysu_mt_suggest_threads();
+    if (threads < 1) threads = 1;
+    int runs[2] = { 1, threads };
+    double best[2] = { 1e30, 1e30 };
+    GPUBVHNode *nodes[2] = { NULL, NULL };
+    int32_t *indices[2] = { NULL, NULL };
+    uint32_t node_count[2] = { 0, 0 }, index_count[2] = { 0, 0 };
+
+    for (int c = 0; c < 2; ++c) {
+        for (int it = 0; it < iters; ++it) {
+            free(nodes[c]);
+            free(indices[c]);
+            double t0 = bench_now_ms();
+            if (!gpu_build_bvh_from_tri_vec4_lbv_ex(tris, tri_count, runs[c], &nodes[c], &node_count[c],
+                                                    &indices[c], &index_count[c])) {
+                printf("[BENCH] lbvh build failed\n");
+                free(tris);
+                return 1;
+            }
+            double ms = bench_now_ms() - t0;
+            if (ms < best[c]) best[c] = ms;
+        }
+    }
+
+    int same = node_count[0] == node_count[1] && index_count[0] == index_count[1] &&
+               memcmp(nodes[0], nodes[1], sizeof(GPUBVHNode) * node_count[0]) == 0 &&
+               memcmp(indices[0], indices[1], sizeof(int32_t) * index_count[0]) == 0;
+    printf("[BENCH] lbvh %u tris  1 thread %.1f ms (%.1f Mtris/s)  %d threads %.1f ms (%.1f Mtris/s, x%.2f)"
+           "  nodes %u  %s\n",
+           tri_count, best[0], tri_count / (best[0] * 1000.0), threads, best[1],
+           tri_count / (best[1] * 1000.0), best[0] / best[1], node_count[1], same ? "identical" : "DIFFER");
+
+    for (int c = 0; c < 2; ++c) { free(nodes[c]); free(indices[c]); }
+
+    // the same mesh as 8 chunks through the job API, median vs LBVH per chunk
+    enum { CHUNKS = 8 };
+    double job_ms[2] = { 1e30, 1e30 };
+    for (int b = 0; b < 2; ++b) {
+        for (int it = 0; it < iters; ++it) {
+            GpuBvhBuildJob jobs[CHUNKS];
+            memset(jobs, 0, sizeof(jobs));
+            for (int k = 0; k < CHUNKS; ++k) {
+                uint32_t s0 = (uint32_t)(((uint64_t)tri_count * (uint64_t)k) / CHUNKS);
+                uint32_t s1 = (uint32_t)(((uint64_t)tri_count * (uint64_t)(k + 1)) / CHUNKS);
+                jobs[k].tri_data  = tris + (size_t)s0 * 12u;
+                jobs[k].tri_count = s1 - s0;
+                jobs[k].builder   = b ? GPU_BVH_BUILDER_LBVH : GPU_BVH_BUILDER_MEDIAN;
+            }
+            double ms = 0.0;
+            int ok = gpu_bvh_build_jobs(jobs, CHUNKS, threads, &ms);
+            for (int k = 0; k < CHUNKS; ++k) { free(jobs[k].nodes); free(jobs[k].indices); }
+            if (ok && ms < job_ms[b]) job_ms[b] = ms;
+        }
+    }
+    printf("[BENCH] bvh jobs %d chunks, %d threads  median %.1f ms  lbvh %.1f ms\n",
+           CHUNKS, threads, job_ms[0], job_ms[1]);
+
+    free(tris);
+    return same ? 0 : 2;
+}
+
+// ------------------------- tlas -------------------------
+// INST instances of one N-triangle heightfield on a grid (random yaw and
+// scale) behind a TLAS. Times BLAS / TLAS builds, a TLAS rebuild after every
+// instance moved, and W x H primary + shadow rays. Small scenes are also
+// flattened into one world-space BVH; "diff" counts rays whose hit differs.
+static int bench_tlas(int argc, char **argv) {
+    int inst  = arg_int(argc, argv, 2, 10000);
+    int n     = arg_int(argc, argv, 3, 100000);
+    int iters = arg_int(argc, argv, 4, 3);
+    const int W = 640, H = 360;
+    if (inst < 1 || n < 1 || iters < 1) return 1;
+
+    uint32_t tri_count = 0;
+    float *tris = bench_heightfield(n, &tri_count);
+    if (!tris) return 1;
+
+    Tlas tl;
+    tlas_init(&tl);
+    double t0 = bench_now_ms();
+    int blas = tlas_add_blas(&tl, tris, tri_count);
+    double blas_ms = bench_now_ms() - t0;
+    if (blas < 0) { free(tris); return 1; }
+
+    int side = (int)ceilf(sqrtf((float)inst));
+    float span = 50.0f * (float)side;
+    uint32_t s = 0x2545F491u;
+    float *yaw = (float*)malloc(sizeof(float) * (size_t)inst);
+    float *scl = (float*)malloc(sizeof(float) * (size_t)inst);
+    if (!yaw || !scl) { free(yaw); free(scl); tlas_free(&tl); free(tris); return 1; }
+    for (int i = 0; i < inst; ++i) {
+        float u[2];
+        for (int k = 0; k < 2; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        yaw[i] = u[0] * 6.2831853f;
+        scl[i] = 0.8f + 0.4f * u[1];
+        float xf[12];
+        tlas_xform_trs(xf, vec3(50.0f * (float)(i % side) - 0.5f * span, 0.0f, 50.0f * (float)(i / side) - 0.5f * span),
+                       yaw[i], scl[i]);
+        if (tlas_add_instance(&tl, (uint32_t)blas, xf, (uint32_t)i) < 0) break;
+    }
+    t0 = bench_now_ms();
+    tlas_build(&tl);
+    double tlas_ms = bench_now_ms() - t0;
+
+    // every instance moves: only the top level is rebuilt
+    double move_ms = 1e30;
+    for (int it = 0; it < iters; ++it) {
+        t0 = bench_now_ms();
+        for (int i = 0; i < tl.inst_count; ++i) {
+            float xf[12];
+            tlas_xform_trs(xf, vec3(50.0f * (float)(i % side) - 0.5f * span, 0.5f * (float)(it + 1),
+                                    50.0f * (float)(i / side) - 0.5f * span),
+                           yaw[i] + 0.1f * (float)(it + 1), scl[i]);
+            tlas_set_transform(&tl, (uint32_t)i, xf);
+        }
+        tlas_build(&tl);
+        double ms = bench_now_ms() - t0;
+        if (ms < move_ms) move_ms = ms;
+    }
+
+    Camera cam = camera_look_at(vec3(0.0f, 0.35f * span + 30.0f, 0.6f * span + 40.0f), vec3(0.0f, 0.0f, 0.0f),
+                                vec3(0.0f, 1.0f, 0.0f), 50.0f, (float)W / (float)H);
+    Vec3 light = vec3(0.3f * span, span, 0.2f * span);
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * (size_t)W * (size_t)H);
+    TlasHit *hits = (TlasHit*)malloc(sizeof(TlasHit) * (size_t)W * (size_t)H);
+    if (!rays || !hits) { free(rays); free(hits); free(yaw); free(scl); tlas_free(&tl); free(tris); return 1; }
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            rays[y * W + x] = camera_get_ray(cam, ((float)x + 0.5f) / (float)W, ((float)y + 0.5f) / (float)H);
+        }
+    }
+
+    double prim_ms = 1e30, shadow_ms = 1e30;
+    long hit_count = 0, lit = 0;
+    for (int it = 0; it < iters; ++it) {
+        t0 = bench_now_ms();
+        hit_count = 0;
+        for (int i = 0; i < W * H; ++i) hit_count += tlas_hit_closest(&tl, &rays[i], 0.001f, 1e30f, &hits[i]);
+        double ms = bench_now_ms() - t0;
+        if (ms < prim_ms) prim_ms = ms;
+
+        t0 = bench_now_ms();
+        lit = 0;
+        for (int i = 0; i < W * H; ++i) {
+            if (hits[i].inst < 0) continue;
+            Vec3 p = ray_at(rays[i], hits[i].t);
+            Vec3 nrm = tlas_hit_normal(&tl, &hits[i]);
+            if (vec3_dot(nrm, rays[i].direction) > 0.0f) nrm = vec3_scale(nrm, -1.0f);
+            p = vec3_add(p, vec3_scale(nrm, 1e-3f));
+            Vec3 to = vec3_sub(light, p);
+            float d = vec3_length(to);
+            Ray sr = ray_create(p, vec3_scale(to, 1.0f / d));
+            lit += !tlas_occluded(&tl, &sr, 0.001f, d);
+        }
+        ms = bench_now_ms() - t0;
+        if (ms < shadow_ms) shadow_ms = ms;
+    }
+
+    // flattened reference for small scenes
+    long diff = -1;
+    size_t flat_tris = (size_t)tl.inst_count * tri_count;
+    if (flat_tris <= 4000000u) {
+        float *world = (float*)malloc(sizeof(float) * 12u * flat_tris);
+        GPUBVHNode *nodes = NULL;
+        int32_t *indices = NULL;
+        uint32_t node_count = 0, index_count = 0;
+        if (world) {
+            for (int i = 0; i < tl.inst_count; ++i) {
+                const float *m = tl.inst[i].xform;
+                for (uint32_t t = 0; t < tri_count; ++t) {
+                    const float *v = tris + (size_t)t * 12u;
+                    float *w = world + ((size_t)i * tri_count + t) * 12u;
+                    for (int c = 0; c < 3; ++c) {
+                        const float *p = v + 4 * c;
+                        for (int r = 0; r < 3; ++r) {
+                            w[4 * c + r] = m[4 * r] * p[0] + m[4 * r + 1] * p[1] + m[4 * r + 2] * p[2] + m[4 * r + 3];
+                        }
+                        w[4 * c + 3] = 0.0f;
+                    }
+                }
+            }
+        }
+        if (world && gpu_build_bvh_from_tri_vec4(world, (uint32_t)flat_tris, &nodes, &node_count,
+                                                 &indices, &index_count)) {
+            BvhTriMesh mesh = { nodes, node_count, indices, world };
+            diff = 0;
+            for (int i = 0; i < W * H; ++i) {
+                float t = 1e30f;
+                int ref = bvh_tri_hit_closest(&mesh, &rays[i], 0.001f, 1e30f, &t);
+                if ((ref >= 0) != (hits[i].inst >= 0)) diff++;
+                else if (ref >= 0 && fabsf(t - hits[i].t) > 1e-3f * t) diff++;
+            }
+        }
+        free(nodes);
+        free(indices);
+        free(world);
+    }
+
+    double rays_m = (double)W * (double)H / 1e6;
+    size_t blas_bytes = sizeof(GPUBVHNode) * tl.blas[blas].mesh.node_count + sizeof(int32_t) * tri_count +
+                        sizeof(float) * 12u * tri_count;
+    size_t per_inst = sizeof(TlasInstance) + sizeof(int32_t) + 2u * sizeof(GPUBVHNode);
+    printf("[BENCH] tlas %d inst x %u tris  blas %.1f ms (%.1f MB)  tlas %.2f ms  move+rebuild %.2f ms"
+           "  %zu B/inst (flat would be %.1f GB)\n",
+           tl.inst_count, tri_count, blas_ms, (double)blas_bytes / 1e6, tlas_ms, move_ms, per_inst,
+           (double)flat_tris * 48.0 / 1e9);
+    printf("[BENCH] tlas %dx%d  primary %.2f Mrays/s (hit %.1f%%)  shadow %.2f Mrays/s (lit %ld)  diff=%ld%s\n",
+           W, H, rays_m / (prim_ms / 1000.0), 100.0 * (double)hit_count / (double)(W * H),
+           (double)hit_count / 1e6 / (shadow_ms / 1000.0), lit, diff, diff < 0 ? " (no flat reference)" : "");
+
+    free(rays); free(hits); free(yaw); free(scl);
+    tlas_free(&tl);
+    free(tris);
+    return 0;
+}
+
+// ------------------------- refit -------------------------
+// N clustered spheres, the first MOVING of them swing back and forth along
+// random directions (amplitude 1, the scene is 40 across). Each frame the
+// render BVH (flat + wide) is either refitted (bvh_refit_step, partial
+// rebuilds past YSU_BVH_REFIT_MAX) or built from scratch, then a 128x128
+// grid of rays is traced through it. "diff" counts rays whose closest hit
+// differs between the two (grazing hits on the tiny far spheres can round
+// either way).
+#define BENCH_REFIT_GRID 128
+
+static void bench_refit_trace(const BvhFlat *flat, const BvhWide *wide, const Sphere *sp,
+                              Camera cam, float *hit_t)
+{
+    for (int y = 0; y < BENCH_REFIT_GRID; ++y) {
+        for (int x = 0; x < BENCH_REFIT_GRID; ++x) {
+            Ray r = camera_get_ray(cam, ((float)x + 0.5f) / BENCH_REFIT_GRID,
+                                        ((float)y + 0.5f) / BENCH_REFIT_GRID);
+            float t = 1e30f;
+            int h = wide->nodes ? bvh_wide_hit_closest(wide, sp, &r, 0.001f, 1e30f, &t)
+                                : bvh_flat_hit_closest(flat, sp, &r, 0.001f, 1e30f, &t);
+            hit_t[y * BENCH_REFIT_GRID + x] = (h >= 0) ? t : -1.0f;
+        }
+    }
+}
+
+static int bench_refit(int argc, char **argv) {
+    int n      = arg_int(argc, argv, 2, 200000);
+    int frames = arg_int(argc, argv, 3, 60);
+    int moving = arg_int(argc, argv, 4, n / 10);
+    if (n < 2 || frames < 1 || moving < 1) return 1;
+    if (moving > n) moving = n;
+
+    Sphere *anim = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);   // caller order
+    Vec3 *dir    = (Vec3*)malloc(sizeof(Vec3) * 2u * (size_t)moving);   // direction, home
+    Sphere *sr   = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);   // refit copy, slot order
+    Sphere *sb   = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);   // rebuilt copy
+    int32_t *ids = (int32_t*)malloc(sizeof(int32_t) * (size_t)n);
+    int32_t *slots = (int32_t*)malloc(sizeof(int32_t) * (size_t)moving);
+    float *hr = (float*)malloc(sizeof(float) * BENCH_REFIT_GRID * BENCH_REFIT_GRID);
+    float *hb = (float*)malloc(sizeof(float) * BENCH_REFIT_GRID * BENCH_REFIT_GRID);
+    if (!anim || !dir || !sr || !sb || !ids || !slots || !hr || !hb) {
+        free(anim); free(dir); free(sr); free(sb); free(ids); free(slots); free(hr); free(hb);
+        return 1;
+    }
+
+    uint32_t s = 0x9E3779B9u;
+    float rad = 2.0f / cbrtf((float)n);
+    for (int i = 0; i < n; ++i) {
+        float u[4];
+        for (int k = 0; k < 4; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        float w = u[0] * u[0];
+        anim[i] = sphere_create(vec3(w * 40.0f - 20.0f, u[1] * 20.0f - 10.0f, u[2] * 40.0f - 20.0f),
+                                rad * (0.5f + u[3]), 0);
+        if (i < moving) {
+            float z = 2.0f * u[1] - 1.0f, a = 6.2831853f * u[2], q = sqrtf(1.0f - z * z);
+            dir[i] = vec3(q * cosf(a), z, q * sinf(a));
+            dir[moving + i] = anim[i].center;
+        }
+    }
+    Camera cam = camera_look_at(vec3(14.0f, 10.0f, 48.0f), vec3(0.0f, 0.0f, 0.0f),
+                                vec3(0.0f, 1.0f, 0.0f), 50.0f, 1.0f);
+
+    BvhBuildOpts o;
+    bvh_build_opts_default(&o);
+    int width = bvh_wide_default_width();
+
+    BvhFlat flat;
+    BvhWide wide;
+    BvhRefit ctx;
+    memset(&wide, 0, sizeof(wide));
+    memcpy(sr, anim, sizeof(Sphere) * (size_t)n);
+    bvh_node *root = bvh_build_tracked(sr, 0, n, &o, ids);
+    int ok = root && bvh_flatten(root, &flat) && (width == 2 || bvh_wide_build(root, width, &wide));
+    bvh_free(root);
+    if (!ok || !bvh_refit_init(&ctx, &flat, width == 2 ? NULL : &wide, n, ids)) {
+        printf("[BENCH] refit build failed\n");
+        free(anim); free(dir); free(sr); free(sb); free(ids); free(slots); free(hr); free(hb);
+        return 1;
+    }
+
+    double refit_ms = 0.0, refit_max = 0.0, rebuild_ms = 0.0, full_ms = 0.0, full_max = 0.0;
+    double trace_r = 0.0, trace_b = 0.0;
+    int rebuilds = 0, rebuilt = 0;
+    float ratio_max = 1.0f;
+    long diff = 0;
+    for (int f = 1; f <= frames; ++f) {
+        for (int i = 0; i < moving; ++i) {
+            float phase = 0.15f * (float)f + 6.2831853f * (float)i / (float)moving;
+            anim[i].center = vec3_add(dir[moving + i], vec3_scale(dir[i], sinf(phase)));
+            int32_t sl = ctx.slot[i];
+            sr[sl].center = anim[i].center;
+            slots[i] = sl;
+        }
+
+        BvhRefitStats st;
+        bvh_refit_step(&ctx, sr, slots, moving, &o, &st);
+        double ms = st.refit_ms + st.rebuild_ms;
+        refit_ms += ms;
+        if (ms > refit_max) refit_max = ms;
+        if (st.rebuilt) { rebuilds++; rebuilt += st.rebuilt; rebuild_ms += st.rebuild_ms; }
+        if (st.sah_ratio > ratio_max) ratio_max = st.sah_ratio;
+
+        memcpy(sb, anim, sizeof(Sphere) * (size_t)n);
+        BvhFlat bf;
+        BvhWide bw;
+        memset(&bw, 0, sizeof(bw));
+        double t0 = bench_now_ms();
+        root = bvh_build_ex(sb, 0, n, &o);
+        ok = root && bvh_flatten(root, &bf) && (width == 2 || bvh_wide_build(root, width, &bw));
+        bvh_free(root);
+        ms = bench_now_ms() - t0;
+        if (!ok) { printf("[BENCH] refit rebuild failed\n"); break; }
+        full_ms += ms;
+        if (ms > full_max) full_max = ms;
+
+        t0 = bench_now_ms();
+        bench_refit_trace(&flat, &wide, sr, cam, hr);
+        double t1 = bench_now_ms();
+        bench_refit_trace(&bf, &bw, sb, cam, hb);
+        trace_b += bench_now_ms() - t1;
+        trace_r += t1 - t0;
+
+        for (int k = 0; k < BENCH_REFIT_GRID * BENCH_REFIT_GRID; ++k) {
+            if ((hr[k] >= 0.0f) != (hb[k] >= 0.0f)) diff++;
+            else if (hr[k] >= 0.0f && fabsf(hr[k] - hb[k]) > 1e-3f * hb[k]) diff++;
+        }
+        bvh_flat_free(&bf);
+        bvh_wide_free(&bw);
+    }
+
+    double mrays = (double)frames * BENCH_REFIT_GRID * BENCH_REFIT_GRID / 1000.0;
+    printf("[BENCH] refit n=%d moving=%d frames=%d BVH%d %s leaf %d\n", n, moving, frames, width,
+           (o.mode == BVH_BUILD_SAH) ? "sah" : "median", o.leaf_size);
+    printf("[BENCH] refit   update avg %.3f ms max %.3f ms  rebuilds %d (%d spheres, %.2f ms)  sah max x%.2f"
+           "  trace %.2f Mrays/s\n",
+           refit_ms / frames, refit_max, rebuilds, rebuilt, rebuild_ms, ratio_max, mrays / trace_r);
+    printf("[BENCH] rebuild update avg %.3f ms max %.3f ms  (x%.1f refit)  trace %.2f Mrays/s  diff=%ld\n",
+           full_ms / frames, full_max, full_ms / (refit_ms > 1e-9 ? refit_ms : 1e-9), mrays / trace_b, diff);
+
+    bvh_refit_free(&ctx);
+    bvh_flat_free(&flat);
+    bvh_wide_free(&wide);
+    free(anim); free(dir); free(sr); free(sb); free(ids); free(slots); free(hr); free(hb);
+    return 0;
+}
+
+// ------------------------- policy -------------------------
+// N clustered spheres; MODEL (default DATA/bvh_ml_model.json) is scored on
+// the counters of a 64x64 sample of a 256x256 primary-ray grid, then the
+// whole grid is traced through the flat BVH with and without the pruned
+// subtrees. "error" is the share of pixels whose closest hit changed. Then
+// bench_policy_frames() checks the renderer's online policy.
+#define BENCH_POLICY_GRID 256
+#define BENCH_POLICY_SAMPLE 64
+
+static double bench_policy_trace(const BvhFlat *flat, const Sphere *sp, Camera cam, float *hit_t) {
+    double t0 = bench_now_ms();
+    for (int y = 0; y < BENCH_POLICY_GRID; ++y) {
+        for (int x = 0; x < BENCH_POLICY_GRID; ++x) {
+            Ray r = camera_get_ray(cam, ((float)x + 0.5f) / BENCH_POLICY_GRID,
+                                        ((float)y + 0.5f) / BENCH_POLICY_GRID);
+            float t = 1e30f;
+            int h = bvh_flat_hit_closest(flat, sp, &r, 0.001f, 1e30f, &t);
+            hit_t[y * BENCH_POLICY_GRID + x] = (h >= 0) ? t : -1.0f;
+        }
+    }
+    return bench_now_ms() - t0;
+}
+
+// The renderer scores the policy on the first perspective frame after
+// render_set_scene(). A single frame and a batch-style sequence (first-touch
+// framebuffer, G-buffer and 360 dispatches before the frame, as in
+// ysu_render_campath) must prune the same nodes: the pixels the policy
+// changes against an unpruned render have to match exactly.
+static int bench_policy_frames(const Sphere *sp, int n, const char *path, Camera cam) {
+    const int W = 96, H = 96;
+    Vec3 *ref = (Vec3*)malloc(sizeof(Vec3) * W * H);
+    Vec3 *one = (Vec3*)malloc(sizeof(Vec3) * W * H);
+    Vec3 *env = (Vec3*)malloc(sizeof(Vec3) * 32 * 16);
+    float *depth = (float*)malloc(sizeof(float) * W * H);
+    Vec3 *batch = NULL;
+    int ok = ref && one && env && depth;
+    render_set_integrator(YSU_INTEGRATOR_DIRECT);
+    for (int k = 0; k < 3 && ok; ++k) {
+        render_set_policy_model(k ? path : NULL);
+        ok = render_set_scene(sp, n, NULL, 0, 0);
+        if (!ok) break;
+        if (k == 2) {
+            YSU_GBuffer gb;
+            memset(&gb, 0, sizeof(gb));
+            gb.width = W;
+            gb.height = H;
+            gb.depth = depth;
+            batch = render_alloc_framebuffer(W, H, 0, 0);
+            ok = batch && render_gbuffer(&gb, cam, 0, 0) &&
+                 render_scene_360(env, 32, 16, cam.origin, YSU_LENS_EQUIRECT, 1, 1, 0, 0);
+            if (!ok) break;
+        }
+        render_scene_mt((k == 0) ? ref : (k == 1) ? one : batch, W, H, cam, 1, 1, 0, 0);
+    }
+    render_set_policy_model(NULL);
+    render_set_scene(NULL, 0, NULL, 0, 0);
+
+    long changed = 0, differ = 0;
+    for (int i = 0; ok && i < W * H; ++i) {
+        if (memcmp(&one[i], &ref[i], sizeof(Vec3)) != 0) changed++;
+        if (memcmp(&one[i], &batch[i], sizeof(Vec3)) != 0) differ++;
+    }
+    if (ok) {
+        printf("[BENCH] policy frames %dx%d: %ld px changed by pruning, batch vs single frame %s (%ld px differ)\n",
+               W, H, changed, differ ? "DIFFER" : "identical", differ);
+    } else {
+        printf("[BENCH] policy frames: render failed\n");
+    }
+    free(ref); free(one); free(env); free(depth);
+    if (batch) render_free_framebuffer(batch);
+    return ok && differ == 0;
+}
+
+static int bench_policy(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 100000);
+    int iters = arg_int(argc, argv, 3, 3);
+    const char *path = (argc > 4) ? argv[4] : "DATA/bvh_ml_model.json";
+    if (n < 2 || iters < 1) return 1;
+
+    BvhPolicyModel model;
+    if (!bvh_policy_load(path, &model)) return 1;
+
+    const int grid = BENCH_POLICY_GRID * BENCH_POLICY_GRID;
+    const int ns = BENCH_POLICY_SAMPLE * BENCH_POLICY_SAMPLE;
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    Ray *rays  = (Ray*)malloc(sizeof(Ray) * (size_t)ns);
+    float *hf  = (float*)malloc(sizeof(float) * (size_t)grid);
+    float *hp  = (float*)malloc(sizeof(float) * (size_t)grid);
+    if (!sp || !rays || !hf || !hp) {
+        free(sp); free(rays); free(hf); free(hp);
+        return 1;
+    }
+
+    uint32_t s = 0x9E3779B9u;
+    float rad = 2.0f / cbrtf((float)n);
+    for (int i = 0; i < n; ++i) {
+        float u[4];
+        for (int k = 0; k < 4; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        float w = u[0] * u[0];
+        sp[i] = sphere_create(vec3(w * 40.0f - 20.0f, u[1] * 20.0f - 10.0f, u[2] * 40.0f - 20.0f),
+                              rad * (0.5f + u[3]), 0);
+    }
+    Camera cam = camera_look_at(vec3(14.0f, 10.0f, 48.0f), vec3(0.0f, 0.0f, 0.0f),
+                                vec3(0.0f, 1.0f, 0.0f), 50.0f, 1.0f);
+    for (int y = 0; y < BENCH_POLICY_SAMPLE; ++y) {
+        for (int x = 0; x < BENCH_POLICY_SAMPLE; ++x) {
+            rays[y * BENCH_POLICY_SAMPLE + x] = camera_get_ray(cam, ((float)x + 0.5f) / BENCH_POLICY_SAMPLE,
+                                                                    ((float)y + 0.5f) / BENCH_POLICY_SAMPLE);
+        }
+    }
+
+    BvhFlat full, pruned;
+    BvhPolicyStats st;
+    bvh_node *root = bvh_build(sp, 0, n);
+    int ok = root && bvh_flatten(root, &full);
+    if (ok) {
+        bvh_policy_eval(root, sp, rays, ns, &model, (float)grid / (float)ns, &st);
+        ok = bvh_flatten(root, &pruned);
+        if (!ok) bvh_flat_free(&full);
+    }
+    bvh_free(root);
+    if (!ok) {
+        printf("[BENCH] policy build failed\n");
+        free(sp); free(rays); free(hf); free(hp);
+        return 1;
+    }
+
+    double best_f = 1e30, best_p = 1e30;
+    for (int it = 0; it < iters; ++it) {
+        double ms = bench_policy_trace(&full, sp, cam, hf);
+        if (ms < best_f) best_f = ms;
+        ms = bench_policy_trace(&pruned, sp, cam, hp);
+        if (ms < best_p) best_p = ms;
+    }
+    long diff = 0;
+    for (int i = 0; i < grid; ++i) {
+        if ((hf[i] < 0.0f) != (hp[i] < 0.0f) || fabsf(hf[i] - hp[i]) > 1e-4f * fabsf(hf[i])) diff++;
+    }
+
+    printf("[BENCH] policy %d spheres  %s: marked %d, nodes %d -> %d (%d pruned), eval %.1f ms\n",
+           n, path, st.marked, full.count, pruned.count, st.removed, st.ms);
+    printf("[BENCH] policy sample %d rays: visits/ray %.1f -> %.1f (-%.1f%%), changed %d\n",
+           ns, (double)st.visits_full / ns, (double)st.visits_pruned / ns,
+           st.visits_full ? 100.0 * (double)(st.visits_full - st.visits_pruned) / (double)st.visits_full : 0.0,
+           st.rays_changed);
+    printf("[BENCH] policy %dx%d  full %.2f Mrays/s  pruned %.2f Mrays/s  x%.2f  error %.2f%% (%ld px)\n",
+           BENCH_POLICY_GRID, BENCH_POLICY_GRID, (double)grid / 1e6 / (best_f / 1000.0),
+           (double)grid / 1e6 / (best_p / 1000.0), best_f / best_p, 100.0 * (double)diff / (double)grid, diff);
+
+    bvh_flat_free(&full);
+    bvh_flat_free(&pruned);
+    free(rays); free(hf); free(hp);
+
+    int stable = bench_policy_frames(sp, n, path, cam);
+    free(sp);
+    return stable ? 0 : 2;
+}
+
+// ------------------------- raysort -------------------------
+// N clustered diffuse spheres rendered with the wavefront integrator at
+// depth 4, 6 and 8, YSU_RAY_SORT off and on. Rays/s is for the whole frame;
+// "trace" is the traversal stage alone (incl. the sort). Run with
+// YSU_PERF=1 for the stage timing and L1D / LLC misses per ray.
+static int bench_raysort(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 200000);
+    int W     = arg_int(argc, argv, 3, 320);
+    int H     = arg_int(argc, argv, 4, 180);
+    int spp   = arg_int(argc, argv, 5, 4);
+    int iters = arg_int(argc, argv, 6, 2);
+    if (n < 1 || W < 1 || H < 1 || spp < 1 || iters < 1) return 1;
+
+    Sphere *sp = (Sphere*)malloc(sizeof(Sphere) * (size_t)n);
+    Vec3 *px = (Vec3*)malloc(sizeof(Vec3) * (size_t)W * (size_t)H);
+    int nt = ysu_mt_suggest_threads();
+    YSU_ThreadStats *ts = (YSU_ThreadStats*)malloc(sizeof(YSU_ThreadStats) * (size_t)nt);
+    if (!sp || !px || !ts) {
+        free(sp); free(px); free(ts);
+        return 1;
+    }
+
+    uint32_t s = 0x9E3779B9u;
+    float rad = 10.0f / cbrtf((float)n);   // dense enough that bounces keep hitting
+    for (int i = 0; i < n; ++i) {
+        float u[4];
+        for (int k = 0; k < 4; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            u[k] = (float)(s >> 8) * (1.0f / 16777216.0f);
+        }
+        float w = u[0] * u[0];
+        sp[i] = sphere_create(vec3(w * 40.0f - 20.0f, u[1] * 20.0f - 10.0f, u[2] * 40.0f - 20.0f),
+                              rad * (0.5f + u[3]), i & 1);
+    }
+    Material mats[2] = {
+        { MAT_LAMBERTIAN, { 0.8f, 0.4f, 0.3f }, 0.0f, 1.0f, { 0.0f, 0.0f, 0.0f } },
+        { MAT_LAMBERTIAN, { 0.4f, 0.7f, 0.5f }, 0.0f, 1.0f, { 0.0f, 0.0f, 0.0f } },
+    };
+    if (!render_set_scene(sp, n, mats, 2, 1)) {
+        free(sp); free(px); free(ts);
+        return 1;
+    }
+    Camera cam = camera_look_at(vec3(14.0f, 10.0f, 48.0f), vec3(0.0f, 0.0f, 0.0f),
+                                vec3(0.0f, 1.0f, 0.0f), 50.0f, (float)W / (float)H);
+    render_set_integrator(YSU_INTEGRATOR_WAVEFRONT);
+    render_scene_mt(px, W, H, cam, 1, 2, nt, 0);   // warm-up: pool, scratch
+
+    for (int depth = 4; depth <= 8; depth += 2) {
+        double mrays[2] = { 0.0, 0.0 };
+        for (int sort = 0; sort < 2; ++sort) {
+            render_set_ray_sort(sort);
+            double best = 1e30, trace_ms = 0.0;
+            uint64_t rays = 0, trays = 0, l1 = 0, llc = 0;
+            for (int it = 0; it < iters; ++it) {
+                double t0 = bench_now_ms();
+                render_scene_mt(px, W, H, cam, spp, depth, nt, 0);
+                double dt = bench_now_ms() - t0;
+                if (dt >= best) continue;
+                best = dt;
+                rays = trays = l1 = llc = 0;
+                trace_ms = 0.0;
+                int m = render_get_thread_stats(ts, nt, NULL);
+                for (int i = 0; i < m; ++i) {
+                    rays += ts[i].rays;
+                    trays += ts[i].trace_rays;
+                    trace_ms += ts[i].trace_ms;
+                    l1 += ts[i].l1d_misses;
+                    llc += ts[i].llc_misses;
+                }
+            }
+            mrays[sort] = (double)rays / (best * 1000.0);
+            printf("[BENCH] raysort depth=%d sort=%s best=%.2f ms  %.2f Mrays/s", depth, sort ? "on " : "off",
+                   best, mrays[sort]);
+            if (trays) {
+                printf("  trace %.2f Mrays/s/thread", (double)trays / (trace_ms * 1000.0));
+                if (l1 || llc) {
+                    printf("  L1D miss/ray=%.2f  LLC miss/ray=%.3f", (double)l1 / (double)trays, (double)llc / (double)trays);
+                } else {
+                    printf("  (cache counters unavailable)");
+                }
+            }
+            printf("\n");
+        }
+        printf("[BENCH] raysort depth=%d speedup x%.2f\n", depth, (mrays[0] > 0.0) ? mrays[1] / mrays[0] : 0.0);
+    }
+
+    render_set_ray_sort(0);
+    free(sp); free(px); free(ts);
+    return 0;
+}
+
+// ------------------------- obj -------------------------
+// Writes a MTRIS-million-triangle grid mesh (quads, with vt/vn indices like
+// a scanner export) to ysu_bench.obj, or loads FILE. Parses it on one
+// thread and on THREADS, then through the binary cache twice: "cold" parses
+// and writes the cache, "warm" hashes the OBJ and reads the cache. The OS
+// page cache is warm for all runs.
+static int bench_obj_write(const char *path, double mtris) {
+    int side = (int)sqrt(mtris * 1e6 / 2.0);
+    if (side < 2) side = 2;
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    for (int y = 0; y <= side; ++y) {
+        for (int x = 0; x <= side; ++x) {
+            float h = 0.25f * sinf(0.05f * (float)x) * cosf(0.07f * (float)y);
+            fprintf(f, "v %.6f %.6f %.6f\n", (float)x * 0.01f, h, (float)y * -0.01f);
+        }
+    }
+    fprintf(f, "vt 0 0\nvn 0 1 0\n");
+    int row = side + 1;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            int a = y * row + x + 1;
+            fprintf(f, "f %d/1/1 %d/1/1 %d/1/1 %d/1/1\n", a, a + 1, a + row + 1, a + row);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+// A 256-gon (254 fan triangles) and a 257-gon, which does not fit the
+// loader's face buffer and must be dropped and counted, on a parse and on
+// a cache hit.
+static int bench_obj_long_faces(void) {
+    const char *path = "ysu_bench_long.obj";
+    char cache[1024];
+    snprintf(cache, sizeof(cache), "%s.ysutri", path);
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    for (int i = 0; i < 257; ++i) {
+        float a = 6.2831853f * (float)i / 257.0f;
+        fprintf(f, "v %.6f %.6f 0\n", cosf(a), sinf(a));
+    }
+    for (int n = 256; n <= 257; ++n) {
+        fprintf(f, "f");
+        for (int i = 1; i <= n; ++i) fprintf(f, " %d", i);
+        fprintf(f, "\n");
+    }
+    int ok = fclose(f) == 0;
+    remove(cache);
+    for (int k = 0; k < 3 && ok; ++k) {
+        ObjMesh m;
+        ok = (k == 0) ? obj_load(path, 0, 1, &m) : obj_load_cached(path, cache, 0, 1, &m);
+        if (!ok) break;
+        ok = m.tri_count == 254 && m.long_faces == 1 && m.from_cache == (k == 2);
+        obj_mesh_free(&m);
+    }
+    printf("[BENCH] obj 256-gon kept, 257-gon dropped and counted (parse, cache cold, warm): %s\n",
+           ok ? "ok" : "FAILED");
+    remove(cache);
+    remove(path);
+    return ok;
+}
+
+static int bench_obj(int argc, char **argv) {
+    const char *path = "ysu_bench.obj";
+    double mtris = 2.0;
+    int threads = arg_int(argc, argv, 3, ysu_mt_suggest_threads());
+    int generated = 0;
+    if (argc > 2 && atof(argv[2]) <= 0.0) {
+        path = argv[2];
+    } else {
+        if (argc > 2) mtris = atof(argv[2]);
+        double t0 = bench_now_ms();
+        if (!bench_obj_write(path, mtris)) return 1;
+        generated = 1;
+        printf("[BENCH] obj wrote %s (%.1f Mtris) in %.0f ms\n", path, mtris, bench_now_ms() - t0);
+    }
+    if (threads < 1) threads = 1;
+
+    char cache[1024];
+    snprintf(cache, sizeof(cache), "%s.ysutri", path);
+    remove(cache);
+
+    ObjMesh m;
+    double per[4] = { 0.0, 0.0, 0.0, 0.0 };
+    const char *label[4] = { "parse 1 thread", "parse", "cache cold", "cache warm" };
+    int ok = 1;
+    for (int k = 0; k < 4 && ok; ++k) {
+        int t = (k == 0) ? 1 : threads;
+        ok = (k < 2) ? obj_load(path, 0, t, &m) : obj_load_cached(path, cache, 0, t, &m);
+        if (!ok) break;
+        double mt = (double)m.tri_count / 1e6;
+        per[k] = m.total_ms / mt;
+        printf("[BENCH] obj %-14s threads=%d  %.1f ms  %.1f ms/Mtri  (hash %.1f  parse %.1f  cache %.1f ms)\n",
+               label[k], t, m.total_ms, per[k], m.hash_ms, m.parse_ms, m.cache_ms);
+        obj_mesh_free(&m);
+    }
+    if (ok) {
+        printf("[BENCH] obj %s: threads x%.2f, warm cache x%.1f vs 1-thread parse\n",
+               path, per[0] / per[1], per[0] / per[3]);
+    }
+
+    remove(cache);
+    if (generated) remove(path);
+    if (!ok) return 1;
+    return bench_obj_long_faces() ? 0 : 2;
+}
+
+// ------------------------- mesh -------------------------
+// Bumpy unit sphere of about mtris million triangles, 12 floats each.
+static float *bench_mesh_sphere(double mtris, uint32_t *tri_count_out) {
+    int rows = (int)sqrt(mtris * 1e6 / 4.0);
+    if (rows < 4) rows = 4;
+    int cols = 2 * rows;
+    uint32_t n = (uint32_t)rows * (uint32_t)cols * 2u;
+    float *tris = (float*)calloc((size_t)n * 12u, sizeof(float));
+    if (!tris) return NULL;
+
+    // vertex (r, c): latitude r / rows, longitude c / cols, radius 1 +- 4%
+    float *out = tris;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            float p[4][3];
+            for (int k = 0; k < 4; ++k) {
+                int rr = r + (k >> 1), cc = c + ((k & 1) ^ (k >> 1));
+                float th = 3.14159265f * (float)rr / (float)rows;
+                float ph = 6.2831853f * (float)cc / (float)cols;
+                float rad = 1.0f + 0.04f * sinf(14.0f * th) * sinf(11.0f * ph);
+                p[k][0] = rad * sinf(th) * cosf(ph);
+                p[k][1] = rad * cosf(th);
+                p[k][2] = rad * sinf(th) * sinf(ph);
+            }
+            static const int fan[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            for (int t = 0; t < 2; ++t) {
+                for (int v = 0; v < 3; ++v) memcpy(out + v * 4, p[fan[t][v]], sizeof(float) * 3);
+                out += 12;
+            }
+        }
+    }
+    *tri_count_out = n;
+    return tris;
+}
+
+// A bumpy sphere of about MTRIS million triangles (default 1), or an OBJ
+// FILE. W x H primary rays on one thread through the packet/TLAS triangle
+// BVH (GPUBVHNode leaves, one triangle at a time) and through the mesh BVH
+// with scalar and AVX2 8-triangle SoA leaves; "diff" counts rays whose hit t
+// differs from the first. Then path-traced frames (depth 4, 1 spp) of the
+// mesh over the ground on all threads, the tracked Mrays/s number.
+static int bench_mesh(int argc, char **argv) {
+    const char *file = (argc > 2 && atof(argv[2]) <= 0.0) ? argv[2] : NULL;
+    double mtris = (argc > 2 && !file) ? atof(argv[2]) : 1.0;
+    int W     = arg_int(argc, argv, 3, 640);
+    int H     = arg_int(argc, argv, 4, 360);
+    int iters = arg_int(argc, argv, 5, 3);
+    if (W < 1 || H < 1 || iters < 1) return 1;
+
+    ObjMesh obj;
+    memset(&obj, 0, sizeof(obj));
+    uint32_t n = 0;
+    float *tris = NULL;
+    if (file) {
+        if (!obj_load_cached(file, NULL, 0, 0, &obj)) return 1;
+        tris = obj.tris;
+        n = obj.tri_count;
+    } else {
+        tris = bench_mesh_sphere(mtris, &n);
+        if (!tris) return 1;
+    }
+
+    // reference: the median-built GPUBVHNode tree of the packet / TLAS code
+    GPUBVHNode *gn = NULL;
+    int32_t *gi = NULL;
+    uint32_t gn_count = 0, gi_count = 0;
+    double t0 = bench_now_ms();
+    int ok = gpu_build_bvh_from_tri_vec4(tris, n, &gn, &gn_count, &gi, &gi_count);
+    double ref_build = bench_now_ms() - t0;
+    MeshBvh mb;
+    if (!ok || !mesh_bvh_build(&mb, tris, n)) {
+        free(gn); free(gi);
+        if (file) obj_mesh_free(&obj); else free(tris);
+        return 1;
+    }
+    BvhTriMesh ref = { gn, gn_count, gi, tris };
+    printf("[BENCH] mesh %u tris: reference BVH %.0f ms (%u nodes); mesh BVH %.0f ms (%u nodes, %u blocks, %.0f%% lanes used)\n",
+           n, ref_build, gn_count, mb.build_ms, mb.node_count, mb.block_count,
+           100.0 * (double)n / (8.0 * (double)mb.block_count));
+
+    // camera at 1.7 bounding radii, a little above the centre
+    Vec3 c = vec3(0.5f * (mb.bmin[0] + mb.bmax[0]), 0.5f * (mb.bmin[1] + mb.bmax[1]), 0.5f * (mb.bmin[2] + mb.bmax[2]));
+    float rad = 0.5f * vec3_length(vec3(mb.bmax[0] - mb.bmin[0], mb.bmax[1] - mb.bmin[1], mb.bmax[2] - mb.bmin[2]));
+    Camera cam = camera_look_at(vec3_add(c, vec3(0.0f, 0.5f * rad, 1.6f * rad)), c,
+                                vec3(0.0f, 1.0f, 0.0f), 45.0f, (float)W / (float)H);
+    size_t nr = (size_t)W * (size_t)H;
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * nr);
+    float *t_ref = (float*)malloc(sizeof(float) * nr);
+    if (!rays || !t_ref) {
+        free(rays); free(t_ref); free(gn); free(gi); mesh_bvh_free(&mb);
+        if (file) obj_mesh_free(&obj); else free(tris);
+        return 1;
+    }
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            rays[(size_t)y * W + x] = camera_get_ray(cam, ((float)x + 0.5f) / (float)W, ((float)y + 0.5f) / (float)H);
+        }
+    }
+
+    const int avx2 = mb.avx2;
+    const char *label[3] = { "gpubvh tri1", "soa scalar8", "soa avx2x8" };
+    double mrays[3] = { 0.0, 0.0, 0.0 };
+    for (int mode = 0; mode < 3; ++mode) {
+        if (mode == 2 && !avx2) {
+            printf("[BENCH] mesh %-12s skipped (no AVX2 or YSU_MESH_SIMD=0)\n", label[mode]);
+            continue;
+        }
+        mb.avx2 = (mode == 2);
+        double best = 1e30;
+        long hits = 0, diff = 0;
+        for (int it = 0; it < iters; ++it) {
+            hits = diff = 0;
+            t0 = bench_now_ms();
+            for (size_t i = 0; i < nr; ++i) {
+                float t = 1e30f;
+                int h = (mode == 0) ? bvh_tri_hit_closest(&ref, &rays[i], 0.001f, 1e30f, &t)
+                                    : mesh_bvh_hit_closest(&mb, &rays[i], 0.001f, 1e30f, &t);
+                if (h < 0) t = 1e30f;
+                hits += (h >= 0);
+                if (mode == 0) t_ref[i] = t;
+                else diff += (t != t_ref[i]);
+            }
+            double ms = bench_now_ms() - t0;
+            if (ms < best) best = ms;
+        }
+        mrays[mode] = (double)nr / (best * 1000.0);
+        printf("[BENCH] mesh %-12s best=%.2f ms  %.2f Mrays/s  hits=%ld", label[mode], best, mrays[mode], hits);
+        if (mode > 0) printf("  diff=%ld  x%.2f", diff, mrays[mode] / mrays[0]);
+        printf("\n");
+    }
+    mb.avx2 = avx2;
+    free(rays); free(t_ref); free(gn); free(gi);
+    mesh_bvh_free(&mb);
+
+    // whole frames through render_set_mesh (AVX2 leaves unless YSU_MESH_SIMD=0)
+    int nt = ysu_mt_suggest_threads();
+    Vec3 *px = (Vec3*)malloc(sizeof(Vec3) * nr);
+    YSU_ThreadStats *ts = (YSU_ThreadStats*)malloc(sizeof(YSU_ThreadStats) * (size_t)nt);
+    ok = px && ts && render_set_mesh(tris, n, NULL);
+    if (file) obj_mesh_free(&obj); else free(tris);
+    if (!ok) { free(px); free(ts); return 1; }
+
+    render_set_integrator(YSU_INTEGRATOR_PATH);
+    render_scene_mt(px, W, H, cam, 1, 2, nt, 0);   // warm-up: pool
+    double best = 1e30;
+    uint64_t rays_best = 0;
+    for (int it = 0; it < iters; ++it) {
+        t0 = bench_now_ms();
+        render_scene_mt(px, W, H, cam, 1, 4, nt, 0);
+        double ms = bench_now_ms() - t0;
+        if (ms >= best) continue;
+        best = ms;
+        rays_best = 0;
+        int m = render_get_thread_stats(ts, nt, NULL);
+        for (int i = 0; i < m; ++i) rays_best += ts[i].rays;
+    }
+    printf("[BENCH] mesh path depth=4 %dx%d threads=%d best=%.2f ms  %.2f Mrays/s\n",
+           W, H, nt, best, (double)rays_best / (best * 1000.0));
+
+    render_set_mesh(NULL, 0, NULL);
+    free(px); free(ts);
+    return 0;
+}
+
+// ------------------------- meshq -------------------------
+// The bench_mesh_sphere() surface as shared vertices plus an index list.
+static int bench_meshq_sphere(double mtris, float **verts_out, uint32_t **idx_out,
+                              uint32_t *vert_count, uint32_t *tri_count)
+{
+    int rows = (int)sqrt(mtris * 1e6 / 4.0);
+    if (rows < 4) rows = 4;
+    int cols = 2 * rows;
+    uint32_t nv = (uint32_t)(rows + 1) * (uint32_t)(cols + 1);
+    uint32_t nt = (uint32_t)rows * (uint32_t)cols * 2u;
+    float *v = (float*)malloc(sizeof(float) * 3u * (size_t)nv);
+    uint32_t *ix = (uint32_t*)malloc(sizeof(uint32_t) * 3u * (size_t)nt);
+    if (!v || !ix) { free(v); free(ix); return 0; }
+
+    for (int r = 0; r <= rows; ++r) {
+        for (int c = 0; c <= cols; ++c) {
+            float th = 3.14159265f * (float)r / (float)rows;
+            float ph = 6.2831853f * (float)c / (float)cols;
+            float rad = 1.0f + 0.04f * sinf(14.0f * th) * sinf(11.0f * ph);
+            float *p = v + ((size_t)r * (size_t)(cols + 1) + (size_t)c) * 3u;
+            p[0] = rad * sinf(th) * cosf(ph);
+            p[1] = rad * cosf(th);
+            p[2] = rad * sinf(th) * sinf(ph);
+        }
+    }
+    uint32_t *o = ix;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            uint32_t a = (uint32_t)(r * (cols + 1) + c), b = a + (uint32_t)(cols + 1);
+            uint32_t q[4] = { a, a + 1u, b + 1u, b };
+            o[0] = q[0]; o[1] = q[1]; o[2] = q[2];
+            o[3] = q[0]; o[4] = q[2]; o[5] = q[3];
+            o += 6;
+        }
+    }
+    *verts_out = v;
+    *idx_out = ix;
+    *vert_count = nv;
+    *tri_count = nt;
+    return 1;
+}
+
+// Float vs 8-bit quantised mesh BVH leaves on the bumpy sphere (MTRIS
+// million triangles, default 1) or an OBJ FILE, both built from the
+// indexed mesh. Prints input bytes per triangle (tri_vec4 vs indexed),
+// BVH bytes per triangle (nodes + leaf blocks, as kept by the renderer),
+// W x H primary rays on one thread with scalar and AVX2 leaves, and how
+// far quantised hits move: rays whose hit / miss flips and the largest t
+// change relative to the mesh radius.
+static int bench_meshq(int argc, char **argv) {
+    const char *file = (argc > 2 && atof(argv[2]) <= 0.0) ? argv[2] : NULL;
+    double mtris = (argc > 2 && !file) ? atof(argv[2]) : 1.0;
+    int W     = arg_int(argc, argv, 3, 640);
+    int H     = arg_int(argc, argv, 4, 360);
+    int iters = arg_int(argc, argv, 5, 3);
+    if (W < 1 || H < 1 || iters < 1) return 1;
+
+    ObjMesh obj;
+    memset(&obj, 0, sizeof(obj));
+    float *verts = NULL;
+    uint32_t *idx = NULL, nv = 0, n = 0;
+    if (file) {
+        if (!obj_load_cached(file, NULL, OBJ_LOAD_INDEXED, 0, &obj)) return 1;
+        verts = obj.verts; idx = obj.indices; nv = obj.vert_count; n = obj.tri_count;
+    } else if (!bench_meshq_sphere(mtris, &verts, &idx, &nv, &n)) {
+        return 1;
+    }
+    printf("[BENCH] meshq %u tris, %u verts: input tri_vec4 48.0 B/tri, indexed %.1f B/tri\n",
+           n, nv, (12.0 * (double)nv + 12.0 * (double)n) / (double)n);
+
+    MeshBvh mb[2];
+    int ok = 1;
+    for (int q = 0; q < 2 && ok; ++q) {
+        mesh_bvh_set_quant(q);
+        ok = mesh_bvh_build_indexed(&mb[q], verts, idx, n);
+    }
+    if (file) obj_mesh_free(&obj); else { free(verts); free(idx); }
+    if (!ok) {
+        if (mb[0].nodes) mesh_bvh_free(&mb[0]);
+        return 1;
+    }
+    double bpt[2];
+    for (int q = 0; q < 2; ++q) {
+        size_t bytes = mb[q].bytes - sizeof(uint32_t) * 8u * (size_t)mb[q].block_count;
+        bpt[q] = (double)bytes / (double)n;
+        printf("[BENCH] meshq %-9s BVH %.0f ms  %.1f MB  %.1f B/tri (%u nodes, %u blocks)\n",
+               q ? "quantised" : "float", mb[q].build_ms, (double)bytes / 1e6, bpt[q],
+               mb[q].node_count, mb[q].block_count);
+    }
+    int e_lo = 127, e_hi = -127;
+    for (uint32_t b = 0; b < mb[1].block_count; ++b) {
+        for (int a = 0; a < 3; ++a) {
+            if (mb[1].qblocks[b].exp[a] < e_lo) e_lo = mb[1].qblocks[b].exp[a];
+            if (mb[1].qblocks[b].exp[a] > e_hi) e_hi = mb[1].qblocks[b].exp[a];
+        }
+    }
+    printf("[BENCH] meshq quantised x%.2f smaller, block steps 2^%d .. 2^%d\n", bpt[0] / bpt[1], e_lo, e_hi);
+
+    Vec3 c = vec3(0.5f * (mb[0].bmin[0] + mb[0].bmax[0]), 0.5f * (mb[0].bmin[1] + mb[0].bmax[1]),
+                  0.5f * (mb[0].bmin[2] + mb[0].bmax[2]));
+    float rad = 0.5f * vec3_length(vec3(mb[0].bmax[0] - mb[0].bmin[0], mb[0].bmax[1] - mb[0].bmin[1],
+                                        mb[0].bmax[2] - mb[0].bmin[2]));
+    Camera cam = camera_look_at(vec3_add(c, vec3(0.0f, 0.5f * rad, 1.6f * rad)), c,
+                                vec3(0.0f, 1.0f, 0.0f), 45.0f, (float)W / (float)H);
+    size_t nr = (size_t)W * (size_t)H;
+    Ray *rays = (Ray*)malloc(sizeof(Ray) * nr);
+    float *t_ref = (float*)malloc(sizeof(float) * nr);
+    if (!rays || !t_ref) {
+        free(rays); free(t_ref);
+        mesh_bvh_free(&mb[0]); mesh_bvh_free(&mb[1]);
+        return 1;
+    }
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            rays[(size_t)y * W + x] = camera_get_ray(cam, ((float)x + 0.5f) / (float)W, ((float)y + 0.5f) / (float)H);
+        }
+    }
+
+    const int avx2 = mb[0].avx2 && mb[1].avx2;
+    double mrays[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+    for (int simd = 0; simd < 2; ++simd) {
+        if (simd && !avx2) {
+            printf("[BENCH] meshq avx2 skipped (no AVX2 or YSU_MESH_SIMD=0)\n");
+            continue;
+        }
+        for (int q = 0; q < 2; ++q) {
+            mb[q].avx2 = simd;
+            double best = 1e30, max_dt = 0.0;
+            long flips = 0;
+            for (int it = 0; it < iters; ++it) {
+                flips = 0;
+                max_dt = 0.0;
+                double t0 = bench_now_ms();
+                for (size_t i = 0; i < nr; ++i) {
+                    float t = 1e30f;
+                    if (mesh_bvh_hit_closest(&mb[q], &rays[i], 0.001f, 1e30f, &t) < 0) t = 1e30f;
+                    if (q == 0) { t_ref[i] = t; continue; }
+                    if ((t < 1e30f) != (t_ref[i] < 1e30f)) flips++;
+                    else if (t < 1e30f && fabs((double)t - (double)t_ref[i]) > max_dt) max_dt = fabs((double)t - (double)t_ref[i]);
+                }
+                double ms = bench_now_ms() - t0;
+                if (ms < best) best = ms;
+            }
+            mrays[simd][q] = (double)nr / (best * 1000.0);
+            printf("[BENCH] meshq %-6s %-9s best=%.2f ms  %.2f Mrays/s", simd ? "avx2" : "scalar",
+                   q ? "quantised" : "float", best, mrays[simd][q]);
+            if (q) {
+                printf("  x%.2f  flipped=%ld  max |dt|/radius=%.2e", mrays[simd][1] / mrays[simd][0],
+                       flips, max_dt / (double)rad);
+            }
+            printf("\n");
+        }
+    }
+    mesh_bvh_set_quant(0);
+    free(rays); free(t_ref);
+    mesh_bvh_free(&mb[0]); mesh_bvh_free(&mb[1]);
+    return 0;
+}
+
+// ------------------------- scene -------------------------
+// Writes an N-object .ysc (default 1M: named-material spheres, scene.txt
+// style spheres, lights and mesh instances with transforms, plus comments)
+// to ysu_bench.ysc and times scene_desc_load() over it. The mesh is never
+// loaded; only the description is parsed.
+static int bench_scene_write(const char *path, int n) {
+    static const char *k_mats[] = {
+        "material red lambert 0.8 0.2 0.2",      "material green lambert 0.2 0.8 0.2",
+        "material steel metal 0.8 0.8 0.85 0.1", "material gold metal 1.0 0.8 0.3 0.3",
+        "material glass glass 1 1 1 1.5",        "material lamp light 1 0.9 0.7 4",
+        "material \"blue paint\" lambert 0.1 0.2 0.9", "material white lambert 0.9 0.9 0.9",
+    };
+    static const char *k_names[] = { "red", "green", "steel", "gold", "glass", "lamp", "\"blue paint\"", "white" };
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "# ysu_bench scene, %d objects\ncamera 0 3 12 0 0 0 40\nground on\n", n);
+    for (int i = 0; i < 8; ++i) fprintf(f, "%s\n", k_mats[i]);
+    fprintf(f, "mesh bunny ysu_bench.obj\n\n");
+
+    uint32_t s = 12345u;
+    for (int i = 0; i < n; ++i) {
+        s = s * 1664525u + 1013904223u;
+        float x = (float)((s >> 8) % 20000u) * 0.01f - 100.0f;
+        float z = (float)((s >> 4) % 20000u) * -0.01f;
+        float r = 0.05f + (float)(s % 97u) * 0.002f;
+        int kind = (int)((s >> 24) % 20u);
+        if (kind < 14) {
+            fprintf(f, "sphere %.3f %.3f %.3f %.3f %s", x, r, z, r, k_names[(s >> 16) % 8u]);
+            if (kind < 4) fprintf(f, " 0.5 0.7 0.9");
+            fputc('\n', f);
+        } else if (kind < 16) {
+            fprintf(f, "sphere %.3f %.3f %.3f %.3f 0.7 0.7 0.7 metal 0.2\n", x, r, z, r);
+        } else if (kind < 17) {
+            fprintf(f, "light %.3f 4 %.3f 0.5 1 0.95 0.9 8\n", x, z);
+        } else {
+            fprintf(f, "instance bunny %s s %.2f ry %d t %.3f 0 %.3f\n",
+                    k_names[(s >> 16) % 8u], 0.5f + r, (int)(s % 360u), x, z);
+        }
+        if ((i & 1023) == 0) fprintf(f, "# block %d\n", i >> 10);
+    }
+    return fclose(f) == 0;
+}
+
+static int bench_scene(int argc, char **argv) {
+    const char *path = "ysu_bench.ysc";
+    int n     = arg_int(argc, argv, 2, 1000000);
+    int iters = arg_int(argc, argv, 3, 3);
+    if (n < 1) n = 1;
+    if (iters < 1) iters = 1;
+
+    double t0 = bench_now_ms();
+    if (!bench_scene_write(path, n)) return 1;
+    FILE *f = fopen(path, "rb");
+    long bytes = 0;
+    if (f) { fseek(f, 0, SEEK_END); bytes = ftell(f); fclose(f); }
+    printf("[BENCH] scene wrote %s (%d objects, %.1f MB) in %.0f ms\n",
+           path, n, (double)bytes / 1e6, bench_now_ms() - t0);
+
+    double best = 1e30;
+    int ok = 1;
+    SceneDesc d;
+    memset(&d, 0, sizeof(d));
+    for (int it = 0; it < iters && ok; ++it) {
+        scene_desc_free(&d);
+        double t1 = bench_now_ms();
+        ok = scene_desc_load(path, &d, NULL);
+        double ms = bench_now_ms() - t1;
+        if (ms < best) best = ms;
+    }
+    if (ok) {
+        int objects = d.sphere_count + d.instance_count;
+        printf("[BENCH] scene load %d objects (%d spheres, %d lights, %d instances, %d materials): "
+               "%.1f ms  %.2f Mobjects/s  %.0f MB/s\n",
+               objects, d.sphere_count, d.lights, d.instance_count, d.material_count,
+               best, (double)objects / (best * 1000.0), (double)bytes / (best * 1000.0));
+        ok = objects == n;
+    }
+    scene_desc_free(&d);
+    remove(path);
+    return ok ? 0 : 1;
+}
+
+// ------------------------- scenefuzz -------------------------
+// .ysc parser corpus and fuzzer. Each corpus entry is parsed and checked
+// against its expected error line (0 = must parse) and object counts; a
+// scene past the 1 MiB read block checks that streamed line numbers stay
+// right. Then ITERS mutations of the valid entries (byte flips, inserted
+// tokens, deleted / duplicated / truncated lines) must either parse into a
+// consistent description (indices in range, radius > 0) or fail on a line
+// and column that exist. Exits 1 on the first broken case.
+typedef struct {
+    const char *text;
+    int         err_line;     // expected error line, 0 = valid
+    int         spheres;
+    int         instances;
+} BenchYscCase;
+
+static const BenchYscCase k_ysc_corpus[] = {
+    { "", 0, 0, 0 },
+    { "# only a comment\n\n   \n", 0, 0, 0 },
+    { "sphere 0 1 -2 1 0.8 0.3 0.3\n", 0, 1, 0 },
+    { "sphere 0 1 -2 1 0.8 0.3 0.3 metal 0.1\nsphere 0 0 0 .5 1 1 1 glass 1.5\n", 0, 2, 0 },
+    { "material red lambert 0.8 0.1 0.1\nsphere 0 0 -1 0.5 red\nsphere 1 0 -1 0.5 red 1 1 0.5 # tinted\n", 0, 2, 0 },
+    { "material \"two words\" metal 1 1 1 0\nsphere 0 0 0 1 \"two words\"\n", 0, 1, 0 },
+    { "light 0 5 0 1 1 1 1 10\nlight 0 5 0 1 1 1 1\n", 0, 2, 0 },
+    { "material m glass 1 1 1\nmesh a a.obj\ninstance a m\ninstance a m t 1 2 3 s 2 rx 90 ry -45 rz 10 s 1 2 3\n", 0, 0, 2 },
+    { "camera 0 1 5 0 0 0\ncamera 0 1 5 0 0 0 60 0 1 0\nground off\nground 1\n", 0, 0, 0 },
+    { "sphere 0 0 0 1 1 1 1\r\nsphere 0 0 0 1 1 1 1\r\n", 0, 2, 0 },
+    { "sphere 0 0 0 1e-3 1 1 1\nsphere -1.5e+2 0 0 2 1 1 1", 0, 2, 0 },
+    { "\n\nbogus 1 2 3\n", 3, 0, 0 },
+    { "sphere 0 0 0 0 1 1 1\n", 1, 0, 0 },
+    { "sphere 0 0 0 -1 1 1 1\n", 1, 0, 0 },
+    { "sphere 0 0\n", 1, 0, 0 },
+    { "sphere 0 0 0 1 nosuch\n", 1, 0, 0 },
+    { "sphere 0 0 0 1 1 1 1 wood\n", 1, 0, 0 },
+    { "sphere 0 0 0 1 1 1 1 metal 0.1 extra\n", 1, 0, 0 },
+    { "sphere 0 0 0 nan 1 1 1\n", 1, 0, 0 },
+    { "sphere 0 0 0 inf 1 1 1\n", 1, 0, 0 },
+    { "sphere 0 0 0 1e40 1 1 1\n", 1, 0, 0 },
+    { "sphere 0 0 0 1 -1 1 1\n", 1, 0, 0 },
+    { "material a lambert 1 1 1\nmaterial a metal 1 1 1\n", 2, 0, 0 },
+    { "material a plastic 1 1 1\n", 1, 0, 0 },
+    { "material a metal 1 1 1 2\n", 1, 0, 0 },
+    { "material a glass 1 1 1 0\n", 1, 0, 0 },
+    { "material a lambert 1 1 1 0.5\n", 1, 0, 0 },
+    { "material \"unterminated lambert 1 1 1\n", 1, 0, 0 },
+    { "material \"\" lambert 1 1 1\n", 1, 0, 0 },
+    { "material 1.5 lambert 1 1 1\n", 1, 0, 0 },
+    { "material aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa lambert 1 1 1\n", 1, 0, 0 },
+    { "light 0 5 0 1 1 1 1 -2\n", 1, 0, 0 },
+    { "mesh a a.obj\nmesh a b.obj\n", 2, 0, 0 },
+    { "mesh a\n", 1, 0, 0 },
+    { "material m lambert 1 1 1\ninstance a m\n", 2, 0, 0 },
+    { "material m lambert 1 1 1\nmesh a a.obj\ninstance a n\n", 3, 0, 0 },
+    { "material m lambert 1 1 1\nmesh a a.obj\ninstance a m s 0\n", 3, 0, 0 },
+    { "material m lambert 1 1 1\nmesh a a.obj\ninstance a m t 1 2\n", 3, 0, 0 },
+    { "material m lambert 1 1 1\nmesh a a.obj\ninstance a m shear 1\n", 3, 0, 0 },
+    { "camera 0 0 0 0 0 0\n", 1, 0, 0 },
+    { "camera 0 0 1 0 0 0 180\n", 1, 0, 0 },
+    { "camera 0 0 1 0 0 0 45 0 0 0\n", 1, 0, 0 },
+    { "ground maybe\n", 1, 0, 0 },
+    { "ground\n", 1, 0, 0 },
+    { "sphere 0 0 0 1 1 1 1\nsphere 0 0 0 1 1 1 1\n\n# c\nsphere 0 0 0 1 1 1\n", 5, 0, 0 },
+};
+
+static int bench_ysc_count_lines(const char *t, size_t len) {
+    int lines = 0;
+    for (size_t i = 0; i < len; ++i) lines += t[i] == '\n';
+    return lines + (len > 0 && t[len - 1] != '\n');
+}
+
+// Checks the invariants of one parse; returns 0 and prints on a violation.
+static int bench_ysc_check(const char *what, const char *t, size_t len, int ok,
+                           const SceneDesc *d, const SceneError *e)
+{
+    int lines = bench_ysc_count_lines(t, len);
+    if (!ok) {
+        size_t ls = 0;
+        int ln = 1;
+        for (size_t i = 0; i < len && ln < e->line; ++i) {
+            if (t[i] == '\n') { ln++; ls = i + 1; }
+        }
+        size_t le = ls;
+        while (le < len && t[le] != '\n') le++;
+        if (e->line < 1 || e->line > (lines ? lines : 1) || e->column < 1 ||
+            (size_t)e->column > le - ls + 1 || !e->msg[0] || d->spheres || d->material_count) {
+            printf("[BENCH] scenefuzz %s: bad error %d:%d '%s' (%d lines)\n", what, e->line, e->column, e->msg, lines);
+            return 0;
+        }
+        return 1;
+    }
+    if (d->lines != lines) {
+        printf("[BENCH] scenefuzz %s: counted %d lines, expected %d\n", what, d->lines, lines);
+        return 0;
+    }
+    for (int i = 0; i < d->sphere_count; ++i) {
+        const SceneSphereDef *s = &d->spheres[i];
+        if (!(s->radius > 0.0f) || s->material < 0 || s->material >= d->material_count) {
+            printf("[BENCH] scenefuzz %s: bad sphere %d\n", what, i);
+            return 0;
+        }
+    }
+    for (int i = 0; i < d->instance_count; ++i) {
+        const SceneInstanceDef *in = &d->instances[i];
+        if (in->mesh < 0 || in->mesh >= d->mesh_count || in->material < 0 || in->material >= d->material_count) {
+            printf("[BENCH] scenefuzz %s: bad instance %d\n", what, i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int bench_scenefuzz(int argc, char **argv) {
+    int iters = arg_int(argc, argv, 2, 100000);
+    uint32_t s = (uint32_t)arg_int(argc, argv, 3, 1);
+    const int cases = (int)(sizeof(k_ysc_corpus) / sizeof(k_ysc_corpus[0]));
+    SceneDesc d;
+    SceneError e;
+
+    int valid = 0;
+    for (int i = 0; i < cases; ++i) {
+        const BenchYscCase *c = &k_ysc_corpus[i];
+        size_t len = strlen(c->text);
+        int ok = scene_desc_parse(c->text, len, NULL, &d, &e);
+        char what[32];
+        snprintf(what, sizeof(what), "corpus %d", i);
+        int good = bench_ysc_check(what, c->text, len, ok, &d, &e) && ok == (c->err_line == 0) &&
+                   (ok ? d.sphere_count == c->spheres && d.instance_count == c->instances : e.line == c->err_line);
+        if (!good) {
+            printf("[BENCH] scenefuzz corpus %d: got %s (line %d: %s), expected %s line %d\n",
+                   i, ok ? "ok" : "error", e.line, e.msg, c->err_line ? "error on" : "ok,", c->err_line);
+            scene_desc_free(&d);
+            return 1;
+        }
+        valid += ok;
+        scene_desc_free(&d);
+    }
+    printf("[BENCH] scenefuzz corpus: %d cases (%d valid, %d errors) as expected\n", cases, valid, cases - valid);
+
+    // streaming: an error past the first 1 MiB block keeps its line number
+    const char *path = "ysu_bench_fuzz.ysc";
+    FILE *f = fopen(path, "wb");
+    if (!f) return 1;
+    int good_lines = 40000;
+    for (int i = 0; i < good_lines; ++i) fprintf(f, "sphere %d 0.5 -3 0.5 0.8 0.8 0.8 # padding\n", i);
+    fprintf(f, "sphere 0 0 0 1 1 1 oops\n");
+    fclose(f);
+    int ok = scene_desc_load(path, &d, &e);
+    remove(path);
+    scene_desc_free(&d);
+    if (ok || e.line != good_lines + 1 || e.column != 20) {
+        printf("[BENCH] scenefuzz stream: got line %d col %d, expected %d col 20\n", e.line, e.column, good_lines + 1);
+        return 1;
+    }
+    printf("[BENCH] scenefuzz stream: error at %d:%d past the first read block\n", e.line, e.column);
+
+    // mutations
+    static const char *k_tokens[] = {
+        " ", "\n", "#", "\"", "-", ".", "e", "0", "1", "9", "nan", "inf", "1e39", "-0", "sphere", "light",
+        "material", "mesh", "instance", "camera", "ground", "red", "m", "a", "lambert", "metal", "glass",
+        "t", "s", "rx", "ry", "rz", "\t", "\r", "\xff", "\0",
+    };
+    const int ntok = (int)(sizeof(k_tokens) / sizeof(k_tokens[0]));
+    char *buf = (char*)malloc(4096);
+    if (!buf) return 1;
+    int parsed = 0;
+    double t0 = bench_now_ms();
+    for (int it = 0; it < iters; ++it) {
+        const BenchYscCase *c;
+        do {
+            s = s * 1664525u + 1013904223u;
+            c = &k_ysc_corpus[(s >> 8) % (uint32_t)cases];
+        } while (c->err_line != 0 && (s & 3u));
+        size_t len = strlen(c->text);
+        memcpy(buf, c->text, len);
+
+        int muts = 1 + (int)((s >> 20) % 4u);
+        for (int m = 0; m < muts; ++m) {
+            s = s * 1664525u + 1013904223u;
+            size_t at = len ? (s >> 8) % len : 0;
+            switch ((s >> 28) % 5u) {
+            case 0:                                              // flip a byte
+                if (len) buf[at] = (char)(buf[at] ^ (1 << ((s >> 4) % 8u)));
+                break;
+            case 1: {                                            // insert a token
+                int k = (int)((s >> 4) % (uint32_t)ntok);
+                size_t tl = k_tokens[k][0] ? strlen(k_tokens[k]) : 1;
+                if (len + tl + 1 >= 4096) break;
+                memmove(buf + at + tl, buf + at, len - at);
+                memcpy(buf + at, k_tokens[k], tl);
+                len += tl;
+                break;
+            }
+            case 2: {                                            // delete a span
+                size_t n = 1 + (s >> 4) % 8u;
+                if (at + n > len) n = len - at;
+                memmove(buf + at, buf + at + n, len - at - n);
+                len -= n;
+                break;
+            }
+            case 3: {                                            // duplicate the text
+                if (len * 2 + 1 >= 4096) break;
+                memcpy(buf + len, buf, len);
+                len *= 2;
+                break;
+            }
+            default:                                             // truncate
+                len = at;
+                break;
+            }
+        }
+
+        int r = scene_desc_parse(buf, len, "dir", &d, &e);
+        char what[48];
+        snprintf(what, sizeof(what), "mutation %d", it);
+        if (!bench_ysc_check(what, buf, len, r, &d, &e)) {
+            fwrite(buf, 1, len, stdout);
+            printf("\n");
+            scene_desc_free(&d);
+            free(buf);
+            return 1;
+        }
+        parsed += r;
+        scene_desc_free(&d);
+    }
+    double ms = bench_now_ms() - t0;
+    free(buf);
+    printf("[BENCH] scenefuzz %d mutations (%d parsed, %d rejected) in %.0f ms, invariants held\n",
+           iters, parsed, iters - parsed, ms);
+    return 0;
+}
+
+// ------------------------- ysub -------------------------
+// Writes a W x H x C float32 .ysub dump (default 4096 x 4096 x 4, 256 MB)
+// and checksums it ITERS times the old tool way (fread into a buffer) and
+// through the mapped reader (ysub_reader.h), both with a warm page cache.
+// Then checks that crop and step views checksum like dumps of the same
+// pixels, and that truncated / mislabelled files are rejected.
+static int bench_ysub_fread_sum(const char *path, uint64_t *sum) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    unsigned char hdr[YSUB_HEADER_BYTES];
+    uint32_t d[5];
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) { fclose(f); return 0; }
+    memcpy(d, hdr + 4, sizeof(d));
+    size_t n = (size_t)d[1] * (size_t)d[2] * (size_t)d[3];
+    float *buf = (float*)malloc(sizeof(float) * n);
+    int ok = buf && fread(buf, sizeof(float), n, f) == n;
+    fclose(f);
+    if (ok) {
+        YsubView v = { buf, d[1], d[2], d[3], d[3], (size_t)d[1] * d[3] };
+        *sum = ysub_view_checksum(&v);
+    }
+    free(buf);
+    return ok;
+}
+
+static int bench_ysub_dump_view(const char *path, const YsubView *v) {
+    float *buf = (float*)malloc(sizeof(float) * (size_t)v->width * v->height * v->channels);
+    if (!buf) return 0;
+    float *o = buf;
+    for (uint32_t y = 0; y < v->height; ++y) {
+        for (uint32_t x = 0; x < v->width; ++x, o += v->channels) {
+            memcpy(o, ysub_pixel(v, x, y), sizeof(float) * v->channels);
+        }
+    }
+    int ok = ysu_dump_f32n(path, buf, (int)v->width, (int)v->height, (int)v->channels);
+    free(buf);
+    return ok;
+}
+
+static int bench_ysub(int argc, char **argv) {
+    int W     = arg_int(argc, argv, 2, 4096);
+    int H     = arg_int(argc, argv, 3, 4096);
+    int C     = arg_int(argc, argv, 4, 4);
+    int iters = arg_int(argc, argv, 5, 3);
+    if (W < 2 || H < 2 || C < 1 || iters < 1) return 1;
+    const char *path = "ysu_bench.ysub", *tmp = "ysu_bench_view.ysub";
+
+    size_t n = (size_t)W * (size_t)H * (size_t)C;
+    float *img = (float*)malloc(sizeof(float) * n);
+    if (!img) return 1;
+    uint32_t s = 12345u;
+    for (size_t i = 0; i < n; ++i) {
+        s = s * 1664525u + 1013904223u;
+        img[i] = (float)(s >> 8) * (1.0f / 16777216.0f);
+    }
+    double t0 = bench_now_ms();
+    int ok = ysu_dump_f32n(path, img, W, H, C);
+    free(img);
+    if (!ok) return 1;
+    double mb = (double)(sizeof(float) * n) / 1e6;
+    printf("[BENCH] ysub wrote %s (%dx%d x%d, %.0f MB) in %.0f ms\n", path, W, H, C, mb, bench_now_ms() - t0);
+
+    uint64_t sum[2] = { 0, 0 };
+    double best[2] = { 1e30, 1e30 };
+    const char *label[2] = { "fread+sum", "mmap+sum" };
+    for (int it = 0; it < iters && ok; ++it) {
+        for (int k = 0; k < 2 && ok; ++k) {
+            t0 = bench_now_ms();
+            if (k == 0) {
+                ok = bench_ysub_fread_sum(path, &sum[0]);
+            } else {
+                YsubFile f;
+                ok = ysub_open(path, &f);
+                if (ok) sum[1] = ysub_view_checksum(&f.view);
+                ysub_close(&f);
+            }
+            double ms = bench_now_ms() - t0;
+            if (ms < best[k]) best[k] = ms;
+        }
+    }
+    for (int k = 0; k < 2 && ok; ++k) {
+        printf("[BENCH] ysub %-10s best=%.1f ms  %.2f GB/s  checksum %016llx\n", label[k], best[k],
+               mb / best[k], (unsigned long long)sum[k]);
+    }
+    if (ok) printf("[BENCH] ysub mapped x%.2f vs fread\n", best[0] / best[1]);
+
+    // views checksum like a dump of their pixels; bad headers are refused
+    int checks = 0, failed = !ok || sum[0] != sum[1];
+    YsubFile f;
+    if (ok && ysub_open(path, &f)) {
+        YsubView v[3];
+        int nv = 0;
+        nv += ysub_view_crop(&f.view, (uint32_t)W / 3u, (uint32_t)H / 5u, (uint32_t)W / 2u, (uint32_t)H, &v[nv]);
+        nv += ysub_view_step(&f.view, 3u, &v[nv]);
+        if (nv == 2 && ysub_view_step(&v[0], 2u, &v[nv])) nv++;
+        for (int k = 0; k < nv; ++k, ++checks) {
+            YsubFile g;
+            if (!bench_ysub_dump_view(tmp, &v[k]) || !ysub_open(tmp, &g)) { failed++; continue; }
+            if (ysub_view_checksum(&v[k]) != ysub_view_checksum(&g.view)) {
+                printf("[BENCH] ysub view %d checksum differs from its dump\n", k);
+                failed++;
+            }
+            ysub_close(&g);
+        }
+
+        // header corruptions: magic, version, channels, dtype, dims, truncation
+        static const struct { int off; uint32_t val; } bad[] = {
+            { 0, 0x42555359u ^ 1u }, { 4, 2u }, { 16, 0u }, { 20, 2u }, { 8, 0u }, { 12, 1u << 30 }, { -1, 0u }
+        };
+        const unsigned char *raw = (const unsigned char*)f.map;
+        size_t small = YSUB_HEADER_BYTES + sizeof(float) * 2u * (size_t)C;
+        for (size_t k = 0; k < sizeof(bad) / sizeof(bad[0]); ++k, ++checks) {
+            unsigned char hdr[YSUB_HEADER_BYTES];
+            memcpy(hdr, raw, sizeof(hdr));
+            uint32_t one = 1u, two = 2u;
+            memcpy(hdr + 8, &two, 4);   // 2 x 1 image
+            memcpy(hdr + 12, &one, 4);
+            if (bad[k].off >= 0) memcpy(hdr + bad[k].off, &bad[k].val, 4);
+            FILE *o = fopen(tmp, "wb");
+            size_t len = (bad[k].off >= 0) ? small : small - 1u;
+            int wrote = o && fwrite(hdr, 1, sizeof(hdr), o) == sizeof(hdr) &&
+                        fwrite(raw + YSUB_HEADER_BYTES, 1, len - sizeof(hdr), o) == len - sizeof(hdr);
+            if (o) fclose(o);
+            YsubFile g;
+            if (!wrote || ysub_open(tmp, &g)) {
+                printf("[BENCH] ysub corrupt header %zu was accepted\n", k);
+                if (wrote) ysub_close(&g);
+                failed++;
+            }
+        }
+        ysub_close(&f);
+    } else {
+        failed++;
+    }
+    printf("[BENCH] ysub checks %d, %s\n", checks, failed ? "FAILED" : "ok");
+
+    remove(tmp);
+    remove(path);
+    return failed ? 2 : 0;
+}
+
+// ------------------------- vec3 -------------------------
+// Ray-sphere against a fixed sphere for N rays; counts hits so nothing is
+// optimized away. Scalar uses the inline vec3.h API on AoS data, the wide
+// kernels read SoA lanes.
+static int sphere_scalar(const Vec3 *o, const Vec3 *d, int n, Vec3 c, float r2, float *t_out) {
+    int hits = 0;
+    for (int i = 0; i < n; ++i) {
+        Vec3 oc = vec3_sub(o[i], c);
+        float a = vec3_dot(d[i], d[i]);
+        float b = vec3_dot(oc, d[i]);
+        float cc = vec3_dot(oc, oc) - r2;
+        float disc = b * b - a * cc;
+        float t = -1.0f;
+        if (disc >= 0.0f) { t = (-b - sqrtf(disc)) / a; hits++; }
+        t_out[i] = t;
+    }
+    return hits;
+}
+
+static int sphere_x4(const float *ox, const float *oy, const float *oz,
+                     const float *dx, const float *dy, const float *dz,
+                     int n, Vec3 c, float r2, float *t_out)
+{
+    int hits = 0;
+    Vec3x4 c4 = vec3x4_splat(c);
+    ysu_f4 r24 = ysu_f4_set1(r2), zero = ysu_f4_set1(0.0f), neg1 = ysu_f4_set1(-1.0f);
+    for (int i = 0; i + 4 <= n; i += 4) {
+        Vec3x4 oc = vec3x4_sub(vec3x4_load(ox + i, oy + i, oz + i), c4);
+        Vec3x4 d  = vec3x4_load(dx + i, dy + i, dz + i);
+        ysu_f4 a  = vec3x4_dot(d, d);
+        ysu_f4 b  = vec3x4_dot(oc, d);
+        ysu_f4 cc = ysu_f4_sub(vec3x4_dot(oc, oc), r24);
+        ysu_f4 disc = ysu_f4_sub(ysu_f4_mul(b, b), ysu_f4_mul(a, cc));
+        ysu_f4 m = ysu_f4_ge(disc, zero);
+        ysu_f4 t = ysu_f4_div(ysu_f4_sub(ysu_f4_sub(zero, b), ysu_f4_sqrt(ysu_f4_max(disc, zero))), a);
+        ysu_f4_store(t_out + i, ysu_f4_select(m, t, neg1));
+        int bits = ysu_f4_mask(m);
+        for (; bits; bits &= bits - 1) hits++;
+    }
+    return hits;
+}
+
+static int sphere_x8(const float *ox, const float *oy, const float *oz,
+                     const float *dx, const float *dy, const float *dz,
+                     int n, Vec3 c, float r2, float *t_out)
+{
+    int hits = 0;
+    Vec3x8 c8 = vec3x8_splat(c);
+    ysu_f8 r28 = ysu_f8_set1(r2), zero = ysu_f8_set1(0.0f), neg1 = ysu_f8_set1(-1.0f);
+    for (int i = 0; i + 8 <= n; i += 8) {
+        Vec3x8 oc = vec3x8_sub(vec3x8_load(ox + i, oy + i, oz + i), c8);
+        Vec3x8 d  = vec3x8_load(dx + i, dy + i, dz + i);
+        ysu_f8 a  = vec3x8_dot(d, d);
+        ysu_f8 b  = vec3x8_dot(oc, d);
+        ysu_f8 cc = ysu_f8_sub(vec3x8_dot(oc, oc), r28);
+        ysu_f8 disc = ysu_f8_sub(ysu_f8_mul(b, b), ysu_f8_mul(a, cc));
+        ysu_f8 m = ysu_f8_ge(disc, zero);
+        ysu_f8 t = ysu_f8_div(ysu_f8_sub(ysu_f8_sub(zero, b), ysu_f8_sqrt(ysu_f8_max(disc, zero))), a);
+        ysu_f8_store(t_out + i, ysu_f8_select(m, t, neg1));
+        int bits = ysu_f8_mask(m);
+        for (; bits; bits &= bits - 1) hits++;
+    }
+    return hits;
+}
+
+static int bench_vec3(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 1 << 16) & ~7;
+    int iters = arg_int(argc, argv, 3, 200);
+    if (n < 8 || iters < 1) return 1;
+
+    Vec3  *o  = (Vec3*)malloc(sizeof(Vec3) * (size_t)n);
+    Vec3  *d  = (Vec3*)malloc(sizeof(Vec3) * (size_t)n);
+    float *soa = (float*)malloc(sizeof(float) * 6 * (size_t)n);
+    float *t  = (float*)malloc(sizeof(float) * 3 * (size_t)n);
+    if (!o || !d || !soa || !t) return 1;
+    float *ox = soa, *oy = ox + n, *oz = oy + n, *dx = oz + n, *dy = dx + n, *dz = dy + n;
+
+    uint32_t s = 0x12345678u;
+    for (int i = 0; i < n; ++i) {
+        float r[6];
+        for (int k = 0; k < 6; ++k) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            r[k] = (float)(s >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f;
+        }
+        o[i] = vec3(r[0] * 0.1f, r[1] * 0.1f, 0.0f);
+        d[i] = vec3_normalize(vec3(r[3] * 0.5f, r[4] * 0.5f, -1.0f));
+        ox[i] = o[i].x; oy[i] = o[i].y; oz[i] = o[i].z;
+        dx[i] = d[i].x; dy[i] = d[i].y; dz[i] = d[i].z;
+    }
+    Vec3 c = vec3(0.0f, 0.0f, -1.0f);
+    float r2 = 0.25f;
+
+    const char *names[3] = { "scalar", "x4", "x8" };
+    double best[3] = { 1e30, 1e30, 1e30 };
+    int hits[3] = { 0, 0, 0 };
+    for (int it = 0; it < iters; ++it) {
+        for (int k = 0; k < 3; ++k) {
+            double t0 = bench_now_ms();
+            if (k == 0) hits[k] = sphere_scalar(o, d, n, c, r2, t);
+            if (k == 1) hits[k] = sphere_x4(ox, oy, oz, dx, dy, dz, n, c, r2, t + n);
+            if (k == 2) hits[k] = sphere_x8(ox, oy, oz, dx, dy, dz, n, c, r2, t + 2 * n);
+            double dt = bench_now_ms() - t0;
+            if (dt < best[k]) best[k] = dt;
+        }
+    }
+
+    int same = (memcmp(t, t + n, sizeof(float) * (size_t)n) == 0) &&
+               (memcmp(t, t + 2 * n, sizeof(float) * (size_t)n) == 0);
+    for (int k = 0; k < 3; ++k) {
+        printf("[BENCH] vec3 sphere %-6s n=%d best=%.3f ms  %.1f Mrays/s  hits=%d  x%.2f\n",
+               names[k], n, best[k], (double)n / (best[k] * 1000.0), hits[k], best[0] / best[k]);
+    }
+    printf("[BENCH] vec3 results %s\n", same ? "bit-identical" : "DIFFER");
+
+    free(o); free(d); free(soa); free(t);
+    return same ? 0 : 2;
+}
+
+// ------------------------- rng -------------------------
+// ysu_rng_u01x8: the AVX2 kernel against the scalar pcg4d loop over edge
+// and random (pixel, sample, dim, seed) tuples, which must be bit-identical;
+// then N blocks of 8 uniforms through each path and the runtime pick.
+static int bench_rng(int argc, char **argv) {
+    int n     = arg_int(argc, argv, 2, 1 << 22);
+    int iters = arg_int(argc, argv, 3, 5);
+    if (n < 1 || iters < 1) return 1;
+    const int avx2 = ysu_rng_avx2();
+    if (!avx2) printf("[BENCH] rng avx2 not in use (no AVX2, not built, or YSU_RNG_SIMD=0): scalar only\n");
+
+    long checked = 0, diff = 0;
+    if (avx2) {
+        static const uint32_t edge[] = { 0u, 1u, 7u, 8u, 0xFFFFu, 0x10000u, 0x7FFFFFFFu, 0x80000000u,
+                                         0xFFFFFFF8u, 0xFFFFFFFFu };
+        const int ne = (int)(sizeof(edge) / sizeof(edge[0]));
+        uint32_t s = 0xA511E9B3u;
+        for (int i = 0; i < ne * ne * ne * ne + 1000000; ++i) {
+            uint32_t v[4];
+            if (i < ne * ne * ne * ne) {
+                int q = i;
+                for (int k = 0; k < 4; ++k) { v[k] = edge[q % ne]; q /= ne; }
+            } else {
+                for (int k = 0; k < 4; ++k) { s ^= s << 13; s ^= s >> 17; s ^= s << 5; v[k] = s; }
+            }
+            float a[8], b[8];
+            ysu_rng_u01x8_scalar(v[0], v[1], v[2], v[3], a);
+            ysu_rng_u01x8_avx2(v[0], v[1], v[2], v[3], b);
+            diff += memcmp(a, b, sizeof(a)) != 0;
+            checked++;
+        }
+        printf("[BENCH] rng avx2 vs scalar pcg4d: %ld/%ld blocks %s\n", diff, checked,
+               diff ? "DIFFER" : "differ (bit-identical)");
+    }
+
+    const char *names[3] = { "scalar", "avx2", "picked" };
+    double best[3] = { 1e30, 1e30, 1e30 };
+    for (int it = 0; it < iters; ++it) {
+        for (int k = 0; k < 3; ++k) {
+            if (k == 1 && !avx2) continue;
+            float acc = 0.0f, out[8];
+            double t0 = bench_now_ms();
+            for (int i = 0; i < n; ++i) {
+                uint32_t px = (uint32_t)i >> 4, smp = (uint32_t)i & 15u;
+                if (k == 0)      ysu_rng_u01x8_scalar(px, smp, 0x10000u, 1234u, out);
+                else if (k == 1) ysu_rng_u01x8_avx2(px, smp, 0x10000u, 1234u, out);
+                else             ysu_rng_u01x8(px, smp, 0x10000u, 1234u, out);
+                acc += out[i & 7];
+            }
+            double dt = bench_now_ms() - t0;
+            if (dt < best[k]) best[k] = dt;
+            g_bench_sink += (int)acc;
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        if (k == 1 && !avx2) continue;
+        printf("[BENCH] rng %-6s %d blocks best=%.2f ms  %.0f Muniforms/s  x%.2f\n", names[k], n, best[k],
+               8.0 * (double)n / (best[k] * 1000.0), best[0] / best[k]);
+    }
+    return diff ? 2 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *mode = (argc > 1) ? argv[1] : "render";
+    if (strcmp(mode, "render") == 0) return bench_render(argc, argv);
+    if (strcmp(mode, "vec3") == 0)   return bench_vec3(argc, argv);
+    if (strcmp(mode, "scale") == 0)  return bench_scale(argc, argv);
+    if (strcmp(mode, "360") == 0)    return bench_360(argc, argv);
+    if (strcmp(mode, "bvh") == 0)    return bench_bvh(argc, argv);
+    if (strcmp(mode, "packet") == 0) return bench_packet(argc, argv);
+    if (strcmp(mode, "lbvh") == 0)   return bench_lbvh(argc, argv);
+    if (strcmp(mode, "tlas") == 0)   return bench_tlas(argc, argv);
+    if (strcmp(mode, "refit") == 0)  return bench_refit(argc, argv);
+    if (strcmp(mode, "policy") == 0) return bench_policy(argc, argv);
+    if (strcmp(mode, "raysort") == 0) return bench_raysort(argc, argv);
+    if (strcmp(mode, "obj") == 0)    return bench_obj(argc, argv);
+    if (strcmp(mode, "mesh") == 0)   return bench_mesh(argc, argv);
+    if (strcmp(mode, "meshq") == 0)  return bench_meshq(argc, argv);
+    if (strcmp(mode, "scene") == 0)  return bench_scene(argc, argv);
+    if (strcmp(mode, "scenefuzz") == 0) return bench_scenefuzz(argc, argv);
+    if (strcmp(mode, "ysub") == 0)   return bench_ysub(argc, argv);
+    if (strcmp(mode, "rng") == 0)    return bench_rng(argc, argv);
+    printf("usage: ysu_bench render [W H SPP DEPTH ITERS] | vec3 [N ITERS] | scale [W H SPP DEPTH MAXT ITERS]"
+           " | 360 [W H SPP DEPTH ITERS] | bvh [N ITERS SCENE] | packet [W H N ITERS] | lbvh [N ITERS]"
+           " | tlas [INST N ITERS] | refit [N FRAMES MOVING] | policy [N ITERS MODEL]"
+           " | raysort [N W H SPP ITERS] | obj [MTRIS THREADS | FILE]"
+           " | mesh [MTRIS|FILE W H ITERS] | meshq [MTRIS|FILE W H ITERS] | scene [N ITERS] | scenefuzz [ITERS SEED]"
+           " | ysub [W H C ITERS] | rng [N ITERS]\n");
+    return 1;
+}
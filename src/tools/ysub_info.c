@@ -1,26 +1,124 @@
+// ysub_info.c - print a .ysub header; optionally checksum / stats of a view
+//
+//   ysub_info [FILE] [-crop X Y W H] [-step N] [-sum] [-stats]
+//
+// The file is mapped (ysub_reader.h), so the header costs nothing on a
+// multi-GB dump and -sum / -stats read only the pages of the view.
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
-typedef struct {
-    char     magic[4];
-    uint32_t version;
-    uint32_t width;
-    uint32_t height;
-    uint32_t channels;
-    uint32_t dtype;
-} YSU_BinHeader;
+#include "ysub_reader.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+static double info_now_ms(void) {
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+}
+#else
+  #include <time.h>
+static double info_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+#endif
+
+static void print_rate(const char *what, const YsubView *v, double ms) {
+    double bytes = 4.0 * (double)v->width * (double)v->height * (double)v->channels;
+    printf("%s: %.1f ms, %.2f GB/s\n", what, ms, bytes / (ms * 1e6 + 1e-9));
+}
+
+static int print_stats(const YsubView *v) {
+    double *sum = (double*)calloc(v->channels, sizeof(double));
+    uint64_t *cnt = (uint64_t*)calloc(v->channels, sizeof(uint64_t));
+    float *lo = (float*)malloc(sizeof(float) * v->channels);
+    float *hi = (float*)malloc(sizeof(float) * v->channels);
+    if (!sum || !cnt || !lo || !hi) {
+        free(sum); free(cnt); free(lo); free(hi);
+        printf("alloc fail\n");
+        return 0;
+    }
+    for (uint32_t c = 0; c < v->channels; ++c) { lo[c] = INFINITY; hi[c] = -INFINITY; }
+
+    uint64_t bad = 0;
+    double t0 = info_now_ms();
+    for (uint32_t y = 0; y < v->height; ++y) {
+        const float *p = ysub_row(v, y);
+        for (uint32_t x = 0; x < v->width; ++x, p += v->pixel_stride) {
+            for (uint32_t c = 0; c < v->channels; ++c) {
+                float f = p[c];
+                if (!isfinite(f)) { bad++; continue; }
+                if (f < lo[c]) lo[c] = f;
+                if (f > hi[c]) hi[c] = f;
+                sum[c] += f;
+                cnt[c]++;
+            }
+        }
+    }
+    double ms = info_now_ms() - t0;
+
+    for (uint32_t c = 0; c < v->channels; ++c) {
+        printf("ch%u min=%g max=%g mean=%g\n", c, lo[c], hi[c], cnt[c] ? sum[c] / (double)cnt[c] : 0.0);
+    }
+    printf("non-finite=%llu\n", (unsigned long long)bad);
+    print_rate("stats", v, ms);
+    free(sum); free(cnt); free(lo); free(hi);
+    return 1;
+}
 
 int main(int argc, char** argv){
-    const char* in = (argc > 1) ? argv[1] : "output_color.ysub";
-    FILE* f = fopen(in, "rb");
-    if(!f){ printf("cannot open %s\n", in); return 1; }
-
-    YSU_BinHeader h;
-    if(fread(&h, sizeof(h), 1, f) != 1){ printf("bad header\n"); return 1; }
-    fclose(f);
-
-    printf("magic=%c%c%c%c version=%u w=%u h=%u ch=%u dtype=%u\n",
-           h.magic[0], h.magic[1], h.magic[2], h.magic[3],
-           h.version, h.width, h.height, h.channels, h.dtype);
-    return 0;
+    const char* in = "output_color.ysub";
+    uint32_t crop[4] = { 0, 0, UINT32_MAX, UINT32_MAX };
+    uint32_t step = 1;
+    int do_sum = 0, do_stats = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-crop") == 0 && i + 4 < argc) {
+            for (int k = 0; k < 4; ++k) crop[k] = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-step") == 0 && i + 1 < argc) {
+            step = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-sum") == 0) {
+            do_sum = 1;
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            do_stats = 1;
+        } else if (argv[i][0] == '-') {
+            printf("usage: ysub_info [FILE] [-crop X Y W H] [-step N] [-sum] [-stats]\n");
+            return 1;
+        } else {
+            in = argv[i];
+        }
+    }
+
+    YsubFile f;
+    if (!ysub_open(in, &f)) return 1;
+    printf("magic=YSUB version=%u w=%u h=%u ch=%u dtype=%u bytes=%llu\n",
+           f.version, f.width, f.height, f.channels, f.dtype, (unsigned long long)f.size);
+
+    YsubView v;
+    if (!ysub_view_crop(&f.view, crop[0], crop[1], crop[2], crop[3], &v) || !ysub_view_step(&v, step, &v)) {
+        printf("empty view\n");
+        ysub_close(&f);
+        return 1;
+    }
+    if (v.width != f.width || v.height != f.height) {
+        printf("view %ux%u at %u,%u step %u\n", v.width, v.height, crop[0], crop[1], step);
+    }
+
+    int ok = 1;
+    if (do_sum) {
+        double t0 = info_now_ms();
+        uint64_t h = ysub_view_checksum(&v);
+        double ms = info_now_ms() - t0;
+        printf("checksum=%016llx\n", (unsigned long long)h);
+        print_rate("checksum", &v, ms);
+    }
+    if (do_stats) ok = print_stats(&v);
+
+    ysub_close(&f);
+    return ok ? 0 : 1;
 }
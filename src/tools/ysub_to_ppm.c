@@ -1,62 +1,84 @@
 // ysub_to_ppm.c - convert YSUB float32 buffer to PPM (for quick inspection)
+//
+//   ysub_to_ppm [IN] [OUT] [-crop X Y W H] [-step N] [-ch C]
+//
+// Reads through a mapped view (ysub_reader.h): only the cropped / stepped
+// pixels are touched. 1-channel buffers come out grey, others as channels
+// C, C+1, C+2 (default 0; missing channels are 0).
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
-typedef struct {
-    char     magic[4];   // "YSUB"
-    uint32_t version;    // 1
-    uint32_t width;
-    uint32_t height;
-    uint32_t channels;   // 3
-    uint32_t dtype;      // 1 = float32
-} YSU_BinHeader;
+#include "ysub_reader.h"
 
-static float clamp01(float x){ return x < 0.f ? 0.f : (x > 1.f ? 1.f : x); }
+// NaN -> 0
+static float clamp01(float x){ return x > 0.f ? (x < 1.f ? x : 1.f) : 0.f; }
 
 // basit gamma
 static float gamma22(float x){ return powf(clamp01(x), 1.f/2.2f); }
 
 int main(int argc, char** argv){
-    const char* in  = (argc > 1) ? argv[1] : "output_color.ysub";
-    const char* out = (argc > 2) ? argv[2] : "ysub_preview.ppm";
+    const char* in  = "output_color.ysub";
+    const char* out = "ysub_preview.ppm";
+    uint32_t crop[4] = { 0, 0, UINT32_MAX, UINT32_MAX };
+    uint32_t step = 1, ch = 0;
+    int pos = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-crop") == 0 && i + 4 < argc) {
+            for (int k = 0; k < 4; ++k) crop[k] = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-step") == 0 && i + 1 < argc) {
+            step = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-ch") == 0 && i + 1 < argc) {
+            ch = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-' || pos >= 2) {
+            printf("usage: ysub_to_ppm [IN] [OUT] [-crop X Y W H] [-step N] [-ch C]\n");
+            return 1;
+        } else if (pos++ == 0) {
+            in = argv[i];
+        } else {
+            out = argv[i];
+        }
+    }
 
-    FILE* f = fopen(in, "rb");
-    if(!f){ printf("cannot open %s\n", in); return 1; }
+    YsubFile f;
+    if(!ysub_open(in, &f)) return 1;
+    YsubView v;
+    if(!ysub_view_crop(&f.view, crop[0], crop[1], crop[2], crop[3], &v) || !ysub_view_step(&v, step, &v)){
+        printf("empty view\n");
+        ysub_close(&f);
+        return 1;
+    }
+    if(ch >= v.channels){ printf("no channel %u (ch=%u)\n", ch, v.channels); ysub_close(&f); return 1; }
 
-    YSU_BinHeader h;
-    if(fread(&h, sizeof(h), 1, f) != 1){ printf("bad header\n"); return 1; }
-    if(h.magic[0]!='Y'||h.magic[1]!='S'||h.magic[2]!='U'||h.magic[3]!='B'){ printf("not YSUB\n"); return 1; }
-    if(h.dtype != 1 || h.channels != 3){ printf("expected float32 RGB\n"); return 1; }
+    unsigned char* row = (unsigned char*)malloc((size_t)v.width * 3);
+    if(!row){ printf("alloc fail\n"); ysub_close(&f); return 1; }
 
-    size_t npx = (size_t)h.width * (size_t)h.height;
-    float* rgb = (float*)malloc(npx * 3 * sizeof(float));
-    if(!rgb){ printf("alloc fail\n"); return 1; }
+    FILE* o = fopen(out, "wb");
+    if(!o){ printf("cannot open %s\n", out); free(row); ysub_close(&f); return 1; }
 
-    if(fread(rgb, sizeof(float), npx*3, f) != npx*3){ printf("read fail\n"); return 1; }
-    fclose(f);
+    fprintf(o, "P6\n%u %u\n255\n", v.width, v.height);
 
-    FILE* o = fopen(out, "wb");
-    if(!o){ printf("cannot open %s\n", out); return 1; }
-
-    fprintf(o, "P6\n%u %u\n255\n", h.width, h.height);
-
-    for(size_t i=0;i<npx;i++){
-        float r = gamma22(rgb[i*3+0]);
-        float g = gamma22(rgb[i*3+1]);
-        float b = gamma22(rgb[i*3+2]);
-        unsigned char px[3] = {
-            (unsigned char)(r*255.f + 0.5f),
-            (unsigned char)(g*255.f + 0.5f),
-            (unsigned char)(b*255.f + 0.5f)
-        };
-        fwrite(px, 1, 3, o);
+    int ok = 1;
+    const uint32_t nc = (v.channels == 1) ? 1u : 3u;
+    for(uint32_t y=0; y<v.height && ok; y++){
+        const float* p = ysub_row(&v, y);
+        for(uint32_t x=0; x<v.width; x++, p += v.pixel_stride){
+            for(uint32_t k=0;k<3;k++){
+                uint32_t c = ch + ((nc == 1) ? 0u : k);
+                float g = (c < v.channels) ? gamma22(p[c]) : 0.f;
+                row[(size_t)x*3 + k] = (unsigned char)(g*255.f + 0.5f);
+            }
+        }
+        ok = fwrite(row, 3, v.width, o) == v.width;
     }
 
-    fclose(o);
-    free(rgb);
+    if(fclose(o) != 0) ok = 0;
+    free(row);
+    ysub_close(&f);
+    if(!ok){ printf("write fail %s\n", out); return 1; }
 
-    printf("wrote %s\n", out);
+    printf("wrote %s (%ux%u)\n", out, v.width, v.height);
     return 0;
 }
@@ -3,6 +3,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#endif
+
+#include "gpu_bvh_lbv.h"
+#include "ysu_mt.h"   // ysu_mt_suggest_threads
 
 typedef struct { float x,y,z; } v3;
 
@@ -17,6 +26,19 @@ typedef struct {
     v3 centroid;
 } TriInfo;
 
+static double gpu_bvh_now_ms(void){
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1000.0 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
 typedef struct {
     GPUBVHNode* nodes;
     uint32_t count;
@@ -37,17 +59,35 @@ static uint32_t nv_push(NodeVec* nv, const GPUBVHNode* n){
     return nv->count++;
 }
 
-static int g_sort_axis = 0;
-static const TriInfo* g_tri = NULL;
+// nth_element on idx[start,end) by centroid[axis]: afterwards idx[k] holds
+// the k-th centroid and everything before / after it is <= / >=. Three-way
+// partitions keep runs of equal centroids (grids, instanced geometry) linear.
+static inline float tri_key(const TriInfo* tri, int32_t t, int axis){
+    return axis==0 ? tri[t].centroid.x : axis==1 ? tri[t].centroid.y : tri[t].centroid.z;
+}
+
+static void select_nth(const TriInfo* tri, int32_t* idx, uint32_t start, uint32_t end, uint32_t k, int axis){
+    while(end - start > 1){
+        // median of three as pivot
+        uint32_t m = start + (end - start)/2;
+        float a = tri_key(tri, idx[start], axis);
+        float b = tri_key(tri, idx[m], axis);
+        float c = tri_key(tri, idx[end-1], axis);
+        float p = (a < b) ? ((b < c) ? b : (a < c) ? c : a)
+                          : ((a < c) ? a : (b < c) ? c : b);
 
-static int cmp_centroid(const void* a, const void* b){
-    int32_t ia = *(const int32_t*)a;
-    int32_t ib = *(const int32_t*)b;
-    float ca, cb;
-    if(g_sort_axis==0){ ca = g_tri[ia].centroid.x; cb = g_tri[ib].centroid.x; }
-    else if(g_sort_axis==1){ ca = g_tri[ia].centroid.y; cb = g_tri[ib].centroid.y; }
-    else { ca = g_tri[ia].centroid.z; cb = g_tri[ib].centroid.z; }
-    return (ca < cb) ? -1 : (ca > cb) ? 1 : 0;
+        // [start,lt) < p, [lt,i) == p, [gt,end) > p
+        uint32_t lt = start, i = start, gt = end;
+        while(i < gt){
+            float v = tri_key(tri, idx[i], axis);
+            if(v < p){ int32_t t = idx[lt]; idx[lt++] = idx[i]; idx[i++] = t; }
+            else if(v > p){ int32_t t = idx[--gt]; idx[gt] = idx[i]; idx[i] = t; }
+            else i++;
+        }
+        if(k < lt) end = lt;
+        else if(k >= gt) start = gt;
+        else return;
+    }
 }
 
 static void compute_bounds_range(
@@ -74,9 +114,9 @@ static uint32_t build_node(
     const TriInfo* tri,
     int32_t* idx,
     uint32_t start,
-    uint32_t end
+    uint32_t end,
+    uint32_t leaf_max
 ){
-    const uint32_t LEAF_MAX = 8;
     uint32_t ntris = end - start;
 
     v3 mn, mx;
@@ -93,7 +133,7 @@ static uint32_t build_node(
 
     uint32_t my_index = nv_push(nv, &node);
 
-    if(ntris <= LEAF_MAX){
+    if(ntris <= leaf_max){
         // leaf
         return my_index;
     }
@@ -104,15 +144,12 @@ static uint32_t build_node(
     if(ext.y > ext.x) axis = 1;
     if(ext.z > (axis==0 ? ext.x : ext.y)) axis = 2;
 
-    // sort indices in [start,end) by centroid along axis
-    g_sort_axis = axis;
-    g_tri = tri;
-    qsort(idx + start, (size_t)ntris, sizeof(int32_t), cmp_centroid);
-
+    // median split along axis: partition, no full sort
     uint32_t mid = start + ntris/2;
+    select_nth(tri, idx, start, end, mid, axis);
 
-    uint32_t L = build_node(nv, tri, idx, start, mid);
-    uint32_t R = build_node(nv, tri, idx, mid, end);
+    uint32_t L = build_node(nv, tri, idx, start, mid, leaf_max);
+    uint32_t R = build_node(nv, tri, idx, mid, end, leaf_max);
 
     nv->nodes[my_index].left  = (int32_t)L;
     nv->nodes[my_index].right = (int32_t)R;
@@ -123,7 +160,67 @@ static uint32_t build_node(
     return my_index;
 }
 
-int gpu_build_bvh_from_tri_vec4(
+// ------------------------- context -------------------------
+void gpu_bvh_build_ctx_init(GpuBvhBuildCtx* ctx){
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->leaf_max = 8;
+}
+
+void gpu_bvh_build_ctx_free(GpuBvhBuildCtx* ctx){
+    if(!ctx) return;
+    free(ctx->tri);
+    ctx->tri = NULL;
+    ctx->tri_cap = 0;
+}
+
+static int ctx_reserve(GpuBvhBuildCtx* ctx, uint32_t tri_count){
+    if(ctx->tri_cap < tri_count){
+        void* p = realloc(ctx->tri, (size_t)tri_count * sizeof(TriInfo));
+        if(!p) return 0;
+        ctx->tri = p;
+        ctx->tri_cap = tri_count;
+    }
+    return 1;
+}
+
+static void tri_info_set(TriInfo* ti, v3 p0, v3 p1, v3 p2){
+    ti->bmin = v3_min(p0, v3_min(p1, p2));
+    ti->bmax = v3_max(p0, v3_max(p1, p2));
+    ti->centroid = v3_mul(v3_add(v3_add(p0,p1),p2), 1.0f/3.0f);
+}
+
+// Builds from the filled ctx->tri.
+static int ctx_build(
+    GpuBvhBuildCtx* ctx,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+){
+    TriInfo* tri = (TriInfo*)ctx->tri;
+    int32_t* idx = (int32_t*)malloc((size_t)tri_count * sizeof(int32_t));
+    if(!idx) return 0;
+    for(uint32_t i=0;i<tri_count;i++) idx[i] = (int32_t)i;
+
+    // a median tree with leaves of up to leaf_max has < 2*tri_count nodes
+    NodeVec nv;
+    memset(&nv, 0, sizeof(nv));
+    nv_reserve(&nv, 2u * tri_count);
+    if(!nv.nodes){ free(idx); return 0; }
+
+    // root build (creates all nodes)
+    (void)build_node(&nv, tri, idx, 0, tri_count, ctx->leaf_max ? ctx->leaf_max : 1u);
+
+    *out_nodes = nv.nodes;
+    *out_node_count = nv.count;
+    *out_indices = idx;
+    *out_index_count = tri_count;
+    return 1;
+}
+
+int gpu_bvh_build_ctx_run(
+    GpuBvhBuildCtx* ctx,
     const float* tri_data,
     uint32_t tri_count,
     GPUBVHNode** out_nodes,
@@ -131,11 +228,10 @@ int gpu_build_bvh_from_tri_vec4(
     int32_t** out_indices,
     uint32_t* out_index_count
 ){
-    if(!tri_data || tri_count == 0 || !out_nodes || !out_node_count || !out_indices || !out_index_count)
+    if(!ctx || !tri_data || tri_count == 0 || !out_nodes || !out_node_count || !out_indices || !out_index_count)
         return 0;
-
-    TriInfo* tri = (TriInfo*)malloc((size_t)tri_count * sizeof(TriInfo));
-    if(!tri) return 0;
+    if(!ctx_reserve(ctx, tri_count)) return 0;
+    TriInfo* tri = (TriInfo*)ctx->tri;
 
     // tri_info fill
     for(uint32_t i=0;i<tri_count;i++){
@@ -144,31 +240,137 @@ int gpu_build_bvh_from_tri_vec4(
         v3 p0 = { t[0],  t[1],  t[2]  };
         v3 p1 = { t[4],  t[5],  t[6]  };
         v3 p2 = { t[8],  t[9],  t[10] };
+        tri_info_set(&tri[i], p0, p1, p2);
+    }
+    return ctx_build(ctx, tri_count, out_nodes, out_node_count, out_indices, out_index_count);
+}
 
-        v3 mn = v3_min(p0, v3_min(p1, p2));
-        v3 mx = v3_max(p0, v3_max(p1, p2));
-        v3 c  = v3_mul(v3_add(v3_add(p0,p1),p2), 1.0f/3.0f);
+int gpu_bvh_build_ctx_run_indexed(
+    GpuBvhBuildCtx* ctx,
+    const float* verts,
+    const uint32_t* indices,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+){
+    if(!ctx || !verts || !indices || tri_count == 0 || !out_nodes || !out_node_count || !out_indices || !out_index_count)
+        return 0;
+    if(!ctx_reserve(ctx, tri_count)) return 0;
+    TriInfo* tri = (TriInfo*)ctx->tri;
 
-        tri[i].bmin = mn;
-        tri[i].bmax = mx;
-        tri[i].centroid = c;
+    for(uint32_t i=0;i<tri_count;i++){
+        const float* a = verts + (size_t)indices[i*3u + 0u] * 3u;
+        const float* b = verts + (size_t)indices[i*3u + 1u] * 3u;
+        const float* c = verts + (size_t)indices[i*3u + 2u] * 3u;
+
+        v3 p0 = { a[0], a[1], a[2] };
+        v3 p1 = { b[0], b[1], b[2] };
+        v3 p2 = { c[0], c[1], c[2] };
+        tri_info_set(&tri[i], p0, p1, p2);
     }
+    return ctx_build(ctx, tri_count, out_nodes, out_node_count, out_indices, out_index_count);
+}
 
-    int32_t* idx = (int32_t*)malloc((size_t)tri_count * sizeof(int32_t));
-    if(!idx){ free(tri); return 0; }
-    for(uint32_t i=0;i<tri_count;i++) idx[i] = (int32_t)i;
+int gpu_build_bvh_from_tri_vec4(
+    const float* tri_data,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+){
+    GpuBvhBuildCtx ctx;
+    gpu_bvh_build_ctx_init(&ctx);
+    int ok = gpu_bvh_build_ctx_run(&ctx, tri_data, tri_count, out_nodes, out_node_count,
+                                   out_indices, out_index_count);
+    gpu_bvh_build_ctx_free(&ctx);
+    return ok;
+}
 
-    NodeVec nv;
-    memset(&nv, 0, sizeof(nv));
+// ------------------------- jobs -------------------------
+typedef struct {
+    GpuBvhBuildJob* jobs;
+    int*            order;     // largest first
+    int             count;
+    int             lbvh_threads;   // per LBVH job when there are fewer jobs than threads
+    atomic_int      next;
+} GpuBvhJobQueue;
 
-    // root build (creates all nodes)
-    (void)build_node(&nv, tri, idx, 0, tri_count);
+static void* gpu_bvh_job_worker(void* arg){
+    GpuBvhJobQueue* q = (GpuBvhJobQueue*)arg;
+    GpuBvhBuildCtx ctx;
+    gpu_bvh_build_ctx_init(&ctx);
+    for(;;){
+        int k = atomic_fetch_add(&q->next, 1);
+        if(k >= q->count) break;
+        GpuBvhBuildJob* j = &q->jobs[q->order[k]];
+        j->nodes = NULL;
+        j->indices = NULL;
+        if(j->builder == GPU_BVH_BUILDER_LBVH){
+            j->ok = gpu_build_bvh_from_tri_vec4_lbv_ex(j->tri_data, j->tri_count, q->lbvh_threads,
+                                                       &j->nodes, &j->node_count,
+                                                       &j->indices, &j->index_count) ? 1 : 0;
+        } else {
+            if(j->leaf_max > 0) ctx.leaf_max = j->leaf_max;
+            else ctx.leaf_max = 8;
+            j->ok = gpu_bvh_build_ctx_run(&ctx, j->tri_data, j->tri_count, &j->nodes, &j->node_count,
+                                          &j->indices, &j->index_count);
+        }
+    }
+    gpu_bvh_build_ctx_free(&ctx);
+    return NULL;
+}
 
-    free(tri);
+typedef struct { uint32_t tris; int job; } GpuBvhJobSize;
 
-    *out_nodes = nv.nodes;
-    *out_node_count = nv.count;
-    *out_indices = idx;
-    *out_index_count = tri_count;
-    return 1;
+static int gpu_bvh_job_cmp(const void* a, const void* b){
+    uint32_t na = ((const GpuBvhJobSize*)a)->tris;
+    uint32_t nb = ((const GpuBvhJobSize*)b)->tris;
+    return (na < nb) - (na > nb);   // largest first
+}
+
+int gpu_bvh_build_jobs(GpuBvhBuildJob* jobs, int job_count, int threads, double* wall_ms){
+    if(wall_ms) *wall_ms = 0.0;
+    if(!jobs || job_count <= 0) return 0;
+    double t0 = gpu_bvh_now_ms();
+
+    GpuBvhJobSize* sz = (GpuBvhJobSize*)malloc(sizeof(GpuBvhJobSize) * (size_t)job_count);
+    int* order = (int*)malloc(sizeof(int) * (size_t)job_count);
+    if(!sz || !order){ free(sz); free(order); return 0; }
+    for(int k=0;k<job_count;k++){ sz[k].tris = jobs[k].tri_count; sz[k].job = k; jobs[k].ok = 0; }
+    qsort(sz, (size_t)job_count, sizeof(GpuBvhJobSize), gpu_bvh_job_cmp);
+    for(int k=0;k<job_count;k++) order[k] = sz[k].job;
+    free(sz);
+
+    GpuBvhJobQueue q;
+    q.jobs  = jobs;
+    q.order = order;
+    q.count = job_count;
+    atomic_init(&q.next, 0);
+
+    if(threads <= 0){
+        const char* s = getenv("YSU_BVH_THREADS");
+        threads = (s && s[0]) ? atoi(s) : ysu_mt_suggest_threads();
+    }
+    if(threads < 1) threads = 1;
+    q.lbvh_threads = (threads > job_count) ? threads / job_count : 1;
+    if(threads > job_count) threads = job_count;
+
+    int nthr = threads - 1;
+    pthread_t* thr = (nthr > 0) ? (pthread_t*)malloc(sizeof(pthread_t) * (size_t)nthr) : NULL;
+    int started = 0;
+    for(; thr && started < nthr; ++started){
+        if(pthread_create(&thr[started], NULL, gpu_bvh_job_worker, &q) != 0) break;
+    }
+    gpu_bvh_job_worker(&q);
+    for(int i=0;i<started;i++) pthread_join(thr[i], NULL);
+    free(thr);
+    free(order);
+
+    int ok = 1;
+    for(int k=0;k<job_count;k++) ok &= jobs[k].ok;
+    if(wall_ms) *wall_ms = gpu_bvh_now_ms() - t0;
+    return ok;
 }
@@ -27,6 +27,70 @@ int gpu_build_bvh_from_tri_vec4(
     uint32_t* out_index_count
 );
 
+// ---- reentrant builder ----
+// Same median build with all state in a context, so several meshes can be
+// built at once (one context per thread). The context keeps its scratch
+// between runs; outputs are malloc'd per run as above.
+typedef struct {
+    uint32_t leaf_max;   // max triangles per leaf (init: 8)
+    void*    tri;        // per-triangle bounds/centroids, reused across runs
+    uint32_t tri_cap;
+} GpuBvhBuildCtx;
+
+void gpu_bvh_build_ctx_init(GpuBvhBuildCtx* ctx);
+void gpu_bvh_build_ctx_free(GpuBvhBuildCtx* ctx);
+
+int gpu_bvh_build_ctx_run(
+    GpuBvhBuildCtx* ctx,
+    const float* tri_data,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+);
+
+// Same build from an indexed mesh: verts are xyz (3 floats per vertex),
+// indices 3 per triangle.
+int gpu_bvh_build_ctx_run_indexed(
+    GpuBvhBuildCtx* ctx,
+    const float* verts,
+    const uint32_t* indices,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+);
+
+// ---- job API ----
+// One BVH per job (e.g. the YSU_GPU_BVH_CHUNK_TRIS chunks of a big mesh).
+// Jobs run largest first on a shared counter, one job per thread; with
+// fewer jobs than threads the LBVH jobs split the spare threads.
+typedef enum {
+    GPU_BVH_BUILDER_MEDIAN = 0,   // gpu_build_bvh_from_tri_vec4
+    GPU_BVH_BUILDER_LBVH  = 1     // gpu_build_bvh_from_tri_vec4_lbv
+} GpuBvhBuilder;
+
+typedef struct {
+    // in
+    const float*  tri_data;
+    uint32_t      tri_count;
+    GpuBvhBuilder builder;
+    uint32_t      leaf_max;      // median builder, 0 = 8
+    // out (malloc'd, caller frees)
+    GPUBVHNode*   nodes;
+    uint32_t      node_count;
+    int32_t*      indices;
+    uint32_t      index_count;
+    int           ok;
+} GpuBvhBuildJob;
+
+// Builds all jobs on up to `threads` threads (<= 0: YSU_BVH_THREADS, else
+// the CPU count). Returns 1 if every job succeeded; *wall_ms (optional) is
+// the wall time of the whole batch.
+int gpu_bvh_build_jobs(GpuBvhBuildJob* jobs, int job_count, int threads, double* wall_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,29 +1,38 @@
-// gpu_bvh_lbv.c
+// gpu_bvh_lbv.c - parallel LBVH (Karras 2012) over tri_vec4 triangles
+//
+// All threads run the same phases with a spin barrier between them:
+//   1. centroids + per-thread centroid bounds
+//   2. 30-bit Morton keys, packed as (key << 32 | triangle id) so every key
+//      is unique (Karras' index tie-break for duplicate codes)
+//   3. LSD radix sort, 3 passes of 10 bits; per-thread histograms, each
+//      thread scatters its own slice
+//   4. leaves + internal nodes, one Karras range/split per node, parents
+//   5. bottom-up refit: a leaf walks up until it is the first child to
+//      reach a parent (atomic visit counter); the second one boxes it
+// Output layout is the one the Vulkan path reads: internal nodes 0..n-2
+// (root 0), leaves n-1..2n-2 with one triangle each, in Morton order.
 #include "gpu_bvh_lbv.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <sched.h>
+#endif
 
-typedef struct {
-    uint32_t key;   // 30-bit morton
-    uint32_t id;    // triangle id
-    float c[3];     // centroid
-    float bmin[3];
-    float bmax[3];
-} Prim;
+#include "ysu_mt.h"   // ysu_mt_suggest_threads
+
+#define LBVH_RADIX_BITS 10
+#define LBVH_RADIX      (1u << LBVH_RADIX_BITS)
+#define LBVH_MIN_SLICE  16384   // prims per thread below which fewer threads are used
+#define LBVH_MAX_THREADS 64
 
 static inline float fmin3(float a,float b,float c){ return fminf(a,fminf(b,c)); }
 static inline float fmax3(float a,float b,float c){ return fmaxf(a,fmaxf(b,c)); }
 
-static inline void bbox_init(float mn[3], float mx[3]){
-    mn[0]=mn[1]=mn[2]= +INFINITY;
-    mx[0]=mx[1]=mx[2]= -INFINITY;
-}
-static inline void bbox_expand(float mn[3], float mx[3], const float p[3]){
-    mn[0]=fminf(mn[0],p[0]); mn[1]=fminf(mn[1],p[1]); mn[2]=fminf(mn[2],p[2]);
-    mx[0]=fmaxf(mx[0],p[0]); mx[1]=fmaxf(mx[1],p[1]); mx[2]=fmaxf(mx[2],p[2]);
-}
-
 // bit interleave (10-bit -> 30-bit spread)
 static inline uint32_t expand_bits_10(uint32_t v){
     v &= 1023u;
@@ -48,44 +57,35 @@ static inline uint32_t morton3(float x, float y, float z){
     return (xb << 0) | (yb << 1) | (zb << 2);
 }
 
-static inline int clz32_u(uint32_t x){
+static inline int clz64_u(uint64_t x){
 #if defined(__GNUC__) || defined(__clang__)
-    return x ? __builtin_clz(x) : 32;
+    return x ? __builtin_clzll(x) : 64;
 #else
     // portable fallback
     int n=0;
-    while(n<32 && (x & 0x80000000u)==0){ x<<=1; n++; }
+    while(n<64 && (x & 0x8000000000000000ull)==0){ x<<=1; n++; }
     return n;
 #endif
 }
 
-// Karras common prefix
-static inline int common_prefix(const Prim* p, int i, int j, int n){
+// Karras common prefix; keys are unique, so i != j never gives 64
+static inline int common_prefix(const uint64_t* k, int i, int j, int n){
     if(j < 0 || j >= n) return -1;
-    uint32_t ki = p[i].key;
-    uint32_t kj = p[j].key;
-    if(ki == kj){
-        // tie-breaker by id
-        uint32_t di = p[i].id;
-        uint32_t dj = p[j].id;
-        uint32_t x = di ^ dj;
-        return 32 + (x ? clz32_u(x) : 32);
-    }
-    return clz32_u(ki ^ kj);
+    return clz64_u(k[i] ^ k[j]);
 }
 
-static void determine_range(const Prim* p, int i, int n, int* out_first, int* out_last){
-    int cpL = common_prefix(p, i, i-1, n);
-    int cpR = common_prefix(p, i, i+1, n);
+static void determine_range(const uint64_t* k, int i, int n, int* out_first, int* out_last){
+    int cpL = common_prefix(k, i, i-1, n);
+    int cpR = common_prefix(k, i, i+1, n);
     int d = (cpR > cpL) ? 1 : -1;
-    int cpMin = common_prefix(p, i, i - d, n);
+    int cpMin = common_prefix(k, i, i - d, n);
 
     int lmax = 2;
-    while(common_prefix(p, i, i + lmax*d, n) > cpMin) lmax <<= 1;
+    while(common_prefix(k, i, i + lmax*d, n) > cpMin) lmax <<= 1;
 
     int l = 0;
     for(int t = lmax >> 1; t > 0; t >>= 1){
-        if(common_prefix(p, i, i + (l + t)*d, n) > cpMin) l += t;
+        if(common_prefix(k, i, i + (l + t)*d, n) > cpMin) l += t;
     }
 
     int j = i + l*d;
@@ -96,198 +96,346 @@ static void determine_range(const Prim* p, int i, int n, int* out_first, int* ou
     *out_last  = last;
 }
 
-static int find_split(const Prim* p, int first, int last, int n){
+static int find_split(const uint64_t* k, int first, int last, int n){
     if(first == last) return first;
-    int cp = common_prefix(p, first, last, n);
+    int cp = common_prefix(k, first, last, n);
     int split = first;
     int step = last - first;
     do {
         step = (step + 1) >> 1;
         int mid = split + step;
         if(mid < last){
-            int cpm = common_prefix(p, first, mid, n);
+            int cpm = common_prefix(k, first, mid, n);
             if(cpm > cp) split = mid;
         }
     } while(step > 1);
     return split;
 }
 
-// bottom-up bbox compute (post-order) - iterative, stack allocated
-static void compute_internal_bboxes(GPUBVHNode* nodes, uint32_t root){
-    typedef struct { uint32_t n; uint8_t state; } Stack;
-    Stack st[256];
-    int sp=0;
-    st[sp++] = (Stack){root, 0};
-
-    while(sp){
-        Stack* top = &st[sp-1];
-        uint32_t ni = top->n;
-        GPUBVHNode* nd = &nodes[ni];
-
-        if(nd->left < 0 && nd->right < 0){
-            sp--;
-            continue;
-        }
-
-        if(top->state == 0){
-            top->state = 1;
-            st[sp++] = (Stack){(uint32_t)nd->left, 0};
-            continue;
-        }
-        if(top->state == 1){
-            top->state = 2;
-            st[sp++] = (Stack){(uint32_t)nd->right, 0};
-            continue;
-        }
-
-        GPUBVHNode* L = &nodes[(uint32_t)nd->left];
-        GPUBVHNode* R = &nodes[(uint32_t)nd->right];
-
-        nd->bmin[0]=fminf(L->bmin[0], R->bmin[0]);
-        nd->bmin[1]=fminf(L->bmin[1], R->bmin[1]);
-        nd->bmin[2]=fminf(L->bmin[2], R->bmin[2]);
-        nd->bmin[3]=0.0f;
+// ------------------------- thread team -------------------------
+static inline void lbvh_relax(void){
+#if defined(_WIN32)
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
 
-        nd->bmax[0]=fmaxf(L->bmax[0], R->bmax[0]);
-        nd->bmax[1]=fmaxf(L->bmax[1], R->bmax[1]);
-        nd->bmax[2]=fmaxf(L->bmax[2], R->bmax[2]);
-        nd->bmax[3]=0.0f;
+static inline void lbvh_yield(void){
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
 
-        sp--;
+typedef struct {
+    const float* tri;
+    uint32_t     n;
+    int          nthreads;
+    atomic_int   start;        // 1 once nthreads is final
+
+    atomic_int   bar_count;
+    atomic_int   bar_gen;
+
+    float*       cen;          // 3 per triangle
+    float      (*cbounds)[6];  // per thread: centroid min xyz, max xyz
+    uint64_t*    keys;         // sorted result
+    uint64_t*    tmp;
+    uint32_t   (*hist)[LBVH_RADIX];
+    uint32_t*    parent;       // 2n-1
+    atomic_uint* visit;        // n-1 internal nodes
+    GPUBVHNode*  nodes;
+    int32_t*     indices;
+} LbvhJob;
+
+typedef struct { LbvhJob* job; int tid; } LbvhArg;
+
+// Phases are short, so waiters spin before yielding.
+static void lbvh_barrier(LbvhJob* j){
+    if(j->nthreads == 1) return;
+    int gen = atomic_load_explicit(&j->bar_gen, memory_order_acquire);
+    if(atomic_fetch_add_explicit(&j->bar_count, 1, memory_order_acq_rel) == j->nthreads - 1){
+        atomic_store_explicit(&j->bar_count, 0, memory_order_relaxed);
+        atomic_store_explicit(&j->bar_gen, gen + 1, memory_order_release);
+        return;
+    }
+    unsigned spins = 0;
+    while(atomic_load_explicit(&j->bar_gen, memory_order_acquire) == gen){
+        if((++spins & 255u) == 0) lbvh_yield();
+        else lbvh_relax();
     }
 }
 
-bool gpu_build_bvh_from_tri_vec4_lbv(
-    const float* tri_vec4,
-    uint32_t tri_count,
-    GPUBVHNode** out_nodes,
-    uint32_t* out_node_count,
-    int32_t** out_indices,
-    uint32_t* out_index_count
-){
-    if(!tri_vec4 || tri_count == 0 || !out_nodes || !out_node_count || !out_indices || !out_index_count)
-        return false;
-
-    Prim* prim = (Prim*)calloc(tri_count, sizeof(Prim));
-    Prim* tmp  = (Prim*)calloc(tri_count, sizeof(Prim));
-    if(!prim || !tmp){ free(prim); free(tmp); return false; }
-
-    float cmin[3], cmax[3]; bbox_init(cmin,cmax);
-
-    for(uint32_t i=0;i<tri_count;i++){
-        const float* t = tri_vec4 + (size_t)i * 12; // 3*vec4
-        float a[3] = {t[0], t[1], t[2]};
-        float b[3] = {t[4], t[5], t[6]};
-        float c[3] = {t[8], t[9], t[10]};
+static inline void lbvh_slice(const LbvhJob* j, int tid, uint32_t count, uint32_t* b, uint32_t* e){
+    *b = (uint32_t)(((uint64_t)count * (uint64_t)tid) / (uint64_t)j->nthreads);
+    *e = (uint32_t)(((uint64_t)count * (uint64_t)(tid + 1)) / (uint64_t)j->nthreads);
+}
 
-        float mn[3] = { fmin3(a[0],b[0],c[0]), fmin3(a[1],b[1],c[1]), fmin3(a[2],b[2],c[2]) };
-        float mx[3] = { fmax3(a[0],b[0],c[0]), fmax3(a[1],b[1],c[1]), fmax3(a[2],b[2],c[2]) };
+static void lbvh_histogram(LbvhJob* j, int tid, const uint64_t* src, uint32_t shift){
+    uint32_t b, e;
+    lbvh_slice(j, tid, j->n, &b, &e);
+    uint32_t* h = j->hist[tid];
+    memset(h, 0, sizeof(uint32_t) * LBVH_RADIX);
+    for(uint32_t i=b;i<e;i++) h[(uint32_t)(src[i] >> shift) & (LBVH_RADIX - 1u)]++;
+}
 
-        float cen[3] = { (a[0]+b[0]+c[0])/3.0f, (a[1]+b[1]+c[1])/3.0f, (a[2]+b[2]+c[2])/3.0f };
+// Stable scatter of this thread's slice: digit d of thread t goes after all
+// smaller digits and after digit d of threads < t.
+static void lbvh_scatter(LbvhJob* j, int tid, const uint64_t* src, uint64_t* dst, uint32_t shift){
+    uint32_t off[LBVH_RADIX];
+    uint32_t sum = 0;
+    for(uint32_t d=0; d<LBVH_RADIX; d++){
+        uint32_t mine = sum;
+        for(int t=0;t<j->nthreads;t++){
+            if(t == tid) mine = sum;
+            sum += j->hist[t][d];
+        }
+        off[d] = mine;
+    }
+    uint32_t b, e;
+    lbvh_slice(j, tid, j->n, &b, &e);
+    for(uint32_t i=b;i<e;i++){
+        uint64_t v = src[i];
+        dst[off[(uint32_t)(v >> shift) & (LBVH_RADIX - 1u)]++] = v;
+    }
+}
 
-        bbox_expand(cmin,cmax,cen);
+static inline void node_box_from_children(GPUBVHNode* nodes, GPUBVHNode* nd){
+    const GPUBVHNode* L = &nodes[nd->left];
+    const GPUBVHNode* R = &nodes[nd->right];
+    nd->bmin[0]=fminf(L->bmin[0], R->bmin[0]);
+    nd->bmin[1]=fminf(L->bmin[1], R->bmin[1]);
+    nd->bmin[2]=fminf(L->bmin[2], R->bmin[2]);
+    nd->bmin[3]=0.0f;
+    nd->bmax[0]=fmaxf(L->bmax[0], R->bmax[0]);
+    nd->bmax[1]=fmaxf(L->bmax[1], R->bmax[1]);
+    nd->bmax[2]=fmaxf(L->bmax[2], R->bmax[2]);
+    nd->bmax[3]=0.0f;
+}
 
-        prim[i].id = i;
-        prim[i].c[0]=cen[0]; prim[i].c[1]=cen[1]; prim[i].c[2]=cen[2];
-        prim[i].bmin[0]=mn[0]; prim[i].bmin[1]=mn[1]; prim[i].bmin[2]=mn[2];
-        prim[i].bmax[0]=mx[0]; prim[i].bmax[1]=mx[1]; prim[i].bmax[2]=mx[2];
+static void lbvh_run(LbvhJob* j, int tid){
+    const uint32_t n = j->n;
+    const uint32_t leafBase = n - 1;
+    uint32_t b, e;
+
+    // 1. centroids
+    lbvh_slice(j, tid, n, &b, &e);
+    float mn[3] = { +INFINITY, +INFINITY, +INFINITY };
+    float mx[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for(uint32_t i=b;i<e;i++){
+        const float* t = j->tri + (size_t)i * 12; // 3*vec4
+        float* c = j->cen + (size_t)i * 3;
+        c[0] = (t[0]+t[4]+t[8]) /3.0f;
+        c[1] = (t[1]+t[5]+t[9]) /3.0f;
+        c[2] = (t[2]+t[6]+t[10])/3.0f;
+        for(int a=0;a<3;a++){ mn[a]=fminf(mn[a],c[a]); mx[a]=fmaxf(mx[a],c[a]); }
     }
-
-    float extent[3] = { cmax[0]-cmin[0], cmax[1]-cmin[1], cmax[2]-cmin[2] };
+    memcpy(j->cbounds[tid], mn, sizeof(mn));
+    memcpy(j->cbounds[tid] + 3, mx, sizeof(mx));
+    lbvh_barrier(j);
+
+    // 2. keys (every thread reduces the bounds itself)
+    for(int t=0;t<j->nthreads;t++){
+        for(int a=0;a<3;a++){
+            mn[a]=fminf(mn[a], j->cbounds[t][a]);
+            mx[a]=fmaxf(mx[a], j->cbounds[t][3+a]);
+        }
+    }
+    float extent[3] = { mx[0]-mn[0], mx[1]-mn[1], mx[2]-mn[2] };
     if(extent[0] < 1e-20f) extent[0]=1.0f;
     if(extent[1] < 1e-20f) extent[1]=1.0f;
     if(extent[2] < 1e-20f) extent[2]=1.0f;
-
-    for(uint32_t i=0;i<tri_count;i++){
-        float nx = (prim[i].c[0]-cmin[0]) / extent[0];
-        float ny = (prim[i].c[1]-cmin[1]) / extent[1];
-        float nz = (prim[i].c[2]-cmin[2]) / extent[2];
-        prim[i].key = morton3(nx,ny,nz);
+    for(uint32_t i=b;i<e;i++){
+        const float* c = j->cen + (size_t)i * 3;
+        uint32_t key = morton3((c[0]-mn[0]) / extent[0], (c[1]-mn[1]) / extent[1], (c[2]-mn[2]) / extent[2]);
+        j->tmp[i] = ((uint64_t)key << 32) | i;
     }
 
-    // radix sort 30-bit, 6 passes of 5 bits
-    Prim* a=prim;
-    Prim* b=tmp;
-    const uint32_t RAD=32u;
-    for(uint32_t pass=0; pass<6; pass++){
-        uint32_t shift = pass*5u;
-        uint32_t count[RAD]; memset(count,0,sizeof(count));
-        for(uint32_t i=0;i<tri_count;i++){
-            uint32_t bin = (a[i].key >> shift) & (RAD-1u);
-            count[bin]++;
-        }
-        uint32_t sum=0;
-        for(uint32_t bin=0;bin<RAD;bin++){
-            uint32_t c = count[bin];
-            count[bin]=sum;
-            sum += c;
-        }
-        for(uint32_t i=0;i<tri_count;i++){
-            uint32_t bin = (a[i].key >> shift) & (RAD-1u);
-            b[count[bin]++] = a[i];
-        }
-        Prim* sw=a; a=b; b=sw;
+    // 3. radix sort on the key bits 32..61; an odd pass count ends in keys
+    uint64_t* src = j->tmp;
+    uint64_t* dst = j->keys;
+    for(uint32_t pass=0; pass<3; pass++){
+        uint32_t shift = 32u + pass * LBVH_RADIX_BITS;
+        lbvh_histogram(j, tid, src, shift);
+        lbvh_barrier(j);
+        lbvh_scatter(j, tid, src, dst, shift);
+        lbvh_barrier(j);
+        uint64_t* sw=src; src=dst; dst=sw;
     }
-    if(a != prim) memcpy(prim, a, sizeof(Prim)*tri_count);
-
-    uint32_t n = tri_count;
-    uint32_t leafBase = (n > 1) ? (n - 1) : 0;
-    uint32_t nodeCount = (n > 1) ? (2*n - 1) : 1;
-
-    GPUBVHNode* nodes = (GPUBVHNode*)calloc(nodeCount, sizeof(GPUBVHNode));
-    int32_t* indices  = (int32_t*)malloc(sizeof(int32_t)*n);
-    if(!nodes || !indices){
-        free(nodes); free(indices); free(prim); free(tmp);
-        return false;
+    const uint64_t* keys = j->keys;
+
+    // 4. leaves: one triangle per leaf, in morton order. Each thread reads
+    //    its own triangles in input order and scatters the boxes by rank;
+    //    scattered writes are cheaper than gathering triangles in key order.
+    uint32_t* rank = (uint32_t*)j->tmp;   // free after the sort
+    lbvh_slice(j, tid, n, &b, &e);
+    for(uint32_t i=b;i<e;i++){
+        uint32_t id = (uint32_t)keys[i];
+        j->indices[i] = (int32_t)id;
+        rank[id] = i;
     }
-
-    // Leaves: one triangle per leaf, in morton order
-    for(uint32_t i=0;i<n;i++){
-        indices[i] = (int32_t)prim[i].id;
-
-        GPUBVHNode* L = &nodes[leafBase + i];
-        L->bmin[0]=prim[i].bmin[0]; L->bmin[1]=prim[i].bmin[1]; L->bmin[2]=prim[i].bmin[2]; L->bmin[3]=0.0f;
-        L->bmax[0]=prim[i].bmax[0]; L->bmax[1]=prim[i].bmax[1]; L->bmax[2]=prim[i].bmax[2]; L->bmax[3]=0.0f;
+    lbvh_barrier(j);
+    for(uint32_t id=b;id<e;id++){
+        const float* t = j->tri + (size_t)id * 12;
+        uint32_t i = rank[id];
+        GPUBVHNode* L = &j->nodes[leafBase + i];
+        L->bmin[0]=fmin3(t[0],t[4],t[8]); L->bmin[1]=fmin3(t[1],t[5],t[9]); L->bmin[2]=fmin3(t[2],t[6],t[10]); L->bmin[3]=0.0f;
+        L->bmax[0]=fmax3(t[0],t[4],t[8]); L->bmax[1]=fmax3(t[1],t[5],t[9]); L->bmax[2]=fmax3(t[2],t[6],t[10]); L->bmax[3]=0.0f;
         L->left = -1; L->right = -1;
         L->triOffset = (int32_t)i;
         L->triCount  = 1;
     }
 
-    if(n == 1){
-        *out_nodes = nodes;
-        *out_node_count = 1;
-        *out_indices = indices;
-        *out_index_count = 1;
-        free(prim); free(tmp);
-        return true;
-    }
-
-    // Internal nodes 0..n-2
-    for(uint32_t i=0;i<n-1;i++){
+    //    internal nodes 0..n-2
+    lbvh_slice(j, tid, n - 1, &b, &e);
+    for(uint32_t i=b;i<e;i++){
         int first=0,last=0;
-        determine_range(prim, (int)i, (int)n, &first, &last);
-        int split = find_split(prim, first, last, (int)n);
+        determine_range(keys, (int)i, (int)n, &first, &last);
+        int split = find_split(keys, first, last, (int)n);
 
         int leftIndex  = (split == first) ? (int)(leafBase + (uint32_t)split) : split;
         int rightIndex = (split + 1 == last) ? (int)(leafBase + (uint32_t)(split + 1)) : (split + 1);
 
-        GPUBVHNode* N = &nodes[i];
+        GPUBVHNode* N = &j->nodes[i];
         N->left = leftIndex;
         N->right = rightIndex;
         N->triOffset = 0;
         N->triCount = 0;
         N->bmin[0]=N->bmin[1]=N->bmin[2]=+INFINITY; N->bmin[3]=0.0f;
         N->bmax[0]=N->bmax[1]=N->bmax[2]=-INFINITY; N->bmax[3]=0.0f;
+        j->parent[leftIndex]  = i;
+        j->parent[rightIndex] = i;
+        atomic_store_explicit(&j->visit[i], 0u, memory_order_relaxed);
+    }
+    lbvh_barrier(j);
+
+    // 5. refit; the acq_rel counter orders the first child's box before the
+    //    second child reads it
+    lbvh_slice(j, tid, n, &b, &e);
+    for(uint32_t i=b;i<e;i++){
+        uint32_t ni = j->parent[leafBase + i];
+        for(;;){
+            if(atomic_fetch_add_explicit(&j->visit[ni], 1u, memory_order_acq_rel) == 0u) break;
+            node_box_from_children(j->nodes, &j->nodes[ni]);
+            if(ni == 0) break;
+            ni = j->parent[ni];
+        }
+    }
+}
+
+static void* lbvh_worker(void* p){
+    LbvhArg* a = (LbvhArg*)p;
+    while(atomic_load_explicit(&a->job->start, memory_order_acquire) == 0) lbvh_yield();
+    lbvh_run(a->job, a->tid);
+    return NULL;
+}
+
+static int lbvh_default_threads(void){
+    const char* s = getenv("YSU_BVH_THREADS");
+    return (s && s[0]) ? atoi(s) : ysu_mt_suggest_threads();
+}
+
+bool gpu_build_bvh_from_tri_vec4_lbv_ex(
+    const float* tri_vec4,
+    uint32_t tri_count,
+    int threads,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+){
+    if(!tri_vec4 || tri_count == 0 || !out_nodes || !out_node_count || !out_indices || !out_index_count)
+        return false;
+
+    uint32_t n = tri_count;
+    uint32_t nodeCount = (n > 1) ? (2*n - 1) : 1;
+    GPUBVHNode* nodes = (GPUBVHNode*)malloc(sizeof(GPUBVHNode) * (size_t)nodeCount);   // every field is written
+    int32_t* indices  = (int32_t*)malloc(sizeof(int32_t)*n);
+    if(!nodes || !indices){ free(nodes); free(indices); return false; }
+
+    if(n == 1){
+        const float* t = tri_vec4;
+        GPUBVHNode* L = &nodes[0];
+        L->bmin[0]=fmin3(t[0],t[4],t[8]); L->bmin[1]=fmin3(t[1],t[5],t[9]); L->bmin[2]=fmin3(t[2],t[6],t[10]); L->bmin[3]=0.0f;
+        L->bmax[0]=fmax3(t[0],t[4],t[8]); L->bmax[1]=fmax3(t[1],t[5],t[9]); L->bmax[2]=fmax3(t[2],t[6],t[10]); L->bmax[3]=0.0f;
+        L->left = -1; L->right = -1;
+        L->triOffset = 0;
+        L->triCount  = 1;
+        indices[0] = 0;
+        *out_nodes = nodes;
+        *out_node_count = 1;
+        *out_indices = indices;
+        *out_index_count = 1;
+        return true;
     }
 
-    compute_internal_bboxes(nodes, 0);
+    if(threads <= 0) threads = lbvh_default_threads();
+    uint32_t by_size = (n + LBVH_MIN_SLICE - 1) / LBVH_MIN_SLICE;
+    if((uint32_t)threads > by_size) threads = (int)by_size;
+    if(threads > LBVH_MAX_THREADS) threads = LBVH_MAX_THREADS;
+    if(threads < 1) threads = 1;
+
+    LbvhJob job;
+    memset(&job, 0, sizeof(job));
+    job.tri     = tri_vec4;
+    job.n       = n;
+    job.nodes   = nodes;
+    job.indices = indices;
+    job.cen     = (float*)malloc(sizeof(float) * 3u * (size_t)n);
+    job.keys    = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)n);
+    job.tmp     = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)n);
+    job.parent  = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)nodeCount);
+    job.visit   = (atomic_uint*)malloc(sizeof(atomic_uint) * (size_t)(n - 1));
+    job.cbounds = (float(*)[6])malloc(sizeof(float[6]) * (size_t)threads);
+    job.hist    = (uint32_t(*)[LBVH_RADIX])malloc(sizeof(uint32_t[LBVH_RADIX]) * (size_t)threads);
+    pthread_t* thr = (threads > 1) ? (pthread_t*)malloc(sizeof(pthread_t) * (size_t)(threads - 1)) : NULL;
+    LbvhArg* args = (LbvhArg*)malloc(sizeof(LbvhArg) * (size_t)threads);
+    bool ok = job.cen && job.keys && job.tmp && job.parent && job.visit && job.cbounds && job.hist &&
+              args && (threads == 1 || thr);
+
+    if(ok){
+        atomic_init(&job.start, 0);
+        atomic_init(&job.bar_count, 0);
+        atomic_init(&job.bar_gen, 0);
+        job.nthreads = threads;
+
+        // workers wait for `start` so a failed pthread_create can shrink the team
+        int started = 0;
+        for(int t=1; t<threads; t++){
+            args[t].job = &job;
+            args[t].tid = t;
+            if(pthread_create(&thr[t-1], NULL, lbvh_worker, &args[t]) != 0) break;
+            ++started;
+        }
+        job.nthreads = started + 1;
+        atomic_store_explicit(&job.start, 1, memory_order_release);
+        lbvh_run(&job, 0);
+        for(int t=0; t<started; t++) pthread_join(thr[t], NULL);
+    }
+
+    free(args); free(thr);
+    free(job.cen); free(job.keys); free(job.tmp); free(job.parent);
+    free((void*)job.visit); free(job.cbounds); free(job.hist);
+    if(!ok){ free(nodes); free(indices); return false; }
 
     *out_nodes = nodes;
     *out_node_count = nodeCount;
     *out_indices = indices;
     *out_index_count = n;
-
-    free(prim);
-    free(tmp);
     return true;
 }
+
+bool gpu_build_bvh_from_tri_vec4_lbv(
+    const float* tri_vec4,
+    uint32_t tri_count,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+){
+    return gpu_build_bvh_from_tri_vec4_lbv_ex(tri_vec4, tri_count, 0, out_nodes, out_node_count,
+                                              out_indices, out_index_count);
+}
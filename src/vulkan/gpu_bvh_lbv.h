@@ -23,6 +23,20 @@ bool gpu_build_bvh_from_tri_vec4_lbv(
     uint32_t* out_index_count
 );
 
+// Same build on `threads` threads (<= 0: YSU_BVH_THREADS, else the CPU count;
+// small inputs use fewer). Built in parallel: radix-sorted Morton keys,
+// Karras internal nodes and an atomic bottom-up refit. The result does not
+// depend on the thread count.
+bool gpu_build_bvh_from_tri_vec4_lbv_ex(
+    const float* tri_vec4,
+    uint32_t tri_count,
+    int threads,
+    GPUBVHNode** out_nodes,
+    uint32_t* out_node_count,
+    int32_t** out_indices,
+    uint32_t* out_index_count
+);
+
 #ifdef __cplusplus
 }
 #endif
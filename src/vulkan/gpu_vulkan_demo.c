@@ -301,13 +301,12 @@ static void compute_depth_hints_occ(
 
 #include "gpu_bvh.h"
 #include "gpu_bvh_build.h"
+#include "obj_load.h"
 
-// ---------------- OBJ loader (minimal) ----------------
-// Supports lines:
-//   v x y z
-//   f i j k [l ...]   where each index can be "i", "i/j", "i//n", "i/j/n" and can be negative.
-// Faces with >3 verts are triangulated as a fan.
-// Output format matches tri.comp: vec4 per vertex, repeating (p0,p1,p2) per triangle.
+// ---------------- OBJ loading ----------------
+// OBJ files go through the parallel mmap loader (obj_load.h); faces with >3
+// verts are fan triangulated. Output format matches tri.comp: vec4 per
+// vertex, repeating (p0,p1,p2) per triangle.
 typedef struct { float x,y,z; } ObjV3;
 
 static void die(const char* what, VkResult r){
@@ -332,48 +331,6 @@ static uint8_t* read_file(const char* path, size_t* out_sz){
     return data;
 }
 
-static int parse_int(const char** s, int* out){
-    while(**s==' ' || **s=='\t') (*s)++;
-    int sign = 1;
-    if(**s=='-'){ sign=-1; (*s)++; }
-    if(**s<'0' || **s>'9') return 0;
-    int v=0;
-    while(**s>='0' && **s<='9'){ v = v*10 + (**s - '0'); (*s)++; }
-    *out = v*sign;
-    return 1;
-}
-
-static int parse_face_vi(const char** s, int* vi_out){
-    int vi;
-    if(!parse_int(s, &vi)) return 0;
-
-    // skip /vt/vn forms
-    if(**s=='/'){
-        (*s)++;
-        if(**s=='/'){
-            (*s)++;
-            int tmp;
-            parse_int(s,&tmp);
-        } else {
-            int tmp;
-            parse_int(s,&tmp);
-            if(**s=='/'){
-                (*s)++;
-                parse_int(s,&tmp);
-            }
-        }
-    }
-    while(**s && **s!=' ' && **s!='\t' && **s!='\r' && **s!='\n') (*s)++;
-    *vi_out = vi;
-    return 1;
-}
-
-static int obj_index_to_zero(int idx, int vcount){
-    if(idx > 0) return idx - 1;
-    if(idx < 0) return vcount + idx;
-    return -1;
-}
-
 // Push constants shared with shaders/tri.comp
 typedef struct {
     int W;
@@ -439,91 +396,6 @@ static uint64_t ysu_now_us(void){
 #endif
 }
 
-// ---------------- Triangle cache (binary) ----------------
-// Speeds up huge OBJ loads by caching the vec4 triangle stream to disk.
-// Env: YSU_GPU_TRI_CACHE="path/to/file.tri"
-// If not set, and YSU_GPU_BVH_CACHE is set, we auto-use "<bvh_cache>.tri".
-#define TRI_CACHE_MAGIC "YSUTRI1"
-typedef struct TriCacheHeader {
-    char magic[8];        // "YSUTRI1"
-    uint32_t tri_count;
-    uint64_t obj_size;
-    uint64_t obj_mtime;
-} TriCacheHeader;
-
-static int ysu_stat_file(const char* path, uint64_t* out_size, uint64_t* out_mtime){
-#if defined(_WIN32)
-    struct _stat64 st;
-    if(_stat64(path, &st) != 0) return 0;
-    if(out_size) *out_size = (uint64_t)st.st_size;
-    if(out_mtime) *out_mtime = (uint64_t)st.st_mtime;
-    return 1;
-#else
-    struct stat st;
-    if(stat(path, &st) != 0) return 0;
-    if(out_size) *out_size = (uint64_t)st.st_size;
-    if(out_mtime) *out_mtime = (uint64_t)st.st_mtime;
-    return 1;
-#endif
-}
-
-static int tri_cache_load(const char* tri_cache_path, const char* obj_path,
-                          float** out_tri_data, int* out_tri_count){
-    if(!tri_cache_path || !tri_cache_path[0] || !obj_path || !obj_path[0]) return 0;
-
-    uint64_t obj_size=0, obj_mtime=0;
-    if(!ysu_stat_file(obj_path, &obj_size, &obj_mtime)) return 0;
-
-    FILE* f = fopen(tri_cache_path, "rb");
-    if(!f) return 0;
-
-    TriCacheHeader h;
-    if(fread(&h, 1, sizeof(h), f) != sizeof(h)){ fclose(f); return 0; }
-    if(memcmp(h.magic, TRI_CACHE_MAGIC, 7) != 0){ fclose(f); return 0; }
-    if(h.obj_size != obj_size || h.obj_mtime != obj_mtime){ fclose(f); return 0; }
-    if(h.tri_count == 0){ fclose(f); return 0; }
-
-    size_t floats = (size_t)h.tri_count * 12u;
-    float* data = (float*)malloc(floats * sizeof(float));
-    if(!data){ fclose(f); return 0; }
-
-    if(fread(data, sizeof(float), floats, f) != floats){
-        fclose(f); free(data); return 0;
-    }
-    fclose(f);
-
-    *out_tri_data = data;
-    *out_tri_count = (int)h.tri_count;
-    return 1;
-}
-
-static int tri_cache_save(const char* tri_cache_path, const char* obj_path,
-                          const float* tri_data, int tri_count){
-    if(!tri_cache_path || !tri_cache_path[0] || !obj_path || !obj_path[0]) return 0;
-    if(!tri_data || tri_count <= 0) return 0;
-
-    uint64_t obj_size=0, obj_mtime=0;
-    if(!ysu_stat_file(obj_path, &obj_size, &obj_mtime)) return 0;
-
-    FILE* f = fopen(tri_cache_path, "wb");
-    if(!f) return 0;
-
-    TriCacheHeader h;
-    memset(&h, 0, sizeof(h));
-    memcpy(h.magic, TRI_CACHE_MAGIC, 7);
-    h.tri_count = (uint32_t)tri_count;
-    h.obj_size  = obj_size;
-    h.obj_mtime = obj_mtime;
-
-    if(fwrite(&h, 1, sizeof(h), f) != sizeof(h)){ fclose(f); return 0; }
-
-    size_t floats = (size_t)tri_count * 12u;
-    if(fwrite(tri_data, sizeof(float), floats, f) != floats){ fclose(f); return 0; }
-
-    fclose(f);
-    return 1;
-}
-
 
 typedef struct {
     uint32_t magic;
@@ -599,128 +471,6 @@ static int bvh_cache_save(
     return 1;
 }
 
-static int load_obj_as_tri_vec4(const char* path, float** out_tri_data, int* out_tri_count){
-    *out_tri_data = NULL;
-    *out_tri_count = 0;
-
-    FILE* f = fopen(path, "rb");
-    if(!f) return 0;
-
-    ObjV3* verts = NULL;
-    int vcap = 0, vcount = 0;
-
-    int* faces = NULL;
-    int* face_off = NULL;
-    int* face_len = NULL;
-    int fcap = 0, fcount = 0;
-
-    char line[4096];
-    while(fgets(line, sizeof(line), f)){
-        if(line[0] == 'v' && (line[1]==' ' || line[1]=='\t')){
-            float x=0,y=0,z=0;
-            if(sscanf(line+1, "%f %f %f", &x, &y, &z) == 3){
-                if(vcount >= vcap){
-                    vcap = vcap ? vcap*2 : 1024;
-                    verts = (ObjV3*)realloc(verts, (size_t)vcap * sizeof(ObjV3));
-                    if(!verts){ fclose(f); return 0; }
-                }
-                verts[vcount++] = (ObjV3){x,y,z};
-            }
-        } else if(line[0] == 'f' && (line[1]==' ' || line[1]=='\t')){
-            const char* s = line+1;
-
-            int tmpIdx[256];
-            int n = 0;
-            while(*s){
-                while(*s==' ' || *s=='\t') s++;
-                if(*s=='\0' || *s=='\r' || *s=='\n') break;
-                if(n >= 256) break;
-                int vi=0;
-                if(!parse_face_vi(&s, &vi)) break;
-                tmpIdx[n++] = vi;
-            }
-            if(n < 3) continue;
-
-            if(fcount >= fcap){
-                fcap = fcap ? fcap*2 : 1024;
-                face_off = (int*)realloc(face_off, (size_t)fcap * sizeof(int));
-                face_len = (int*)realloc(face_len, (size_t)fcap * sizeof(int));
-                if(!face_off || !face_len){ fclose(f); return 0; }
-            }
-
-            int start = 0;
-            if(faces){
-                start = face_off[fcount-1] + face_len[fcount-1];
-            }
-            faces = (int*)realloc(faces, (size_t)(start + n) * sizeof(int));
-            if(!faces){ fclose(f); return 0; }
-
-            for(int i=0;i<n;i++) faces[start+i] = tmpIdx[i];
-            face_off[fcount] = start;
-            face_len[fcount] = n;
-            fcount++;
-        }
-    }
-    fclose(f);
-
-    // Count triangles after fan triangulation
-    int tri_count = 0;
-    for(int fi=0; fi<fcount; fi++){
-        int n = face_len[fi];
-        tri_count += (n - 2);
-    }
-    if(tri_count <= 0 || vcount <= 0){
-        free(verts); free(faces); free(face_off); free(face_len);
-        return 0;
-    }
-
-    // Allocate tri_data as vec4 stream: p0,p1,p2 repeating => 3 vec4 per tri => 12 floats
-    float* tri_data = (float*)malloc((size_t)tri_count * 12u * sizeof(float));
-    if(!tri_data){
-        free(verts); free(faces); free(face_off); free(face_len);
-        return 0;
-    }
-
-    int t = 0;
-    for(int fi=0; fi<fcount; fi++){
-        int start = face_off[fi];
-        int n = face_len[fi];
-
-        int i0 = obj_index_to_zero(faces[start+0], vcount);
-        if(i0 < 0 || i0 >= vcount) continue;
-        ObjV3 a = verts[i0];
-
-        for(int k=1; k+1<n; k++){
-            int i1 = obj_index_to_zero(faces[start+k], vcount);
-            int i2 = obj_index_to_zero(faces[start+k+1], vcount);
-            if(i1<0||i1>=vcount||i2<0||i2>=vcount) continue;
-
-            ObjV3 b = verts[i1];
-            ObjV3 c = verts[i2];
-
-            size_t base = (size_t)t * 12u;
-            // p0
-            tri_data[base+0]=a.x; tri_data[base+1]=a.y; tri_data[base+2]=a.z; tri_data[base+3]=0.0f;
-            // p1
-            tri_data[base+4]=b.x; tri_data[base+5]=b.y; tri_data[base+6]=b.z; tri_data[base+7]=0.0f;
-            // p2
-            tri_data[base+8]=c.x; tri_data[base+9]=c.y; tri_data[base+10]=c.z; tri_data[base+11]=0.0f;
-            t++;
-        }
-    }
-
-    free(verts); free(faces); free(face_off); free(face_len);
-
-    if(t <= 0){
-        free(tri_data);
-        return 0;
-    }
-
-    *out_tri_data = tri_data;
-    *out_tri_count = t;
-    return 1;
-}
-
 // ---------------- Vulkan helper funcs ----------------
 
 static VkBuffer create_buffer(VkDevice dev, VkDeviceSize size, VkBufferUsageFlags usage){
@@ -1051,7 +801,10 @@ int main(void){
     float* tri_data = NULL;
     int tri_count = 0;
 
-    // Triangle cache: avoids slow OBJ parsing on repeat runs.
+    // Triangle cache: avoids slow OBJ parsing on repeat runs. Keyed on the
+    // OBJ contents (obj_load_cached), so edits and touch-ups are both safe.
+    // Env: YSU_GPU_TRI_CACHE="path/to/file.tri"; if not set and
+    // YSU_GPU_BVH_CACHE is, "<bvh_cache>.tri"; else YSU_OBJ_CACHE applies.
     const char* tri_cache_path = getenv("YSU_GPU_TRI_CACHE");
     char tri_cache_auto[1024];
     if((!tri_cache_path || !tri_cache_path[0])) {
@@ -1067,23 +820,17 @@ int main(void){
     int tri_cache_hit = 0;
 
     if(obj_path && obj_path[0]){
-        if(tri_cache_path && tri_cache_path[0]) {
-            if(tri_cache_load(tri_cache_path, obj_path, &tri_data, &tri_count)) {
-                tri_cache_hit = 1;
-                fprintf(stderr, "[GPU] TRI CACHE HIT: %s tris=%d\n", tri_cache_path, tri_count);
-            } else {
-                fprintf(stderr, "[GPU] TRI CACHE MISS: %s\n", tri_cache_path);
-            }
-        }
-
-        if(!tri_data || tri_count <= 0){
-            if(!load_obj_as_tri_vec4(obj_path, &tri_data, &tri_count)){
-                fprintf(stderr, "[GPU] OBJ load failed: %s (falling back to cube)\n", obj_path);
-            } else if(tri_cache_path && tri_cache_path[0]) {
-                if(tri_cache_save(tri_cache_path, obj_path, tri_data, tri_count)) {
-                    fprintf(stderr, "[GPU] TRI CACHE SAVED: %s\n", tri_cache_path);
-                }
-            }
+        ObjMesh mesh;
+        if(!obj_load_cached(obj_path, (tri_cache_path && tri_cache_path[0]) ? tri_cache_path : NULL, 0, 0, &mesh)){
+            fprintf(stderr, "[GPU] OBJ load failed: %s (falling back to cube)\n", obj_path);
+        } else if(mesh.tri_count > (uint32_t)INT32_MAX){
+            fprintf(stderr, "[GPU] OBJ too large: %u tris (falling back to cube)\n", mesh.tri_count);
+            obj_mesh_free(&mesh);
+        } else {
+            tri_data = mesh.tris;
+            tri_count = (int)mesh.tri_count;
+            tri_cache_hit = mesh.from_cache;
+            if(tri_cache_hit) fprintf(stderr, "[GPU] TRI CACHE HIT: %s tris=%d\n", tri_cache_path ? tri_cache_path : "(YSU_OBJ_CACHE)", tri_count);
         }
     }
 
@@ -1177,41 +924,39 @@ if(use_bvh != 0 && !cache_hit){
         bvh_roots = (int32_t*)malloc((size_t)chunks * sizeof(int32_t));
         if(!bvh_roots){ fprintf(stderr,"[GPU] OOM roots\n"); exit(1); }
 
-        // First pass: build each chunk, keep temporary arrays
-        GPUBVHNode** chunk_nodes = (GPUBVHNode**)calloc((size_t)chunks, sizeof(GPUBVHNode*));
-        int32_t**   chunk_idx   = (int32_t**)calloc((size_t)chunks, sizeof(int32_t*));
-        uint32_t*   chunk_ncnt  = (uint32_t*)calloc((size_t)chunks, sizeof(uint32_t));
-        uint32_t*   chunk_icnt  = (uint32_t*)calloc((size_t)chunks, sizeof(uint32_t));
-        if(!chunk_nodes||!chunk_idx||!chunk_ncnt||!chunk_icnt){
+        // First pass: build all chunks in parallel (one LBVH per chunk,
+        // YSU_BVH_THREADS workers), keep temporary arrays
+        GpuBvhBuildJob* chunk_jobs = (GpuBvhBuildJob*)calloc((size_t)chunks, sizeof(GpuBvhBuildJob));
+        if(!chunk_jobs){
             fprintf(stderr,"[GPU] OOM chunk arrays\n"); exit(1);
         }
 
-        uint32_t total_nodes = 0;
-        uint32_t total_idx   = 0;
-
         for(int ci=0; ci<chunks; ci++){
             int start = ci * chunk_tris;
             int count = chunk_tris;
             if(start + count > tri_count) count = tri_count - start;
 
-            const float* tri_ptr = tri_data + (size_t)start * 12u;
-
             fprintf(stderr, "[GPU] BVH chunk %d/%d: tris=%d (start=%d)\n", ci+1, chunks, count, start);
 
-            if(!gpu_build_bvh_from_tri_vec4_lbv(
-                    tri_ptr,
-                    (uint32_t)count,
-                    &chunk_nodes[ci],
-                    &chunk_ncnt[ci],
-                    &chunk_idx[ci],
-                    &chunk_icnt[ci]))
-            {
-                fprintf(stderr, "[GPU] BVH build failed on chunk %d\n", ci);
-                exit(1);
+            chunk_jobs[ci].tri_data  = tri_data + (size_t)start * 12u;
+            chunk_jobs[ci].tri_count = (uint32_t)count;
+            chunk_jobs[ci].builder   = GPU_BVH_BUILDER_LBVH;
+        }
+
+        double chunk_ms = 0.0;
+        if(!gpu_bvh_build_jobs(chunk_jobs, chunks, 0, &chunk_ms)){
+            for(int ci=0; ci<chunks; ci++){
+                if(!chunk_jobs[ci].ok) fprintf(stderr, "[GPU] BVH build failed on chunk %d\n", ci);
             }
+            exit(1);
+        }
+        fprintf(stderr, "[GPU] BVH chunks built: %d in %.1f ms\n", chunks, chunk_ms);
 
-            total_nodes += chunk_ncnt[ci];
-            total_idx   += chunk_icnt[ci];
+        uint32_t total_nodes = 0;
+        uint32_t total_idx   = 0;
+        for(int ci=0; ci<chunks; ci++){
+            total_nodes += chunk_jobs[ci].node_count;
+            total_idx   += chunk_jobs[ci].index_count;
         }
 
         // Allocate combined arrays
@@ -1232,8 +977,8 @@ if(use_bvh != 0 && !cache_hit){
             bvh_roots[ci] = (int32_t)node_off;
 
             // copy nodes and fix child pointers + triOffset
-            for(uint32_t n=0; n<chunk_ncnt[ci]; n++){
-                GPUBVHNode nd = chunk_nodes[ci][n];
+            for(uint32_t n=0; n<chunk_jobs[ci].node_count; n++){
+                GPUBVHNode nd = chunk_jobs[ci].nodes[n];
 
                 if(nd.left  >= 0) nd.left  += (int32_t)node_off;
                 if(nd.right >= 0) nd.right += (int32_t)node_off;
@@ -1244,21 +989,18 @@ if(use_bvh != 0 && !cache_hit){
             }
 
             // copy indices and convert to GLOBAL triangle IDs
-            for(uint32_t j=0; j<chunk_icnt[ci]; j++){
-                bvh_indices[idx_off + j] = chunk_idx[ci][j] + start_tri;
+            for(uint32_t j=0; j<chunk_jobs[ci].index_count; j++){
+                bvh_indices[idx_off + j] = chunk_jobs[ci].indices[j] + start_tri;
             }
 
-            node_off += chunk_ncnt[ci];
-            idx_off  += chunk_icnt[ci];
+            node_off += chunk_jobs[ci].node_count;
+            idx_off  += chunk_jobs[ci].index_count;
 
-            free(chunk_nodes[ci]);
-            free(chunk_idx[ci]);
+            free(chunk_jobs[ci].nodes);
+            free(chunk_jobs[ci].indices);
         }
 
-        free(chunk_nodes);
-        free(chunk_idx);
-        free(chunk_ncnt);
-        free(chunk_icnt);
+        free(chunk_jobs);
 
         bvh_node_count = total_nodes;
         bvh_index_count = total_idx;